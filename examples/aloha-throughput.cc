@@ -7,6 +7,7 @@
  */
 
 #include "ns3/building-allocator.h"
+#include "ns3/boolean.h"
 #include "ns3/building-penetration-loss.h"
 #include "ns3/buildings-helper.h"
 #include "ns3/callback.h"
@@ -34,6 +35,7 @@
 #include "ns3/position-allocator.h"
 #include "ns3/random-variable-stream.h"
 #include "ns3/simulator.h"
+#include "ns3/uinteger.h"
 
 #include <algorithm>
 #include <ctime>
@@ -57,6 +59,8 @@ bool realisticChannelModel = false; //!< Whether to use a more realistic channel
 auto packetsSent = std::vector<int>(6, 0);
 /** Record received pkts by Data Rate (DR) [index 0 -> DR5, index 5 -> DR0]. */
 auto packetsReceived = std::vector<int>(6, 0);
+/** Record pkts recovered by SIC by Data Rate (DR) [index 0 -> DR5, index 5 -> DR0]. */
+auto packetsRecovered = std::vector<int>(6, 0);
 
 /**
  * Record the beginning of a transmission by an end device.
@@ -88,10 +92,27 @@ OnPacketReceptionCallback(Ptr<const Packet> packet, uint32_t receiverNodeId)
     packetsReceived.at(tag.GetSpreadingFactor() - 7)++;
 }
 
+/**
+ * Record the reception of a packet by a gateway after cancelling interferers.
+ *
+ * \param packet A pointer to the packet received.
+ * \param receiverNodeId Node id of the receiver gateway.
+ */
+void
+OnPacketRecoveryCallback(Ptr<const Packet> packet, uint32_t receiverNodeId)
+{
+    NS_LOG_FUNCTION(packet << receiverNodeId);
+    LoraTag tag;
+    packet->PeekPacketTag(tag);
+    packetsRecovered.at(tag.GetSpreadingFactor() - 7)++;
+}
+
 int
 main(int argc, char* argv[])
 {
     std::string interferenceMatrix = "aloha";
+    uint32_t sicDepth = 0;
+    bool preambleCapture = false;
 
     CommandLine cmd(__FILE__);
     cmd.AddValue("nDevices", "Number of end devices to include in the simulation", nDevices);
@@ -100,6 +121,12 @@ main(int argc, char* argv[])
                  "Interference matrix to use [aloha, goursaud]",
                  interferenceMatrix);
     cmd.AddValue("radius", "Radius (m) of the deployment", radiusMeters);
+    cmd.AddValue("sicDepth",
+                 "Number of interferers gateways can cancel to recover a packet (0 disables SIC)",
+                 sicDepth);
+    cmd.AddValue("preambleCapture",
+                 "Whether gateways release the paths of packets destroyed before they end",
+                 preambleCapture);
     cmd.Parse(argc, argv);
 
     int appPeriodSeconds = simulationTimeSeconds;
@@ -242,6 +269,8 @@ main(int argc, char* argv[])
 
     // Create a netdevice for each gateway
     phyHelper.SetDeviceType(LoraPhyHelper::GW);
+    phyHelper.Set("SicDepth", UintegerValue(sicDepth));
+    phyHelper.Set("PreambleCapture", BooleanValue(preambleCapture));
     macHelper.SetDeviceType(LorawanMacHelper::GW);
     helper.Install(phyHelper, macHelper, gateways);
 
@@ -328,6 +357,10 @@ main(int argc, char* argv[])
         DynamicCast<LoraNetDevice>((*node)->GetDevice(0))
             ->GetPhy()
             ->TraceConnectWithoutContext("ReceivedPacket", MakeCallback(OnPacketReceptionCallback));
+        DynamicCast<LoraNetDevice>((*node)->GetDevice(0))
+            ->GetPhy()
+            ->TraceConnectWithoutContext("RecoveredPacketBySic",
+                                         MakeCallback(OnPacketRecoveryCallback));
     }
 
     // Install trace sources
@@ -361,5 +394,14 @@ main(int argc, char* argv[])
         std::cout << packetsSent.at(i) << " " << packetsReceived.at(i) << std::endl;
     }
 
+    // Packets received only thanks to SIC, to compare with a run without it
+    if (sicDepth > 0)
+    {
+        for (int i = 0; i < 6; i++)
+        {
+            std::cout << "SIC recovered " << packetsRecovered.at(i) << std::endl;
+        }
+    }
+
     return 0;
 }
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2017 University of Padova
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+/*
+ * This program measures the memory used by the channel configuration of end
+ * devices, and the time spent installing them, with a channel plan per device
+ * and with a single EU868 channel plan shared by all devices.
+ */
+
+#include "ns3/command-line.h"
+#include "ns3/lora-helper.h"
+#include "ns3/lorawan-mac-helper.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/node-container.h"
+#include "ns3/propagation-delay-model.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/simulator.h"
+
+#include <chrono>
+#include <iostream>
+
+using namespace ns3;
+using namespace lorawan;
+
+/**
+ * Install end devices and print the memory used by their channel
+ * configuration and the time spent installing them.
+ *
+ * \param nDevices The number of end devices to install.
+ * \param sharePlans Whether the end devices share their channel plan.
+ */
+void
+InstallEndDevices(uint32_t nDevices, bool sharePlans)
+{
+    Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel>();
+    Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel>();
+    Ptr<LoraChannel> channel = CreateObject<LoraChannel>(loss, delay);
+
+    NodeContainer endDevices;
+    endDevices.Create(nDevices);
+
+    MobilityHelper mobility;
+    mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+    mobility.Install(endDevices);
+
+    LoraPhyHelper phyHelper;
+    phyHelper.SetChannel(channel);
+    phyHelper.SetDeviceType(LoraPhyHelper::ED);
+    LorawanMacHelper macHelper;
+    macHelper.SetDeviceType(LorawanMacHelper::ED_A);
+    macHelper.SetShareChannelPlans(sharePlans);
+    LoraHelper helper;
+
+    auto start = std::chrono::steady_clock::now();
+    helper.Install(phyHelper, macHelper, endDevices);
+    std::chrono::duration<double> setupTime = std::chrono::steady_clock::now() - start;
+
+    std::cout << (sharePlans ? "Shared plan: " : "Plan per device: ")
+              << LorawanMacHelper::GetChannelPlanBytesPerDevice(endDevices)
+              << " bytes/device, setup time " << setupTime.count() << " s" << std::endl;
+
+    Simulator::Destroy();
+}
+
+int
+main(int argc, char* argv[])
+{
+    uint32_t nDevices = 10000;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("nDevices", "Number of end devices", nDevices);
+    cmd.Parse(argc, argv);
+
+    InstallEndDevices(nDevices, false);
+    InstallEndDevices(nDevices, true);
+
+    return 0;
+}
@@ -0,0 +1,303 @@
+/*
+ * Copyright (c) 2017 University of Padova
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+/*
+ * This example runs the scenario of aloha-throughput on multiple MPI ranks.
+ *
+ * The deployment disc is split in vertical stripes of the same width, one per
+ * rank, and each rank only creates the end devices that fall in its stripe.
+ * All ranks draw the same device positions, so that the population doesn't
+ * depend on the number of ranks. The gateway, at the center of the disc,
+ * belongs to rank 0. Packets sent by end devices reach the other ranks through
+ * a LoraChannelMpiBridge.
+ *
+ * To measure how the scenario scales, run it with an increasing number of
+ * ranks, e.g.:
+ *
+ * for n in 1 2 4 8 16; do
+ *   ./ns3 run "distributed-aloha-throughput --nDevices=100000" \
+ *     --command-template="mpiexec -np $n %s"
+ * done
+ */
+
+#include "ns3/box.h"
+#include "ns3/command-line.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/double.h"
+#include "ns3/global-value.h"
+#include "ns3/log.h"
+#include "ns3/lora-channel-mpi-bridge.h"
+#include "ns3/lora-helper.h"
+#include "ns3/lora-net-device.h"
+#include "ns3/lora-phy.h"
+#include "ns3/lora-tag.h"
+#include "ns3/lorawan-mac-helper.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/mpi-interface.h"
+#include "ns3/node-container.h"
+#include "ns3/periodic-sender-helper.h"
+#include "ns3/position-allocator.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+
+#include <algorithm>
+#include <chrono>
+#include <mpi.h>
+
+using namespace ns3;
+using namespace lorawan;
+
+NS_LOG_COMPONENT_DEFINE("DistributedAlohaThroughput");
+
+// Network settings
+int nDevices = 200;                 //!< Number of end device nodes to create, on all ranks
+double radiusMeters = 1000;         //!< Radius (m) of the deployment
+double simulationTimeSeconds = 100; //!< Scenario duration (s) in simulated time
+
+/** Record sent pkts by Data Rate (DR) [index 0 -> DR5, index 5 -> DR0]. */
+auto packetsSent = std::vector<int>(6, 0);
+/** Record received pkts by Data Rate (DR) [index 0 -> DR5, index 5 -> DR0]. */
+auto packetsReceived = std::vector<int>(6, 0);
+
+/**
+ * Record the beginning of a transmission by an end device.
+ *
+ * \param packet A pointer to the packet sent.
+ * \param senderNodeId Node id of the sender end device.
+ */
+void
+OnTransmissionCallback(Ptr<const Packet> packet, uint32_t senderNodeId)
+{
+    NS_LOG_FUNCTION(packet << senderNodeId);
+    LoraTag tag;
+    packet->PeekPacketTag(tag);
+    packetsSent.at(tag.GetSpreadingFactor() - 7)++;
+}
+
+/**
+ * Record the correct reception of a packet by a gateway.
+ *
+ * \param packet A pointer to the packet received.
+ * \param receiverNodeId Node id of the receiver gateway.
+ */
+void
+OnPacketReceptionCallback(Ptr<const Packet> packet, uint32_t receiverNodeId)
+{
+    NS_LOG_FUNCTION(packet << receiverNodeId);
+    LoraTag tag;
+    packet->PeekPacketTag(tag);
+    packetsReceived.at(tag.GetSpreadingFactor() - 7)++;
+}
+
+int
+main(int argc, char* argv[])
+{
+    double minDelayMicroSeconds = 100;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("nDevices", "Number of end devices to include in the simulation", nDevices);
+    cmd.AddValue("simulationTime", "Simulation Time (s)", simulationTimeSeconds);
+    cmd.AddValue("radius", "Radius (m) of the deployment", radiusMeters);
+    cmd.AddValue("minDelay",
+                 "Delay (us) after which packets reach other ranks, i.e., the lookahead",
+                 minDelayMicroSeconds);
+    cmd.Parse(argc, argv);
+
+    int appPeriodSeconds = simulationTimeSeconds;
+
+    // Distributed simulation setup
+    GlobalValue::Bind("SimulatorImplementationType",
+                      StringValue("ns3::DistributedSimulatorImpl"));
+    MpiInterface::Enable(&argc, &argv);
+    uint32_t rank = MpiInterface::GetSystemId();
+    uint32_t size = MpiInterface::GetSize();
+
+    auto wallClockStart = std::chrono::steady_clock::now();
+
+    /************************
+     *  Create the channel  *
+     ************************/
+
+    // Create the lora channel object
+    Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel>();
+    loss->SetPathLossExponent(3.76);
+    loss->SetReference(1, 7.7);
+
+    Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel>();
+
+    Ptr<LoraChannel> channel = CreateObject<LoraChannel>(loss, delay);
+
+    // Connect the channel to the ones of the other ranks. This needs to happen
+    // before any other node is created, so that node ids match across ranks.
+    Ptr<LoraChannelMpiBridge> bridge = CreateObject<LoraChannelMpiBridge>();
+    bridge->SetAttribute("MinDelay", TimeValue(MicroSeconds(minDelayMicroSeconds)));
+    bridge->Install(channel);
+
+    // Only forward packets to the ranks whose stripe they can reach. Rank 0
+    // also holds the gateway, at the center of the disc.
+    for (uint32_t r = 0; r < size; r++)
+    {
+        double stripeWidth = 2 * radiusMeters / size;
+        double xMin = -radiusMeters + r * stripeWidth;
+        double xMax = xMin + stripeWidth;
+        if (r == 0)
+        {
+            xMax = std::max(xMax, 0.0);
+        }
+        bridge->SetRankRegion(r, Box(xMin, xMax, -radiusMeters, radiusMeters, 0.0, 15.0));
+    }
+
+    /************************
+     *  Create the helpers  *
+     ************************/
+
+    // Create the LoraPhyHelper
+    LoraPhyHelper phyHelper = LoraPhyHelper();
+    phyHelper.SetChannel(channel);
+
+    // Create the LorawanMacHelper
+    LorawanMacHelper macHelper = LorawanMacHelper();
+    macHelper.SetRegion(LorawanMacHelper::ALOHA);
+
+    // Create the LoraHelper
+    LoraHelper helper = LoraHelper();
+
+    /*********************
+     *  Create Gateways  *
+     *********************/
+
+    // The gateway belongs to rank 0, but all ranks know about it in order to
+    // configure the spreading factors of their end devices
+    NodeContainer gateways;
+    gateways.Add(CreateObject<Node>(0));
+
+    MobilityHelper mobility;
+    Ptr<ListPositionAllocator> allocator = CreateObject<ListPositionAllocator>();
+    allocator->Add(Vector(0.0, 0.0, 15.0));
+    mobility.SetPositionAllocator(allocator);
+    mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+    mobility.Install(gateways);
+
+    phyHelper.SetDeviceType(LoraPhyHelper::GW);
+    macHelper.SetDeviceType(LorawanMacHelper::GW);
+    helper.Install(phyHelper, macHelper, gateways);
+
+    /************************
+     *  Create End Devices  *
+     ************************/
+
+    // Draw the same positions on all ranks, and only keep those in our stripe
+    Ptr<UniformDiscPositionAllocator> disc = CreateObject<UniformDiscPositionAllocator>();
+    disc->SetRho(radiusMeters);
+    disc->SetX(0.0);
+    disc->SetY(0.0);
+    disc->AssignStreams(0);
+
+    NodeContainer endDevices;
+    for (int i = 0; i < nDevices; i++)
+    {
+        Vector position = disc->GetNext();
+        position.z = 1.2;
+        auto stripe =
+            static_cast<uint32_t>((position.x + radiusMeters) / (2 * radiusMeters) * size);
+        if (std::min(stripe, size - 1) != rank)
+        {
+            continue;
+        }
+
+        Ptr<Node> node = CreateObject<Node>(rank);
+        Ptr<ConstantPositionMobilityModel> nodeMobility =
+            CreateObject<ConstantPositionMobilityModel>();
+        nodeMobility->SetPosition(position);
+        node->AggregateObject(nodeMobility);
+        endDevices.Add(node);
+    }
+
+    NS_LOG_INFO("Rank " << rank << " holds " << endDevices.GetN() << " end devices");
+
+    // Create the LoraNetDevices of the end devices
+    uint8_t nwkId = 54;
+    uint32_t nwkAddr = 1864;
+    Ptr<LoraDeviceAddressGenerator> addrGen =
+        CreateObject<LoraDeviceAddressGenerator>(nwkId, nwkAddr);
+    macHelper.SetAddressGenerator(addrGen);
+    phyHelper.SetDeviceType(LoraPhyHelper::ED);
+    macHelper.SetDeviceType(LorawanMacHelper::ED_A);
+    helper.Install(phyHelper, macHelper, endDevices);
+
+    /*********************************************
+     *  Install applications on the end devices  *
+     *********************************************/
+
+    Time appStopTime = Seconds(simulationTimeSeconds);
+    PeriodicSenderHelper appHelper = PeriodicSenderHelper();
+    appHelper.SetPeriod(Seconds(appPeriodSeconds));
+    appHelper.SetPacketSize(50);
+    ApplicationContainer appContainer = appHelper.Install(endDevices);
+
+    appContainer.Start(Seconds(0));
+    appContainer.Stop(appStopTime);
+
+    // Install trace sources
+    if (rank == 0)
+    {
+        DynamicCast<LoraNetDevice>(gateways.Get(0)->GetDevice(0))
+            ->GetPhy()
+            ->TraceConnectWithoutContext("ReceivedPacket", MakeCallback(OnPacketReceptionCallback));
+    }
+    for (auto node = endDevices.Begin(); node != endDevices.End(); node++)
+    {
+        DynamicCast<LoraNetDevice>((*node)->GetDevice(0))
+            ->GetPhy()
+            ->TraceConnectWithoutContext("StartSending", MakeCallback(OnTransmissionCallback));
+    }
+
+    LorawanMacHelper::SetSpreadingFactorsUp(endDevices, gateways, channel);
+
+    ////////////////
+    // Simulation //
+    ////////////////
+
+    Simulator::Stop(appStopTime + Hours(1));
+
+    NS_LOG_INFO("Running simulation...");
+    Simulator::Run();
+
+    Simulator::Destroy();
+
+    /////////////////////////////
+    // Print results to stdout //
+    /////////////////////////////
+
+    // Transmissions are counted on each rank, receptions on the gateway's one
+    std::vector<int> totalSent(6, 0);
+    MPI_Reduce(packetsSent.data(), totalSent.data(), 6, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    double wallClockSeconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - wallClockStart).count();
+    double maxWallClockSeconds = 0;
+    MPI_Reduce(&wallClockSeconds,
+               &maxWallClockSeconds,
+               1,
+               MPI_DOUBLE,
+               MPI_MAX,
+               0,
+               MPI_COMM_WORLD);
+
+    if (rank == 0)
+    {
+        for (int i = 0; i < 6; i++)
+        {
+            std::cout << totalSent.at(i) << " " << packetsReceived.at(i) << std::endl;
+        }
+        std::cout << "Ranks: " << size << ", wall clock time: " << maxWallClockSeconds << " s"
+                  << std::endl;
+    }
+
+    MpiInterface::Disable();
+
+    return 0;
+}
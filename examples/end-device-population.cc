@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2017 University of Padova
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+/*
+ * This program simulates a large number of periodic, uplink-only sensors with
+ * a LoraEndDevicePopulation, which keeps no Node, NetDevice or application per
+ * device.
+ *
+ * Devices are uniformly placed in a disc around the gateways, which are laid
+ * out on a hexagonal grid, and send one packet per period with a random phase.
+ * Their data rate is set according to the power received by the best gateway.
+ * The program prints the memory used by the state of the devices, the number
+ * of packets sent and received by gateways, and the wall clock time spent
+ * creating the devices and running the simulation.
+ */
+
+#include "ns3/command-line.h"
+#include "ns3/forwarder-helper.h"
+#include "ns3/hex-grid-position-allocator.h"
+#include "ns3/lora-channel.h"
+#include "ns3/lora-end-device-population.h"
+#include "ns3/lora-helper.h"
+#include "ns3/lora-net-device.h"
+#include "ns3/lora-phy-helper.h"
+#include "ns3/lorawan-mac-helper.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/network-server-helper.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/position-allocator.h"
+#include "ns3/propagation-delay-model.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+
+#include <chrono>
+#include <iostream>
+
+using namespace ns3;
+using namespace lorawan;
+
+uint64_t packetsSent = 0;     //!< Number of packets sent by the population
+uint64_t packetsReceived = 0; //!< Number of packets received by a gateway
+
+/**
+ * Record a packet sent by a device of the population.
+ *
+ * \param packet The packet sent.
+ * \param index The index of the device.
+ */
+void
+OnPopulationSend(Ptr<const Packet> packet, uint32_t index)
+{
+    packetsSent++;
+}
+
+/**
+ * Record the correct reception of a packet by a gateway.
+ *
+ * \param packet The packet received.
+ * \param receiverNodeId Node id of the receiver gateway.
+ */
+void
+OnPacketReception(Ptr<const Packet> packet, uint32_t receiverNodeId)
+{
+    packetsReceived++;
+}
+
+int
+main(int argc, char* argv[])
+{
+    uint32_t nDevices = 1000000;
+    int nGateways = 7;
+    double radiusMeters = 6000;
+    double periodSeconds = 3600;
+    double simulationTimeSeconds = 600;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("nDevices", "Number of end devices of the population", nDevices);
+    cmd.AddValue("nGateways", "Number of gateways", nGateways);
+    cmd.AddValue("radius", "Radius (m) of the deployment", radiusMeters);
+    cmd.AddValue("period", "Interval (s) between packets of each device", periodSeconds);
+    cmd.AddValue("simulationTime", "Duration (s) of the simulation", simulationTimeSeconds);
+    cmd.Parse(argc, argv);
+
+    // Create the channel
+    Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel>();
+    loss->SetPathLossExponent(3.76);
+    loss->SetReference(1, 7.7);
+
+    Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel>();
+
+    Ptr<LoraChannel> channel = CreateObject<LoraChannel>(loss, delay);
+
+    // Create the gateways
+    NodeContainer gateways;
+    gateways.Create(nGateways);
+
+    MobilityHelper mobility;
+    Ptr<HexGridPositionAllocator> hexGrid = CreateObject<HexGridPositionAllocator>(radiusMeters);
+    mobility.SetPositionAllocator(hexGrid);
+    mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+    mobility.Install(gateways);
+    for (auto gw = gateways.Begin(); gw != gateways.End(); ++gw)
+    {
+        Ptr<MobilityModel> gwMobility = (*gw)->GetObject<MobilityModel>();
+        Vector position = gwMobility->GetPosition();
+        position.z = 15;
+        gwMobility->SetPosition(position);
+    }
+
+    LoraPhyHelper phyHelper;
+    phyHelper.SetChannel(channel);
+    phyHelper.SetDeviceType(LoraPhyHelper::GW);
+    LorawanMacHelper macHelper;
+    macHelper.SetDeviceType(LorawanMacHelper::GW);
+    LoraHelper helper;
+    helper.Install(phyHelper, macHelper, gateways);
+
+    for (auto gw = gateways.Begin(); gw != gateways.End(); ++gw)
+    {
+        DynamicCast<LoraNetDevice>((*gw)->GetDevice(0))
+            ->GetPhy()
+            ->TraceConnectWithoutContext("ReceivedPacket", MakeCallback(OnPacketReception));
+    }
+
+    // Create the devices
+    auto start = std::chrono::steady_clock::now();
+
+    Ptr<LoraEndDevicePopulation> population = CreateObject<LoraEndDevicePopulation>();
+    population->SetChannel(channel);
+    population->AssignStreams(0);
+    population->Reserve(nDevices);
+
+    Ptr<UniformDiscPositionAllocator> disc = CreateObject<UniformDiscPositionAllocator>();
+    disc->SetRho(radiusMeters * 2);
+    disc->AssignStreams(1);
+    Ptr<UniformRandomVariable> phase = CreateObject<UniformRandomVariable>();
+    phase->SetStream(2);
+
+    Time period = Seconds(periodSeconds);
+    for (uint32_t i = 0; i < nDevices; i++)
+    {
+        Vector position = disc->GetNext();
+        position.z = 1.2;
+        population->Add(position, period, Seconds(phase->GetValue(0, periodSeconds)));
+    }
+    LorawanMacHelper::SetSpreadingFactorsUp(population, gateways, channel);
+
+    std::chrono::duration<double> setupTime = std::chrono::steady_clock::now() - start;
+
+    population->TraceConnectWithoutContext("StartSending", MakeCallback(OnPopulationSend));
+
+    // Create the network server, connected to each gateway
+    Ptr<Node> networkServer = CreateObject<Node>();
+
+    PointToPointHelper p2p;
+    p2p.SetDeviceAttribute("DataRate", StringValue("5Mbps"));
+    p2p.SetChannelAttribute("Delay", StringValue("2ms"));
+    P2PGwRegistration_t gwRegistration;
+    for (auto gw = gateways.Begin(); gw != gateways.End(); ++gw)
+    {
+        auto container = p2p.Install(networkServer, *gw);
+        auto serverP2PNetDev = DynamicCast<PointToPointNetDevice>(container.Get(0));
+        gwRegistration.emplace_back(serverP2PNetDev, *gw);
+    }
+
+    NetworkServerHelper networkServerHelper;
+    networkServerHelper.SetGatewaysP2P(gwRegistration);
+    networkServerHelper.SetEndDevicePopulation(population);
+    networkServerHelper.Install(networkServer);
+
+    ForwarderHelper forwarderHelper;
+    forwarderHelper.Install(gateways);
+
+    // Run the simulation
+    Time stopTime = Seconds(simulationTimeSeconds);
+    population->Start(stopTime);
+    Simulator::Stop(stopTime + Seconds(10));
+
+    start = std::chrono::steady_clock::now();
+    Simulator::Run();
+    std::chrono::duration<double> runTime = std::chrono::steady_clock::now() - start;
+    Simulator::Destroy();
+
+    std::cout << "Devices: " << nDevices << ", "
+              << LoraEndDevicePopulation::GetBytesPerDevice() << " bytes/device" << std::endl;
+    std::cout << "Packets sent: " << packetsSent << ", received: " << packetsReceived
+              << std::endl;
+    std::cout << "Setup time: " << setupTime.count() << " s, run time: " << runTime.count()
+              << " s" << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2017 University of Padova
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+/*
+ * This program measures how many LoraFrameHeader round-trips per second can be
+ * performed on a downlink frame carrying MAC commands.
+ *
+ * Each round-trip serializes the header, deserializes it and reads back the
+ * fields of its commands, either through the values returned by
+ * GetCommandValues or through the MacCommand objects returned by GetCommands,
+ * which allocates an object per command.
+ */
+
+#include "ns3/buffer.h"
+#include "ns3/command-line.h"
+#include "ns3/lora-frame-header.h"
+
+#include <chrono>
+#include <iostream>
+
+using namespace ns3;
+using namespace lorawan;
+
+/**
+ * Serialize and deserialize a frame header, and read its commands.
+ *
+ * \param frameHdr The frame header to serialize.
+ * \param buffer The buffer to serialize to, large enough for the header.
+ * \param useObjects Whether to read the commands through MacCommand objects.
+ * \return The sum of the data rates of the LinkAdrReq commands.
+ */
+uint32_t
+RoundTrip(const LoraFrameHeader& frameHdr, Buffer& buffer, bool useObjects)
+{
+    frameHdr.Serialize(buffer.Begin());
+
+    LoraFrameHeader received;
+    received.SetAsDownlink();
+    received.Deserialize(buffer.Begin());
+
+    uint32_t dataRates = 0;
+    if (useObjects)
+    {
+        for (const auto& command : received.GetCommands())
+        {
+            if (command->GetCommandType() == LINK_ADR_REQ)
+            {
+                dataRates += DynamicCast<LinkAdrReq>(command)->GetDataRate();
+            }
+        }
+    }
+    else
+    {
+        const MacCommandList& commands = received.GetCommandValues();
+        for (std::size_t i = 0; i < commands.GetN(); i++)
+        {
+            if (const auto* linkAdrReq = std::get_if<LinkAdrReqValue>(&commands.Get(i)))
+            {
+                dataRates += linkAdrReq->dataRate;
+            }
+        }
+    }
+    return dataRates;
+}
+
+int
+main(int argc, char* argv[])
+{
+    uint32_t nRoundTrips = 1000000;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("nRoundTrips", "Number of header round-trips", nRoundTrips);
+    cmd.Parse(argc, argv);
+
+    // A network server reply with ADR and a status request
+    LoraFrameHeader frameHdr;
+    frameHdr.SetAsDownlink();
+    frameHdr.SetAddress(LoraDeviceAddress(56, 1864));
+    frameHdr.SetFCnt(1);
+    frameHdr.SetFPort(1);
+    frameHdr.AddLinkAdrReq(5, 1, {0, 1, 2}, 1);
+    frameHdr.AddDutyCycleReq(7);
+    frameHdr.AddDevStatusReq();
+    frameHdr.AddLinkCheckAns(10, 2);
+
+    Buffer buffer;
+    buffer.AddAtStart(frameHdr.GetSerializedSize());
+
+    for (bool useObjects : {true, false})
+    {
+        uint32_t dataRates = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < nRoundTrips; i++)
+        {
+            dataRates += RoundTrip(frameHdr, buffer, useObjects);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        std::cout << (useObjects ? "MacCommand objects: " : "MacCommand values: ")
+                  << nRoundTrips / elapsed.count() << " round-trips/s (checksum " << dataRates
+                  << ")" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+/*
+ * This program measures how many uplink packets per second the NetworkServer
+ * can ingest when it serves a large number of end devices.
+ *
+ * The packets are handed to NetworkServer::Receive directly, as if they had
+ * been forwarded by a gateway, so that only the time spent by the network
+ * server to parse the packets and update its NetworkStatus, NetworkScheduler and
+ * NetworkController components is measured.
+ */
+
+#include "ns3/command-line.h"
+#include "ns3/lora-frame-header.h"
+#include "ns3/lora-tag.h"
+#include "ns3/lorawan-mac-header.h"
+#include "ns3/network-controller-components.h"
+#include "ns3/network-server.h"
+#include "ns3/simulator.h"
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+using namespace lorawan;
+
+/**
+ * Build an unconfirmed uplink packet as forwarded by a gateway.
+ *
+ * \param address The address of the sender.
+ * \param fCnt The frame counter of the packet.
+ * \return The packet, with its headers and LoraTag.
+ */
+Ptr<Packet>
+CreateUplink(LoraDeviceAddress address, uint16_t fCnt)
+{
+    Ptr<Packet> packet = Create<Packet>(10);
+
+    LoraFrameHeader frameHdr;
+    frameHdr.SetAsUplink();
+    frameHdr.SetAddress(address);
+    frameHdr.SetFCnt(fCnt);
+    packet->AddHeader(frameHdr);
+
+    LorawanMacHeader macHdr;
+    macHdr.SetMType(LorawanMacHeader::UNCONFIRMED_DATA_UP);
+    packet->AddHeader(macHdr);
+
+    LoraTag tag;
+    tag.SetSpreadingFactor(7);
+    tag.SetFrequency(868.1);
+    tag.SetReceivePower(-100);
+    packet->AddPacketTag(tag);
+
+    return packet;
+}
+
+int
+main(int argc, char* argv[])
+{
+    uint32_t nDevices = 100000;
+    uint32_t nRounds = 5;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("nDevices", "Number of end devices", nDevices);
+    cmd.AddValue("nRounds", "Number of uplink packets sent by each end device", nRounds);
+    cmd.Parse(argc, argv);
+
+    Ptr<NetworkServer> server = CreateObject<NetworkServer>();
+    server->AddComponent(CreateObject<ConfirmedMessagesComponent>());
+    server->AddComponent(CreateObject<LinkCheckComponent>());
+
+    std::vector<LoraDeviceAddress> addresses;
+    addresses.reserve(nDevices);
+    for (uint32_t i = 0; i < nDevices; i++)
+    {
+        addresses.push_back(LoraDeviceAddress(i));
+        server->GetNetworkStatus()->AddNode(addresses.back());
+    }
+
+    Address gwAddress;
+    double elapsedTime = 0;
+    for (uint32_t round = 0; round < nRounds; round++)
+    {
+        // Build the packets beforehand, so that only their reception is measured
+        std::vector<Ptr<Packet>> packets;
+        packets.reserve(nDevices);
+        for (const auto& address : addresses)
+        {
+            packets.push_back(CreateUplink(address, round));
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& packet : packets)
+        {
+            server->Receive(nullptr, packet, 0, gwAddress);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        elapsedTime += elapsed.count();
+    }
+
+    std::cout << nDevices << " devices: " << uint64_t(nDevices) * nRounds / elapsedTime
+              << " uplinks/s" << std::endl;
+
+    Simulator::Destroy();
+
+    return 0;
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2017 University of Padova
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+/*
+ * This program measures the cost of computing the power received by many
+ * receivers from a single sender, comparing one LoraChannel::GetRxPower call
+ * per receiver with the batch LoraChannel::GetRxPowers methods.
+ *
+ * Receivers are uniformly placed in a disc around the sender, and the channel
+ * uses the log distance loss model of the other examples. The program prints
+ * the average time spent per receiver by each method, and the largest
+ * difference between the powers they compute.
+ */
+
+#include "ns3/command-line.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/lora-channel.h"
+#include "ns3/position-allocator.h"
+#include "ns3/propagation-delay-model.h"
+#include "ns3/propagation-loss-model.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+using namespace ns3;
+using namespace lorawan;
+
+/**
+ * Time a function over a number of repetitions.
+ *
+ * \param repetitions The number of calls.
+ * \param nReceivers The number of receivers handled by each call.
+ * \param function The function to time.
+ * \return The average time per receiver [ns].
+ */
+template <typename F>
+double
+TimePerReceiver(int repetitions, int nReceivers, F function)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repetitions; i++)
+    {
+        function();
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / (double(repetitions) * nReceivers);
+}
+
+int
+main(int argc, char* argv[])
+{
+    int nReceivers = 10000;
+    int repetitions = 100;
+    double radiusMeters = 6000;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("nReceivers", "Number of receivers", nReceivers);
+    cmd.AddValue("repetitions", "Number of times the powers are computed", repetitions);
+    cmd.AddValue("radius", "Radius (m) of the deployment", radiusMeters);
+    cmd.Parse(argc, argv);
+
+    // Create the channel
+    Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel>();
+    loss->SetPathLossExponent(3.76);
+    loss->SetReference(1, 7.7);
+
+    Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel>();
+
+    Ptr<LoraChannel> channel = CreateObject<LoraChannel>(loss, delay);
+
+    // Place the sender at the center and the receivers around it
+    Ptr<ConstantPositionMobilityModel> sender = CreateObject<ConstantPositionMobilityModel>();
+    sender->SetPosition(Vector(0.0, 0.0, 15.0));
+
+    Ptr<UniformDiscPositionAllocator> disc = CreateObject<UniformDiscPositionAllocator>();
+    disc->SetRho(radiusMeters);
+    disc->AssignStreams(0);
+
+    std::vector<Ptr<MobilityModel>> receivers;
+    LoraPositionBatch positions;
+    for (int i = 0; i < nReceivers; i++)
+    {
+        Ptr<ConstantPositionMobilityModel> receiver =
+            CreateObject<ConstantPositionMobilityModel>();
+        Vector position = disc->GetNext();
+        position.z = 1.2;
+        receiver->SetPosition(position);
+        receivers.push_back(receiver);
+        positions.Add(position);
+    }
+
+    // Compute the powers with each method
+    std::vector<double> perPair(nReceivers);
+    std::vector<double> fromMobility;
+    std::vector<double> fromPositions;
+
+    double perPairNs = TimePerReceiver(repetitions, nReceivers, [&]() {
+        for (int k = 0; k < nReceivers; k++)
+        {
+            perPair[k] = channel->GetRxPower(14, sender, receivers[k]);
+        }
+    });
+    double fromMobilityNs = TimePerReceiver(repetitions, nReceivers, [&]() {
+        channel->GetRxPowers(14, sender, receivers, fromMobility);
+    });
+    double fromPositionsNs = TimePerReceiver(repetitions, nReceivers, [&]() {
+        channel->GetRxPowers(14, sender->GetPosition(), positions, fromPositions);
+    });
+
+    double maxDifference = 0;
+    for (int k = 0; k < nReceivers; k++)
+    {
+        maxDifference = std::max(maxDifference, std::abs(fromMobility[k] - perPair[k]));
+        maxDifference = std::max(maxDifference, std::abs(fromPositions[k] - perPair[k]));
+    }
+
+    std::cout << "Per-pair GetRxPower: " << perPairNs << " ns/receiver" << std::endl;
+    std::cout << "GetRxPowers (mobility models): " << fromMobilityNs << " ns/receiver"
+              << std::endl;
+    std::cout << "GetRxPowers (position batch): " << fromPositionsNs << " ns/receiver"
+              << std::endl;
+    std::cout << "Largest difference: " << maxDifference << " dB" << std::endl;
+
+    return 0;
+}
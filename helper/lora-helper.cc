@@ -89,6 +89,13 @@ LoraHelper::Install(const LoraPhyHelper& phyHelper,
         NS_ASSERT(mac);
         mac->SetPhy(phy);
         NS_LOG_DEBUG("Done creating the MAC");
+
+        // Keep interfering signals as long as the region's longest packets
+        Time maxOnAirTime = mac->GetMaxOnAirTime();
+        if (maxOnAirTime.IsStrictlyPositive())
+        {
+            phy->SetInterferenceRetentionHorizon(maxOnAirTime);
+        }
         device->SetMac(mac);
 
         if (m_packetTracker)
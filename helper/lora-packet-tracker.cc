@@ -9,7 +9,7 @@
 #include "lora-packet-tracker.h"
 
 #include "ns3/log.h"
-#include "ns3/lorawan-mac-header.h"
+#include "ns3/lorawan-frame-view.h"
 #include "ns3/simulator.h"
 
 #include <fstream>
@@ -185,10 +185,7 @@ LoraPacketTracker::IsUplink(Ptr<const Packet> packet)
 {
     NS_LOG_FUNCTION(this);
 
-    LorawanMacHeader mHdr;
-    Ptr<Packet> copy = packet->Copy();
-    copy->RemoveHeader(mHdr);
-    return mHdr.IsUplink();
+    return LorawanFrameView(packet).IsUplink();
 }
 
 ////////////////////////
@@ -309,6 +306,34 @@ LoraPacketTracker::PrintPhyPacketsPerGw(Time startTime, Time stopTime, int gwId)
     return output;
 }
 
+std::string
+LoraPacketTracker::CountMacPacketsPerGw(Time startTime, Time stopTime, int gwId)
+{
+    NS_LOG_FUNCTION(this << startTime << stopTime << gwId);
+
+    double sent = 0;
+    double received = 0;
+    for (auto it = m_macPacketTracker.begin(); it != m_macPacketTracker.end(); ++it)
+    {
+        if ((*it).second.sendTime >= startTime && (*it).second.sendTime <= stopTime)
+        {
+            sent++;
+            if ((*it).second.receptionTimes.count(gwId) > 0)
+            {
+                received++;
+            }
+        }
+    }
+
+    return std::to_string(sent) + " " + std::to_string(received);
+}
+
+std::string
+LoraPacketTracker::PrintMacPacketsPerGw(Time startTime, Time stopTime, int gwId)
+{
+    return CountMacPacketsPerGw(startTime, stopTime, gwId);
+}
+
 std::string
 LoraPacketTracker::CountMacPacketsGlobally(Time startTime, Time stopTime)
 {
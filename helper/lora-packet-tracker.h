@@ -218,14 +218,13 @@ class LoraPacketTracker
 
     /**
      * Count packets in a time interval to evaluate the performance at MAC level of a specific
-     * gateway.
+     * gateway. It counts the total number of uplink packets sent by the MAC layer of end devices,
+     * and the number of such packets received by the MAC layer of the specified gateway.
      *
      * \param startTime Timestamp of the start of the measurement.
      * \param stopTime Timestamp of the end of the measurement.
      * \param systemId Node id of the gateway.
-     * \return String of output values.
-     *
-     * \todo Not implemented, this is a placeholder for future implementation.
+     * \return String of output values: [totPacketsSent, receivedPackets].
      */
     std::string CountMacPacketsPerGw(Time startTime, Time stopTime, int systemId);
     /** \copydoc ns3::lorawan::LoraPacketTracker::CountMacPacketsPerGw */
@@ -101,6 +101,18 @@ LoraPhyHelper::Create(Ptr<Node> node, Ptr<NetDevice> device) const
             DynamicCast<SimpleGatewayLoraPhy>(phy)->AddReceptionPath();
             receptionPaths++;
         }
+
+        // Add the concentrator boards, if any
+        for (const auto& gatewayBoard : m_gatewayBoards)
+        {
+            Ptr<SimpleGatewayLoraPhy> gwPhy = DynamicCast<SimpleGatewayLoraPhy>(phy);
+            uint32_t board =
+                gwPhy->AddBoard(gatewayBoard.nReceptionPaths, gatewayBoard.maxFrequencies);
+            for (auto f : gatewayBoard.frequencies)
+            {
+                gwPhy->AddBoardFrequency(board, f);
+            }
+        }
     }
     else if (typeId == "ns3::SimpleEndDeviceLoraPhy")
     {
@@ -130,5 +142,15 @@ LoraPhyHelper::SetGatewayTransmissionPriority(bool txPriority)
 {
     m_txPriority = txPriority;
 }
+
+void
+LoraPhyHelper::AddGatewayBoard(uint32_t nReceptionPaths,
+                               uint32_t maxFrequencies,
+                               std::vector<double> frequencies)
+{
+    NS_LOG_FUNCTION(this << nReceptionPaths << maxFrequencies);
+
+    m_gatewayBoards.push_back({nReceptionPaths, maxFrequencies, frequencies});
+}
 } // namespace lorawan
 } // namespace ns3
@@ -98,10 +98,35 @@ class LoraPhyHelper
      */
     void SetGatewayTransmissionPriority(bool txPriority);
 
+    /**
+     * Add a concentrator board to the gateways created by this helper.
+     *
+     * Boards are kept when a LorawanMacHelper later resets the reception paths
+     * of the gateway for its region (see GatewayLoraPhy::AddBoard).
+     *
+     * \param nReceptionPaths The number of demodulators of the board.
+     * \param maxFrequencies The number of IF chains of the board.
+     * \param frequencies The frequencies [MHz] the board listens to.
+     */
+    void AddGatewayBoard(uint32_t nReceptionPaths,
+                         uint32_t maxFrequencies,
+                         std::vector<double> frequencies);
+
   private:
+    /**
+     * The configuration of a concentrator board of the gateways.
+     */
+    struct GatewayBoard
+    {
+        uint32_t nReceptionPaths;        //!< The number of demodulators
+        uint32_t maxFrequencies;         //!< The number of IF chains
+        std::vector<double> frequencies; //!< The frequencies the board listens to
+    };
+
     ObjectFactory m_phy;        //!< The PHY layer factory object.
     Ptr<LoraChannel> m_channel; //!< The channel instance the PHYs will be connected to.
     int m_maxReceptionPaths;    //!< The maximum number of receive paths at the gateway.
+    std::vector<GatewayBoard> m_gatewayBoards; //!< The concentrator boards of the gateways.
     bool m_txPriority; //!< Whether to give priority to downlink transmission over reception at the
                        //!< gateways. \todo This parameter does nothing, to be removed.
 };
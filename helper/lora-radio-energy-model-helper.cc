@@ -32,6 +32,20 @@ LoraRadioEnergyModelHelper::Set(std::string name, const AttributeValue& v)
     m_radioEnergy.Set(name, v);
 }
 
+void
+LoraRadioEnergyModelHelper::SetDepletionCallback(
+    LoraRadioEnergyModel::LoraRadioEnergyDepletionCallback callback)
+{
+    m_depletionCallback = callback;
+}
+
+void
+LoraRadioEnergyModelHelper::SetRechargedCallback(
+    LoraRadioEnergyModel::LoraRadioEnergyRechargedCallback callback)
+{
+    m_rechargedCallback = callback;
+}
+
 void
 LoraRadioEnergyModelHelper::SetTxCurrentModel(std::string name,
                                               std::string n0,
@@ -85,10 +99,28 @@ LoraRadioEnergyModelHelper::DoInstall(Ptr<NetDevice> device, Ptr<EnergySource> s
     // set energy source pointer
     model->SetEnergySource(source);
 
-    // set energy depletion callback
-    // if none is specified, make a callback to EndDeviceLoraPhy::SetSleepMode
+    // set energy depletion and recharged callbacks
+    // if none is specified, stop listening to the channel while the source is depleted
     Ptr<LoraNetDevice> loraDevice = DynamicCast<LoraNetDevice>(device);
     Ptr<EndDeviceLoraPhy> loraPhy = DynamicCast<EndDeviceLoraPhy>(loraDevice->GetPhy());
+    if (m_depletionCallback.IsNull())
+    {
+        model->SetEnergyDepletionCallback(
+            MakeCallback(&EndDeviceLoraPhy::HandleEnergyDepletion, loraPhy));
+    }
+    else
+    {
+        model->SetEnergyDepletionCallback(m_depletionCallback);
+    }
+    if (m_rechargedCallback.IsNull())
+    {
+        model->SetEnergyRechargedCallback(
+            MakeCallback(&EndDeviceLoraPhy::HandleEnergyRecharged, loraPhy));
+    }
+    else
+    {
+        model->SetEnergyRechargedCallback(m_rechargedCallback);
+    }
     // add model to device model list in energy source
     source->AppendDeviceEnergyModel(model);
     // create and register energy model phy listener
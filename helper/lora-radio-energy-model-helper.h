@@ -38,6 +38,22 @@ class LoraRadioEnergyModelHelper : public DeviceEnergyModelHelper
      */
     void Set(std::string name, const AttributeValue& v) override;
 
+    /**
+     * \param callback Callback function for energy depletion handling.
+     *
+     * Sets the callback invoked when the energy source is depleted. If none is set, the
+     * EndDeviceLoraPhy stops listening to the channel until the source is recharged.
+     */
+    void SetDepletionCallback(LoraRadioEnergyModel::LoraRadioEnergyDepletionCallback callback);
+
+    /**
+     * \param callback Callback function for energy recharged handling.
+     *
+     * Sets the callback invoked when the energy source is recharged. If none is set, the
+     * EndDeviceLoraPhy starts listening to the channel again.
+     */
+    void SetRechargedCallback(LoraRadioEnergyModel::LoraRadioEnergyRechargedCallback callback);
+
     /**
      * \param name The name of the model to set.
      * \param n0 The name of the attribute to set.
@@ -91,6 +107,10 @@ class LoraRadioEnergyModelHelper : public DeviceEnergyModelHelper
   private:
     ObjectFactory m_radioEnergy;    ///< radio energy
     ObjectFactory m_txCurrentModel; ///< transmit current model
+    LoraRadioEnergyModel::LoraRadioEnergyDepletionCallback
+        m_depletionCallback; ///< energy depletion callback
+    LoraRadioEnergyModel::LoraRadioEnergyRechargedCallback
+        m_rechargedCallback; ///< energy recharged callback
 };
 
 } // namespace lorawan
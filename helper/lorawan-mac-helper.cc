@@ -14,6 +14,9 @@
 #include "ns3/lora-net-device.h"
 #include "ns3/random-variable-stream.h"
 
+#include <algorithm>
+#include <limits>
+
 namespace ns3
 {
 namespace lorawan
@@ -22,7 +25,8 @@ namespace lorawan
 NS_LOG_COMPONENT_DEFINE("LorawanMacHelper");
 
 LorawanMacHelper::LorawanMacHelper()
-    : m_region(LorawanMacHelper::EU)
+    : m_region(LorawanMacHelper::EU),
+      m_shareChannelPlans(true)
 {
 }
 
@@ -62,6 +66,12 @@ LorawanMacHelper::SetRegion(enum LorawanMacHelper::Regions region)
     m_region = region;
 }
 
+void
+LorawanMacHelper::SetShareChannelPlans(bool share)
+{
+    m_shareChannelPlans = share;
+}
+
 Ptr<LorawanMac>
 LorawanMacHelper::Create(Ptr<Node> node, Ptr<NetDevice> device) const
 {
@@ -200,16 +210,24 @@ LorawanMacHelper::ApplyCommonAlohaConfigurations(Ptr<LorawanMac> lorawanMac) con
     // SubBands //
     //////////////
 
-    Ptr<LogicalLoraChannelHelper> channelHelper = CreateObject<LogicalLoraChannelHelper>();
-    channelHelper->AddSubBand(868, 868.6, 1, 14);
+    Ptr<LogicalLoraChannelPlan> plan = m_shareChannelPlans ? m_alohaPlan : nullptr;
+    if (!plan)
+    {
+        plan = ns3::Create<LogicalLoraChannelPlan>();
+        plan->AddSubBand(CreateObject<SubBand>(868, 868.6, 1, 14));
 
-    //////////////////////
-    // Default channels //
-    //////////////////////
-    Ptr<LogicalLoraChannel> lc1 = CreateObject<LogicalLoraChannel>(868.1, 0, 5);
-    channelHelper->AddChannel(lc1);
+        //////////////////////
+        // Default channels //
+        //////////////////////
+        plan->AddChannel(CreateObject<LogicalLoraChannel>(868.1, 0, 5));
 
-    lorawanMac->SetLogicalLoraChannelHelper(channelHelper);
+        if (m_shareChannelPlans)
+        {
+            m_alohaPlan = plan;
+        }
+    }
+
+    lorawanMac->SetLogicalLoraChannelHelper(CreateObject<LogicalLoraChannelHelper>(plan));
 
     ///////////////////////////////////////////////////////////
     // Data rate -> Spreading factor, Data rate -> Bandwidth //
@@ -306,22 +324,28 @@ LorawanMacHelper::ApplyCommonEuConfigurations(Ptr<LorawanMac> lorawanMac) const
     // SubBands //
     //////////////
 
-    Ptr<LogicalLoraChannelHelper> channelHelper = CreateObject<LogicalLoraChannelHelper>();
-    channelHelper->AddSubBand(868, 868.6, 0.01, 14);
-    channelHelper->AddSubBand(868.7, 869.2, 0.001, 14);
-    channelHelper->AddSubBand(869.4, 869.65, 0.1, 27);
-
-    //////////////////////
-    // Default channels //
-    //////////////////////
-    Ptr<LogicalLoraChannel> lc1 = CreateObject<LogicalLoraChannel>(868.1, 0, 5);
-    Ptr<LogicalLoraChannel> lc2 = CreateObject<LogicalLoraChannel>(868.3, 0, 5);
-    Ptr<LogicalLoraChannel> lc3 = CreateObject<LogicalLoraChannel>(868.5, 0, 5);
-    channelHelper->AddChannel(lc1);
-    channelHelper->AddChannel(lc2);
-    channelHelper->AddChannel(lc3);
+    Ptr<LogicalLoraChannelPlan> plan = m_shareChannelPlans ? m_euPlan : nullptr;
+    if (!plan)
+    {
+        plan = ns3::Create<LogicalLoraChannelPlan>();
+        plan->AddSubBand(CreateObject<SubBand>(868, 868.6, 0.01, 14));
+        plan->AddSubBand(CreateObject<SubBand>(868.7, 869.2, 0.001, 14));
+        plan->AddSubBand(CreateObject<SubBand>(869.4, 869.65, 0.1, 27));
+
+        //////////////////////
+        // Default channels //
+        //////////////////////
+        plan->AddChannel(CreateObject<LogicalLoraChannel>(868.1, 0, 5));
+        plan->AddChannel(CreateObject<LogicalLoraChannel>(868.3, 0, 5));
+        plan->AddChannel(CreateObject<LogicalLoraChannel>(868.5, 0, 5));
+
+        if (m_shareChannelPlans)
+        {
+            m_euPlan = plan;
+        }
+    }
 
-    lorawanMac->SetLogicalLoraChannelHelper(channelHelper);
+    lorawanMac->SetLogicalLoraChannelHelper(CreateObject<LogicalLoraChannelHelper>(plan));
 
     ///////////////////////////////////////////////////////////
     // Data rate -> Spreading factor, Data rate -> Bandwidth //
@@ -418,18 +442,26 @@ LorawanMacHelper::ApplyCommonSingleChannelConfigurations(Ptr<LorawanMac> lorawan
     // SubBands //
     //////////////
 
-    Ptr<LogicalLoraChannelHelper> channelHelper = CreateObject<LogicalLoraChannelHelper>();
-    channelHelper->AddSubBand(868, 868.6, 0.01, 14);
-    channelHelper->AddSubBand(868.7, 869.2, 0.001, 14);
-    channelHelper->AddSubBand(869.4, 869.65, 0.1, 27);
+    Ptr<LogicalLoraChannelPlan> plan = m_shareChannelPlans ? m_singleChannelPlan : nullptr;
+    if (!plan)
+    {
+        plan = ns3::Create<LogicalLoraChannelPlan>();
+        plan->AddSubBand(CreateObject<SubBand>(868, 868.6, 0.01, 14));
+        plan->AddSubBand(CreateObject<SubBand>(868.7, 869.2, 0.001, 14));
+        plan->AddSubBand(CreateObject<SubBand>(869.4, 869.65, 0.1, 27));
+
+        //////////////////////
+        // Default channels //
+        //////////////////////
+        plan->AddChannel(CreateObject<LogicalLoraChannel>(868.1, 0, 5));
 
-    //////////////////////
-    // Default channels //
-    //////////////////////
-    Ptr<LogicalLoraChannel> lc1 = CreateObject<LogicalLoraChannel>(868.1, 0, 5);
-    channelHelper->AddChannel(lc1);
+        if (m_shareChannelPlans)
+        {
+            m_singleChannelPlan = plan;
+        }
+    }
 
-    lorawanMac->SetLogicalLoraChannelHelper(channelHelper);
+    lorawanMac->SetLogicalLoraChannelHelper(CreateObject<LogicalLoraChannelHelper>(plan));
 
     ///////////////////////////////////////////////////////////
     // Data rate -> Spreading factor, Data rate -> Bandwidth //
@@ -450,6 +482,14 @@ LorawanMacHelper::SetSpreadingFactorsUp(NodeContainer endDevices,
     NS_LOG_FUNCTION_NOARGS();
 
     std::vector<int> sfQuantity(7, 0);
+
+    std::vector<Ptr<MobilityModel>> gatewayPositions;
+    for (auto currentGw = gateways.Begin(); currentGw != gateways.End(); ++currentGw)
+    {
+        gatewayPositions.push_back((*currentGw)->GetObject<MobilityModel>());
+    }
+    std::vector<double> gatewayRxPowers;
+
     for (auto j = endDevices.Begin(); j != endDevices.End(); ++j)
     {
         Ptr<Node> object = *j;
@@ -462,25 +502,20 @@ LorawanMacHelper::SetSpreadingFactorsUp(NodeContainer endDevices,
             DynamicCast<ClassAEndDeviceLorawanMac>(loraNetDevice->GetMac());
         NS_ASSERT(mac);
 
-        // Try computing the distance from each gateway and find the best one
-        Ptr<Node> bestGateway = gateways.Get(0);
-        Ptr<MobilityModel> bestGatewayPosition = bestGateway->GetObject<MobilityModel>();
+        // Compute the power received by all gateways at once, assuming devices
+        // transmit at 14 dBm
+        channel->GetRxPowers(14, position, gatewayPositions, gatewayRxPowers);
 
-        // Assume devices transmit at 14 dBm
-        double highestRxPower = channel->GetRxPower(14, position, bestGatewayPosition);
+        // Find the best gateway
+        Ptr<Node> bestGateway = gateways.Get(0);
+        double highestRxPower = gatewayRxPowers[0];
 
-        for (auto currentGw = gateways.Begin() + 1; currentGw != gateways.End(); ++currentGw)
+        for (uint32_t currentGw = 1; currentGw < gateways.GetN(); ++currentGw)
         {
-            // Compute the power received from the current gateway
-            Ptr<Node> curr = *currentGw;
-            Ptr<MobilityModel> currPosition = curr->GetObject<MobilityModel>();
-            double currentRxPower = channel->GetRxPower(14, position, currPosition); // dBm
-
-            if (currentRxPower > highestRxPower)
+            if (gatewayRxPowers[currentGw] > highestRxPower)
             {
-                bestGateway = curr;
-                bestGatewayPosition = currPosition;
-                highestRxPower = currentRxPower;
+                bestGateway = gateways.Get(currentGw);
+                highestRxPower = gatewayRxPowers[currentGw];
             }
         }
 
@@ -585,6 +620,50 @@ LorawanMacHelper::SetSpreadingFactorsUp(NodeContainer endDevices,
 
 } //  end function
 
+std::vector<int>
+LorawanMacHelper::SetSpreadingFactorsUp(Ptr<LoraEndDevicePopulation> population,
+                                        NodeContainer gateways,
+                                        Ptr<LoraChannel> channel)
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    std::vector<int> sfQuantity(7, 0);
+
+    // Keep the highest power received by a gateway from each device, assuming
+    // devices transmit at 14 dBm
+    std::vector<double> highestRxPowers(population->GetN(),
+                                        -std::numeric_limits<double>::infinity());
+    std::vector<double> gatewayRxPowers;
+    for (auto currentGw = gateways.Begin(); currentGw != gateways.End(); ++currentGw)
+    {
+        Ptr<MobilityModel> gwMobility = (*currentGw)->GetObject<MobilityModel>();
+        NS_ASSERT(gwMobility);
+        channel->GetRxPowers(14,
+                             gwMobility->GetPosition(),
+                             population->GetPositions(),
+                             gatewayRxPowers);
+        for (uint32_t i = 0; i < population->GetN(); i++)
+        {
+            highestRxPowers[i] = std::max(highestRxPowers[i], gatewayRxPowers[i]);
+        }
+    }
+
+    const double* edSensitivity = EndDeviceLoraPhy::sensitivity;
+    for (uint32_t i = 0; i < population->GetN(); i++)
+    {
+        // The first sensitivity the power is above gives the data rate, from DR5 down
+        int k = 0;
+        while (k < 6 && highestRxPowers[i] <= edSensitivity[k])
+        {
+            k++;
+        }
+        population->SetDataRate(i, k < 6 ? 5 - k : 0);
+        sfQuantity[k]++;
+    }
+
+    return sfQuantity;
+}
+
 std::vector<int>
 LorawanMacHelper::SetSpreadingFactorsGivenDistribution(NodeContainer endDevices,
                                                        NodeContainer gateways,
@@ -661,5 +740,28 @@ LorawanMacHelper::SetSpreadingFactorsGivenDistribution(NodeContainer endDevices,
 
 } //  end function
 
+std::size_t
+LorawanMacHelper::GetChannelPlanBytesPerDevice(NodeContainer nodes)
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    if (nodes.GetN() == 0)
+    {
+        return 0;
+    }
+
+    std::size_t bytes = 0;
+    for (auto node = nodes.Begin(); node != nodes.End(); ++node)
+    {
+        Ptr<LoraNetDevice> loraNetDevice = DynamicCast<LoraNetDevice>((*node)->GetDevice(0));
+        NS_ASSERT(loraNetDevice);
+        Ptr<LogicalLoraChannelHelper> channelHelper =
+            loraNetDevice->GetMac()->GetLogicalLoraChannelHelper();
+        bytes += channelHelper->GetMemoryUsage();
+    }
+
+    return bytes / nodes.GetN();
+}
+
 } // namespace lorawan
 } // namespace ns3
@@ -11,8 +11,10 @@
 
 #include "ns3/class-a-end-device-lorawan-mac.h"
 #include "ns3/gateway-lorawan-mac.h"
+#include "ns3/logical-lora-channel-plan.h"
 #include "ns3/lora-channel.h"
 #include "ns3/lora-device-address-generator.h"
+#include "ns3/lora-end-device-population.h"
 #include "ns3/lora-phy.h"
 #include "ns3/lorawan-mac.h"
 #include "ns3/net-device.h"
@@ -90,6 +92,19 @@ class LorawanMacHelper
      */
     void SetRegion(enum Regions region);
 
+    /**
+     * Set whether the MACs created by this helper share the channels and
+     * SubBands of their region.
+     *
+     * When sharing is enabled (the default), all devices configured for the
+     * same region use a single LogicalLoraChannelPlan, and only keep their
+     * channel mask and duty cycle timers. A device copies the plan the first
+     * time its channels are changed, for instance by a NewChannelReq.
+     *
+     * \param share Whether channel plans are shared.
+     */
+    void SetShareChannelPlans(bool share);
+
     /**
      * Create the LorawanMac instance and connect it to a device.
      *
@@ -137,6 +152,22 @@ class LorawanMacHelper
                                                   NodeContainer gateways,
                                                   Ptr<LoraChannel> channel);
 
+    /**
+     * Set up the data rate of the devices of a population as SetSpreadingFactorsUp does for
+     * end device nodes, and return the same DR distribution vector.
+     *
+     * The power received from each gateway is computed for all devices at once, assuming
+     * links are reciprocal.
+     *
+     * \param population The population of end devices to configure.
+     * \param gateways The gateways to consider for RSSI measurements.
+     * \param channel The radio channel to consider for RSSI measurements.
+     * \return A vector containing the final number of devices per DR.
+     */
+    static std::vector<int> SetSpreadingFactorsUp(Ptr<LoraEndDevicePopulation> population,
+                                                  NodeContainer gateways,
+                                                  Ptr<LoraChannel> channel);
+
     /**
      * Randomly initialize the end devices' data rate parameter according to the given
      * distribution.
@@ -176,6 +207,15 @@ class LorawanMacHelper
                                                                  NodeContainer gateways,
                                                                  std::vector<double> distribution);
 
+    /**
+     * Get the average memory used by the channel configuration of a set of
+     * devices, i.e., by their LogicalLoraChannelHelper and channel plan.
+     *
+     * \param nodes The nodes, each with a LoraNetDevice as its first device.
+     * \return The average number of bytes per device.
+     */
+    static std::size_t GetChannelPlanBytesPerDevice(NodeContainer nodes);
+
   private:
     /**
      * Perform region-specific configurations for the 868 MHz EU band.
@@ -247,6 +287,11 @@ class LorawanMacHelper
     Ptr<LoraDeviceAddressGenerator> m_addrGen; //!< Pointer to the address generator to use
     enum DeviceType m_deviceType;              //!< The kind of device to install
     enum Regions m_region;                     //!< The region in which the device will operate
+    bool m_shareChannelPlans;                  //!< Whether devices share channel plans
+
+    mutable Ptr<LogicalLoraChannelPlan> m_euPlan;            //!< Shared EU channel plan
+    mutable Ptr<LogicalLoraChannelPlan> m_singleChannelPlan; //!< Shared single channel plan
+    mutable Ptr<LogicalLoraChannelPlan> m_alohaPlan;         //!< Shared ALOHA channel plan
 };
 
 } // namespace lorawan
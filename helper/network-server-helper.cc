@@ -61,6 +61,12 @@ NetworkServerHelper::SetEndDevices(NodeContainer endDevices)
     m_endDevices = endDevices;
 }
 
+void
+NetworkServerHelper::SetEndDevicePopulation(Ptr<LoraEndDevicePopulation> population)
+{
+    m_population = population;
+}
+
 ApplicationContainer
 NetworkServerHelper::Install(Ptr<Node> node)
 {
@@ -87,6 +93,10 @@ NetworkServerHelper::InstallPriv(Ptr<Node> node)
 
     // Add the end devices
     app->AddNodes(m_endDevices);
+    if (m_population)
+    {
+        app->AddPopulation(m_population);
+    }
 
     // Add components to the NetworkServer
     InstallComponents(app);
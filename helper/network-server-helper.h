@@ -83,6 +83,14 @@ class NetworkServerHelper
      */
     void SetEndDevices(NodeContainer endDevices);
 
+    /**
+     * Set a population of end devices that will be managed by this network server, in
+     * addition to the end device nodes.
+     *
+     * \param population The population of end devices.
+     */
+    void SetEndDevicePopulation(Ptr<LoraEndDevicePopulation> population);
+
     /**
      * Enable (true) or disable (false) the Adaptive Data Rate (ADR) component in the Network
      * Server created by this helper.
@@ -123,6 +131,7 @@ class NetworkServerHelper
     std::list<std::pair<Ptr<NetDevice>, Ptr<Node>>>
         m_gatewayRegistrationList; //!< List of gateway to register to this network server
     NodeContainer m_endDevices;    //!< Set of end devices to connect to this network server
+    Ptr<LoraEndDevicePopulation> m_population; //!< Population to connect to this network server
     bool m_adrEnabled; //!< Whether to enable the Adaptive Data Rate (ADR) algorithm on the
                        //!< NetworkServer application
     ObjectFactory m_adrSupportFactory; //!< Factory to create the Adaptive Data Rate (ADR) component
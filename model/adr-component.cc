@@ -70,12 +70,16 @@ AdrComponent::~AdrComponent()
 {
 }
 
+bool
+AdrComponent::HandlesMType(uint8_t mType) const
+{
+    return false;
+}
+
 void
-AdrComponent::OnReceivedPacket(Ptr<const Packet> packet,
-                               Ptr<EndDeviceStatus> status,
-                               Ptr<NetworkStatus> networkStatus)
+AdrComponent::OnReceivedPacket(const UplinkContext& context, Ptr<NetworkStatus> networkStatus)
 {
-    NS_LOG_FUNCTION(this->GetTypeId() << packet << networkStatus);
+    NS_LOG_FUNCTION(this->GetTypeId() << context.packet << networkStatus);
 
     // We will only act just before reply, when all Gateways will have received
     // the packet, since we need their respective received power.
@@ -86,15 +90,10 @@ AdrComponent::BeforeSendingReply(Ptr<EndDeviceStatus> status, Ptr<NetworkStatus>
 {
     NS_LOG_FUNCTION(this << status << networkStatus);
 
-    Ptr<Packet> myPacket = status->GetLastPacketReceivedFromDevice()->Copy();
-    LorawanMacHeader mHdr;
-    LoraFrameHeader fHdr;
-    fHdr.SetAsUplink();
-    myPacket->RemoveHeader(mHdr);
-    myPacket->RemoveHeader(fHdr);
+    LorawanFrameView frame(status->GetLastPacketReceivedFromDevice());
 
     // Execute the Adaptive Data Rate (ADR) algorithm only if the request bit is set
-    if (fHdr.GetAdr())
+    if (frame.GetAdr())
     {
         if (int(status->GetReceivedPacketList().size()) < historyRange)
         {
@@ -48,9 +48,16 @@ class AdrComponent : public NetworkControllerComponent
     AdrComponent();           //!< Default constructor
     ~AdrComponent() override; //!< Destructor
 
-    void OnReceivedPacket(Ptr<const Packet> packet,
-                          Ptr<EndDeviceStatus> status,
-                          Ptr<NetworkStatus> networkStatus) override;
+    /**
+     * The ADR algorithm only runs just before the reply, when all gateways have
+     * received the packet.
+     *
+     * \param mType The message type.
+     * \return False.
+     */
+    bool HandlesMType(uint8_t mType) const override;
+
+    void OnReceivedPacket(const UplinkContext& context, Ptr<NetworkStatus> networkStatus) override;
 
     void BeforeSendingReply(Ptr<EndDeviceStatus> status, Ptr<NetworkStatus> networkStatus) override;
 
@@ -15,6 +15,7 @@
 #include "end-device-lora-phy.h"
 #include "end-device-lorawan-mac.h"
 
+#include "ns3/boolean.h"
 #include "ns3/log.h"
 
 #include <algorithm>
@@ -31,10 +32,17 @@ NS_OBJECT_ENSURE_REGISTERED(ClassAEndDeviceLorawanMac);
 TypeId
 ClassAEndDeviceLorawanMac::GetTypeId()
 {
-    static TypeId tid = TypeId("ns3::ClassAEndDeviceLorawanMac")
-                            .SetParent<EndDeviceLorawanMac>()
-                            .SetGroupName("lorawan")
-                            .AddConstructor<ClassAEndDeviceLorawanMac>();
+    static TypeId tid =
+        TypeId("ns3::ClassAEndDeviceLorawanMac")
+            .SetParent<EndDeviceLorawanMac>()
+            .SetGroupName("lorawan")
+            .AddConstructor<ClassAEndDeviceLorawanMac>()
+            .AddAttribute("LazyReceiveWindows",
+                          "Whether the receive windows of unconfirmed uplinks are only opened "
+                          "by events if a signal arrives during them",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&ClassAEndDeviceLorawanMac::m_lazyReceiveWindows),
+                          MakeBooleanChecker());
     return tid;
 }
 
@@ -43,7 +51,12 @@ ClassAEndDeviceLorawanMac::ClassAEndDeviceLorawanMac()
       m_receiveDelay1(Seconds(1)),
       // LoraWAN default
       m_receiveDelay2(Seconds(2)),
-      m_rx1DrOffset(0)
+      m_rx1DrOffset(0),
+      m_lazyReceiveWindows(false),
+      m_lazyWindowsPending(false),
+      m_firstWindowEnd(Seconds(0)),
+      m_secondWindowStart(Seconds(0)),
+      m_secondWindowEnd(Seconds(0))
 {
     NS_LOG_FUNCTION(this);
 
@@ -74,6 +87,10 @@ ClassAEndDeviceLorawanMac::SendToPhy(Ptr<Packet> packetToSend)
 
     NS_LOG_DEBUG("PacketToSend: " << packetToSend);
 
+    // The lazy windows of the previous uplink are over, even if the event
+    // resolving them is scheduled at this same time after us
+    ResolveLazyReceiveWindows();
+
     // Data rate adaptation as in LoRaWAN specification, V1.0.2 (2016)
     if (m_enableDRAdapt && (m_dataRate > 0) && (m_retxParams.retxLeft < m_maxNumbTx) &&
         (m_retxParams.retxLeft % 2 == 0))
@@ -265,6 +282,36 @@ ClassAEndDeviceLorawanMac::TxFinished(Ptr<const Packet> packet)
 {
     NS_LOG_FUNCTION_NOARGS();
 
+    Ptr<EndDeviceLoraPhy> phy = DynamicCast<EndDeviceLoraPhy>(m_phy);
+
+    Time firstWindowStart = Simulator::Now() + m_receiveDelay1;
+    m_firstWindowEnd =
+        firstWindowStart + GetReceiveWindowDuration(GetFirstReceiveWindowDataRate());
+    m_secondWindowStart = Simulator::Now() + m_receiveDelay2;
+    m_secondWindowEnd =
+        m_secondWindowStart + GetReceiveWindowDuration(GetSecondReceiveWindowDataRate());
+
+    // Retransmissions of confirmed uplinks are driven by the window events
+    if (m_lazyReceiveWindows && !m_retxParams.waitingAck)
+    {
+        NS_LOG_DEBUG("Registering lazy receive windows");
+
+        // Sleep first, so that the PHY keeps listening during the windows
+        phy->SwitchToSleep();
+        phy->SetLazyReceiveWindowCallback(
+            MakeCallback(&ClassAEndDeviceLorawanMac::OpenLazyReceiveWindow, this));
+        phy->AddLazyReceiveWindow(firstWindowStart, m_firstWindowEnd);
+        phy->AddLazyReceiveWindow(m_secondWindowStart, m_secondWindowEnd);
+        m_lazyWindowsPending = true;
+
+        // A single event replaces those opening and closing the windows
+        m_resolveLazyWindows =
+            Simulator::Schedule(m_secondWindowEnd - Simulator::Now(),
+                                &ClassAEndDeviceLorawanMac::ResolveLazyReceiveWindows,
+                                this);
+        return;
+    }
+
     // Schedule the opening of the first receive window
     Simulator::Schedule(m_receiveDelay1, &ClassAEndDeviceLorawanMac::OpenFirstReceiveWindow, this);
 
@@ -282,7 +329,7 @@ ClassAEndDeviceLorawanMac::TxFinished(Ptr<const Packet> packet)
     //                                              this);
 
     // Switch the PHY to sleep
-    DynamicCast<EndDeviceLoraPhy>(m_phy)->SwitchToSleep();
+    phy->SwitchToSleep();
 }
 
 void
@@ -293,16 +340,13 @@ ClassAEndDeviceLorawanMac::OpenFirstReceiveWindow()
     // Set Phy in Standby mode
     DynamicCast<EndDeviceLoraPhy>(m_phy)->SwitchToStandby();
 
-    // Calculate the duration of a single symbol for the first receive window data rate
-    double tSym = pow(2, GetSfFromDataRate(GetFirstReceiveWindowDataRate())) /
-                  GetBandwidthFromDataRate(GetFirstReceiveWindowDataRate());
-
     // Schedule return to sleep after "at least the time required by the end
     // device's radio transceiver to effectively detect a downlink preamble"
     // (LoraWAN specification)
-    m_closeFirstWindow = Simulator::Schedule(Seconds(m_receiveWindowDurationInSymbols * tSym),
-                                             &ClassAEndDeviceLorawanMac::CloseFirstReceiveWindow,
-                                             this); // m_receiveWindowDuration
+    m_closeFirstWindow =
+        Simulator::Schedule(GetReceiveWindowDuration(GetFirstReceiveWindowDataRate()),
+                            &ClassAEndDeviceLorawanMac::CloseFirstReceiveWindow,
+                            this); // m_receiveWindowDuration
 }
 
 void
@@ -359,16 +403,13 @@ ClassAEndDeviceLorawanMac::OpenSecondReceiveWindow()
     DynamicCast<EndDeviceLoraPhy>(m_phy)->SetSpreadingFactor(
         GetSfFromDataRate(m_secondReceiveWindowDataRate));
 
-    // Calculate the duration of a single symbol for the second receive window data rate
-    double tSym = pow(2, GetSfFromDataRate(GetSecondReceiveWindowDataRate())) /
-                  GetBandwidthFromDataRate(GetSecondReceiveWindowDataRate());
-
     // Schedule return to sleep after "at least the time required by the end
     // device's radio transceiver to effectively detect a downlink preamble"
     // (LoraWAN specification)
-    m_closeSecondWindow = Simulator::Schedule(Seconds(m_receiveWindowDurationInSymbols * tSym),
-                                              &ClassAEndDeviceLorawanMac::CloseSecondReceiveWindow,
-                                              this);
+    Time duration = GetReceiveWindowDuration(GetSecondReceiveWindowDataRate());
+    m_secondWindowEnd = Simulator::Now() + duration;
+    m_closeSecondWindow =
+        Simulator::Schedule(duration, &ClassAEndDeviceLorawanMac::CloseSecondReceiveWindow, this);
 }
 
 void
@@ -439,6 +480,64 @@ ClassAEndDeviceLorawanMac::CloseSecondReceiveWindow()
     }
 }
 
+void
+ClassAEndDeviceLorawanMac::OpenLazyReceiveWindow()
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    Ptr<EndDeviceLoraPhy> phy = DynamicCast<EndDeviceLoraPhy>(m_phy);
+
+    // From now on, the windows are handled as if they had been opened by events
+    m_lazyWindowsPending = false;
+    m_resolveLazyWindows.Cancel();
+    phy->SwitchToStandby();
+    phy->ClearLazyReceiveWindows();
+
+    Time now = Simulator::Now();
+    if (now < m_secondWindowStart)
+    {
+        NS_LOG_INFO("Opening the first receive window on signal arrival");
+        m_closeFirstWindow =
+            Simulator::Schedule(m_firstWindowEnd - now,
+                                &ClassAEndDeviceLorawanMac::CloseFirstReceiveWindow,
+                                this);
+        m_secondReceiveWindow =
+            Simulator::Schedule(m_secondWindowStart - now,
+                                &ClassAEndDeviceLorawanMac::OpenSecondReceiveWindow,
+                                this);
+    }
+    else
+    {
+        NS_LOG_INFO("Opening the second receive window on signal arrival");
+        phy->SetFrequency(m_secondReceiveWindowFrequency);
+        phy->SetSpreadingFactor(GetSfFromDataRate(m_secondReceiveWindowDataRate));
+        m_closeSecondWindow =
+            Simulator::Schedule(m_secondWindowEnd - now,
+                                &ClassAEndDeviceLorawanMac::CloseSecondReceiveWindow,
+                                this);
+    }
+}
+
+void
+ClassAEndDeviceLorawanMac::ResolveLazyReceiveWindows()
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    if (!m_lazyWindowsPending)
+    {
+        return;
+    }
+    m_lazyWindowsPending = false;
+    m_resolveLazyWindows.Cancel();
+
+    DynamicCast<EndDeviceLoraPhy>(m_phy)->ClearLazyReceiveWindows();
+
+    // Report the unconfirmed uplink as CloseSecondReceiveWindow would have,
+    // since retransmission parameters are always reset while sending
+    // unconfirmed uplinks
+    m_requiredTxCallback(0, true, Seconds(0), nullptr);
+}
+
 /////////////////////////
 // Getters and Setters //
 /////////////////////////
@@ -453,16 +552,13 @@ ClassAEndDeviceLorawanMac::GetNextClassTransmissionDelay(Time waitingTime)
     if (!m_retxParams.waitingAck)
     {
         if (!m_closeFirstWindow.IsExpired() || !m_closeSecondWindow.IsExpired() ||
-            !m_secondReceiveWindow.IsExpired())
+            !m_secondReceiveWindow.IsExpired() ||
+            (m_lazyWindowsPending && Simulator::Now() < m_secondWindowEnd))
         {
             NS_LOG_WARN(
                 "Attempting to send when there are receive windows: Transmission postponed.");
-            // Compute the duration of a single symbol for the second receive window data rate
-            double tSym = pow(2, GetSfFromDataRate(GetSecondReceiveWindowDataRate())) /
-                          GetBandwidthFromDataRate(GetSecondReceiveWindowDataRate());
-            // Compute the closing time of the second receive window
-            Time endSecondRxWindow = Time(m_secondReceiveWindow.GetTs()) +
-                                     Seconds(m_receiveWindowDurationInSymbols * tSym);
+            // The closing time of the second receive window
+            Time endSecondRxWindow = m_secondWindowEnd;
 
             NS_LOG_DEBUG("Duration until endSecondRxWindow for new transmission:"
                          << (endSecondRxWindow - Simulator::Now()).GetSeconds());
@@ -487,6 +583,14 @@ ClassAEndDeviceLorawanMac::GetNextClassTransmissionDelay(Time waitingTime)
     return waitingTime;
 }
 
+Time
+ClassAEndDeviceLorawanMac::GetReceiveWindowDuration(uint8_t dataRate)
+{
+    // Duration of a single symbol at this data rate
+    double tSym = pow(2, GetSfFromDataRate(dataRate)) / GetBandwidthFromDataRate(dataRate);
+    return Seconds(m_receiveWindowDurationInSymbols * tSym);
+}
+
 uint8_t
 ClassAEndDeviceLorawanMac::GetFirstReceiveWindowDataRate()
 {
@@ -554,7 +658,11 @@ ClassAEndDeviceLorawanMac::OnRxClassParamSetupReq(Ptr<RxParamSetupReq> rxParamSe
 
     // Craft a RxParamSetupAns as response
     NS_LOG_INFO("Adding RxParamSetupAns reply");
-    m_macCommandList.emplace_back(CreateObject<RxParamSetupAns>(offsetOk, dataRateOk, true));
+    RxParamSetupAnsValue rxParamSetupAns;
+    rxParamSetupAns.rx1DrOffsetAck = offsetOk;
+    rxParamSetupAns.rx2DataRateAck = dataRateOk;
+    rxParamSetupAns.channelAck = true;
+    m_macCommandList.Add(rxParamSetupAns);
 }
 
 } /* namespace lorawan */
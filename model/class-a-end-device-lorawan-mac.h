@@ -91,6 +91,12 @@ class ClassAEndDeviceLorawanMac : public EndDeviceLorawanMac
      */
     void CloseSecondReceiveWindow();
 
+    /**
+     * Switch to event-driven handling of the receive windows registered lazily
+     * with the PHY, because a signal arrived during one of them.
+     */
+    void OpenLazyReceiveWindow();
+
     /////////////////////////
     // Getters and Setters //
     /////////////////////////
@@ -156,6 +162,23 @@ class ClassAEndDeviceLorawanMac : public EndDeviceLorawanMac
     void OnRxClassParamSetupReq(Ptr<RxParamSetupReq> rxParamSetupReq) override;
 
   private:
+    /**
+     * Compute how long a receive window stays open.
+     *
+     * \param dataRate The data rate listened for during the window.
+     * \return The duration of the window.
+     */
+    Time GetReceiveWindowDuration(uint8_t dataRate);
+
+    /**
+     * Fire the trace of an unconfirmed uplink whose lazy receive windows
+     * elapsed without a downlink, and drop the windows from the PHY.
+     *
+     * This is scheduled at the end of the second receive window, when
+     * CloseSecondReceiveWindow would have run.
+     */
+    void ResolveLazyReceiveWindows();
+
     Time m_receiveDelay1; //!< The interval between when a packet is done sending and when the first
                           //!< receive window is opened.
 
@@ -187,6 +210,13 @@ class ClassAEndDeviceLorawanMac : public EndDeviceLorawanMac
      */
     EventId m_secondReceiveWindow;
 
+    /**
+     * The event resolving the lazy receive windows of the last uplink.
+     *
+     * This Event is canceled if a signal arrives during the windows.
+     */
+    EventId m_resolveLazyWindows;
+
     /**
      * The frequency to listen on for the second receive window.
      */
@@ -202,6 +232,17 @@ class ClassAEndDeviceLorawanMac : public EndDeviceLorawanMac
      */
     uint8_t m_rx1DrOffset;
 
+    /**
+     * Whether the receive windows following unconfirmed uplinks are registered
+     * with the PHY as intervals instead of being opened and closed by events.
+     */
+    bool m_lazyReceiveWindows;
+
+    bool m_lazyWindowsPending; //!< Whether lazy windows were registered and not resolved yet
+    Time m_firstWindowEnd;     //!< The end of the last first receive window
+    Time m_secondWindowStart;  //!< The beginning of the last second receive window
+    Time m_secondWindowEnd;    //!< The end of the last second receive window
+
 }; /* ClassAEndDeviceLorawanMac */
 } /* namespace lorawan */
 } /* namespace ns3 */
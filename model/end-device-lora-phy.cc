@@ -32,6 +32,16 @@ EndDeviceLoraPhyListener::~EndDeviceLoraPhyListener()
 {
 }
 
+void
+EndDeviceLoraPhyListener::NotifyLazyReceiveWindow(Time start, Time end)
+{
+}
+
+void
+EndDeviceLoraPhyListener::NotifyLazyReceiveWindowsCleared()
+{
+}
+
 TypeId
 EndDeviceLoraPhy::GetTypeId()
 {
@@ -63,7 +73,8 @@ EndDeviceLoraPhy::GetTypeId()
 EndDeviceLoraPhy::EndDeviceLoraPhy()
     : m_state(SLEEP),
       m_frequency(868.1),
-      m_sf(7)
+      m_sf(7),
+      m_energyDepleted(false)
 {
 }
 
@@ -125,6 +136,12 @@ EndDeviceLoraPhy::SwitchToStandby()
 {
     NS_LOG_FUNCTION_NOARGS();
 
+    // Start listening again if we were not doing so
+    if (m_channel && !m_energyDepleted && (m_state == SLEEP || m_state == TX))
+    {
+        m_channel->Subscribe(this, Simulator::Now(), Time::Max());
+    }
+
     m_state = STANDBY;
 
     // Notify listeners of the state change
@@ -157,6 +174,11 @@ EndDeviceLoraPhy::SwitchToTx(double txPowerDbm)
 
     NS_ASSERT(m_state != RX);
 
+    if (m_channel)
+    {
+        m_channel->EndSubscriptions(this, Simulator::Now());
+    }
+
     m_state = TX;
 
     // Notify listeners of the state change
@@ -173,6 +195,11 @@ EndDeviceLoraPhy::SwitchToSleep()
 
     NS_ASSERT(m_state == STANDBY);
 
+    if (m_channel)
+    {
+        m_channel->EndSubscriptions(this, Simulator::Now());
+    }
+
     m_state = SLEEP;
 
     // Notify listeners of the state change
@@ -190,6 +217,95 @@ EndDeviceLoraPhy::GetState()
     return m_state;
 }
 
+void
+EndDeviceLoraPhy::HandleEnergyDepletion()
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    m_energyDepleted = true;
+
+    if (m_channel)
+    {
+        m_channel->Unsubscribe(this);
+    }
+}
+
+void
+EndDeviceLoraPhy::HandleEnergyRecharged()
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    m_energyDepleted = false;
+
+    if (m_channel && (m_state == STANDBY || m_state == RX))
+    {
+        m_channel->Subscribe(this, Simulator::Now(), Time::Max());
+    }
+}
+
+void
+EndDeviceLoraPhy::AddLazyReceiveWindow(Time start, Time end)
+{
+    NS_LOG_FUNCTION(this << start << end);
+
+    m_lazyReceiveWindows.emplace_back(start, end);
+
+    // Make sure signals arriving during the window are delivered
+    if (m_channel && !m_energyDepleted)
+    {
+        m_channel->Subscribe(this, start, end);
+    }
+
+    for (auto i = m_listeners.begin(); i != m_listeners.end(); i++)
+    {
+        (*i)->NotifyLazyReceiveWindow(start, end);
+    }
+}
+
+void
+EndDeviceLoraPhy::ClearLazyReceiveWindows()
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    if (m_lazyReceiveWindows.empty())
+    {
+        return;
+    }
+
+    m_lazyReceiveWindows.clear();
+
+    for (auto i = m_listeners.begin(); i != m_listeners.end(); i++)
+    {
+        (*i)->NotifyLazyReceiveWindowsCleared();
+    }
+}
+
+void
+EndDeviceLoraPhy::SetLazyReceiveWindowCallback(Callback<void> callback)
+{
+    m_lazyReceiveWindowCallback = callback;
+}
+
+void
+EndDeviceLoraPhy::OpenLazyReceiveWindow()
+{
+    if (m_state != SLEEP || m_lazyReceiveWindowCallback.IsNull())
+    {
+        return;
+    }
+
+    Time now = Simulator::Now();
+    for (const auto& window : m_lazyReceiveWindows)
+    {
+        if (window.first <= now && now < window.second)
+        {
+            NS_LOG_INFO("Signal arrived during a lazy receive window");
+            m_lazyReceiveWindowCallback();
+            return;
+        }
+    }
+}
+
 void
 EndDeviceLoraPhy::RegisterListener(EndDeviceLoraPhyListener* listener)
 {
@@ -20,6 +20,9 @@
 #include "ns3/object.h"
 #include "ns3/traced-value.h"
 
+#include <utility>
+#include <vector>
+
 namespace ns3
 {
 namespace lorawan
@@ -69,6 +72,22 @@ class EndDeviceLoraPhyListener
      * Notify listeners that we woke up.
      */
     virtual void NotifyStandby() = 0;
+
+    /**
+     * Notify listeners that we will listen during an interval without leaving
+     * the SLEEP state, unless a signal arrives during it. Listeners should
+     * account for the interval as if we were in STANDBY.
+     *
+     * \param start The time the interval begins.
+     * \param end The time the interval ends.
+     */
+    virtual void NotifyLazyReceiveWindow(Time start, Time end);
+
+    /**
+     * Notify listeners that the intervals announced with
+     * NotifyLazyReceiveWindow were dropped, because we switched state.
+     */
+    virtual void NotifyLazyReceiveWindowsCleared();
 };
 
 /**
@@ -223,6 +242,51 @@ class EndDeviceLoraPhy : public LoraPhy
      */
     void UnregisterListener(EndDeviceLoraPhyListener* listener);
 
+    /**
+     * Stop listening to the channel because the energy source of the device is
+     * depleted.
+     *
+     * This method is typically connected to the energy depletion callback of
+     * the LoraRadioEnergyModel.
+     */
+    void HandleEnergyDepletion();
+
+    /**
+     * Resume listening to the channel, if the PHY is in a listening state,
+     * after the energy source of the device was recharged.
+     *
+     * This method is typically connected to the energy recharged callback of
+     * the LoraRadioEnergyModel.
+     */
+    void HandleEnergyRecharged();
+
+    /**
+     * Listen during an interval without switching to the STANDBY state.
+     *
+     * The PHY stays asleep, and its listeners account for the interval as if
+     * it were in STANDBY. If a signal arrives during the interval, the
+     * callback set with SetLazyReceiveWindowCallback is invoked before the
+     * signal is handled, so that the upper layer can switch the PHY to
+     * STANDBY and handle the rest of the window with state changes.
+     *
+     * \param start The time the interval begins.
+     * \param end The time the interval ends.
+     */
+    void AddLazyReceiveWindow(Time start, Time end);
+
+    /**
+     * Drop the intervals registered with AddLazyReceiveWindow.
+     */
+    void ClearLazyReceiveWindows();
+
+    /**
+     * Set the callback invoked when a signal arrives during a lazy receive
+     * window.
+     *
+     * \param callback The callback.
+     */
+    void SetLazyReceiveWindowCallback(Callback<void> callback);
+
     static const double sensitivity[6]; //!< The sensitivity vector of this device to different SFs
 
   protected:
@@ -233,6 +297,12 @@ class EndDeviceLoraPhy : public LoraPhy
      */
     void TxFinished(Ptr<const Packet> packet) override;
 
+    /**
+     * Invoke the lazy receive window callback if the PHY is asleep during a
+     * lazy receive window.
+     */
+    void OpenLazyReceiveWindow();
+
     /**
      * Switch to the RX state.
      */
@@ -267,6 +337,12 @@ class EndDeviceLoraPhy : public LoraPhy
 
     uint8_t m_sf; //!< The Spreading Factor this device is listening for
 
+    bool m_energyDepleted; //!< Whether the energy source of the device is depleted
+
+    std::vector<std::pair<Time, Time>>
+        m_lazyReceiveWindows;                //!< The intervals listened to while asleep
+    Callback<void> m_lazyReceiveWindowCallback; //!< Opens a lazy receive window on signal arrival
+
     /**
      * typedef for a list of EndDeviceLoraPhyListener.
      */
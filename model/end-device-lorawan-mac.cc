@@ -227,7 +227,7 @@ EndDeviceLorawanMac::DoSend(Ptr<Packet> packet)
         packet->AddHeader(macHdr);
 
         // Reset MAC command list
-        m_macCommandList.clear();
+        m_macCommandList.Clear();
 
         if (m_retxParams.waitingAck)
         {
@@ -354,55 +354,53 @@ EndDeviceLorawanMac::ParseCommands(LoraFrameHeader frameHeader)
         }
     }
 
-    std::list<Ptr<MacCommand>> commands = frameHeader.GetCommands();
-    std::list<Ptr<MacCommand>>::iterator it;
-    for (it = commands.begin(); it != commands.end(); it++)
+    const MacCommandList& commands = frameHeader.GetCommandValues();
+    for (std::size_t i = 0; i < commands.GetN(); i++)
     {
         NS_LOG_DEBUG("Iterating over the MAC commands...");
-        enum MacCommandType type = (*it)->GetCommandType();
+        const MacCommandValue& command = commands.Get(i);
+        enum MacCommandType type = GetMacCommandType(command);
         switch (type)
         {
         case (LINK_CHECK_ANS): {
             NS_LOG_DEBUG("Detected a LinkCheckAns command.");
 
-            // Cast the command
-            Ptr<LinkCheckAns> linkCheckAns = DynamicCast<LinkCheckAns>(*it);
+            const auto& linkCheckAns = std::get<LinkCheckAnsValue>(command);
 
             // Call the appropriate function to take action
-            OnLinkCheckAns(linkCheckAns->GetMargin(), linkCheckAns->GetGwCnt());
+            OnLinkCheckAns(linkCheckAns.margin, linkCheckAns.gwCnt);
 
             break;
         }
         case (LINK_ADR_REQ): {
             NS_LOG_DEBUG("Detected a LinkAdrReq command.");
 
-            // Cast the command
-            Ptr<LinkAdrReq> linkAdrReq = DynamicCast<LinkAdrReq>(*it);
+            const auto& linkAdrReq = std::get<LinkAdrReqValue>(command);
 
             // Call the appropriate function to take action
-            OnLinkAdrReq(linkAdrReq->GetDataRate(),
-                         linkAdrReq->GetTxPower(),
-                         linkAdrReq->GetEnabledChannelsList(),
-                         linkAdrReq->GetRepetitions());
+            OnLinkAdrReq(linkAdrReq.dataRate,
+                         linkAdrReq.txPower,
+                         linkAdrReq.GetEnabledChannelsList(),
+                         linkAdrReq.nbRep);
 
             break;
         }
         case (DUTY_CYCLE_REQ): {
             NS_LOG_DEBUG("Detected a DutyCycleReq command.");
 
-            // Cast the command
-            Ptr<DutyCycleReq> dutyCycleReq = DynamicCast<DutyCycleReq>(*it);
+            const auto& dutyCycleReq = std::get<DutyCycleReqValue>(command);
 
             // Call the appropriate function to take action
-            OnDutyCycleReq(dutyCycleReq->GetMaximumAllowedDutyCycle());
+            OnDutyCycleReq(dutyCycleReq.GetMaximumAllowedDutyCycle());
 
             break;
         }
         case (RX_PARAM_SETUP_REQ): {
             NS_LOG_DEBUG("Detected a RxParamSetupReq command.");
 
-            // Cast the command
-            Ptr<RxParamSetupReq> rxParamSetupReq = DynamicCast<RxParamSetupReq>(*it);
+            // The handlers of this command take the object
+            Ptr<RxParamSetupReq> rxParamSetupReq =
+                DynamicCast<RxParamSetupReq>(ToMacCommand(command));
 
             // Call the appropriate function to take action
             OnRxParamSetupReq(rxParamSetupReq);
@@ -412,9 +410,6 @@ EndDeviceLorawanMac::ParseCommands(LoraFrameHeader frameHeader)
         case (DEV_STATUS_REQ): {
             NS_LOG_DEBUG("Detected a DevStatusReq command.");
 
-            // Cast the command
-            Ptr<DevStatusReq> devStatusReq = DynamicCast<DevStatusReq>(*it);
-
             // Call the appropriate function to take action
             OnDevStatusReq();
 
@@ -423,14 +418,13 @@ EndDeviceLorawanMac::ParseCommands(LoraFrameHeader frameHeader)
         case (NEW_CHANNEL_REQ): {
             NS_LOG_DEBUG("Detected a NewChannelReq command.");
 
-            // Cast the command
-            Ptr<NewChannelReq> newChannelReq = DynamicCast<NewChannelReq>(*it);
+            const auto& newChannelReq = std::get<NewChannelReqValue>(command);
 
             // Call the appropriate function to take action
-            OnNewChannelReq(newChannelReq->GetChannelIndex(),
-                            newChannelReq->GetFrequency(),
-                            newChannelReq->GetMinDataRate(),
-                            newChannelReq->GetMaxDataRate());
+            OnNewChannelReq(newChannelReq.chIndex,
+                            newChannelReq.frequency,
+                            newChannelReq.minDataRate,
+                            newChannelReq.maxDataRate);
 
             break;
         }
@@ -460,10 +454,11 @@ EndDeviceLorawanMac::ApplyNecessaryOptions(LoraFrameHeader& frameHeader)
     frameHeader.SetFCnt(m_currentFCnt);
 
     // Add listed MAC commands
-    for (const auto& command : m_macCommandList)
+    for (std::size_t i = 0; i < m_macCommandList.GetN(); i++)
     {
+        const MacCommandValue& command = m_macCommandList.Get(i);
         NS_LOG_INFO("Applying a MAC Command of CID "
-                    << unsigned(MacCommand::GetCIDFromMacCommand(command->GetCommandType())));
+                    << unsigned(MacCommand::GetCIDFromMacCommand(GetMacCommandType(command))));
 
         frameHeader.AddCommand(command);
     }
@@ -510,27 +505,11 @@ EndDeviceLorawanMac::GetNextTransmissionDelay()
 
     //    Check duty cycle    //
 
-    // Pick a random channel to transmit on
-    std::vector<Ptr<LogicalLoraChannel>> logicalChannels;
-    logicalChannels =
-        m_channelHelper->GetEnabledChannelList(); // Use a separate list to do the shuffle
-    // logicalChannels = Shuffle (logicalChannels);
-
-    Time waitingTime = Time::Max();
-
-    // Try every channel
-    std::vector<Ptr<LogicalLoraChannel>>::iterator it;
-    for (it = logicalChannels.begin(); it != logicalChannels.end(); ++it)
-    {
-        // Pointer to the current channel
-        Ptr<LogicalLoraChannel> logicalChannel = *it;
-        double frequency = logicalChannel->GetFrequency();
+    // The earliest time any enabled channel can be used
+    Time waitingTime = m_channelHelper->GetMinWaitingTime();
 
-        waitingTime = std::min(waitingTime, m_channelHelper->GetWaitingTime(logicalChannel));
-
-        NS_LOG_DEBUG("Waiting time before the next transmission in channel with frequency "
-                     << frequency << " is = " << waitingTime.GetSeconds() << ".");
-    }
+    NS_LOG_DEBUG("Waiting time before the next transmission is = " << waitingTime.GetSeconds()
+                                                                   << ".");
 
     waitingTime = GetNextClassTransmissionDelay(waitingTime);
 
@@ -542,57 +521,9 @@ EndDeviceLorawanMac::GetChannelForTx()
 {
     NS_LOG_FUNCTION_NOARGS();
 
-    // Pick a random channel to transmit on
-    std::vector<Ptr<LogicalLoraChannel>> logicalChannels;
-    logicalChannels =
-        m_channelHelper->GetEnabledChannelList(); // Use a separate list to do the shuffle
-    logicalChannels = Shuffle(logicalChannels);
-
-    // Try every channel
-    std::vector<Ptr<LogicalLoraChannel>>::iterator it;
-    for (it = logicalChannels.begin(); it != logicalChannels.end(); ++it)
-    {
-        // Pointer to the current channel
-        Ptr<LogicalLoraChannel> logicalChannel = *it;
-        double frequency = logicalChannel->GetFrequency();
-
-        NS_LOG_DEBUG("Frequency of the current channel: " << frequency);
-
-        // Verify that we can send the packet
-        Time waitingTime = m_channelHelper->GetWaitingTime(logicalChannel);
-
-        NS_LOG_DEBUG("Waiting time for current channel = " << waitingTime.GetSeconds());
-
-        // Send immediately if we can
-        if (waitingTime == Seconds(0))
-        {
-            return *it;
-        }
-        else
-        {
-            NS_LOG_DEBUG("Packet cannot be immediately transmitted on "
-                         << "the current channel because of duty cycle limitations.");
-        }
-    }
-    return nullptr; // In this case, no suitable channel was found
-}
-
-std::vector<Ptr<LogicalLoraChannel>>
-EndDeviceLorawanMac::Shuffle(std::vector<Ptr<LogicalLoraChannel>> vector)
-{
-    NS_LOG_FUNCTION_NOARGS();
-
-    int size = vector.size();
-
-    for (int i = 0; i < size; ++i)
-    {
-        uint16_t random = std::floor(m_uniformRV->GetValue(0, size));
-        Ptr<LogicalLoraChannel> temp = vector.at(random);
-        vector.at(random) = vector.at(i);
-        vector.at(i) = temp;
-    }
-
-    return vector;
+    // Pick a random channel among those the duty cycle allows transmitting on.
+    // In this case, no suitable channel was found if nullptr is returned
+    return m_channelHelper->GetChannelForTx(m_uniformRV);
 }
 
 /////////////////////////
@@ -765,17 +696,17 @@ EndDeviceLorawanMac::OnLinkAdrReq(uint8_t dataRate,
     if (channelMaskOk && dataRateOk && txPowerOk)
     {
         // Cycle over all channels in the list
-        for (uint32_t i = 0; i < m_channelHelper->GetChannelList().size(); i++)
+        for (int i = 0; i < channelListSize; i++)
         {
             if (std::find(enabledChannels.begin(), enabledChannels.end(), i) !=
                 enabledChannels.end())
             {
-                m_channelHelper->GetChannelList().at(i)->SetEnabledForUplink();
+                m_channelHelper->EnableChannel(i);
                 NS_LOG_DEBUG("Channel " << i << " enabled");
             }
             else
             {
-                m_channelHelper->GetChannelList().at(i)->DisableForUplink();
+                m_channelHelper->DisableChannel(i);
                 NS_LOG_DEBUG("Channel " << i << " disabled");
             }
         }
@@ -789,7 +720,11 @@ EndDeviceLorawanMac::OnLinkAdrReq(uint8_t dataRate,
 
     // Craft a LinkAdrAns MAC command as a response
     ///////////////////////////////////////////////
-    m_macCommandList.emplace_back(CreateObject<LinkAdrAns>(txPowerOk, dataRateOk, channelMaskOk));
+    LinkAdrAnsValue linkAdrAns;
+    linkAdrAns.powerAck = txPowerOk;
+    linkAdrAns.dataRateAck = dataRateOk;
+    linkAdrAns.channelMaskAck = channelMaskOk;
+    m_macCommandList.Add(linkAdrAns);
 }
 
 void
@@ -805,7 +740,7 @@ EndDeviceLorawanMac::OnDutyCycleReq(double dutyCycle)
 
     // Craft a DutyCycleAns as response
     NS_LOG_INFO("Adding DutyCycleAns reply");
-    m_macCommandList.emplace_back(CreateObject<DutyCycleAns>());
+    m_macCommandList.Add(DutyCycleAnsValue());
 }
 
 void
@@ -832,7 +767,10 @@ EndDeviceLorawanMac::OnDevStatusReq()
 
     // Craft a RxParamSetupAns as response
     NS_LOG_INFO("Adding DevStatusAns reply");
-    m_macCommandList.emplace_back(CreateObject<DevStatusAns>(battery, margin));
+    DevStatusAnsValue devStatusAns;
+    devStatusAns.battery = battery;
+    devStatusAns.margin = margin;
+    m_macCommandList.Add(devStatusAns);
 }
 
 void
@@ -852,7 +790,10 @@ EndDeviceLorawanMac::OnNewChannelReq(uint8_t chIndex,
     SetLogicalChannel(chIndex, frequency, minDataRate, maxDataRate);
 
     NS_LOG_INFO("Adding NewChannelAns reply");
-    m_macCommandList.emplace_back(CreateObject<NewChannelAns>(dataRateRangeOk, channelFrequencyOk));
+    NewChannelAnsValue newChannelAns;
+    newChannelAns.dataRateRangeOk = dataRateRangeOk;
+    newChannelAns.channelFrequencyOk = channelFrequencyOk;
+    m_macCommandList.Add(newChannelAns);
 }
 
 void
@@ -909,7 +850,7 @@ EndDeviceLorawanMac::AddMacCommand(Ptr<MacCommand> macCommand)
 {
     NS_LOG_FUNCTION(this << macCommand);
 
-    m_macCommandList.push_back(macCommand);
+    m_macCommandList.Add(ToMacCommandValue(macCommand));
 }
 
 uint8_t
@@ -401,7 +401,7 @@ class EndDeviceLorawanMac : public LorawanMac
     /**
      * List of the MAC commands that need to be applied to the next UL packet.
      */
-    std::list<Ptr<MacCommand>> m_macCommandList;
+    MacCommandList m_macCommandList;
 
     /**
      * Structure containing the retransmission parameters for this device.
@@ -409,8 +409,8 @@ class EndDeviceLorawanMac : public LorawanMac
     struct LoraRetxParameters m_retxParams;
 
     /**
-     * An uniform random variable, used by the Shuffle method to randomly reorder
-     * the channel list.
+     * An uniform random variable, used to pick a random channel for each
+     * transmission.
      */
     Ptr<UniformRandomVariable> m_uniformRV;
 
@@ -424,16 +424,6 @@ class EndDeviceLorawanMac : public LorawanMac
     TracedCallback<uint8_t, bool, Time, Ptr<Packet>> m_requiredTxCallback;
 
   private:
-    /**
-     * Randomly shuffle a Ptr<LogicalLoraChannel> vector.
-     *
-     * Used to pick a random channel on which to send the packet.
-     *
-     * \param vector The vector of pointers to logical LoRa channels.
-     * \return The shuffled vector.
-     */
-    std::vector<Ptr<LogicalLoraChannel>> Shuffle(std::vector<Ptr<LogicalLoraChannel>> vector);
-
     /**
      * Find the base minimum waiting time before the next possible transmission.
      *
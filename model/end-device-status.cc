@@ -10,8 +10,8 @@
 #include "end-device-status.h"
 
 #include "lora-frame-header.h"
-#include "lora-tag.h"
 #include "lorawan-mac-header.h"
+#include "uplink-context.h"
 
 #include "ns3/command-line.h"
 #include "ns3/log.h"
@@ -117,13 +117,8 @@ EndDeviceStatus::GetCompleteReplyPacket()
 
     // Add headers
     m_reply.frameHeader.SetAddress(m_endDeviceAddress);
-    Ptr<Packet> lastPacket = GetLastPacketReceivedFromDevice()->Copy();
-    LorawanMacHeader mHdr;
-    LoraFrameHeader fHdr;
-    fHdr.SetAsUplink();
-    lastPacket->RemoveHeader(mHdr);
-    lastPacket->RemoveHeader(fHdr);
-    m_reply.frameHeader.SetFCnt(fHdr.GetFCnt());
+    NS_ASSERT_MSG(!m_receivedPacketList.empty(), "Reply to a device that never sent a packet");
+    m_reply.frameHeader.SetFCnt(m_receivedPacketList.back().second.fCnt);
     m_reply.macHeader.SetMType(LorawanMacHeader::UNCONFIRMED_DATA_DOWN);
     replyPacket->AddHeader(m_reply.frameHeader);
     replyPacket->AddHeader(m_reply.macHeader);
@@ -234,30 +229,24 @@ EndDeviceStatus::InsertReceivedPacket(Ptr<const Packet> receivedPacket, const Ad
 {
     NS_LOG_FUNCTION_NOARGS();
 
-    // Create a copy of the packet
-    Ptr<Packet> myPacket = receivedPacket->Copy();
-
-    // Extract the headers
-    LorawanMacHeader macHdr;
-    myPacket->RemoveHeader(macHdr);
+    InsertReceivedPacket(UplinkContext(receivedPacket, gwAddress));
+}
 
-    LoraFrameHeader frameHdr;
-    frameHdr.SetAsUplink();
-    myPacket->RemoveHeader(frameHdr);
+void
+EndDeviceStatus::InsertReceivedPacket(const UplinkContext& context)
+{
+    NS_LOG_FUNCTION_NOARGS();
 
     // Update current parameters
-    LoraTag tag;
-    myPacket->RemovePacketTag(tag);
-    SetFirstReceiveWindowSpreadingFactor(tag.GetSpreadingFactor());
-    SetFirstReceiveWindowFrequency(tag.GetFrequency());
+    SetFirstReceiveWindowSpreadingFactor(context.sf);
+    SetFirstReceiveWindowFrequency(context.frequency);
 
     // Update Information on the received packet
     ReceivedPacketInfo info;
-    info.sf = tag.GetSpreadingFactor();
-    info.frequency = tag.GetFrequency();
-    info.packet = receivedPacket;
-
-    double rcvPower = tag.GetReceivePower();
+    info.sf = context.sf;
+    info.frequency = context.frequency;
+    info.packet = context.packet;
+    info.fCnt = context.frame.GetFCnt();
 
     // Perform insertion in list, also checking that the packet isn't already in
     // the list (it could have been already received by another gateway)
@@ -266,20 +255,13 @@ EndDeviceStatus::InsertReceivedPacket(Ptr<const Packet> receivedPacket, const Ad
     auto it = m_receivedPacketList.rbegin();
     for (; it != m_receivedPacketList.rend(); it++)
     {
-        // Get the frame counter of the current packet to compare it with the
-        // newly received one
-        Ptr<Packet> packetCopy = ((*it).first)->Copy();
-        LorawanMacHeader currentMacHdr;
-        packetCopy->RemoveHeader(currentMacHdr);
-        LoraFrameHeader currentFrameHdr;
-        frameHdr.SetAsUplink();
-        packetCopy->RemoveHeader(currentFrameHdr);
-
-        NS_LOG_DEBUG("Received packet's frame counter: " << unsigned(frameHdr.GetFCnt())
+        // Compare the frame counter of the current packet with the newly
+        // received one
+        NS_LOG_DEBUG("Received packet's frame counter: " << unsigned(info.fCnt)
                                                          << "\nCurrent packet's frame counter: "
-                                                         << unsigned(currentFrameHdr.GetFCnt()));
+                                                         << unsigned(it->second.fCnt));
 
-        if (frameHdr.GetFCnt() == currentFrameHdr.GetFCnt())
+        if (info.fCnt == it->second.fCnt)
         {
             NS_LOG_INFO("Packet was already received by another gateway");
 
@@ -288,10 +270,10 @@ EndDeviceStatus::InsertReceivedPacket(Ptr<const Packet> receivedPacket, const Ad
             GatewayList& gwList = it->second.gwList;
 
             PacketInfoPerGw gwInfo;
-            gwInfo.receivedTime = Simulator::Now();
-            gwInfo.rxPower = rcvPower;
-            gwInfo.gwAddress = gwAddress;
-            gwList.insert(std::pair<Address, PacketInfoPerGw>(gwAddress, gwInfo));
+            gwInfo.receivedTime = context.arrivalTime;
+            gwInfo.rxPower = context.rxPower;
+            gwInfo.gwAddress = context.gwAddress;
+            gwList.insert(std::pair<Address, PacketInfoPerGw>(context.gwAddress, gwInfo));
 
             NS_LOG_DEBUG("Size of gateway list: " << gwList.size());
 
@@ -302,11 +284,11 @@ EndDeviceStatus::InsertReceivedPacket(Ptr<const Packet> receivedPacket, const Ad
     {
         NS_LOG_INFO("Packet was received for the first time");
         PacketInfoPerGw gwInfo;
-        gwInfo.receivedTime = Simulator::Now();
-        gwInfo.rxPower = rcvPower;
-        gwInfo.gwAddress = gwAddress;
-        info.gwList.insert(std::pair<Address, PacketInfoPerGw>(gwAddress, gwInfo));
-        m_receivedPacketList.emplace_back(receivedPacket, info);
+        gwInfo.receivedTime = context.arrivalTime;
+        gwInfo.rxPower = context.rxPower;
+        gwInfo.gwAddress = context.gwAddress;
+        info.gwList.insert(std::pair<Address, PacketInfoPerGw>(context.gwAddress, gwInfo));
+        m_receivedPacketList.emplace_back(context.packet, info);
     }
     NS_LOG_DEBUG(*this);
 }
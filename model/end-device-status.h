@@ -26,6 +26,8 @@ namespace ns3
 namespace lorawan
 {
 
+struct UplinkContext;
+
 /**
  * \ingroup lorawan
  *
@@ -37,7 +39,7 @@ namespace lorawan
  * the parameters and information of the end device and the packets received
  * from it. Furthermore, this class holds the reply packet that the network
  * server will send to this device at the first available receive window. Upon
- * new packet arrivals at the network server, the OnReceivedPacket method is
+ * new packet arrivals at the network server, the InsertReceivedPacket method is
  * called to update the information regarding the last received packet and its
  * parameters.
  *
@@ -155,6 +157,7 @@ class EndDeviceStatus : public Object
         GatewayList gwList;                 //!< List of gateways that received this packet
         uint8_t sf;                         //!< Spreading factor used to send this packet
         double frequency;                   //!< Carrier frequency [MHz] used to send this packet
+        uint16_t fCnt = 0;                  //!< Frame counter of this packet
     };
 
     /**
@@ -288,6 +291,14 @@ class EndDeviceStatus : public Object
      */
     void InsertReceivedPacket(Ptr<const Packet> receivedPacket, const Address& gwAddress);
 
+    /**
+     * Insert a received packet in the packet list, using the information the
+     * network server already parsed from it.
+     *
+     * \param context The context of the received packet.
+     */
+    void InsertReceivedPacket(const UplinkContext& context);
+
     /**
      * Return the last packet that was received from this device.
      *
@@ -10,9 +10,14 @@
 
 #include "lora-tag.h"
 
+#include "ns3/abort.h"
+#include "ns3/boolean.h"
 #include "ns3/log-macros-enabled.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+
+#include <limits>
 
 namespace ns3
 {
@@ -26,8 +31,9 @@ NS_OBJECT_ENSURE_REGISTERED(GatewayLoraPhy);
 /**************************************
  *    ReceptionPath implementation    *
  **************************************/
-GatewayLoraPhy::ReceptionPath::ReceptionPath()
-    : m_available(true),
+GatewayLoraPhy::ReceptionPath::ReceptionPath(uint32_t board)
+    : m_board(board),
+      m_available(true),
       m_event(nullptr),
       m_endReceiveEventId(EventId())
 {
@@ -67,13 +73,13 @@ GatewayLoraPhy::ReceptionPath::SetEvent(Ptr<LoraInterferenceHelper::Event> event
 }
 
 Ptr<LoraInterferenceHelper::Event>
-GatewayLoraPhy::ReceptionPath::GetEvent()
+GatewayLoraPhy::ReceptionPath::GetEvent() const
 {
     return m_event;
 }
 
 EventId
-GatewayLoraPhy::ReceptionPath::GetEndReceive()
+GatewayLoraPhy::ReceptionPath::GetEndReceive() const
 {
     return m_endReceiveEventId;
 }
@@ -84,6 +90,12 @@ GatewayLoraPhy::ReceptionPath::SetEndReceive(EventId endReceiveEventId)
     m_endReceiveEventId = endReceiveEventId;
 }
 
+uint32_t
+GatewayLoraPhy::ReceptionPath::GetBoard() const
+{
+    return m_board;
+}
+
 /***********************************************************************
  *                 Implementation of gateway methods                   *
  ***********************************************************************/
@@ -108,6 +120,32 @@ GatewayLoraPhy::GetTypeId()
                             "there are no more demodulators available",
                             MakeTraceSourceAccessor(&GatewayLoraPhy::m_noMoreDemodulators),
                             "ns3::Packet::TracedCallback")
+            .AddTraceSource("LostPacketBecauseNoMoreReceiversOnBoard",
+                            "Trace source indicating a packet "
+                            "could not be correctly received because "
+                            "there are no more demodulators available on the board "
+                            "listening to its frequency",
+                            MakeTraceSourceAccessor(&GatewayLoraPhy::m_noMoreDemodulatorsOnBoard),
+                            "ns3::lorawan::GatewayLoraPhy::BoardTracedCallback")
+            .AddAttribute("SicDepth",
+                          "The largest number of overlapping signals the gateway can decode "
+                          "and cancel to recover a packet lost to interference, or 0 to "
+                          "disable successive interference cancellation",
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&GatewayLoraPhy::m_sicDepth),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("PreambleCapture",
+                          "Whether the gateway drops a reception as soon as the signals "
+                          "overlapping it are enough to destroy it, freeing its reception path, "
+                          "instead of waiting for the end of the packet",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&GatewayLoraPhy::m_preambleCapture),
+                          MakeBooleanChecker())
+            .AddTraceSource("RecoveredPacketBySic",
+                            "Trace source indicating a packet lost to interference "
+                            "was received after cancelling overlapping signals",
+                            MakeTraceSourceAccessor(&GatewayLoraPhy::m_recoveredBySic),
+                            "ns3::Packet::TracedCallback")
             .AddTraceSource("OccupiedReceptionPaths",
                             "Number of currently occupied reception paths",
                             MakeTraceSourceAccessor(&GatewayLoraPhy::m_occupiedReceptionPaths),
@@ -116,9 +154,14 @@ GatewayLoraPhy::GetTypeId()
 }
 
 GatewayLoraPhy::GatewayLoraPhy()
-    : m_isTransmitting(false)
+    : m_isTransmitting(false),
+      m_sicDepth(0),
+      m_preambleCapture(false)
 {
     NS_LOG_FUNCTION_NOARGS();
+
+    // Board 0 can listen to any frequency
+    m_boards.push_back({std::numeric_limits<uint32_t>::max(), 0, {}, 0});
 }
 
 GatewayLoraPhy::~GatewayLoraPhy()
@@ -135,7 +178,8 @@ GatewayLoraPhy::AddReceptionPath()
 {
     NS_LOG_FUNCTION_NOARGS();
 
-    m_receptionPaths.push_back(Create<GatewayLoraPhy::ReceptionPath>());
+    m_boards[0].freePaths.push_back(m_receptionPaths.size());
+    m_receptionPaths.emplace_back(0);
 }
 
 void
@@ -143,7 +187,134 @@ GatewayLoraPhy::ResetReceptionPaths()
 {
     NS_LOG_FUNCTION(this);
 
-    m_receptionPaths.clear();
+    // Drop the paths of board 0, and rebuild the stacks of available paths
+    // since the indexes of the others may have shifted
+    std::vector<ReceptionPath> receptionPaths;
+    for (auto& board : m_boards)
+    {
+        board.freePaths.clear();
+    }
+    for (const auto& path : m_receptionPaths)
+    {
+        if (path.GetBoard() == 0)
+        {
+            if (!path.IsAvailable())
+            {
+                m_occupiedReceptionPaths--;
+            }
+            continue;
+        }
+        if (path.IsAvailable())
+        {
+            m_boards[path.GetBoard()].freePaths.push_back(receptionPaths.size());
+        }
+        receptionPaths.push_back(path);
+    }
+    m_receptionPaths = std::move(receptionPaths);
+}
+
+uint32_t
+GatewayLoraPhy::AddBoard(uint32_t nReceptionPaths, uint32_t maxFrequencies)
+{
+    NS_LOG_FUNCTION(this << nReceptionPaths << maxFrequencies);
+
+    uint32_t board = m_boards.size();
+    m_boards.push_back({maxFrequencies, 0, {}, 0});
+    for (uint32_t i = 0; i < nReceptionPaths; i++)
+    {
+        m_boards[board].freePaths.push_back(m_receptionPaths.size());
+        m_receptionPaths.emplace_back(board);
+    }
+    return board;
+}
+
+void
+GatewayLoraPhy::AddBoardFrequency(uint32_t board, double frequencyMHz)
+{
+    NS_LOG_FUNCTION(this << board << frequencyMHz);
+
+    NS_ABORT_MSG_IF(board == 0 || board >= m_boards.size(), "Board " << board << " doesn't exist");
+    NS_ABORT_MSG_IF(m_boards[board].nFrequencies >= m_boards[board].maxFrequencies,
+                    "Board " << board << " has no IF chain left for " << frequencyMHz << " MHz");
+    NS_ABORT_MSG_IF(m_frequencyBoards.count(frequencyMHz),
+                    "Frequency " << frequencyMHz << " MHz is already assigned to board "
+                                 << m_frequencyBoards[frequencyMHz]);
+
+    m_frequencyBoards[frequencyMHz] = board;
+    m_boards[board].nFrequencies++;
+}
+
+uint32_t
+GatewayLoraPhy::GetNBoards() const
+{
+    return m_boards.size();
+}
+
+uint32_t
+GatewayLoraPhy::GetBoard(double frequencyMHz) const
+{
+    auto it = m_frequencyBoards.find(frequencyMHz);
+    return it != m_frequencyBoards.end() ? it->second : 0;
+}
+
+uint64_t
+GatewayLoraPhy::GetNLostPacketsNoMoreReceivers(uint32_t board) const
+{
+    NS_ASSERT(board < m_boards.size());
+
+    return m_boards[board].nLostPacketsNoMoreReceivers;
+}
+
+bool
+GatewayLoraPhy::HasAvailableReceptionPath(uint32_t board) const
+{
+    return !m_boards[board].freePaths.empty();
+}
+
+uint32_t
+GatewayLoraPhy::LockReceptionPath(uint32_t board, Ptr<LoraInterferenceHelper::Event> event)
+{
+    std::vector<uint32_t>& freePaths = m_boards[board].freePaths;
+    NS_ASSERT(!freePaths.empty());
+
+    uint32_t index = freePaths.back();
+    freePaths.pop_back();
+    m_receptionPaths[index].LockOnEvent(event);
+    m_occupiedReceptionPaths++;
+    return index;
+}
+
+void
+GatewayLoraPhy::FreeReceptionPath(uint32_t index)
+{
+    NS_ASSERT(index < m_receptionPaths.size() && !m_receptionPaths[index].IsAvailable());
+
+    m_receptionPaths[index].Free();
+    m_boards[m_receptionPaths[index].GetBoard()].freePaths.push_back(index);
+    m_occupiedReceptionPaths--;
+}
+
+void
+GatewayLoraPhy::NotifyNoMoreDemodulators(Ptr<const Packet> packet, uint32_t board)
+{
+    m_boards[board].nLostPacketsNoMoreReceivers++;
+
+    uint32_t nodeId = m_device ? m_device->GetNode()->GetId() : 0;
+    m_noMoreDemodulators(packet, nodeId);
+    m_noMoreDemodulatorsOnBoard(packet, nodeId, board);
+}
+
+uint32_t
+GatewayLoraPhy::FindReceptionPath(Ptr<LoraInterferenceHelper::Event> event) const
+{
+    for (uint32_t index = 0; index < m_receptionPaths.size(); index++)
+    {
+        if (!m_receptionPaths[index].IsAvailable() && m_receptionPaths[index].GetEvent() == event)
+        {
+            return index;
+        }
+    }
+    return m_receptionPaths.size();
 }
 
 void
@@ -181,7 +352,7 @@ GatewayLoraPhy::IsOnFrequency(double frequencyMHz)
             return true;
         }
     }
-    return false;
+    return m_frequencyBoards.count(frequencyMHz) > 0;
 }
 } // namespace lorawan
 } // namespace ns3
@@ -19,6 +19,8 @@
 #include "ns3/traced-value.h"
 
 #include <list>
+#include <unordered_map>
+#include <vector>
 
 namespace ns3
 {
@@ -38,6 +40,29 @@ class LoraChannel;
  * simultaneously. This characteristic of the chip is modeled using the
  * ReceivePath class, which describes a single parallel receiver. GatewayLoraPhy
  * essentially holds and manages a collection of these objects.
+ *
+ * Reception paths are stored in an array, together with a stack of the indexes
+ * of the available ones, so that locking and freeing a path takes constant
+ * time regardless of the number of paths of the gateway.
+ *
+ * Gateways with multiple concentrator boards are modeled by grouping reception
+ * paths in boards. Each board listens to its own set of frequencies, up to the
+ * number of its IF chains, and packets are dispatched to the board serving
+ * their frequency through a lookup table. Board 0 holds the paths added with
+ * AddReceptionPath, and receives the packets on frequencies that are not
+ * assigned to any other board.
+ *
+ * Gateways can perform successive interference cancellation (SIC), through
+ * the SicDepth attribute: a packet lost to interference is checked again once
+ * the signals overlapping it ended, after decoding and subtracting up to
+ * SicDepth of them, from the strongest to the weakest.
+ *
+ * With the PreambleCapture attribute, a packet is checked against the signals
+ * already overlapping it when the gateway locks on its preamble, and again
+ * whenever a new signal arrives on its frequency: packets that can't survive
+ * are reported as lost to interference right away, and their reception path
+ * is released for later arrivals. Since cancelling interferers could still
+ * recover them, this only applies to gateways that don't perform SIC.
  */
 class GatewayLoraPhy : public LoraPhy
 {
@@ -75,14 +100,16 @@ class GatewayLoraPhy : public LoraPhy
     bool IsOnFrequency(double frequencyMHz) override;
 
     /**
-     * Add a reception path, locked on a specific frequency.
+     * Add a reception path to board 0.
      */
     void AddReceptionPath();
 
     /**
      * Reset the list of reception paths.
      *
-     * This method deletes all currently available ReceptionPath objects.
+     * This method deletes the ReceptionPath objects added with
+     * AddReceptionPath. The reception paths of the boards added with AddBoard
+     * are kept.
      */
     void ResetReceptionPaths();
 
@@ -93,6 +120,60 @@ class GatewayLoraPhy : public LoraPhy
      */
     void AddFrequency(double frequencyMHz);
 
+    /**
+     * Add a concentrator board with its own reception paths.
+     *
+     * \param nReceptionPaths The number of demodulators of the board.
+     * \param maxFrequencies The number of IF chains of the board, i.e., the
+     * maximum number of frequencies it can listen to.
+     * \return The index of the new board.
+     */
+    uint32_t AddBoard(uint32_t nReceptionPaths, uint32_t maxFrequencies);
+
+    /**
+     * Make a board listen to a frequency.
+     *
+     * Packets on this frequency can then only be received by the reception
+     * paths of the board.
+     *
+     * \param board The index of the board, as returned by AddBoard.
+     * \param frequencyMHz The value of the frequency [MHz].
+     */
+    void AddBoardFrequency(uint32_t board, double frequencyMHz);
+
+    /**
+     * Get the number of boards of the gateway, including board 0.
+     *
+     * \return The number of boards.
+     */
+    uint32_t GetNBoards() const;
+
+    /**
+     * Get the board receiving the packets on a frequency.
+     *
+     * \param frequencyMHz The value of the frequency [MHz].
+     * \return The index of the board.
+     */
+    uint32_t GetBoard(double frequencyMHz) const;
+
+    /**
+     * Get the number of packets a board could not receive because all its
+     * reception paths were busy.
+     *
+     * \param board The index of the board.
+     * \return The number of lost packets.
+     */
+    uint64_t GetNLostPacketsNoMoreReceivers(uint32_t board) const;
+
+    /**
+     * TracedCallback signature for packets lost on a board.
+     *
+     * \param packet The packet lost.
+     * \param nodeId The id of the gateway node, or 0 if there is none.
+     * \param board The index of the board.
+     */
+    typedef void (*BoardTracedCallback)(Ptr<const Packet> packet, uint32_t nodeId, uint32_t board);
+
     static const double sensitivity[6]; //!< A vector containing the sensitivities required to
                                         //!< correctly decode different spreading factors.
 
@@ -111,13 +192,15 @@ class GatewayLoraPhy : public LoraPhy
      * listen for a certain spreading factor. ReceptionPaths be either locked on an event or
      * free.
      */
-    class ReceptionPath : public SimpleRefCount<GatewayLoraPhy::ReceptionPath>
+    class ReceptionPath
     {
       public:
         /**
          * Constructor.
+         *
+         * \param board The index of the board the reception path belongs to.
          */
-        ReceptionPath();
+        ReceptionPath(uint32_t board);
         ~ReceptionPath(); //!< Destructor
 
         /**
@@ -156,7 +239,7 @@ class GatewayLoraPhy : public LoraPhy
          * \return 0 if no event is currently being received, a pointer to
          * the event otherwise.
          */
-        Ptr<LoraInterferenceHelper::Event> GetEvent();
+        Ptr<LoraInterferenceHelper::Event> GetEvent() const;
 
         /**
          * Get the EventId of the EndReceive call associated to this ReceptionPath's
@@ -164,7 +247,7 @@ class GatewayLoraPhy : public LoraPhy
          *
          * \return The EventId instance.
          */
-        EventId GetEndReceive();
+        EventId GetEndReceive() const;
 
         /**
          * Set the EventId of the EndReceive call associated to this ReceptionPath's
@@ -174,7 +257,15 @@ class GatewayLoraPhy : public LoraPhy
          */
         void SetEndReceive(EventId endReceiveEventId);
 
+        /**
+         * Get the board this reception path belongs to.
+         *
+         * \return The index of the board.
+         */
+        uint32_t GetBoard() const;
+
       private:
+        uint32_t m_board; //!< The board this reception path belongs to.
         bool m_available; //!< Whether this reception path is available to lock on a signal or not.
         Ptr<LoraInterferenceHelper::Event>
             m_event;                 //!< The event this reception path is currently locked on.
@@ -183,8 +274,69 @@ class GatewayLoraPhy : public LoraPhy
                                      //!< locked on finishes reception.
     };
 
-    std::list<Ptr<ReceptionPath>> m_receptionPaths; //!< A list containing the various parallel
-                                                    //!< receivers that are managed by this gateway.
+    /**
+     * Check whether a reception path of a board is available to lock on a
+     * signal.
+     *
+     * \param board The index of the board.
+     * \return True if at least one reception path of the board is free.
+     */
+    bool HasAvailableReceptionPath(uint32_t board) const;
+
+    /**
+     * Lock an available reception path of a board on an event.
+     *
+     * \param board The index of the board.
+     * \param event The LoraInterferenceHelper Event to lock on.
+     * \return The index of the locked reception path.
+     */
+    uint32_t LockReceptionPath(uint32_t board, Ptr<LoraInterferenceHelper::Event> event);
+
+    /**
+     * Free a locked reception path.
+     *
+     * \param index The index of the reception path.
+     */
+    void FreeReceptionPath(uint32_t index);
+
+    /**
+     * Find the reception path locked on an event.
+     *
+     * This visits all reception paths: when possible, remember the index
+     * returned by LockReceptionPath instead.
+     *
+     * \param event The event.
+     * \return The index of the reception path, or the number of reception paths
+     * if no path is locked on the event.
+     */
+    uint32_t FindReceptionPath(Ptr<LoraInterferenceHelper::Event> event) const;
+
+    /**
+     * Notify that a packet could not be received because all the reception
+     * paths of its board were busy.
+     *
+     * \param packet The packet lost.
+     * \param board The index of the board.
+     */
+    void NotifyNoMoreDemodulators(Ptr<const Packet> packet, uint32_t board);
+
+    /**
+     * A concentrator board, i.e., a group of reception paths listening to the
+     * same frequencies.
+     */
+    struct Board
+    {
+        uint32_t maxFrequencies;              //!< The number of IF chains
+        uint32_t nFrequencies;                //!< The number of frequencies listened to
+        std::vector<uint32_t> freePaths;      //!< The indexes of the available reception paths
+        uint64_t nLostPacketsNoMoreReceivers; //!< Packets lost because all paths were busy
+    };
+
+    std::vector<ReceptionPath> m_receptionPaths; //!< The parallel receivers that are managed by
+                                                 //!< this gateway.
+    std::vector<Board> m_boards;                 //!< The boards of the gateway
+    std::unordered_map<double, uint32_t>
+        m_frequencyBoards; //!< The board listening to each frequency, if not board 0
 
     TracedValue<int> m_occupiedReceptionPaths; //!< The number of occupied reception paths.
 
@@ -194,14 +346,30 @@ class GatewayLoraPhy : public LoraPhy
      */
     TracedCallback<Ptr<const Packet>, uint32_t> m_noMoreDemodulators;
 
+    /**
+     * Trace source fired when a packet cannot be received because all ReceivePath instances of
+     * its board are busy, with the index of the board.
+     */
+    TracedCallback<Ptr<const Packet>, uint32_t, uint32_t> m_noMoreDemodulatorsOnBoard;
+
     /**
      * Trace source fired when a packet cannot be received because the gateway is in transmission
      * state.
      */
     TracedCallback<Ptr<const Packet>, uint32_t> m_noReceptionBecauseTransmitting;
 
+    /**
+     * Trace source fired when a packet lost to interference is received after
+     * cancelling overlapping signals.
+     */
+    TracedCallback<Ptr<const Packet>, uint32_t> m_recoveredBySic;
+
     bool m_isTransmitting; //!< Flag indicating whether a transmission is going on
 
+    uint32_t m_sicDepth; //!< The largest number of signals cancelled to recover a packet
+
+    bool m_preambleCapture; //!< Whether doomed receptions release their path early
+
     std::list<double> m_frequencies; //!< List of frequencies the GatewayLoraPhy is listening to.
 };
 
@@ -11,6 +11,8 @@
 #include "ns3/log.h"
 #include "ns3/simulator.h"
 
+#include <algorithm>
+
 namespace ns3
 {
 namespace lorawan
@@ -20,6 +22,9 @@ NS_LOG_COMPONENT_DEFINE("LogicalLoraChannelHelper");
 
 NS_OBJECT_ENSURE_REGISTERED(LogicalLoraChannelHelper);
 
+/// Marks channels outside any SubBand, and SubBands outside the heap
+static const uint8_t NO_INDEX = LogicalLoraChannelPlan::NO_SUB_BAND;
+
 TypeId
 LogicalLoraChannelHelper::GetTypeId()
 {
@@ -29,10 +34,18 @@ LogicalLoraChannelHelper::GetTypeId()
 }
 
 LogicalLoraChannelHelper::LogicalLoraChannelHelper()
-    : m_nextAggregatedTransmissionTime(Seconds(0)),
-      m_aggregatedDutyCycle(1)
+    : LogicalLoraChannelHelper(Create<LogicalLoraChannelPlan>())
 {
-    NS_LOG_FUNCTION(this);
+}
+
+LogicalLoraChannelHelper::LogicalLoraChannelHelper(Ptr<LogicalLoraChannelPlan> plan)
+    : m_plan(plan),
+      m_nextTransmissionTimes(plan->GetSubBands().size(), Seconds(0)),
+      m_nextAggregatedTransmissionTime(Seconds(0)),
+      m_aggregatedDutyCycle(1),
+      m_cacheValid(false)
+{
+    NS_LOG_FUNCTION(this << plan);
 }
 
 LogicalLoraChannelHelper::~LogicalLoraChannelHelper()
@@ -40,17 +53,18 @@ LogicalLoraChannelHelper::~LogicalLoraChannelHelper()
     NS_LOG_FUNCTION(this);
 }
 
+Ptr<LogicalLoraChannelPlan>
+LogicalLoraChannelHelper::GetChannelPlan() const
+{
+    return m_plan;
+}
+
 std::vector<Ptr<LogicalLoraChannel>>
 LogicalLoraChannelHelper::GetChannelList()
 {
     NS_LOG_FUNCTION(this);
 
-    // Make a copy of the channel vector
-    std::vector<Ptr<LogicalLoraChannel>> vector;
-    vector.reserve(m_channelList.size());
-    std::copy(m_channelList.begin(), m_channelList.end(), std::back_inserter(vector));
-
-    return vector;
+    return m_plan->GetChannels();
 }
 
 std::vector<Ptr<LogicalLoraChannel>>
@@ -58,43 +72,215 @@ LogicalLoraChannelHelper::GetEnabledChannelList()
 {
     NS_LOG_FUNCTION(this);
 
-    // Make a copy of the channel vector
-    std::vector<Ptr<LogicalLoraChannel>> vector;
-    vector.reserve(m_channelList.size());
-    std::copy(m_channelList.begin(),
-              m_channelList.end(),
-              std::back_inserter(vector)); // Working on a copy
-
+    const auto& channelList = m_plan->GetChannels();
     std::vector<Ptr<LogicalLoraChannel>> channels;
-    std::vector<Ptr<LogicalLoraChannel>>::iterator it;
-    for (it = vector.begin(); it != vector.end(); it++)
+    channels.reserve(channelList.size());
+    for (std::size_t i = 0; i < channelList.size(); i++)
     {
-        if ((*it)->IsEnabledForUplink())
+        if (IsChannelEnabled(int(i)))
         {
-            channels.push_back(*it);
+            channels.push_back(channelList[i]);
         }
     }
 
     return channels;
 }
 
+void
+LogicalLoraChannelHelper::MakePlanUnique()
+{
+    if (m_plan->GetReferenceCount() > 1)
+    {
+        NS_LOG_DEBUG("Copying the shared channel plan");
+        m_plan = Create<LogicalLoraChannelPlan>(*m_plan);
+    }
+    m_cacheValid = false;
+}
+
+void
+LogicalLoraChannelHelper::UpdateCache()
+{
+    if (m_cacheValid)
+    {
+        return;
+    }
+
+    NS_LOG_FUNCTION(this);
+
+    const auto& channelList = m_plan->GetChannels();
+    auto nChannels = uint8_t(channelList.size());
+    auto nSubBands = uint8_t(m_plan->GetSubBands().size());
+
+    // Group enabled channels by SubBand, keeping their order within each one
+    m_enabledOffsets.assign(nSubBands + 1, 0);
+    for (uint8_t i = 0; i < nChannels; i++)
+    {
+        if (IsChannelEnabled(i))
+        {
+            if (m_plan->GetChannelSubBand(i) == NO_INDEX)
+            {
+                NS_LOG_ERROR("Requested frequency: " << channelList[i]->GetFrequency());
+                NS_ABORT_MSG("Warning: frequency is outside any known SubBand.");
+            }
+            m_enabledOffsets[m_plan->GetChannelSubBand(i) + 1]++;
+        }
+    }
+    for (uint8_t s = 0; s < nSubBands; s++)
+    {
+        m_enabledOffsets[s + 1] += m_enabledOffsets[s];
+    }
+    m_enabledChannels.assign(m_enabledOffsets[nSubBands], 0);
+    std::vector<uint8_t> next(m_enabledOffsets.begin(), m_enabledOffsets.end() - 1);
+    for (uint8_t i = 0; i < nChannels; i++)
+    {
+        if (IsChannelEnabled(i))
+        {
+            m_enabledChannels[next[m_plan->GetChannelSubBand(i)]++] = i;
+        }
+    }
+
+    // Only SubBands with enabled channels matter for transmissions
+    m_subBandHeap.clear();
+    for (uint8_t s = 0; s < nSubBands; s++)
+    {
+        if (m_enabledOffsets[s + 1] > m_enabledOffsets[s])
+        {
+            m_subBandHeap.push_back(s);
+        }
+    }
+    std::make_heap(m_subBandHeap.begin(),
+                   m_subBandHeap.end(),
+                   [this](uint8_t first, uint8_t second) { return IsLater(first, second); });
+    m_heapPositions.assign(nSubBands, NO_INDEX);
+    for (uint8_t k = 0; k < m_subBandHeap.size(); k++)
+    {
+        m_heapPositions[m_subBandHeap[k]] = k;
+    }
+
+    m_cacheValid = true;
+}
+
+uint8_t
+LogicalLoraChannelHelper::GetSubBandIndex(Ptr<LogicalLoraChannel> channel)
+{
+    // Registered channels are mapped directly
+    int chIndex = m_plan->GetChannelIndex(channel);
+    if (chIndex >= 0 && m_plan->GetChannelSubBand(chIndex) != NO_INDEX)
+    {
+        return m_plan->GetChannelSubBand(chIndex);
+    }
+
+    // Other channels, for instance those of gateways, are looked up by frequency
+    uint8_t subBand = m_plan->GetFrequencySubBand(channel->GetFrequency());
+    if (subBand == NO_INDEX)
+    {
+        NS_LOG_ERROR("Requested frequency: " << channel->GetFrequency());
+        NS_ABORT_MSG("Warning: frequency is outside any known SubBand.");
+    }
+
+    return subBand;
+}
+
+bool
+LogicalLoraChannelHelper::IsLater(uint8_t first, uint8_t second) const
+{
+    Time firstTime = m_nextTransmissionTimes[first];
+    Time secondTime = m_nextTransmissionTimes[second];
+    return firstTime > secondTime || (firstTime == secondTime && first > second);
+}
+
+void
+LogicalLoraChannelHelper::UpdateHeap(uint8_t subBand)
+{
+    if (m_heapPositions[subBand] == NO_INDEX)
+    {
+        return;
+    }
+    std::size_t position = m_heapPositions[subBand];
+
+    // Move the SubBand up while it's earlier than its parent
+    while (position > 0 && IsLater(m_subBandHeap[(position - 1) / 2], subBand))
+    {
+        m_subBandHeap[position] = m_subBandHeap[(position - 1) / 2];
+        m_heapPositions[m_subBandHeap[position]] = position;
+        position = (position - 1) / 2;
+    }
+
+    // Move it down while it's later than its earliest child
+    std::size_t size = m_subBandHeap.size();
+    while (2 * position + 1 < size)
+    {
+        std::size_t child = 2 * position + 1;
+        if (child + 1 < size && IsLater(m_subBandHeap[child], m_subBandHeap[child + 1]))
+        {
+            child++;
+        }
+        if (!IsLater(subBand, m_subBandHeap[child]))
+        {
+            break;
+        }
+        m_subBandHeap[position] = m_subBandHeap[child];
+        m_heapPositions[m_subBandHeap[position]] = position;
+        position = child;
+    }
+
+    m_subBandHeap[position] = subBand;
+    m_heapPositions[subBand] = position;
+}
+
+uint32_t
+LogicalLoraChannelHelper::CountAvailableChannels(std::size_t position, int64_t now) const
+{
+    // The children of a SubBand that doesn't allow transmission don't either
+    if (position >= m_subBandHeap.size() ||
+        m_nextTransmissionTimes[m_subBandHeap[position]].GetTimeStep() > now)
+    {
+        return 0;
+    }
+
+    uint8_t subBand = m_subBandHeap[position];
+    return m_enabledOffsets[subBand + 1] - m_enabledOffsets[subBand] +
+           CountAvailableChannels(2 * position + 1, now) +
+           CountAvailableChannels(2 * position + 2, now);
+}
+
+int
+LogicalLoraChannelHelper::FindAvailableChannel(std::size_t position,
+                                               int64_t now,
+                                               uint32_t& pick) const
+{
+    if (position >= m_subBandHeap.size() ||
+        m_nextTransmissionTimes[m_subBandHeap[position]].GetTimeStep() > now)
+    {
+        return -1;
+    }
+
+    uint8_t subBand = m_subBandHeap[position];
+    uint32_t nChannels = m_enabledOffsets[subBand + 1] - m_enabledOffsets[subBand];
+    if (pick < nChannels)
+    {
+        return m_enabledChannels[m_enabledOffsets[subBand] + pick];
+    }
+    pick -= nChannels;
+
+    int channel = FindAvailableChannel(2 * position + 1, now, pick);
+    return channel >= 0 ? channel : FindAvailableChannel(2 * position + 2, now, pick);
+}
+
 Ptr<SubBand>
 LogicalLoraChannelHelper::GetSubBandFromChannel(Ptr<LogicalLoraChannel> channel)
 {
-    return GetSubBandFromFrequency(channel->GetFrequency());
+    return m_plan->GetSubBands()[GetSubBandIndex(channel)];
 }
 
 Ptr<SubBand>
 LogicalLoraChannelHelper::GetSubBandFromFrequency(double frequency)
 {
     // Get the SubBand this frequency belongs to
-    std::list<Ptr<SubBand>>::iterator it;
-    for (it = m_subBandList.begin(); it != m_subBandList.end(); it++)
+    uint8_t subBand = m_plan->GetFrequencySubBand(frequency);
+    if (subBand != NO_INDEX)
     {
-        if ((*it)->BelongsToSubBand(frequency))
-        {
-            return *it;
-        }
+        return m_plan->GetSubBands()[subBand];
     }
 
     NS_LOG_ERROR("Requested frequency: " << frequency);
@@ -112,9 +298,10 @@ LogicalLoraChannelHelper::AddChannel(double frequency)
     Ptr<LogicalLoraChannel> channel = Create<LogicalLoraChannel>(frequency);
 
     // Add it to the list
-    m_channelList.push_back(channel);
+    AddChannel(channel);
 
-    NS_LOG_DEBUG("Added a channel. Current number of channels in list is " << m_channelList.size());
+    NS_LOG_DEBUG("Added a channel. Current number of channels in list is "
+                 << m_plan->GetChannels().size());
 }
 
 void
@@ -123,7 +310,12 @@ LogicalLoraChannelHelper::AddChannel(Ptr<LogicalLoraChannel> logicalChannel)
     NS_LOG_FUNCTION(this << logicalChannel);
 
     // Add it to the list
-    m_channelList.push_back(logicalChannel);
+    MakePlanUnique();
+    m_plan->AddChannel(logicalChannel);
+    if (!m_enabledMask.empty())
+    {
+        m_enabledMask.push_back(logicalChannel->IsEnabledForUplink());
+    }
 }
 
 void
@@ -132,7 +324,12 @@ LogicalLoraChannelHelper::SetChannel(uint8_t chIndex, Ptr<LogicalLoraChannel> lo
 {
     NS_LOG_FUNCTION(this << chIndex << logicalChannel);
 
-    m_channelList.at(chIndex) = logicalChannel;
+    MakePlanUnique();
+    m_plan->SetChannel(chIndex, logicalChannel);
+    if (!m_enabledMask.empty())
+    {
+        m_enabledMask[chIndex] = logicalChannel->IsEnabledForUplink();
+    }
 }
 
 void
@@ -145,7 +342,7 @@ LogicalLoraChannelHelper::AddSubBand(double firstFrequency,
 
     Ptr<SubBand> subBand = Create<SubBand>(firstFrequency, lastFrequency, dutyCycle, maxTxPowerDbm);
 
-    m_subBandList.push_back(subBand);
+    AddSubBand(subBand);
 }
 
 void
@@ -153,22 +350,20 @@ LogicalLoraChannelHelper::AddSubBand(Ptr<SubBand> subBand)
 {
     NS_LOG_FUNCTION(this << subBand);
 
-    m_subBandList.push_back(subBand);
+    MakePlanUnique();
+    m_plan->AddSubBand(subBand);
+    m_nextTransmissionTimes.push_back(Seconds(0));
 }
 
 void
 LogicalLoraChannelHelper::RemoveChannel(Ptr<LogicalLoraChannel> logicalChannel)
 {
     // Search and remove the channel from the list
-    std::vector<Ptr<LogicalLoraChannel>>::iterator it;
-    for (it = m_channelList.begin(); it != m_channelList.end(); it++)
+    MakePlanUnique();
+    int index = m_plan->RemoveChannel(logicalChannel);
+    if (index >= 0 && !m_enabledMask.empty())
     {
-        Ptr<LogicalLoraChannel> currentChannel = *it;
-        if (currentChannel == logicalChannel)
-        {
-            m_channelList.erase(it);
-            return;
-        }
+        m_enabledMask.erase(m_enabledMask.begin() + index);
     }
 }
 
@@ -191,9 +386,56 @@ LogicalLoraChannelHelper::GetWaitingTime(Ptr<LogicalLoraChannel> channel)
 {
     NS_LOG_FUNCTION(this << channel);
 
+    return GetSubBandWaitingTime(GetSubBandIndex(channel));
+}
+
+Time
+LogicalLoraChannelHelper::GetMinWaitingTime()
+{
+    NS_LOG_FUNCTION(this);
+
+    UpdateCache();
+
+    if (m_subBandHeap.empty())
+    {
+        return Time::Max();
+    }
+
+    // The root of the heap is the SubBand allowing the earliest transmission
+    return GetSubBandWaitingTime(m_subBandHeap.front());
+}
+
+Ptr<LogicalLoraChannel>
+LogicalLoraChannelHelper::GetChannelForTx(Ptr<UniformRandomVariable> uniformRV)
+{
+    NS_LOG_FUNCTION(this);
+
+    UpdateCache();
+
+    int64_t now = Simulator::Now().GetTimeStep();
+    uint32_t nAvailable = CountAvailableChannels(0, now);
+    if (nAvailable == 0)
+    {
+        NS_LOG_DEBUG("No channel is available because of duty cycle limitations");
+        return nullptr;
+    }
+
+    auto pick = uint32_t(uniformRV->GetInteger(0, nAvailable - 1));
+    int channel = FindAvailableChannel(0, now, pick);
+    NS_ASSERT(channel >= 0);
+
+    const auto& channelList = m_plan->GetChannels();
+    NS_LOG_DEBUG("Picked the channel with frequency " << channelList[channel]->GetFrequency()
+                                                      << " among " << nAvailable);
+
+    return channelList[channel];
+}
+
+Time
+LogicalLoraChannelHelper::GetSubBandWaitingTime(uint8_t subBand) const
+{
     // SubBand waiting time
-    Time subBandWaitingTime =
-        GetSubBandFromChannel(channel)->GetNextTransmissionTime() - Simulator::Now();
+    Time subBandWaitingTime = m_nextTransmissionTimes[subBand] - Simulator::Now();
 
     // Handle case in which waiting time is negative
     subBandWaitingTime = Seconds(std::max(subBandWaitingTime.GetSeconds(), double(0)));
@@ -208,13 +450,18 @@ LogicalLoraChannelHelper::AddEvent(Time duration, Ptr<LogicalLoraChannel> channe
 {
     NS_LOG_FUNCTION(this << duration << channel);
 
-    Ptr<SubBand> subBand = GetSubBandFromChannel(channel);
+    UpdateCache();
+
+    uint8_t subBandIndex = GetSubBandIndex(channel);
+    Ptr<SubBand> subBand = m_plan->GetSubBands()[subBandIndex];
 
     double dutyCycle = subBand->GetDutyCycle();
     double timeOnAir = duration.GetSeconds();
 
     // Computation of necessary waiting time on this sub-band
-    subBand->SetNextTransmissionTime(Simulator::Now() + Seconds(timeOnAir / dutyCycle - timeOnAir));
+    m_nextTransmissionTimes[subBandIndex] =
+        Simulator::Now() + Seconds(timeOnAir / dutyCycle - timeOnAir);
+    UpdateHeap(subBandIndex);
 
     // Computation of necessary aggregate waiting time
     m_nextAggregatedTransmissionTime =
@@ -224,7 +471,7 @@ LogicalLoraChannelHelper::AddEvent(Time duration, Ptr<LogicalLoraChannel> channe
     NS_LOG_DEBUG("m_aggregatedDutyCycle: " << m_aggregatedDutyCycle);
     NS_LOG_DEBUG("Current time: " << Simulator::Now().GetSeconds());
     NS_LOG_DEBUG("Next transmission on this sub-band allowed at time: "
-                 << (subBand->GetNextTransmissionTime()).GetSeconds());
+                 << m_nextTransmissionTimes[subBandIndex].GetSeconds());
     NS_LOG_DEBUG("Next aggregated transmission allowed at time "
                  << m_nextAggregatedTransmissionTime.GetSeconds());
 }
@@ -235,14 +482,10 @@ LogicalLoraChannelHelper::GetTxPowerForChannel(Ptr<LogicalLoraChannel> logicalCh
     NS_LOG_FUNCTION_NOARGS();
 
     // Get the maxTxPowerDbm from the SubBand this channel is in
-    std::list<Ptr<SubBand>>::iterator it;
-    for (it = m_subBandList.begin(); it != m_subBandList.end(); it++)
+    uint8_t subBand = m_plan->GetFrequencySubBand(logicalChannel->GetFrequency());
+    if (subBand != NO_INDEX)
     {
-        // Check whether this channel is in this SubBand
-        if ((*it)->BelongsToSubBand(logicalChannel->GetFrequency()))
-        {
-            return (*it)->GetMaxTxPowerDbm();
-        }
+        return m_plan->GetSubBands()[subBand]->GetMaxTxPowerDbm();
     }
     NS_ABORT_MSG("Logical channel doesn't belong to a known SubBand");
 
@@ -254,7 +497,50 @@ LogicalLoraChannelHelper::DisableChannel(int index)
 {
     NS_LOG_FUNCTION(this << index);
 
-    m_channelList.at(index)->DisableForUplink();
+    SetEnabledInMask(index, false);
+}
+
+void
+LogicalLoraChannelHelper::EnableChannel(int index)
+{
+    NS_LOG_FUNCTION(this << index);
+
+    SetEnabledInMask(index, true);
+}
+
+void
+LogicalLoraChannelHelper::SetEnabledInMask(int index, bool enabled)
+{
+    // The mask of the device starts from the uplink flag of channels
+    if (m_enabledMask.empty())
+    {
+        for (const auto& channel : m_plan->GetChannels())
+        {
+            m_enabledMask.push_back(channel->IsEnabledForUplink());
+        }
+    }
+    m_enabledMask.at(index) = enabled;
+    m_cacheValid = false;
+}
+
+bool
+LogicalLoraChannelHelper::IsChannelEnabled(int index) const
+{
+    if (m_enabledMask.empty())
+    {
+        return m_plan->GetChannels().at(index)->IsEnabledForUplink();
+    }
+    return m_enabledMask.at(index);
+}
+
+std::size_t
+LogicalLoraChannelHelper::GetMemoryUsage() const
+{
+    // A shared plan is divided among the helpers using it
+    return sizeof(*this) + m_enabledMask.capacity() / 8 +
+           m_nextTransmissionTimes.capacity() * sizeof(Time) + m_enabledChannels.capacity() +
+           m_enabledOffsets.capacity() + m_subBandHeap.capacity() + m_heapPositions.capacity() +
+           m_plan->GetMemoryUsage() / m_plan->GetReferenceCount();
 }
 } // namespace lorawan
 } // namespace ns3
@@ -9,15 +9,17 @@
 #ifndef LOGICAL_LORA_CHANNEL_HELPER_H
 #define LOGICAL_LORA_CHANNEL_HELPER_H
 
+#include "logical-lora-channel-plan.h"
 #include "logical-lora-channel.h"
 #include "sub-band.h"
 
 #include "ns3/nstime.h"
 #include "ns3/object.h"
 #include "ns3/packet.h"
+#include "ns3/random-variable-stream.h"
 
+#include <cstddef>
 #include <iterator>
-#include <list>
 #include <vector>
 
 namespace ns3
@@ -32,9 +34,23 @@ namespace lorawan
  * channels that the device is supposed to be using, and establishes their
  * relationship with SubBands.
  *
- * This class also takes into account duty cycle limitations, by updating a list
- * of SubBand objects and providing methods to query whether transmission on a
- * set channel is admissible or not.
+ * This class also takes into account duty cycle limitations, by keeping the
+ * time each SubBand allows the next transmission and providing methods to query
+ * whether transmission on a set channel is admissible or not.
+ *
+ * Channels and SubBands are stored in a LogicalLoraChannelPlan, which can be
+ * shared by the helpers of many devices of the same region. The helper only
+ * owns the state that differs between devices: the channel mask, which is
+ * initialized from the uplink flag of channels and then changed through
+ * EnableChannel and DisableChannel, and the next transmission time of each
+ * SubBand. A shared plan is copied the first time the helper adds, replaces
+ * or removes a channel or SubBand, so that changes never affect other devices.
+ *
+ * The channels enabled for uplink, grouped by SubBand, are cached, and the
+ * SubBands with enabled channels are kept in a min-heap ordered by the time
+ * they allow the next transmission, so that picking a channel for a
+ * transmission doesn't allocate memory. Channel and SubBand objects
+ * registered with this helper must not be modified directly.
  */
 class LogicalLoraChannelHelper : public Object
 {
@@ -48,6 +64,21 @@ class LogicalLoraChannelHelper : public Object
     LogicalLoraChannelHelper();           //!< Default constructor
     ~LogicalLoraChannelHelper() override; //!< Destructor
 
+    /**
+     * Construct a helper using the channels and SubBands of a plan, which can
+     * be shared with other helpers.
+     *
+     * \param plan The channel plan.
+     */
+    LogicalLoraChannelHelper(Ptr<LogicalLoraChannelPlan> plan);
+
+    /**
+     * Get the channel plan used by this helper.
+     *
+     * \return The channel plan.
+     */
+    Ptr<LogicalLoraChannelPlan> GetChannelPlan() const;
+
     /**
      * Get the time it is necessary to wait before transmitting again, according
      * to the aggregate duty cycle timer.
@@ -70,6 +101,26 @@ class LogicalLoraChannelHelper : public Object
      */
     Time GetWaitingTime(Ptr<LogicalLoraChannel> channel);
 
+    /**
+     * Get the time it is necessary to wait for before transmitting on any of
+     * the channels enabled for uplink.
+     *
+     * \remark This function does not take into account aggregate waiting time.
+     *
+     * \return The smallest waiting time among enabled channels, or Time::Max ()
+     * if no channel is enabled.
+     */
+    Time GetMinWaitingTime();
+
+    /**
+     * Pick a channel for an uplink transmission, among the enabled ones whose
+     * SubBand allows transmitting now. All such channels are equally likely.
+     *
+     * \param uniformRV The random variable used to pick the channel.
+     * \return A pointer to the channel, or nullptr if no channel is available.
+     */
+    Ptr<LogicalLoraChannel> GetChannelForTx(Ptr<UniformRandomVariable> uniformRV);
+
     /**
      * Register the transmission of a packet.
      *
@@ -155,6 +206,10 @@ class LogicalLoraChannelHelper : public Object
     /**
      * Get the SubBand a channel belongs to.
      *
+     * The SubBand may be shared with other devices, and only describes the
+     * regulations of the band: use GetWaitingTime for the duty cycle state of
+     * this device.
+     *
      * \param channel The channel whose SubBand we want to get.
      * \return The SubBand the channel belongs to.
      */
@@ -175,18 +230,120 @@ class LogicalLoraChannelHelper : public Object
      */
     void DisableChannel(int index);
 
+    /**
+     * Enable the channel at a specified index.
+     *
+     * \param index The index of the channel to enable.
+     */
+    void EnableChannel(int index);
+
+    /**
+     * Check whether the channel at a specified index is enabled for uplink.
+     *
+     * \param index The index of the channel.
+     * \return True if the channel is enabled in the channel mask of this helper.
+     */
+    bool IsChannelEnabled(int index) const;
+
+    /**
+     * Get the approximate number of bytes used by this helper, counting a
+     * shared channel plan in proportion to the number of its owners.
+     *
+     * \return The size of the helper, in bytes.
+     */
+    std::size_t GetMemoryUsage() const;
+
   private:
     /**
-     * A list of the SubBands that are currently registered within this helper.
+     * Make sure the channel plan is only owned by this helper, copying it if
+     * it's shared, before changing it.
+     */
+    void MakePlanUnique();
+
+    /**
+     * Set whether a channel is enabled in the channel mask of this helper.
+     *
+     * \param index The index of the channel.
+     * \param enabled Whether the channel is enabled for uplink.
+     */
+    void SetEnabledInMask(int index, bool enabled);
+
+    /**
+     * Rebuild the cached channel mask, channel to SubBand mapping and SubBand
+     * heap, if they are out of date.
+     */
+    void UpdateCache();
+
+    /**
+     * Get the index of the SubBand a channel belongs to.
+     *
+     * \param channel The channel, which need not be registered with this helper.
+     * \return The index of the SubBand in the channel plan.
+     */
+    uint8_t GetSubBandIndex(Ptr<LogicalLoraChannel> channel);
+
+    /**
+     * Get the time it is necessary to wait for before transmitting on a SubBand.
+     *
+     * \param subBand The index of the SubBand.
+     * \return The waiting time, which is zero if transmission is allowed now.
      */
-    std::list<Ptr<SubBand>> m_subBandList;
+    Time GetSubBandWaitingTime(uint8_t subBand) const;
 
     /**
-     * A vector of the LogicalLoraChannels that are currently registered within
-     * this helper. This vector represents the node's channel mask. The first N
-     * channels are the default ones for a fixed region.
+     * Whether a SubBand allows the next transmission later than another, ties
+     * being broken by index.
+     *
+     * \param first The index of the first SubBand.
+     * \param second The index of the second SubBand.
+     * \return True if the first SubBand needs to come after the second in the heap.
+     */
+    bool IsLater(uint8_t first, uint8_t second) const;
+
+    /**
+     * Move a SubBand to its place in the heap after its next transmission time
+     * changed.
+     *
+     * \param subBand The index of the SubBand.
      */
-    std::vector<Ptr<LogicalLoraChannel>> m_channelList;
+    void UpdateHeap(uint8_t subBand);
+
+    /**
+     * Count the enabled channels of the SubBands allowing transmission, in the
+     * subtree of the heap rooted at a position.
+     *
+     * \param position The position of the root of the subtree in the heap.
+     * \param now The current time step.
+     * \return The number of channels.
+     */
+    uint32_t CountAvailableChannels(std::size_t position, int64_t now) const;
+
+    /**
+     * Find an enabled channel of the SubBands allowing transmission, in the
+     * subtree of the heap rooted at a position.
+     *
+     * \param position The position of the root of the subtree in the heap.
+     * \param now The current time step.
+     * \param pick The rank of the channel among those of the subtree, which is
+     * decreased by the number of channels visited if it isn't found.
+     * \return The index of the channel in the channel plan, or -1 if not found.
+     */
+    int FindAvailableChannel(std::size_t position, int64_t now, uint32_t& pick) const;
+
+    /**
+     * The SubBands and LogicalLoraChannels that are currently registered within
+     * this helper. The order of channels represents the node's channel mask.
+     * The first N channels are the default ones for a fixed region.
+     */
+    Ptr<LogicalLoraChannelPlan> m_plan;
+
+    /**
+     * Whether each channel of the plan is enabled for uplink. If empty, the
+     * uplink flag of the channels applies.
+     */
+    std::vector<bool> m_enabledMask;
+
+    std::vector<Time> m_nextTransmissionTimes; //!< The next transmission time of each SubBand
 
     Time m_nextAggregatedTransmissionTime; //!< The next time at which
     //! transmission will be possible
@@ -197,6 +354,13 @@ class LogicalLoraChannelHelper : public Object
                                   //! transmission will be possible
     //! according to the aggregated
     //! transmission timer
+
+    bool m_cacheValid; //!< Whether the cached fields below are up to date
+
+    std::vector<uint8_t> m_enabledChannels; //!< Enabled channel indices, grouped by SubBand
+    std::vector<uint8_t> m_enabledOffsets;  //!< First enabled channel of each SubBand
+    std::vector<uint8_t> m_subBandHeap;     //!< Min-heap of SubBands with enabled channels
+    std::vector<uint8_t> m_heapPositions;   //!< The position of each SubBand in the heap
 };
 } // namespace lorawan
 
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2017 University of Padova
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#include "logical-lora-channel-plan.h"
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+NS_LOG_COMPONENT_DEFINE("LogicalLoraChannelPlan");
+
+void
+LogicalLoraChannelPlan::AddChannel(Ptr<LogicalLoraChannel> channel)
+{
+    NS_LOG_FUNCTION(this << channel);
+
+    NS_ABORT_MSG_IF(m_channels.size() + 1 >= NO_SUB_BAND, "Too many channels");
+    m_channels.push_back(channel);
+    UpdateIndices();
+}
+
+void
+LogicalLoraChannelPlan::SetChannel(uint8_t chIndex, Ptr<LogicalLoraChannel> channel)
+{
+    NS_LOG_FUNCTION(this << unsigned(chIndex) << channel);
+
+    m_channels.at(chIndex) = channel;
+    UpdateIndices();
+}
+
+int
+LogicalLoraChannelPlan::RemoveChannel(Ptr<LogicalLoraChannel> channel)
+{
+    NS_LOG_FUNCTION(this << channel);
+
+    for (std::size_t i = 0; i < m_channels.size(); i++)
+    {
+        // Channels are compared by frequency
+        if (m_channels[i] == channel)
+        {
+            m_channels.erase(m_channels.begin() + i);
+            UpdateIndices();
+            return int(i);
+        }
+    }
+    return -1;
+}
+
+void
+LogicalLoraChannelPlan::AddSubBand(Ptr<SubBand> subBand)
+{
+    NS_LOG_FUNCTION(this << subBand);
+
+    NS_ABORT_MSG_IF(m_subBands.size() + 1 >= NO_SUB_BAND, "Too many SubBands");
+    m_subBands.push_back(subBand);
+    UpdateIndices();
+}
+
+const std::vector<Ptr<LogicalLoraChannel>>&
+LogicalLoraChannelPlan::GetChannels() const
+{
+    return m_channels;
+}
+
+const std::vector<Ptr<SubBand>>&
+LogicalLoraChannelPlan::GetSubBands() const
+{
+    return m_subBands;
+}
+
+int
+LogicalLoraChannelPlan::GetChannelIndex(Ptr<const LogicalLoraChannel> channel) const
+{
+    std::pair<const LogicalLoraChannel*, uint8_t> key(PeekPointer(channel), 0);
+    auto it = std::lower_bound(m_channelIndices.begin(), m_channelIndices.end(), key);
+    if (it != m_channelIndices.end() && it->first == key.first)
+    {
+        return it->second;
+    }
+    return -1;
+}
+
+uint8_t
+LogicalLoraChannelPlan::GetChannelSubBand(uint8_t chIndex) const
+{
+    return m_channelSubBands.at(chIndex);
+}
+
+uint8_t
+LogicalLoraChannelPlan::GetFrequencySubBand(double frequency) const
+{
+    for (std::size_t s = 0; s < m_subBands.size(); s++)
+    {
+        if (m_subBands[s]->BelongsToSubBand(frequency))
+        {
+            return uint8_t(s);
+        }
+    }
+    return NO_SUB_BAND;
+}
+
+std::size_t
+LogicalLoraChannelPlan::GetMemoryUsage() const
+{
+    return sizeof(*this) +
+           m_channels.capacity() * (sizeof(Ptr<LogicalLoraChannel>) + sizeof(LogicalLoraChannel)) +
+           m_subBands.capacity() * (sizeof(Ptr<SubBand>) + sizeof(SubBand)) +
+           m_channelSubBands.capacity() +
+           m_channelIndices.capacity() * sizeof(std::pair<const LogicalLoraChannel*, uint8_t>);
+}
+
+void
+LogicalLoraChannelPlan::UpdateIndices()
+{
+    m_channelSubBands.resize(m_channels.size());
+    m_channelIndices.clear();
+    for (std::size_t i = 0; i < m_channels.size(); i++)
+    {
+        m_channelSubBands[i] = GetFrequencySubBand(m_channels[i]->GetFrequency());
+        m_channelIndices.emplace_back(PeekPointer(m_channels[i]), uint8_t(i));
+    }
+    std::sort(m_channelIndices.begin(), m_channelIndices.end());
+}
+
+} // namespace lorawan
+} // namespace ns3
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2017 University of Padova
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#ifndef LOGICAL_LORA_CHANNEL_PLAN_H
+#define LOGICAL_LORA_CHANNEL_PLAN_H
+
+#include "logical-lora-channel.h"
+#include "sub-band.h"
+
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+/**
+ * \ingroup lorawan
+ *
+ * The logical channels and SubBands of a region, which can be shared by the
+ * LogicalLoraChannelHelper instances of many devices.
+ *
+ * A plan only describes channels and SubBands: the state that differs between
+ * devices, i.e., the channel mask and the time each SubBand allows the next
+ * transmission, is kept by each LogicalLoraChannelHelper. A plan referenced by
+ * more than one owner must not be modified: helpers copy it before changing
+ * their channels (e.g., on a NewChannelReq), so that the channel and SubBand
+ * objects of a plan can be considered immutable.
+ */
+class LogicalLoraChannelPlan : public SimpleRefCount<LogicalLoraChannelPlan>
+{
+  public:
+    /// Index of a channel outside any SubBand
+    static const uint8_t NO_SUB_BAND = 255;
+
+    /**
+     * Add a channel at the end of the plan.
+     *
+     * \param channel The channel.
+     */
+    void AddChannel(Ptr<LogicalLoraChannel> channel);
+
+    /**
+     * Replace the channel at an index.
+     *
+     * \param chIndex The index of the channel to substitute.
+     * \param channel The new channel.
+     */
+    void SetChannel(uint8_t chIndex, Ptr<LogicalLoraChannel> channel);
+
+    /**
+     * Remove the first channel with the same frequency as a given one.
+     *
+     * \param channel The channel.
+     * \return The index the channel had, or -1 if no channel was removed.
+     */
+    int RemoveChannel(Ptr<LogicalLoraChannel> channel);
+
+    /**
+     * Add a SubBand to the plan.
+     *
+     * \param subBand The SubBand.
+     */
+    void AddSubBand(Ptr<SubBand> subBand);
+
+    /**
+     * Get the channels of the plan.
+     *
+     * \return The channels, in the order of the channel mask.
+     */
+    const std::vector<Ptr<LogicalLoraChannel>>& GetChannels() const;
+
+    /**
+     * Get the SubBands of the plan.
+     *
+     * \return The SubBands.
+     */
+    const std::vector<Ptr<SubBand>>& GetSubBands() const;
+
+    /**
+     * Get the index of a channel of the plan.
+     *
+     * \param channel The channel object.
+     * \return The index of the channel, or -1 if the object doesn't belong to
+     * the plan.
+     */
+    int GetChannelIndex(Ptr<const LogicalLoraChannel> channel) const;
+
+    /**
+     * Get the index of the SubBand a channel of the plan belongs to.
+     *
+     * \param chIndex The index of the channel.
+     * \return The index of the SubBand, or NO_SUB_BAND.
+     */
+    uint8_t GetChannelSubBand(uint8_t chIndex) const;
+
+    /**
+     * Get the index of the SubBand a frequency belongs to.
+     *
+     * \param frequency The frequency [MHz].
+     * \return The index of the SubBand, or NO_SUB_BAND.
+     */
+    uint8_t GetFrequencySubBand(double frequency) const;
+
+    /**
+     * Get the approximate number of bytes used by the plan, including its
+     * channel and SubBand objects.
+     *
+     * \return The size of the plan, in bytes.
+     */
+    std::size_t GetMemoryUsage() const;
+
+  private:
+    /**
+     * Rebuild the channel to SubBand mapping and the index of channel objects.
+     */
+    void UpdateIndices();
+
+    std::vector<Ptr<LogicalLoraChannel>> m_channels; //!< The channels of the plan
+    std::vector<Ptr<SubBand>> m_subBands;            //!< The SubBands of the plan
+    std::vector<uint8_t> m_channelSubBands;          //!< The SubBand index of each channel
+
+    /// The channels sorted by address, with their index in m_channels
+    std::vector<std::pair<const LogicalLoraChannel*, uint8_t>> m_channelIndices;
+};
+
+} // namespace lorawan
+} // namespace ns3
+
+#endif /* LOGICAL_LORA_CHANNEL_PLAN_H */
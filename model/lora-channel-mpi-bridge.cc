@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2017 University of Padova
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#include "lora-channel-mpi-bridge.h"
+
+#include "ns3/abort.h"
+#include "ns3/distributed-simulator-impl.h"
+#include "ns3/log.h"
+#include "ns3/mpi-interface.h"
+#include "ns3/mpi-receiver.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simulator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+NS_LOG_COMPONENT_DEFINE("LoraChannelMpiBridge");
+
+NS_OBJECT_ENSURE_REGISTERED(LoraChannelMpiHeader);
+
+/**
+ * Write a double to a buffer, in network byte order.
+ *
+ * \param start The buffer iterator.
+ * \param value The value to write.
+ */
+static void
+WriteDouble(Buffer::Iterator& start, double value)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    start.WriteHtonU64(bits);
+}
+
+/**
+ * Read a double written by WriteDouble.
+ *
+ * \param start The buffer iterator.
+ * \return The value read.
+ */
+static double
+ReadDouble(Buffer::Iterator& start)
+{
+    uint64_t bits = start.ReadNtohU64();
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/**
+ * Compute the distance between a position and the closest point of a box.
+ *
+ * \param position The position.
+ * \param box The box.
+ * \return The distance [m], zero if the position is inside the box.
+ */
+static double
+GetDistanceToBox(const Vector& position, const Box& box)
+{
+    double dx = std::max({box.xMin - position.x, 0.0, position.x - box.xMax});
+    double dy = std::max({box.yMin - position.y, 0.0, position.y - box.yMax});
+    double dz = std::max({box.zMin - position.z, 0.0, position.z - box.zMax});
+    return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+LoraChannelMpiHeader::LoraChannelMpiHeader()
+    : txPowerDbm(0),
+      sf(0),
+      frequencyMHz(0)
+{
+}
+
+LoraChannelMpiHeader::~LoraChannelMpiHeader()
+{
+}
+
+TypeId
+LoraChannelMpiHeader::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::LoraChannelMpiHeader")
+                            .SetParent<Header>()
+                            .SetGroupName("lorawan")
+                            .AddConstructor<LoraChannelMpiHeader>();
+    return tid;
+}
+
+TypeId
+LoraChannelMpiHeader::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+uint32_t
+LoraChannelMpiHeader::GetSerializedSize() const
+{
+    // 3 doubles for the position, 2 for power and frequency, 2 time steps and
+    // 1 byte for the spreading factor
+    return 7 * 8 + 1;
+}
+
+void
+LoraChannelMpiHeader::Serialize(Buffer::Iterator start) const
+{
+    WriteDouble(start, position.x);
+    WriteDouble(start, position.y);
+    WriteDouble(start, position.z);
+    WriteDouble(start, txPowerDbm);
+    WriteDouble(start, frequencyMHz);
+    start.WriteHtonU64(duration.GetTimeStep());
+    start.WriteHtonU64(txTime.GetTimeStep());
+    start.WriteU8(sf);
+}
+
+uint32_t
+LoraChannelMpiHeader::Deserialize(Buffer::Iterator start)
+{
+    position.x = ReadDouble(start);
+    position.y = ReadDouble(start);
+    position.z = ReadDouble(start);
+    txPowerDbm = ReadDouble(start);
+    frequencyMHz = ReadDouble(start);
+    duration = TimeStep(start.ReadNtohU64());
+    txTime = TimeStep(start.ReadNtohU64());
+    sf = start.ReadU8();
+
+    return GetSerializedSize();
+}
+
+void
+LoraChannelMpiHeader::Print(std::ostream& os) const
+{
+    os << "Position=" << position << ", TxPower=" << txPowerDbm << ", SF=" << unsigned(sf)
+       << ", Duration=" << duration << ", Frequency=" << frequencyMHz << ", TxTime=" << txTime;
+}
+
+NS_OBJECT_ENSURE_REGISTERED(LoraChannelMpiBridge);
+
+TypeId
+LoraChannelMpiBridge::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::LoraChannelMpiBridge")
+            .SetParent<Object>()
+            .SetGroupName("lorawan")
+            .AddConstructor<LoraChannelMpiBridge>()
+            .AddAttribute("MinDelay",
+                          "Delay after which packets sent on a rank reach the other ranks. "
+                          "This is the lookahead of the distributed simulator: receptions on "
+                          "remote ranks start at the largest between this value and the "
+                          "propagation delay.",
+                          TimeValue(MicroSeconds(100)),
+                          MakeTimeAccessor(&LoraChannelMpiBridge::m_minDelay),
+                          MakeTimeChecker(NanoSeconds(1)));
+    return tid;
+}
+
+LoraChannelMpiBridge::LoraChannelMpiBridge()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+LoraChannelMpiBridge::~LoraChannelMpiBridge()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+LoraChannelMpiBridge::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+
+    m_channel = nullptr;
+    m_nodes.clear();
+    m_rankRegions.clear();
+
+    Object::DoDispose();
+}
+
+void
+LoraChannelMpiBridge::Install(Ptr<LoraChannel> channel)
+{
+    NS_LOG_FUNCTION(this << channel);
+
+    NS_ABORT_MSG_UNLESS(MpiInterface::IsEnabled(),
+                        "MpiInterface::Enable must be called before installing the bridge");
+
+    m_channel = channel;
+    uint32_t rank = MpiInterface::GetSystemId();
+
+    // Create the node receiving messages on each rank, with the same id everywhere
+    for (uint32_t r = 0; r < MpiInterface::GetSize(); r++)
+    {
+        Ptr<Node> node = CreateObject<Node>(r);
+        Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice>();
+        node->AddDevice(device);
+        if (r == rank)
+        {
+            Ptr<MpiReceiver> receiver = CreateObject<MpiReceiver>();
+            receiver->SetReceiveCallback(MakeCallback(&LoraChannelMpiBridge::ReceiveRemote, this));
+            device->AggregateObject(receiver);
+        }
+        m_nodes.push_back(node);
+    }
+
+    channel->SetSystemId(rank);
+    channel->SetRemoteSendCallback(MakeCallback(&LoraChannelMpiBridge::SendRemote, this));
+
+    // Messages take at least m_minDelay to reach other ranks
+    Ptr<DistributedSimulatorImpl> simulator =
+        DynamicCast<DistributedSimulatorImpl>(Simulator::GetImplementation());
+    NS_ABORT_MSG_UNLESS(simulator,
+                        "LoraChannelMpiBridge requires ns3::DistributedSimulatorImpl");
+    simulator->BoundLookAhead(m_minDelay);
+}
+
+void
+LoraChannelMpiBridge::SetRankRegion(uint32_t rank, const Box& region)
+{
+    NS_LOG_FUNCTION(this << rank << region);
+
+    m_rankRegions[rank] = region;
+}
+
+void
+LoraChannelMpiBridge::SendRemote(Vector senderPosition,
+                                 Ptr<Packet> packet,
+                                 double txPowerDbm,
+                                 uint8_t sf,
+                                 Time duration,
+                                 double frequencyMHz)
+{
+    NS_LOG_FUNCTION(this << senderPosition << packet << txPowerDbm << unsigned(sf) << duration
+                         << frequencyMHz);
+
+    LoraChannelMpiHeader header;
+    header.position = senderPosition;
+    header.txPowerDbm = txPowerDbm;
+    header.sf = sf;
+    header.duration = duration;
+    header.frequencyMHz = frequencyMHz;
+    header.txTime = Simulator::Now();
+
+    Ptr<Packet> message = packet->Copy();
+    message->AddHeader(header);
+
+    // Only forward the packet to the ranks it can reach
+    double maxRange = m_rankRegions.empty() ? 0 : m_channel->GetMaxRange(txPowerDbm);
+
+    uint32_t rank = MpiInterface::GetSystemId();
+    for (uint32_t r = 0; r < m_nodes.size(); r++)
+    {
+        if (r == rank)
+        {
+            continue;
+        }
+
+        auto region = m_rankRegions.find(r);
+        if (region != m_rankRegions.end() &&
+            GetDistanceToBox(senderPosition, region->second) > maxRange)
+        {
+            NS_LOG_DEBUG("Not forwarding the packet to rank " << r << ", which is out of range");
+            continue;
+        }
+
+        MpiInterface::SendPacket(message->Copy(),
+                                 Simulator::Now() + m_minDelay,
+                                 m_nodes[r]->GetId(),
+                                 0);
+    }
+}
+
+void
+LoraChannelMpiBridge::ReceiveRemote(Ptr<Packet> packet)
+{
+    NS_LOG_FUNCTION(this << packet);
+
+    LoraChannelMpiHeader header;
+    packet->RemoveHeader(header);
+
+    m_channel->ReceiveRemote(header.position,
+                             packet,
+                             header.txPowerDbm,
+                             header.sf,
+                             header.duration,
+                             header.frequencyMHz,
+                             Simulator::Now() - header.txTime);
+}
+
+} // namespace lorawan
+} // namespace ns3
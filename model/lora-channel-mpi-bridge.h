@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2017 University of Padova
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#ifndef LORA_CHANNEL_MPI_BRIDGE_H
+#define LORA_CHANNEL_MPI_BRIDGE_H
+
+#include "lora-channel.h"
+
+#include "ns3/box.h"
+#include "ns3/header.h"
+#include "ns3/node.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/vector.h"
+
+#include <map>
+#include <vector>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+/**
+ * \ingroup lorawan
+ *
+ * Header carrying the parameters of a transmission across the partitions of a
+ * distributed simulation.
+ *
+ * The packet it is added to is the one sent by the PHY, so that the remote
+ * partition can deliver it to its own PHYs.
+ */
+class LoraChannelMpiHeader : public Header
+{
+  public:
+    LoraChannelMpiHeader();           //!< Default constructor
+    ~LoraChannelMpiHeader() override; //!< Destructor
+
+    /**
+     *  Register this type.
+     *  \return The object TypeId.
+     */
+    static TypeId GetTypeId();
+
+    TypeId GetInstanceTypeId() const override;
+    uint32_t GetSerializedSize() const override;
+    void Serialize(Buffer::Iterator start) const override;
+    uint32_t Deserialize(Buffer::Iterator start) override;
+    void Print(std::ostream& os) const override;
+
+    Vector position;     //!< The position of the sender
+    double txPowerDbm;   //!< The power of the transmission
+    uint8_t sf;          //!< The spreading factor of the transmission
+    Time duration;       //!< The on-air duration of the packet
+    double frequencyMHz; //!< The frequency of the transmission
+    Time txTime;         //!< The time the packet was sent at
+};
+
+/**
+ * \ingroup lorawan
+ *
+ * Connects the LoraChannel instances of the partitions of a distributed
+ * simulation, so that packets sent by a PHY reach the PHYs of all ranks.
+ *
+ * Each rank only delivers packets to the PHYs of the nodes it owns (i.e.,
+ * whose system id is the MPI rank), and forwards the packets its PHYs send to
+ * the other ranks as a compact message. Remote ranks receive the message
+ * MinDelay after the transmission, and deliver the packet to their PHYs after
+ * the remaining part of the propagation delay, if any: MinDelay is the
+ * lookahead of the distributed simulator. If the regions holding the PHYs of
+ * the other ranks are known (see SetRankRegion), packets are only forwarded
+ * to the ranks they can reach.
+ *
+ * The bridge needs to be installed on all ranks at the same point of the
+ * scenario construction, since it creates one node per rank and nodes need to
+ * have the same ids on all ranks.
+ */
+class LoraChannelMpiBridge : public Object
+{
+  public:
+    /**
+     *  Register this type.
+     *  \return The object TypeId.
+     */
+    static TypeId GetTypeId();
+
+    LoraChannelMpiBridge();           //!< Default constructor
+    ~LoraChannelMpiBridge() override; //!< Destructor
+
+    /**
+     * Connect a channel to the ones of the other ranks.
+     *
+     * \param channel The channel of this rank.
+     */
+    void Install(Ptr<LoraChannel> channel);
+
+    /**
+     * Set the region holding the PHYs of a rank.
+     *
+     * Packets are then only forwarded to the rank if the region is within
+     * LoraChannel::GetMaxRange of the sender, which also accounts for signals
+     * below sensitivity that may still interfere. Packets are always forwarded
+     * to ranks whose region is not set. The region must contain all PHYs of
+     * the rank, including those that move, for the whole simulation.
+     *
+     * \param rank The MPI rank.
+     * \param region The box containing all PHYs of the rank.
+     */
+    void SetRankRegion(uint32_t rank, const Box& region);
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /**
+     * Forward a packet sent by a local PHY to the other ranks.
+     *
+     * \param senderPosition The position of the sender.
+     * \param packet The packet being sent.
+     * \param txPowerDbm The power of the transmission.
+     * \param sf The spreading factor of the transmission.
+     * \param duration The on-air duration of the packet.
+     * \param frequencyMHz The frequency of the transmission.
+     */
+    void SendRemote(Vector senderPosition,
+                    Ptr<Packet> packet,
+                    double txPowerDbm,
+                    uint8_t sf,
+                    Time duration,
+                    double frequencyMHz);
+
+    /**
+     * Deliver a packet received from another rank to the local channel.
+     *
+     * \param packet The packet, including the LoraChannelMpiHeader.
+     */
+    void ReceiveRemote(Ptr<Packet> packet);
+
+    Time m_minDelay;                       //!< Delay after which remote ranks receive messages
+    Ptr<LoraChannel> m_channel;            //!< The channel of this rank
+    std::vector<Ptr<Node>> m_nodes;        //!< The node receiving messages on each rank
+    std::map<uint32_t, Box> m_rankRegions; //!< The region holding the PHYs of each rank, if known
+};
+
+} // namespace lorawan
+
+} // namespace ns3
+#endif /* LORA_CHANNEL_MPI_BRIDGE_H */
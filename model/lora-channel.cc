@@ -8,16 +8,26 @@
 
 #include "lora-channel.h"
 
+#include "building-penetration-loss.h"
 #include "end-device-lora-phy.h"
 #include "gateway-lora-phy.h"
 
+#include "ns3/boolean.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/double.h"
+#include "ns3/jakes-propagation-loss-model.h"
 #include "ns3/log.h"
 #include "ns3/object-factory.h"
 #include "ns3/packet.h"
 #include "ns3/pointer.h"
 #include "ns3/simulator.h"
+#include "ns3/uinteger.h"
 
 #include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <sstream>
 
 namespace ns3
 {
@@ -46,6 +56,94 @@ LoraChannel::GetTypeId()
                           PointerValue(),
                           MakePointerAccessor(&LoraChannel::m_delay),
                           MakePointerChecker<PropagationDelayModel>())
+            .AddAttribute("SpatialIndex",
+                          "Whether to use a spatial index over receiver positions to only "
+                          "deliver packets to PHYs that are within range of the sender. PHYs "
+                          "without a ConstantPositionMobilityModel, which may move without "
+                          "notice, are checked at each transmission.",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&LoraChannel::m_spatialIndexEnabled),
+                          MakeBooleanChecker())
+            .AddAttribute("SpatialIndexCellSize",
+                          "The side [m] of the square cells of the spatial index.",
+                          DoubleValue(1000),
+                          MakeDoubleAccessor(&LoraChannel::m_cellSize),
+                          MakeDoubleChecker<double>(1))
+            .AddAttribute("RangeCullingMargin",
+                          "Margin [dB] added to the loss budget when computing the maximum "
+                          "range of a transmission, beyond the lowest sensitivity and the "
+                          "isolation of the collision matrix. The default covers the summed "
+                          "energy of up to ten signals that are each too weak to destroy a "
+                          "packet; loss models that can provide a gain (e.g., shadowing) need "
+                          "a larger margin.",
+                          DoubleValue(10),
+                          MakeDoubleAccessor(&LoraChannel::m_cullingMarginDb),
+                          MakeDoubleChecker<double>(0))
+            .AddAttribute("ValidateRangeCulling",
+                          "Whether to check, on every transmission, that the spatial index "
+                          "visits all the PHYs that the loop over every PHY would deliver the "
+                          "packet to at a power that can be received, or that can destroy a "
+                          "packet received at sensitivity. This calls the loss model for "
+                          "every PHY, and is meant for debugging.",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&LoraChannel::m_validateCulling),
+                          MakeBooleanChecker())
+            .AddAttribute("LinkCache",
+                          "Whether to cache the link budget (received power and delay) "
+                          "between each pair of PHYs, until one of them moves. Only links "
+                          "between PHYs with a ConstantPositionMobilityModel are cached, since "
+                          "other models may move without notice.",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&LoraChannel::m_linkCacheEnabled),
+                          MakeBooleanChecker())
+            .AddAttribute("FreezeRandomLoss",
+                          "Whether to also cache links when the loss or delay models draw "
+                          "new random values at each call, freezing the first draw of each "
+                          "link. If false, the cache is not used with such models.",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&LoraChannel::m_freezeRandomLoss),
+                          MakeBooleanChecker())
+            .AddAttribute("ReceiverSubscriptions",
+                          "Whether PHYs that subscribe to the channel (e.g., end devices) "
+                          "are only notified of transmissions that overlap the intervals "
+                          "during which they listen.",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&LoraChannel::m_subscriptionsEnabled),
+                          MakeBooleanChecker())
+            .AddAttribute("SharedAirLog",
+                          "Whether to record each transmission once in a log shared by all "
+                          "PHYs, which look up the signals overlapping a packet when its "
+                          "reception ends instead of storing every signal they hear.",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&LoraChannel::SetSharedAirLog,
+                                              &LoraChannel::GetSharedAirLog),
+                          MakeBooleanChecker())
+            .AddAttribute("BatchedDelivery",
+                          "Whether to schedule a single reception event for all PHYs of a node "
+                          "that share the same propagation delay, instead of one per PHY.",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&LoraChannel::m_batchedDelivery),
+                          MakeBooleanChecker())
+            .AddAttribute("DelayQuantum",
+                          "Granularity used to group propagation delays when BatchedDelivery "
+                          "is set: receptions start at the delay rounded down to a multiple of "
+                          "this value. Zero only groups PHYs with identical delays.",
+                          TimeValue(MicroSeconds(1)),
+                          MakeTimeAccessor(&LoraChannel::m_delayQuantum),
+                          MakeTimeChecker(Seconds(0)))
+            .AddAttribute("ComputeThreads",
+                          "The number of threads used to compute the received power and "
+                          "delay towards the receivers of a packet. Only deterministic, "
+                          "position-based loss and delay models are computed in parallel.",
+                          UintegerValue(1),
+                          MakeUintegerAccessor(&LoraChannel::m_computeThreads),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("ParallelThreshold",
+                          "The minimum number of receivers of a packet for link budgets to "
+                          "be computed on multiple threads.",
+                          UintegerValue(256),
+                          MakeUintegerAccessor(&LoraChannel::m_parallelThreshold),
+                          MakeUintegerChecker<uint32_t>())
             .AddTraceSource("PacketSent",
                             "Trace source fired whenever a packet goes out on the channel",
                             MakeTraceSourceAccessor(&LoraChannel::m_packetSent),
@@ -54,6 +152,23 @@ LoraChannel::GetTypeId()
 }
 
 LoraChannel::LoraChannel()
+    : m_spatialIndexEnabled(false),
+      m_cellSize(1000),
+      m_cullingMarginDb(10),
+      m_validateCulling(false),
+      m_physDirty(true),
+      m_spatialIndexDirty(true),
+      m_linkCacheEnabled(false),
+      m_freezeRandomLoss(false),
+      m_subscriptionsEnabled(false),
+      m_maxDelay(Seconds(0)),
+      m_sharedAirLog(false),
+      m_maxAirDuration(Seconds(0)),
+      m_batchedDelivery(false),
+      m_delayQuantum(MicroSeconds(1)),
+      m_computeThreads(1),
+      m_parallelThreshold(256),
+      m_systemId(std::numeric_limits<uint32_t>::max())
 {
 }
 
@@ -64,10 +179,58 @@ LoraChannel::~LoraChannel()
 
 LoraChannel::LoraChannel(Ptr<PropagationLossModel> loss, Ptr<PropagationDelayModel> delay)
     : m_loss(loss),
-      m_delay(delay)
+      m_delay(delay),
+      m_spatialIndexEnabled(false),
+      m_cellSize(1000),
+      m_cullingMarginDb(10),
+      m_validateCulling(false),
+      m_physDirty(true),
+      m_spatialIndexDirty(true),
+      m_linkCacheEnabled(false),
+      m_freezeRandomLoss(false),
+      m_subscriptionsEnabled(false),
+      m_maxDelay(Seconds(0)),
+      m_sharedAirLog(false),
+      m_maxAirDuration(Seconds(0)),
+      m_batchedDelivery(false),
+      m_delayQuantum(MicroSeconds(1)),
+      m_computeThreads(1),
+      m_parallelThreshold(256),
+      m_systemId(std::numeric_limits<uint32_t>::max())
 {
 }
 
+void
+LoraChannel::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+
+    // Stop following the movements of the tracked mobility models
+    const LoraChannel* self = this;
+    for (auto& tracked : m_trackedMobility)
+    {
+        tracked.first->TraceDisconnectWithoutContext(
+            "CourseChange",
+            MakeCallback(&LoraChannel::CourseChanged, self));
+    }
+    m_trackedMobility.clear();
+    m_phyIndexes.clear();
+    m_grid.clear();
+    m_linkCache.clear();
+    m_interests.clear();
+    m_airLog.clear();
+    m_pendingBatches.clear();
+    m_batchOrder.clear();
+    m_contexts.clear();
+    m_workers = nullptr;
+    m_senderStandIn = nullptr;
+    m_proxies.clear();
+    m_remoteSendCallback = RemoteSendCallback();
+    m_linkTable = nullptr;
+
+    Channel::DoDispose();
+}
+
 void
 LoraChannel::Add(Ptr<LoraPhy> phy)
 {
@@ -75,6 +238,35 @@ LoraChannel::Add(Ptr<LoraPhy> phy)
 
     // Add the new phy to the vector
     m_phyList.push_back(phy);
+    m_phyIndexes[PeekPointer(phy)] = m_phyList.size() - 1;
+
+    // Cache the context of the PHY, if it is already attached to a node
+    m_contexts.push_back(std::numeric_limits<uint32_t>::max());
+    GetContext(m_phyList.size() - 1);
+
+    // End devices only listen when they are not sleeping or transmitting
+    ReceiverInterest interest;
+    Ptr<EndDeviceLoraPhy> edPhy = DynamicCast<EndDeviceLoraPhy>(phy);
+    if (m_subscriptionsEnabled && edPhy)
+    {
+        interest.subscribed = true;
+        if (edPhy->GetState() == EndDeviceLoraPhy::STANDBY ||
+            edPhy->GetState() == EndDeviceLoraPhy::RX)
+        {
+            interest.intervals.emplace_back(Simulator::Now(), Time::Max());
+        }
+    }
+    m_interests.push_back(interest);
+
+    if (m_sharedAirLog)
+    {
+        phy->SetSharedAirLog(true);
+    }
+
+    // Tracking of PHYs is lazily refreshed at the next transmission, since the
+    // mobility of the PHY may not be available yet
+    m_physDirty = true;
+    m_spatialIndexDirty = true;
 }
 
 void
@@ -83,7 +275,45 @@ LoraChannel::Remove(Ptr<LoraPhy> phy)
     NS_LOG_FUNCTION(this << phy);
 
     // Remove the phy from the vector
-    m_phyList.erase(find(m_phyList.begin(), m_phyList.end(), phy));
+    auto it = find(m_phyList.begin(), m_phyList.end(), phy);
+    uint32_t removed = it - m_phyList.begin();
+    m_interests.erase(m_interests.begin() + removed);
+    m_contexts.erase(m_contexts.begin() + removed);
+    m_phyList.erase(it);
+
+    if (m_sharedAirLog)
+    {
+        phy->SetSharedAirLog(false);
+    }
+
+    // Indexes of the following PHYs shifted
+    m_phyIndexes.clear();
+    for (uint32_t j = 0; j < m_phyList.size(); j++)
+    {
+        m_phyIndexes[PeekPointer(m_phyList[j])] = j;
+    }
+    if (m_sharedAirLog)
+    {
+        // Transmissions still on air are needed by the other PHYs: only
+        // forget the indexes they refer to
+        for (auto& record : m_airLog)
+        {
+            record.senderIndex = -1;
+            record.delivered.erase(
+                std::remove(record.delivered.begin(), record.delivered.end(), removed),
+                record.delivered.end());
+            for (auto& j : record.delivered)
+            {
+                j -= (j > removed);
+            }
+        }
+    }
+    else
+    {
+        m_airLog.clear();
+    }
+    m_physDirty = true;
+    m_spatialIndexDirty = true;
 }
 
 std::size_t
@@ -113,89 +343,1662 @@ LoraChannel::Send(Ptr<LoraPhy> sender,
 
     NS_ASSERT(senderMobility); // Make sure it's available
 
-    NS_LOG_INFO("Starting cycle over all " << m_phyList.size() << " PHYs");
-    NS_LOG_INFO("Sender mobility: " << senderMobility->GetPosition());
+    Propagate(sender,
+              senderMobility,
+              packet,
+              txPowerDbm,
+              txParams,
+              duration,
+              frequencyMHz,
+              Seconds(0));
+
+    // Let the other partitions of the simulation deliver the packet to their PHYs
+    if (!m_remoteSendCallback.IsNull())
+    {
+        m_remoteSendCallback(senderMobility->GetPosition(),
+                             packet,
+                             txPowerDbm,
+                             txParams.sf,
+                             duration,
+                             frequencyMHz);
+    }
+}
+
+void
+LoraChannel::Send(const Vector& senderPosition,
+                  Ptr<Packet> packet,
+                  double txPowerDbm,
+                  LoraTxParameters txParams,
+                  Time duration,
+                  double frequencyMHz) const
+{
+    NS_LOG_FUNCTION(this << senderPosition << packet << txPowerDbm << txParams << duration
+                         << frequencyMHz);
+
+    Ptr<MobilityModel> senderMobility = GetSenderStandIn(senderPosition);
+
+    Propagate(nullptr,
+              senderMobility,
+              packet,
+              txPowerDbm,
+              txParams,
+              duration,
+              frequencyMHz,
+              Seconds(0));
+
+    if (!m_remoteSendCallback.IsNull())
+    {
+        m_remoteSendCallback(senderPosition,
+                             packet,
+                             txPowerDbm,
+                             txParams.sf,
+                             duration,
+                             frequencyMHz);
+    }
+}
+
+void
+LoraChannel::ReceiveRemote(Vector senderPosition,
+                           Ptr<Packet> packet,
+                           double txPowerDbm,
+                           uint8_t sf,
+                           Time duration,
+                           double frequencyMHz,
+                           Time elapsed) const
+{
+    NS_LOG_FUNCTION(this << senderPosition << packet << txPowerDbm << unsigned(sf) << duration
+                         << frequencyMHz << elapsed);
+
+    // The sender lives in another partition: stand in for its position
+    Ptr<MobilityModel> senderMobility = GetSenderStandIn(senderPosition);
+
+    LoraTxParameters txParams;
+    txParams.sf = sf;
+
+    Propagate(nullptr,
+              senderMobility,
+              packet,
+              txPowerDbm,
+              txParams,
+              duration,
+              frequencyMHz,
+              elapsed);
+}
+
+void
+LoraChannel::SetSystemId(uint32_t systemId)
+{
+    NS_LOG_FUNCTION(this << systemId);
+
+    m_systemId = systemId;
+}
+
+void
+LoraChannel::SetRemoteSendCallback(RemoteSendCallback callback)
+{
+    m_remoteSendCallback = callback;
+}
+
+bool
+LoraChannel::IsLocal(uint32_t j) const
+{
+    if (m_systemId == std::numeric_limits<uint32_t>::max())
+    {
+        return true;
+    }
+
+    Ptr<NetDevice> device = m_phyList[j]->GetDevice();
+    return !device || !device->GetNode() || device->GetNode()->GetSystemId() == m_systemId;
+}
+
+Ptr<MobilityModel>
+LoraChannel::GetSenderStandIn(const Vector& position) const
+{
+    // The air log keeps the mobility model, so it can't be shared by packets
+    if (m_subscriptionsEnabled || m_sharedAirLog)
+    {
+        Ptr<MobilityModel> mobility = CreateObject<ConstantPositionMobilityModel>();
+        mobility->SetPosition(position);
+        return mobility;
+    }
+
+    if (!m_senderStandIn)
+    {
+        m_senderStandIn = CreateObject<ConstantPositionMobilityModel>();
+    }
+    m_senderStandIn->SetPosition(position);
+    return m_senderStandIn;
+}
+
+void
+LoraChannel::Propagate(Ptr<LoraPhy> sender,
+                       Ptr<MobilityModel> senderMobility,
+                       Ptr<Packet> packet,
+                       double txPowerDbm,
+                       const LoraTxParameters& txParams,
+                       Time duration,
+                       double frequencyMHz,
+                       Time elapsed) const
+{
+    NS_LOG_FUNCTION(this << sender << packet << txPowerDbm << duration << frequencyMHz << elapsed);
 
-    // Cycle over all registered PHYs
-    uint32_t j = 0;
-    std::vector<Ptr<LoraPhy>>::const_iterator i;
-    for (i = m_phyList.begin(); i != m_phyList.end(); i++, j++)
+    // Look up the index of the sender to access cached links
+    int64_t senderIndex = -1;
+    if (m_spatialIndexEnabled || m_linkCacheEnabled || m_linkTable)
     {
-        // Do not deliver to the sender (*i is the current PHY)
-        if (sender != (*i))
+        if (m_physDirty)
+        {
+            TrackPhys();
+        }
+
+        if (sender && (m_linkTable || IsLinkCacheUsable()))
         {
-            // Get the receiver's mobility model
-            Ptr<MobilityModel> receiverMobility = (*i)->GetMobility()->GetObject<MobilityModel>();
+            auto it = m_phyIndexes.find(PeekPointer(sender));
+            if (it != m_phyIndexes.end())
+            {
+                senderIndex = it->second;
+            }
+        }
+    }
 
-            NS_LOG_INFO("Receiver mobility: " << receiverMobility->GetPosition());
+    // Remember this transmission, in case a PHY that is not notified now starts
+    // listening while the packet is still on air, or to let PHYs look up their
+    // interferers from the shared log
+    if (m_subscriptionsEnabled || m_sharedAirLog)
+    {
+        PurgeAirLog();
+        m_maxAirDuration = Max(m_maxAirDuration, duration);
+        m_airLog.push_back({sender,
+                            senderIndex,
+                            senderMobility,
+                            packet,
+                            txPowerDbm,
+                            txParams.sf,
+                            Simulator::Now() - elapsed,
+                            duration,
+                            frequencyMHz,
+                            {}});
+    }
 
-            // Compute delay using the delay model
-            Time delay = m_delay->GetDelay(senderMobility, receiverMobility);
+    // If possible, only visit the PHYs that are close enough to hear the packet
+    m_targets.clear();
+    bool culled = false;
+    if (m_spatialIndexEnabled)
+    {
+        double range = GetMaxRange(txPowerDbm);
+        if (std::isfinite(range))
+        {
+            if (m_spatialIndexDirty)
+            {
+                BuildSpatialIndex();
+            }
 
-            // Compute received power using the loss model
-            double rxPowerDbm = GetRxPower(txPowerDbm, senderMobility, receiverMobility);
+            CollectCandidates(senderMobility->GetPosition(), range);
 
-            NS_LOG_DEBUG("Propagation: txPower="
-                         << txPowerDbm << "dbm, rxPower=" << rxPowerDbm << "dbm, "
-                         << "distance=" << senderMobility->GetDistanceFrom(receiverMobility)
-                         << "m, delay=" << delay);
+            NS_LOG_INFO("Range is " << range << " m, visiting " << m_candidates.size()
+                                    << " out of " << m_phyList.size() << " PHYs");
 
-            // Get the id of the destination PHY to correctly format the context
-            Ptr<NetDevice> dstNetDevice = m_phyList[j]->GetDevice();
-            uint32_t dstNode = 0;
-            if (dstNetDevice)
+            if (m_validateCulling)
             {
-                NS_LOG_INFO("Getting node index from NetDevice, since it exists");
-                dstNode = dstNetDevice->GetNode()->GetId();
-                NS_LOG_DEBUG("dstNode = " << dstNode);
+                ValidateCandidates(sender, senderMobility, txPowerDbm);
             }
-            else
+
+            for (auto j : m_candidates)
             {
-                NS_LOG_INFO("No net device connected to the PHY, using context 0");
+                // Do not deliver to the sender, nor to PHYs of other partitions
+                if (sender != m_phyList[j] && IsLocal(j))
+                {
+                    m_targets.push_back(j);
+                }
             }
+            culled = true;
+        }
+        else
+        {
+            NS_LOG_INFO("Cannot bound the range with the current loss model, visiting all PHYs");
+        }
+    }
 
-            // Create the parameters object based on the calculations above
-            LoraChannelParameters parameters;
-            parameters.rxPowerDbm = rxPowerDbm;
-            parameters.sf = txParams.sf;
-            parameters.duration = duration;
-            parameters.frequencyMHz = frequencyMHz;
-
-            // Schedule the receive event
-            NS_LOG_INFO("Scheduling reception of the packet");
-            Simulator::ScheduleWithContext(dstNode,
-                                           delay,
-                                           &LoraChannel::Receive,
-                                           this,
-                                           j,
-                                           packet,
-                                           parameters);
+    if (!culled)
+    {
+        NS_LOG_INFO("Starting cycle over all " << m_phyList.size() << " PHYs");
+        NS_LOG_INFO("Sender mobility: " << senderMobility->GetPosition());
+
+        // Cycle over all registered PHYs
+        for (uint32_t j = 0; j < m_phyList.size(); j++)
+        {
+            // Do not deliver to the sender, nor to PHYs of other partitions
+            if (sender != m_phyList[j] && IsLocal(j))
+            {
+                m_targets.push_back(j);
+            }
+        }
+    }
 
-            // Fire the trace source for sent packet
-            m_packetSent(packet);
+    // Compute the link budget towards each receiver, then deliver the packet in
+    // the same order in which receivers were visited
+    ComputeLinkBudgets(senderIndex, senderMobility, txPowerDbm);
+    for (std::size_t k = 0; k < m_targets.size(); k++)
+    {
+        // Packets from other partitions reach us after part of the delay
+        if (elapsed.IsStrictlyPositive())
+        {
+            m_budgets[k].delay = Max(m_budgets[k].delay - elapsed, Seconds(0));
         }
+
+        Deliver(m_targets[k],
+                packet,
+                m_budgets[k].delay,
+                m_budgets[k].rxPowerDbm,
+                txParams,
+                duration,
+                frequencyMHz);
+    }
+
+    if (m_batchedDelivery)
+    {
+        FlushBatches();
     }
 }
 
 void
-LoraChannel::Receive(uint32_t i, Ptr<Packet> packet, LoraChannelParameters parameters) const
+LoraChannel::ComputeLinkBudgets(int64_t senderIndex,
+                                Ptr<MobilityModel> senderMobility,
+                                double txPowerDbm) const
 {
-    NS_LOG_FUNCTION(this << i << packet << parameters);
+    NS_LOG_FUNCTION(this << senderIndex << txPowerDbm);
 
-    // Call the appropriate PHY instance to let it begin reception
-    m_phyList[i]->StartReceive(packet,
-                               parameters.rxPowerDbm,
-                               parameters.sf,
-                               parameters.duration,
-                               parameters.frequencyMHz);
+    m_budgets.resize(m_targets.size());
+    bool parallel = m_computeThreads > 1 && m_targets.size() >= m_parallelThreshold;
+
+    // Chains of distance-based models are evaluated on the array of receiver
+    // positions, when links are not served by the cache
+    if (senderIndex < 0 &&
+        m_delay->GetInstanceTypeId() == ConstantSpeedPropagationDelayModel::GetTypeId() &&
+        GetBatchStages(m_batchStages))
+    {
+        m_receiverBatch.Clear();
+        for (auto j : m_targets)
+        {
+            m_receiverBatch.Add(m_phyList[j]->GetMobility()->GetPosition());
+        }
+        m_distances.resize(m_targets.size());
+        m_rxPowers.resize(m_targets.size());
+        Vector senderPosition = senderMobility->GetPosition();
+
+        NS_LOG_INFO("Computing " << m_targets.size() << " link budgets in a batch");
+
+        if (parallel)
+        {
+            StartWorkers();
+            m_workers->Run(m_targets.size(),
+                           [this, txPowerDbm, &senderPosition](uint32_t /* thread */,
+                                                               uint32_t begin,
+                                                               uint32_t end) {
+                               ComputeBatch(txPowerDbm,
+                                            senderPosition,
+                                            m_receiverBatch,
+                                            begin,
+                                            end,
+                                            m_batchStages,
+                                            m_distances.data(),
+                                            m_rxPowers.data());
+                           });
+        }
+        else
+        {
+            ComputeBatch(txPowerDbm,
+                         senderPosition,
+                         m_receiverBatch,
+                         0,
+                         m_targets.size(),
+                         m_batchStages,
+                         m_distances.data(),
+                         m_rxPowers.data());
+        }
+
+        // Same as ConstantSpeedPropagationDelayModel::GetDelay
+        DoubleValue speed;
+        m_delay->GetAttribute("Speed", speed);
+        for (std::size_t k = 0; k < m_targets.size(); k++)
+        {
+            m_budgets[k].delay = Seconds(m_distances[k] / speed.Get());
+            m_budgets[k].rxPowerDbm = m_rxPowers[k];
+        }
+        return;
+    }
+
+    // Models are only queried from several threads if they are stateless, and
+    // when links are not served by the cache
+    if (parallel && senderIndex < 0 && IsParallelSafe())
+    {
+        StartWorkers();
+
+        // Mobility models may update their state when queried, and reference
+        // counts are not thread safe: sample all positions on this thread, and
+        // let each worker only use its own pair of proxy mobility models
+        m_positions.resize(m_targets.size());
+        for (std::size_t k = 0; k < m_targets.size(); k++)
+        {
+            m_positions[k] = m_phyList[m_targets[k]]->GetMobility()->GetPosition();
+        }
+        for (auto& proxy : m_proxies)
+        {
+            proxy.first->SetPosition(senderMobility->GetPosition());
+        }
+
+        NS_LOG_INFO("Computing " << m_targets.size() << " link budgets on " << m_computeThreads
+                                 << " threads");
+
+        m_workers->Run(m_targets.size(),
+                       [this, txPowerDbm](uint32_t t, uint32_t begin, uint32_t end) {
+                           MobilityModel* senderProxy = PeekPointer(m_proxies[t].first);
+                           MobilityModel* receiverProxy = PeekPointer(m_proxies[t].second);
+                           for (uint32_t k = begin; k < end; k++)
+                           {
+                               receiverProxy->SetPosition(m_positions[k]);
+                               m_budgets[k].delay = m_delay->GetDelay(senderProxy, receiverProxy);
+                               m_budgets[k].rxPowerDbm =
+                                   m_loss->CalcRxPower(txPowerDbm, senderProxy, receiverProxy);
+                           }
+                       });
+        return;
+    }
+
+    for (std::size_t k = 0; k < m_targets.size(); k++)
+    {
+        uint32_t j = m_targets[k];
+
+        // Get the receiver's mobility model
+        Ptr<MobilityModel> receiverMobility =
+            m_phyList[j]->GetMobility()->GetObject<MobilityModel>();
+
+        NS_LOG_INFO("Receiver mobility: " << receiverMobility->GetPosition());
+
+        GetLinkBudget(j,
+                      senderIndex,
+                      senderMobility,
+                      receiverMobility,
+                      txPowerDbm,
+                      m_budgets[k].delay,
+                      m_budgets[k].rxPowerDbm);
+
+        NS_LOG_DEBUG("Propagation: txPower="
+                     << txPowerDbm << "dbm, rxPower=" << m_budgets[k].rxPowerDbm << "dbm, "
+                     << "distance=" << senderMobility->GetDistanceFrom(receiverMobility)
+                     << "m, delay=" << m_budgets[k].delay);
+    }
 }
 
-double
-LoraChannel::GetRxPower(double txPowerDbm,
-                        Ptr<MobilityModel> senderMobility,
-                        Ptr<MobilityModel> receiverMobility) const
+void
+LoraChannel::StartWorkers() const
 {
-    return m_loss->CalcRxPower(txPowerDbm, senderMobility, receiverMobility);
+    if (!m_workers || m_workers->GetNThreads() != m_computeThreads)
+    {
+        m_workers = Create<WorkerPool>(m_computeThreads);
+        m_proxies.clear();
+        for (uint32_t t = 0; t < m_computeThreads; t++)
+        {
+            m_proxies.emplace_back(CreateObject<ConstantPositionMobilityModel>(),
+                                   CreateObject<ConstantPositionMobilityModel>());
+        }
+    }
+}
+
+bool
+LoraChannel::GetBatchStages(std::vector<BatchLossStage>& stages) const
+{
+    stages.clear();
+    for (Ptr<PropagationLossModel> model = m_loss; model; model = model->GetNext())
+    {
+        TypeId tid = model->GetInstanceTypeId();
+        if (tid == LogDistancePropagationLossModel::GetTypeId())
+        {
+            DoubleValue exponent;
+            DoubleValue referenceDistance;
+            DoubleValue referenceLoss;
+            model->GetAttribute("Exponent", exponent);
+            model->GetAttribute("ReferenceDistance", referenceDistance);
+            model->GetAttribute("ReferenceLoss", referenceLoss);
+            stages.push_back({BatchLossStage::LOG_DISTANCE,
+                              referenceDistance.Get(),
+                              referenceLoss.Get(),
+                              exponent.Get()});
+        }
+        else if (tid == FixedRssLossModel::GetTypeId())
+        {
+            DoubleValue rss;
+            model->GetAttribute("Rss", rss);
+            stages.push_back({BatchLossStage::FIXED_RSS, 0, rss.Get(), 0});
+        }
+        else if (tid == RangePropagationLossModel::GetTypeId())
+        {
+            DoubleValue range;
+            model->GetAttribute("MaxRange", range);
+            stages.push_back({BatchLossStage::RANGE, range.Get(), 0, 0});
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void
+LoraChannel::ComputeBatch(double txPowerDbm,
+                          const Vector& senderPosition,
+                          const LoraPositionBatch& receivers,
+                          std::size_t begin,
+                          std::size_t end,
+                          const std::vector<BatchLossStage>& stages,
+                          double* distances,
+                          double* rxPowersDbm) const
+{
+    const double* x = receivers.x.data();
+    const double* y = receivers.y.data();
+    const double* z = receivers.z.data();
+    for (std::size_t k = begin; k < end; k++)
+    {
+        double dx = x[k] - senderPosition.x;
+        double dy = y[k] - senderPosition.y;
+        double dz = z[k] - senderPosition.z;
+        distances[k] = std::sqrt(dx * dx + dy * dy + dz * dz);
+        rxPowersDbm[k] = txPowerDbm;
+    }
+
+    // Each stage is applied to the output of the previous one, as in the
+    // chain, with selects instead of branches. Expressions are the same as in
+    // the models, so that results are identical.
+    for (const auto& stage : stages)
+    {
+        switch (stage.type)
+        {
+        case BatchLossStage::LOG_DISTANCE:
+            for (std::size_t k = begin; k < end; k++)
+            {
+                double pathLossDb = 10 * stage.exponent * std::log10(distances[k] / stage.distance);
+                pathLossDb = distances[k] <= stage.distance ? 0 : pathLossDb;
+                rxPowersDbm[k] += -stage.lossOrRssDb - pathLossDb;
+            }
+            break;
+        case BatchLossStage::FIXED_RSS:
+            for (std::size_t k = begin; k < end; k++)
+            {
+                rxPowersDbm[k] = stage.lossOrRssDb;
+            }
+            break;
+        case BatchLossStage::RANGE:
+            for (std::size_t k = begin; k < end; k++)
+            {
+                rxPowersDbm[k] = distances[k] <= stage.distance ? rxPowersDbm[k] : -1000;
+            }
+            break;
+        }
+    }
+}
+
+bool
+LoraChannel::IsParallelSafe() const
+{
+    // Only models whose output depends on the positions alone can be queried
+    // concurrently on proxy mobility models
+    static const std::vector<TypeId> safeLossModels = {
+        LogDistancePropagationLossModel::GetTypeId(),
+        ThreeLogDistancePropagationLossModel::GetTypeId(),
+        FriisPropagationLossModel::GetTypeId(),
+        TwoRayGroundPropagationLossModel::GetTypeId(),
+        FixedRssLossModel::GetTypeId(),
+        RangePropagationLossModel::GetTypeId()};
+
+    for (Ptr<PropagationLossModel> model = m_loss; model; model = model->GetNext())
+    {
+        if (std::find(safeLossModels.begin(),
+                      safeLossModels.end(),
+                      model->GetInstanceTypeId()) == safeLossModels.end())
+        {
+            return false;
+        }
+    }
+
+    return m_delay->GetInstanceTypeId() == ConstantSpeedPropagationDelayModel::GetTypeId();
+}
+
+void
+LoraChannel::Deliver(uint32_t j,
+                     Ptr<Packet> packet,
+                     Time delay,
+                     double rxPowerDbm,
+                     const LoraTxParameters& txParams,
+                     Time duration,
+                     double frequencyMHz) const
+{
+    NS_LOG_FUNCTION(this << j << packet << delay << rxPowerDbm);
+
+    if (m_subscriptionsEnabled || m_sharedAirLog)
+    {
+        m_maxDelay = std::max(m_maxDelay, delay);
+    }
+
+    if (m_subscriptionsEnabled)
+    {
+        // Skip PHYs that won't be listening while the packet is on air
+        Time arrival = Simulator::Now() + delay;
+        if (!IsInterested(j, arrival, arrival + duration))
+        {
+            NS_LOG_INFO("PHY " << j << " is not listening, skipping it");
+            return;
+        }
+        if (m_interests[j].subscribed)
+        {
+            m_airLog.back().delivered.push_back(j);
+        }
+    }
+
+    // Get the id of the destination PHY to correctly format the context
+    uint32_t dstNode = GetContext(j);
+
+    if (m_batchedDelivery)
+    {
+        // Group the reception with the others that start at the same time on
+        // the same node, since events must run in the context of the receiver
+        int64_t step = delay.GetTimeStep();
+        if (m_delayQuantum.IsStrictlyPositive())
+        {
+            step -= step % m_delayQuantum.GetTimeStep();
+        }
+
+        Ptr<ReceptionBatch>& batch = m_pendingBatches[{step, dstNode}];
+        if (!batch)
+        {
+            batch = Create<ReceptionBatch>();
+            batch->packet = packet;
+            batch->sf = txParams.sf;
+            batch->duration = duration;
+            batch->frequencyMHz = frequencyMHz;
+            m_batchOrder.emplace_back(step, batch);
+        }
+        batch->records.push_back({j, rxPowerDbm, dstNode});
+
+        m_packetSent(packet);
+        return;
+    }
+
+    // Create the parameters object based on the calculations above
+    LoraChannelParameters parameters;
+    parameters.rxPowerDbm = rxPowerDbm;
+    parameters.sf = txParams.sf;
+    parameters.duration = duration;
+    parameters.frequencyMHz = frequencyMHz;
+
+    // Schedule the receive event
+    NS_LOG_INFO("Scheduling reception of the packet");
+    Simulator::ScheduleWithContext(dstNode,
+                                   delay,
+                                   &LoraChannel::Receive,
+                                   this,
+                                   j,
+                                   packet,
+                                   parameters);
+
+    // Fire the trace source for sent packet
+    m_packetSent(packet);
+}
+
+void
+LoraChannel::GetLinkBudget(uint32_t j,
+                           int64_t senderIndex,
+                           Ptr<MobilityModel> senderMobility,
+                           Ptr<MobilityModel> receiverMobility,
+                           double txPowerDbm,
+                           Time& delay,
+                           double& rxPowerDbm) const
+{
+    // Only links between PHYs that notify their movements can be reused
+    bool reusable = senderIndex >= 0 && m_staticPhys[senderIndex] && m_staticPhys[j];
+
+    // Links in the table hold until either end moves
+    if (reusable && m_linkTable && m_generations[senderIndex] == 0 && m_generations[j] == 0 &&
+        m_linkTable->HasLink(senderIndex, j))
+    {
+        delay = TimeStep(m_linkTable->GetDelay(senderIndex, j));
+        rxPowerDbm = txPowerDbm + m_linkTable->GetGainDb(senderIndex, j);
+    }
+    else if (reusable && (!m_linkTable || IsLinkCacheUsable()))
+    {
+        // Reuse the link budget if neither end moved since it was computed
+        uint64_t key = (uint64_t(senderIndex) << 32) | j;
+        auto it = m_linkCache.find(key);
+        if (it == m_linkCache.end() ||
+            it->second.senderGeneration != m_generations[senderIndex] ||
+            it->second.receiverGeneration != m_generations[j])
+        {
+            LinkCacheEntry entry;
+            entry.txPowerDbm = txPowerDbm;
+            entry.rxPowerDbm = GetRxPower(txPowerDbm, senderMobility, receiverMobility);
+            entry.delay = m_delay->GetDelay(senderMobility, receiverMobility);
+            entry.senderGeneration = m_generations[senderIndex];
+            entry.receiverGeneration = m_generations[j];
+            it = m_linkCache.insert_or_assign(key, entry).first;
+        }
+        else if (it->second.txPowerDbm != txPowerDbm)
+        {
+            // The gain of additive chains doesn't depend on the transmission
+            // power, while other chains need to be evaluated again
+            if (IsLossAdditive())
+            {
+                it->second.rxPowerDbm += txPowerDbm - it->second.txPowerDbm;
+            }
+            else
+            {
+                it->second.rxPowerDbm = GetRxPower(txPowerDbm, senderMobility, receiverMobility);
+            }
+            it->second.txPowerDbm = txPowerDbm;
+        }
+
+        delay = it->second.delay;
+        rxPowerDbm = it->second.rxPowerDbm;
+    }
+    else
+    {
+        // Compute delay using the delay model
+        delay = m_delay->GetDelay(senderMobility, receiverMobility);
+
+        // Compute received power using the loss model
+        rxPowerDbm = GetRxPower(txPowerDbm, senderMobility, receiverMobility);
+    }
+}
+
+uint32_t
+LoraChannel::GetContext(uint32_t j) const
+{
+    if (m_contexts[j] != std::numeric_limits<uint32_t>::max())
+    {
+        return m_contexts[j];
+    }
+
+    Ptr<NetDevice> dstNetDevice = m_phyList[j]->GetDevice();
+    if (dstNetDevice && dstNetDevice->GetNode())
+    {
+        NS_LOG_INFO("Getting node index from NetDevice, since it exists");
+        m_contexts[j] = dstNetDevice->GetNode()->GetId();
+        NS_LOG_DEBUG("dstNode = " << m_contexts[j]);
+        return m_contexts[j];
+    }
+
+    // The PHY may be attached to a node later on, so don't cache the result
+    NS_LOG_INFO("No net device connected to the PHY, using context 0");
+    return 0;
+}
+
+void
+LoraChannel::FlushBatches() const
+{
+    NS_LOG_FUNCTION(this);
+
+    // Events with the same time run in scheduling order: keep the order in
+    // which receivers were visited among batches starting at the same time
+    std::stable_sort(m_batchOrder.begin(),
+                     m_batchOrder.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    for (auto& pending : m_batchOrder)
+    {
+        // All PHYs of the batch belong to the same node
+        Ptr<const ReceptionBatch> batch = pending.second;
+        Simulator::ScheduleWithContext(batch->records.front().context,
+                                       TimeStep(pending.first),
+                                       &LoraChannel::ReceiveBatch,
+                                       this,
+                                       batch);
+    }
+    m_pendingBatches.clear();
+    m_batchOrder.clear();
+}
+
+void
+LoraChannel::Subscribe(Ptr<LoraPhy> phy, Time start, Time end)
+{
+    NS_LOG_FUNCTION(this << phy << start << end);
+
+    if (!m_subscriptionsEnabled)
+    {
+        return;
+    }
+
+    auto it = m_phyIndexes.find(PeekPointer(phy));
+    if (it == m_phyIndexes.end())
+    {
+        return;
+    }
+    uint32_t j = it->second;
+
+    // Forget intervals that are over
+    ReceiverInterest& interest = m_interests[j];
+    Time now = Simulator::Now();
+    interest.intervals.erase(std::remove_if(interest.intervals.begin(),
+                                            interest.intervals.end(),
+                                            [now](const std::pair<Time, Time>& interval) {
+                                                return interval.second <= now;
+                                            }),
+                             interest.intervals.end());
+    interest.subscribed = true;
+    interest.intervals.emplace_back(start, end);
+
+    BackFill(j, start, end);
+}
+
+void
+LoraChannel::EndSubscriptions(Ptr<LoraPhy> phy, Time end)
+{
+    NS_LOG_FUNCTION(this << phy << end);
+
+    if (!m_subscriptionsEnabled)
+    {
+        return;
+    }
+
+    auto it = m_phyIndexes.find(PeekPointer(phy));
+    if (it == m_phyIndexes.end())
+    {
+        return;
+    }
+
+    ReceiverInterest& interest = m_interests[it->second];
+    interest.intervals.erase(std::remove_if(interest.intervals.begin(),
+                                            interest.intervals.end(),
+                                            [end](const std::pair<Time, Time>& interval) {
+                                                return interval.first >= end;
+                                            }),
+                             interest.intervals.end());
+    for (auto& interval : interest.intervals)
+    {
+        interval.second = std::min(interval.second, end);
+    }
+}
+
+void
+LoraChannel::Unsubscribe(Ptr<LoraPhy> phy)
+{
+    NS_LOG_FUNCTION(this << phy);
+
+    if (!m_subscriptionsEnabled)
+    {
+        return;
+    }
+
+    auto it = m_phyIndexes.find(PeekPointer(phy));
+    if (it == m_phyIndexes.end())
+    {
+        return;
+    }
+
+    m_interests[it->second].subscribed = true;
+    m_interests[it->second].intervals.clear();
+}
+
+bool
+LoraChannel::IsInterested(uint32_t j, Time start, Time end) const
+{
+    const ReceiverInterest& interest = m_interests[j];
+    if (!interest.subscribed)
+    {
+        return true;
+    }
+
+    for (const auto& interval : interest.intervals)
+    {
+        if (interval.first < end && start < interval.second)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+LoraChannel::BackFill(uint32_t j, Time start, Time end)
+{
+    NS_LOG_FUNCTION(this << j << start << end);
+
+    PurgeAirLog();
+
+    Ptr<LoraPhy> phy = m_phyList[j];
+    Ptr<MobilityModel> receiverMobility = phy->GetMobility();
+    Time now = Simulator::Now();
+
+    for (auto& record : m_airLog)
+    {
+        if (record.sender == phy || std::find(record.delivered.begin(),
+                                              record.delivered.end(),
+                                              j) != record.delivered.end())
+        {
+            continue;
+        }
+
+        // Cached links can only be used while the PHY indexes are up to date
+        Time delay;
+        double rxPowerDbm;
+        GetLinkBudget(j,
+                      m_physDirty ? -1 : record.senderIndex,
+                      record.senderMobility,
+                      receiverMobility,
+                      record.txPowerDbm,
+                      delay,
+                      rxPowerDbm);
+
+        // Only consider signals that overlap the new interval at the receiver
+        Time arrival = record.start + delay;
+        if (!(arrival < end && start < arrival + record.duration))
+        {
+            continue;
+        }
+        record.delivered.push_back(j);
+
+        if (arrival > now)
+        {
+            // The signal didn't reach the PHY yet: deliver it as usual
+            LoraChannelParameters parameters;
+            parameters.rxPowerDbm = rxPowerDbm;
+            parameters.sf = record.sf;
+            parameters.duration = record.duration;
+            parameters.frequencyMHz = record.frequencyMHz;
+
+            Simulator::ScheduleWithContext(GetContext(j),
+                                           arrival - now,
+                                           &LoraChannel::Receive,
+                                           this,
+                                           j,
+                                           record.packet,
+                                           parameters);
+        }
+        else
+        {
+            // The signal is already impinging on the antenna: the PHY can't lock
+            // on it anymore, but it needs to account for it as interference
+            NS_LOG_INFO("Back-filling interference from a packet that started at " << arrival);
+            phy->AddInterferer(record.packet,
+                               rxPowerDbm,
+                               record.sf,
+                               arrival,
+                               record.duration,
+                               record.frequencyMHz);
+        }
+    }
+}
+
+void
+LoraChannel::SetSharedAirLog(bool shared)
+{
+    NS_LOG_FUNCTION(this << shared);
+
+    m_sharedAirLog = shared;
+    for (const auto& phy : m_phyList)
+    {
+        phy->SetSharedAirLog(shared);
+    }
+}
+
+bool
+LoraChannel::GetSharedAirLog() const
+{
+    return m_sharedAirLog;
+}
+
+void
+LoraChannel::GetInterferers(Ptr<LoraPhy> receiver,
+                            Ptr<LoraInterferenceHelper::Event> event,
+                            std::vector<Ptr<LoraInterferenceHelper::Event>>& interferers) const
+{
+    NS_LOG_FUNCTION(this << receiver << event);
+
+    PurgeAirLog();
+
+    // Cached links can only be used while the PHY indexes are up to date
+    auto indexed = m_physDirty ? m_phyIndexes.end() : m_phyIndexes.find(PeekPointer(receiver));
+    bool cached = indexed != m_phyIndexes.end();
+
+    Ptr<MobilityModel> receiverMobility = receiver->GetMobility();
+    Time start = event->GetStartTime();
+    Time end = event->GetEndTime();
+
+    for (const auto& record : m_airLog)
+    {
+        // Skip the packet itself, transmissions of the receiver, other
+        // frequencies and transmissions that can't overlap the packet
+        if (record.packet == event->GetPacket() || record.sender == receiver ||
+            record.frequencyMHz != event->GetFrequency() || record.start >= end ||
+            record.start + record.duration + m_maxDelay <= start)
+        {
+            continue;
+        }
+
+        Time delay;
+        double rxPowerDbm;
+        GetLinkBudget(cached ? indexed->second : 0,
+                      cached ? record.senderIndex : -1,
+                      record.senderMobility,
+                      receiverMobility,
+                      record.txPowerDbm,
+                      delay,
+                      rxPowerDbm);
+
+        Time arrival = record.start + delay;
+        if (arrival < end && start < arrival + record.duration)
+        {
+            interferers.push_back(Create<LoraInterferenceHelper::Event>(arrival,
+                                                                         record.duration,
+                                                                         rxPowerDbm,
+                                                                         record.sf,
+                                                                         record.packet,
+                                                                         record.frequencyMHz));
+        }
+    }
+
+    NS_LOG_DEBUG("Found " << interferers.size() << " interferers out of " << m_airLog.size()
+                          << " logged transmissions");
+}
+
+void
+LoraChannel::PurgeAirLog() const
+{
+    // With the shared log, transmissions are needed until all receptions they
+    // may overlap have ended
+    Time now = Simulator::Now();
+    Time horizon = m_sharedAirLog ? m_maxDelay + m_maxAirDuration : m_maxDelay;
+    while (!m_airLog.empty() &&
+           m_airLog.front().start + m_airLog.front().duration + horizon < now)
+    {
+        m_airLog.pop_front();
+    }
+}
+
+void
+LoraChannel::Receive(uint32_t i, Ptr<Packet> packet, LoraChannelParameters parameters) const
+{
+    NS_LOG_FUNCTION(this << i << packet << parameters);
+
+    // Call the appropriate PHY instance to let it begin reception
+    m_phyList[i]->StartReceive(packet,
+                               parameters.rxPowerDbm,
+                               parameters.sf,
+                               parameters.duration,
+                               parameters.frequencyMHz);
+}
+
+void
+LoraChannel::ReceiveBatch(Ptr<const ReceptionBatch> batch) const
+{
+    NS_LOG_FUNCTION(this << batch->packet << batch->records.size());
+
+    for (const auto& record : batch->records)
+    {
+        NS_ASSERT(record.context == Simulator::GetContext());
+        m_phyList[record.phyIndex]->StartReceive(batch->packet,
+                                                 record.rxPowerDbm,
+                                                 batch->sf,
+                                                 batch->duration,
+                                                 batch->frequencyMHz);
+    }
+}
+
+double
+LoraChannel::GetRxPower(double txPowerDbm,
+                        Ptr<MobilityModel> senderMobility,
+                        Ptr<MobilityModel> receiverMobility) const
+{
+    // Serve links between PHYs of this channel from the link table, if possible
+    if (m_linkTable)
+    {
+        if (m_physDirty)
+        {
+            TrackPhys();
+        }
+
+        auto sender = m_trackedMobility.find(senderMobility);
+        auto receiver = m_trackedMobility.find(receiverMobility);
+        if (m_linkTable && sender != m_trackedMobility.end() &&
+            receiver != m_trackedMobility.end() && !sender->second.empty() &&
+            !receiver->second.empty())
+        {
+            uint32_t i = sender->second.front();
+            uint32_t j = receiver->second.front();
+            if (i != j && m_staticPhys[i] && m_staticPhys[j] && m_generations[i] == 0 &&
+                m_generations[j] == 0 && m_linkTable->HasLink(i, j))
+            {
+                return txPowerDbm + m_linkTable->GetGainDb(i, j);
+            }
+        }
+    }
+
+    return m_loss->CalcRxPower(txPowerDbm, senderMobility, receiverMobility);
+}
+
+void
+LoraChannel::GetRxPowers(double txPowerDbm,
+                         Ptr<MobilityModel> senderMobility,
+                         const std::vector<Ptr<MobilityModel>>& receivers,
+                         std::vector<double>& rxPowersDbm) const
+{
+    NS_LOG_FUNCTION(this << txPowerDbm << senderMobility << receivers.size());
+
+    rxPowersDbm.resize(receivers.size());
+
+    // Links in the link table are looked up one by one
+    if (!m_linkTable && GetBatchStages(m_batchStages))
+    {
+        m_receiverBatch.Clear();
+        for (const auto& receiver : receivers)
+        {
+            m_receiverBatch.Add(receiver->GetPosition());
+        }
+        m_distances.resize(receivers.size());
+        ComputeBatch(txPowerDbm,
+                     senderMobility->GetPosition(),
+                     m_receiverBatch,
+                     0,
+                     receivers.size(),
+                     m_batchStages,
+                     m_distances.data(),
+                     rxPowersDbm.data());
+        return;
+    }
+
+    for (std::size_t k = 0; k < receivers.size(); k++)
+    {
+        rxPowersDbm[k] = GetRxPower(txPowerDbm, senderMobility, receivers[k]);
+    }
+}
+
+void
+LoraChannel::GetRxPowers(double txPowerDbm,
+                         const Vector& senderPosition,
+                         const LoraPositionBatch& receivers,
+                         std::vector<double>& rxPowersDbm) const
+{
+    NS_LOG_FUNCTION(this << txPowerDbm << senderPosition << receivers.GetN());
+
+    rxPowersDbm.resize(receivers.GetN());
+
+    if (GetBatchStages(m_batchStages))
+    {
+        m_distances.resize(receivers.GetN());
+        ComputeBatch(txPowerDbm,
+                     senderPosition,
+                     receivers,
+                     0,
+                     receivers.GetN(),
+                     m_batchStages,
+                     m_distances.data(),
+                     rxPowersDbm.data());
+        return;
+    }
+
+    // Fall back to calling the loss model on each pair of positions
+    Ptr<ConstantPositionMobilityModel> senderMobility =
+        CreateObject<ConstantPositionMobilityModel>();
+    Ptr<ConstantPositionMobilityModel> receiverMobility =
+        CreateObject<ConstantPositionMobilityModel>();
+    senderMobility->SetPosition(senderPosition);
+    for (std::size_t k = 0; k < receivers.GetN(); k++)
+    {
+        receiverMobility->SetPosition(Vector(receivers.x[k], receivers.y[k], receivers.z[k]));
+        rxPowersDbm[k] = m_loss->CalcRxPower(txPowerDbm, senderMobility, receiverMobility);
+    }
+}
+
+bool
+LoraChannel::IsBatchComputable() const
+{
+    return GetBatchStages(m_batchStages);
+}
+
+double
+LoraChannel::GetMaxRange(double txPowerDbm) const
+{
+    NS_LOG_FUNCTION(this << txPowerDbm);
+
+    // The lowest power any connected PHY is able to lock on
+    double lowestSensitivity =
+        std::min(*std::min_element(GatewayLoraPhy::sensitivity, GatewayLoraPhy::sensitivity + 6),
+                 *std::min_element(EndDeviceLoraPhy::sensitivity,
+                                   EndDeviceLoraPhy::sensitivity + 6));
+
+    // Signals below sensitivity still interfere with the packets a PHY is
+    // receiving: they matter as long as they can destroy a packet received at
+    // sensitivity
+    double isolationDb = LoraInterferenceHelper::GetMaxIsolationDb();
+    if (!std::isfinite(isolationDb))
+    {
+        NS_LOG_INFO("Any overlapping signal may destroy a packet, not bounding the range");
+        return std::numeric_limits<double>::infinity();
+    }
+
+    // The highest loss after which a transmission may still be heard
+    double maxLossDb = txPowerDbm - lowestSensitivity + isolationDb + m_cullingMarginDb;
+
+    for (Ptr<PropagationLossModel> model = m_loss; model; model = model->GetNext())
+    {
+        Ptr<LogDistancePropagationLossModel> logDistance =
+            DynamicCast<LogDistancePropagationLossModel>(model);
+        if (logDistance)
+        {
+            DoubleValue exponent;
+            DoubleValue referenceDistance;
+            DoubleValue referenceLoss;
+            logDistance->GetAttribute("Exponent", exponent);
+            logDistance->GetAttribute("ReferenceDistance", referenceDistance);
+            logDistance->GetAttribute("ReferenceLoss", referenceLoss);
+
+            // Invert L(d) = L0 + 10 n log10(d / d0)
+            return referenceDistance.Get() *
+                   std::pow(10, (maxLossDb - referenceLoss.Get()) / (10 * exponent.Get()));
+        }
+    }
+
+    return std::numeric_limits<double>::infinity();
+}
+
+bool
+LoraChannel::IsLinkCacheUsable() const
+{
+    if (!m_linkCacheEnabled)
+    {
+        return false;
+    }
+    if (m_freezeRandomLoss)
+    {
+        return true;
+    }
+
+    // Models that draw a new random value at every call would be frozen
+    if (HasRandomModels())
+    {
+        NS_LOG_DEBUG("Not using the link cache because of a stochastic model");
+        return false;
+    }
+
+    return true;
+}
+
+bool
+LoraChannel::HasRandomModels() const
+{
+    for (Ptr<PropagationLossModel> model = m_loss; model; model = model->GetNext())
+    {
+        if (DynamicCast<RandomPropagationLossModel>(model) ||
+            DynamicCast<NakagamiPropagationLossModel>(model) ||
+            DynamicCast<JakesPropagationLossModel>(model) ||
+            DynamicCast<BuildingPenetrationLoss>(model))
+        {
+            return true;
+        }
+    }
+
+    return bool(DynamicCast<RandomPropagationDelayModel>(m_delay));
+}
+
+bool
+LoraChannel::IsLossAdditive() const
+{
+    for (Ptr<PropagationLossModel> model = m_loss; model; model = model->GetNext())
+    {
+        if (DynamicCast<FixedRssLossModel>(model) || DynamicCast<RangePropagationLossModel>(model))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void
+LoraChannel::ClearLinkCache()
+{
+    NS_LOG_FUNCTION(this);
+
+    m_linkCache.clear();
+}
+
+/**
+ * Write the type and the attribute values of an object, and of the objects it
+ * points to, to a stream.
+ *
+ * \param object The object to describe.
+ * \param os The output stream.
+ */
+static void
+DescribeObject(Ptr<Object> object, std::ostream& os)
+{
+    os << object->GetInstanceTypeId().GetName() << "{";
+    for (TypeId tid = object->GetInstanceTypeId();; tid = tid.GetParent())
+    {
+        for (std::size_t i = 0; i < tid.GetAttributeN(); i++)
+        {
+            TypeId::AttributeInformation info = tid.GetAttribute(i);
+            std::string valueType = info.checker->GetValueTypeName();
+            if (!(info.flags & TypeId::ATTR_GET) || !info.accessor->HasGetter() ||
+                valueType == "ns3::ObjectPtrContainerValue")
+            {
+                continue;
+            }
+
+            // Pointers would change at every run, describe the pointed object instead
+            os << info.name << "=";
+            if (valueType == "ns3::PointerValue")
+            {
+                PointerValue pointer;
+                object->GetAttribute(info.name, pointer);
+                if (pointer.GetObject())
+                {
+                    DescribeObject(pointer.GetObject(), os);
+                }
+            }
+            else
+            {
+                Ptr<AttributeValue> value = info.checker->Create();
+                info.accessor->Get(PeekPointer(object), *value);
+                os << value->SerializeToString(info.checker);
+            }
+            os << ";";
+        }
+
+        if (tid.GetParent() == tid)
+        {
+            break;
+        }
+    }
+    os << "}";
+}
+
+LoraLinkTable::Signature
+LoraChannel::GetLinkTableSignature(bool randomLoss) const
+{
+    NS_LOG_FUNCTION(this << randomLoss);
+
+    LoraLinkTable::Signature signature;
+    signature.nPhys = m_phyList.size();
+    signature.nGateways = 0;
+    signature.randomLoss = randomLoss;
+
+    // The hash also covers which PHYs are gateways, since only their links are stored
+    signature.topologyHash = LoraLinkTable::HASH_INIT;
+    for (const auto& phy : m_phyList)
+    {
+        Vector position = phy->GetMobility()->GetPosition();
+        double coordinates[3] = {position.x, position.y, position.z};
+        signature.topologyHash =
+            LoraLinkTable::Hash(signature.topologyHash, coordinates, sizeof(coordinates));
+        uint8_t gateway = DynamicCast<GatewayLoraPhy>(phy) != nullptr;
+        signature.topologyHash =
+            LoraLinkTable::Hash(signature.topologyHash, &gateway, sizeof(gateway));
+        signature.nGateways += gateway;
+    }
+
+    // Delays are stored in time steps, so they also depend on the resolution
+    std::ostringstream models;
+    for (Ptr<PropagationLossModel> model = m_loss; model; model = model->GetNext())
+    {
+        DescribeObject(model, models);
+    }
+    DescribeObject(m_delay, models);
+    models << "Resolution=" << static_cast<int>(Time::GetResolution())
+           << ";RandomLoss=" << randomLoss;
+    std::string description = models.str();
+    signature.modelHash =
+        LoraLinkTable::Hash(LoraLinkTable::HASH_INIT, description.data(), description.size());
+
+    NS_LOG_DEBUG("Link table models: " << description);
+
+    return signature;
+}
+
+bool
+LoraChannel::IsLinkTableValid(Ptr<const LoraLinkTable> table) const
+{
+    const LoraLinkTable::Signature& stored = table->GetSignature();
+    if (stored.nPhys != m_phyList.size())
+    {
+        return false;
+    }
+
+    LoraLinkTable::Signature current = GetLinkTableSignature(stored.randomLoss);
+    return stored.nGateways == current.nGateways && stored.topologyHash == current.topologyHash &&
+           stored.modelHash == current.modelHash && (!stored.randomLoss || m_freezeRandomLoss);
+}
+
+bool
+LoraChannel::SaveLinkTable(std::string filename) const
+{
+    NS_LOG_FUNCTION(this << filename);
+
+    // The table stores gains, to which the transmission power is added
+    if (!IsLossAdditive())
+    {
+        NS_LOG_WARN("Not writing link table " << filename
+                                              << ", since the received power of the loss model "
+                                                 "doesn't scale with the transmission power");
+        return false;
+    }
+
+    bool randomLoss = HasRandomModels();
+    NS_ABORT_MSG_IF(randomLoss && !m_freezeRandomLoss,
+                    "Link tables can only store random loss or delay samples if "
+                    "FreezeRandomLoss is set");
+
+    // Only store the links from and to gateways: there are far fewer of them
+    // than links between end devices, which are rarely needed
+    std::vector<uint32_t> gateways;
+    for (uint32_t i = 0; i < m_phyList.size(); i++)
+    {
+        if (DynamicCast<GatewayLoraPhy>(m_phyList[i]))
+        {
+            gateways.push_back(i);
+        }
+    }
+
+    std::size_t nPhys = m_phyList.size();
+    std::vector<float> gainsDb(2 * gateways.size() * nPhys, 0);
+    std::vector<uint32_t> delays(2 * gateways.size() * nPhys, 0);
+    for (std::size_t row = 0; row < gateways.size(); row++)
+    {
+        Ptr<MobilityModel> gatewayMobility = m_phyList[gateways[row]]->GetMobility();
+        for (std::size_t i = 0; i < nPhys; i++)
+        {
+            if (i == gateways[row])
+            {
+                continue;
+            }
+
+            // Uplink from PHY i in the even row, downlink to PHY i in the odd row
+            Ptr<MobilityModel> mobility = m_phyList[i]->GetMobility();
+            std::size_t uplink = 2 * row * nPhys + i;
+            std::size_t downlink = (2 * row + 1) * nPhys + i;
+            int64_t uplinkDelay = m_delay->GetDelay(mobility, gatewayMobility).GetTimeStep();
+            int64_t downlinkDelay = m_delay->GetDelay(gatewayMobility, mobility).GetTimeStep();
+            NS_ABORT_MSG_IF(std::min(uplinkDelay, downlinkDelay) < 0 ||
+                                std::max(uplinkDelay, downlinkDelay) >
+                                    std::numeric_limits<uint32_t>::max(),
+                            "Propagation delay of link " << i << "-" << gateways[row]
+                                                         << " can't be stored in a link table");
+
+            gainsDb[uplink] = m_loss->CalcRxPower(0, mobility, gatewayMobility);
+            gainsDb[downlink] = m_loss->CalcRxPower(0, gatewayMobility, mobility);
+            delays[uplink] = uplinkDelay;
+            delays[downlink] = downlinkDelay;
+        }
+    }
+
+    return LoraLinkTable::Write(filename,
+                                GetLinkTableSignature(randomLoss),
+                                gateways,
+                                gainsDb,
+                                delays);
+}
+
+bool
+LoraChannel::LoadLinkTable(std::string filename)
+{
+    NS_LOG_FUNCTION(this << filename);
+
+    m_linkTable = nullptr;
+
+    Ptr<LoraLinkTable> table = LoraLinkTable::Open(filename);
+    if (!table)
+    {
+        return false;
+    }
+    if (!IsLinkTableValid(table))
+    {
+        NS_LOG_WARN("Rejecting link table " << filename
+                                            << ", which was computed for other PHYs or models");
+        return false;
+    }
+
+    // Follow the movements of PHYs from now on, so that links of PHYs that
+    // move are computed again
+    TrackPhys();
+    m_linkTable = table;
+
+    return true;
+}
+
+uint64_t
+LoraChannel::GetCellKey(const Vector& position) const
+{
+    auto x = static_cast<int32_t>(std::floor(position.x / m_cellSize));
+    auto y = static_cast<int32_t>(std::floor(position.y / m_cellSize));
+    return (uint64_t(uint32_t(x)) << 32) | uint64_t(uint32_t(y));
+}
+
+void
+LoraChannel::TrackPhys() const
+{
+    NS_LOG_FUNCTION(this);
+
+    for (auto& tracked : m_trackedMobility)
+    {
+        tracked.second.clear();
+    }
+    m_staticPhys.assign(m_phyList.size(), false);
+    m_mobilePhys.clear();
+
+    for (uint32_t j = 0; j < m_phyList.size(); j++)
+    {
+        Ptr<MobilityModel> mobility = m_phyList[j]->GetMobility();
+        NS_ASSERT(mobility);
+
+        // Other models (e.g., ConstantVelocityMobilityModel) move without
+        // firing CourseChange, so their links and cells can't be kept
+        if (DynamicCast<ConstantPositionMobilityModel>(mobility))
+        {
+            m_staticPhys[j] = true;
+        }
+        else
+        {
+            m_mobilePhys.push_back(j);
+        }
+
+        // Follow the movements of this PHY
+        auto tracked = m_trackedMobility.find(mobility);
+        if (tracked == m_trackedMobility.end())
+        {
+            mobility->TraceConnectWithoutContext("CourseChange",
+                                                 MakeCallback(&LoraChannel::CourseChanged, this));
+            tracked = m_trackedMobility.emplace(mobility, std::vector<uint32_t>()).first;
+        }
+        tracked->second.push_back(j);
+    }
+
+    // Indexes may have changed, so cached links can't be trusted anymore
+    m_linkCache.clear();
+    m_generations.assign(m_phyList.size(), 0);
+
+    // The link table only describes the PHYs it was computed for
+    if (m_linkTable && !IsLinkTableValid(m_linkTable))
+    {
+        NS_LOG_WARN("Dropping the link table, since the PHYs of the channel changed");
+        m_linkTable = nullptr;
+    }
+
+    m_physDirty = false;
+}
+
+void
+LoraChannel::BuildSpatialIndex() const
+{
+    NS_LOG_FUNCTION(this);
+
+    m_grid.clear();
+    m_phyCells.resize(m_phyList.size());
+
+    for (uint32_t j = 0; j < m_phyList.size(); j++)
+    {
+        // PHYs that move without notice are visited by each transmission
+        if (!m_staticPhys[j])
+        {
+            continue;
+        }
+
+        uint64_t key = GetCellKey(m_phyList[j]->GetMobility()->GetPosition());
+        m_grid[key].push_back(j);
+        m_phyCells[j] = key;
+    }
+
+    m_spatialIndexDirty = false;
+
+    NS_LOG_DEBUG("Spatial index built with " << m_grid.size() << " non-empty cells, and "
+                                             << m_mobilePhys.size() << " mobile PHYs");
+}
+
+void
+LoraChannel::CollectCandidates(const Vector& position, double range) const
+{
+    NS_LOG_FUNCTION(this << position << range);
+
+    m_candidates.clear();
+
+    // The distance in the x-y plane is a lower bound of the actual distance, so
+    // PHYs in cells outside the square of side 2 * range can be safely skipped
+    double minX = std::floor((position.x - range) / m_cellSize);
+    double maxX = std::floor((position.x + range) / m_cellSize);
+    double minY = std::floor((position.y - range) / m_cellSize);
+    double maxY = std::floor((position.y + range) / m_cellSize);
+    double nCells = (maxX - minX + 1) * (maxY - minY + 1);
+
+    if (nCells > m_grid.size())
+    {
+        // Cheaper to go through the occupied cells
+        for (const auto& cell : m_grid)
+        {
+            auto x = static_cast<int32_t>(uint32_t(cell.first >> 32));
+            auto y = static_cast<int32_t>(uint32_t(cell.first));
+            if (x >= minX && x <= maxX && y >= minY && y <= maxY)
+            {
+                m_candidates.insert(m_candidates.end(), cell.second.begin(), cell.second.end());
+            }
+        }
+    }
+    else
+    {
+        for (auto x = static_cast<int32_t>(minX); x <= static_cast<int32_t>(maxX); x++)
+        {
+            for (auto y = static_cast<int32_t>(minY); y <= static_cast<int32_t>(maxY); y++)
+            {
+                auto cell = m_grid.find((uint64_t(uint32_t(x)) << 32) | uint64_t(uint32_t(y)));
+                if (cell != m_grid.end())
+                {
+                    m_candidates.insert(m_candidates.end(),
+                                        cell->second.begin(),
+                                        cell->second.end());
+                }
+            }
+        }
+    }
+
+    // PHYs that move without notice are not in the grid, and may be anywhere
+    m_candidates.insert(m_candidates.end(), m_mobilePhys.begin(), m_mobilePhys.end());
+
+    // Discard PHYs in the corners of the square, and mobile PHYs out of range
+    auto outOfRange = [this, &position, range](uint32_t j) {
+        return CalculateDistance(position, m_phyList[j]->GetMobility()->GetPosition()) > range;
+    };
+    m_candidates.erase(std::remove_if(m_candidates.begin(), m_candidates.end(), outOfRange),
+                       m_candidates.end());
+
+    // Keep the same delivery order as a cycle over all PHYs
+    std::sort(m_candidates.begin(), m_candidates.end());
+}
+
+void
+LoraChannel::ValidateCandidates(Ptr<LoraPhy> sender,
+                                Ptr<MobilityModel> senderMobility,
+                                double txPowerDbm) const
+{
+    NS_LOG_FUNCTION(this << sender << txPowerDbm);
+
+    // Collect the PHYs the loop over all PHYs delivers the packet to, and for
+    // which it matters: PHYs that can receive it, or that can lose a packet
+    // received at sensitivity because of it
+    double isolationDb = LoraInterferenceHelper::GetMaxIsolationDb();
+    std::vector<uint32_t> affected;
+    for (uint32_t j = 0; j < m_phyList.size(); j++)
+    {
+        Ptr<LoraPhy> phy = m_phyList[j];
+        if (sender == phy || !IsLocal(j))
+        {
+            continue;
+        }
+
+        double rxPowerDbm = GetRxPower(txPowerDbm, senderMobility, phy->GetMobility());
+        const double* sensitivity = DynamicCast<GatewayLoraPhy>(phy)
+                                        ? GatewayLoraPhy::sensitivity
+                                        : EndDeviceLoraPhy::sensitivity;
+        double lowestSensitivity = *std::min_element(sensitivity, sensitivity + 6);
+        if (rxPowerDbm >= lowestSensitivity - isolationDb)
+        {
+            affected.push_back(j);
+        }
+    }
+
+    // All of them must be among the candidates of the spatial index
+    std::vector<uint32_t> culled;
+    std::set_difference(affected.begin(),
+                        affected.end(),
+                        m_candidates.begin(),
+                        m_candidates.end(),
+                        std::back_inserter(culled));
+    if (!culled.empty())
+    {
+        Ptr<LoraPhy> phy = m_phyList[culled.front()];
+        NS_FATAL_ERROR("Spatial index culled "
+                       << culled.size() << " out of " << affected.size()
+                       << " PHYs affected by the packet, such as PHY " << culled.front()
+                       << " at distance " << senderMobility->GetDistanceFrom(phy->GetMobility())
+                       << " m, which receives it at "
+                       << GetRxPower(txPowerDbm, senderMobility, phy->GetMobility()) << " dBm");
+    }
+}
+
+void
+LoraChannel::CourseChanged(Ptr<const MobilityModel> mobility) const
+{
+    NS_LOG_FUNCTION(this << mobility);
+
+    // A full refresh is already pending
+    if (m_physDirty)
+    {
+        return;
+    }
+
+    auto tracked = m_trackedMobility.find(ConstCast<MobilityModel>(mobility));
+    if (tracked == m_trackedMobility.end())
+    {
+        return;
+    }
+
+    uint64_t key = GetCellKey(mobility->GetPosition());
+    for (auto j : tracked->second)
+    {
+        // Links towards and from this PHY need to be computed again
+        m_generations[j]++;
+
+        if (m_spatialIndexDirty || !m_staticPhys[j] || m_phyCells[j] == key)
+        {
+            continue;
+        }
+
+        // Move the PHY from its old cell to the new one
+        std::vector<uint32_t>& oldCell = m_grid[m_phyCells[j]];
+        oldCell.erase(std::find(oldCell.begin(), oldCell.end(), j));
+        if (oldCell.empty())
+        {
+            m_grid.erase(m_phyCells[j]);
+        }
+        m_grid[key].push_back(j);
+        m_phyCells[j] = key;
+    }
 }
 
 std::ostream&
@@ -13,8 +13,12 @@
 #define LORA_CHANNEL_H
 
 #include "logical-lora-channel.h"
+#include "lora-interference-helper.h"
+#include "lora-link-table.h"
 #include "lora-phy.h"
+#include "worker-pool.h"
 
+#include "ns3/callback.h"
 #include "ns3/channel.h"
 #include "ns3/mobility-model.h"
 #include "ns3/net-device.h"
@@ -22,7 +26,11 @@
 #include "ns3/packet.h"
 #include "ns3/propagation-delay-model.h"
 #include "ns3/propagation-loss-model.h"
+#include "ns3/simple-ref-count.h"
 
+#include <deque>
+#include <map>
+#include <unordered_map>
 #include <vector>
 
 namespace ns3
@@ -56,6 +64,51 @@ struct LoraChannelParameters
  */
 std::ostream& operator<<(std::ostream& os, const LoraChannelParameters& params);
 
+/**
+ * \ingroup lorawan
+ *
+ * The positions of a set of receivers, stored as a structure of arrays so
+ * that link budgets towards all of them can be computed in tight loops.
+ */
+struct LoraPositionBatch
+{
+    std::vector<double> x; //!< The x coordinate of each receiver
+    std::vector<double> y; //!< The y coordinate of each receiver
+    std::vector<double> z; //!< The z coordinate of each receiver
+
+    /**
+     * Append the position of a receiver.
+     *
+     * \param position The position to append.
+     */
+    void Add(const Vector& position)
+    {
+        x.push_back(position.x);
+        y.push_back(position.y);
+        z.push_back(position.z);
+    }
+
+    /**
+     * Remove all positions, keeping the allocated memory.
+     */
+    void Clear()
+    {
+        x.clear();
+        y.clear();
+        z.clear();
+    }
+
+    /**
+     * Get the number of positions in the batch.
+     *
+     * \return The number of positions.
+     */
+    std::size_t GetN() const
+    {
+        return x.size();
+    }
+};
+
 /**
  * \ingroup lorawan
  *
@@ -139,6 +192,77 @@ class LoraChannel : public Channel
               Time duration,
               double frequencyMHz) const;
 
+    /**
+     * Send a packet in the channel on behalf of a transmitter without a PHY,
+     * such as a device of a LoraEndDevicePopulation.
+     *
+     * The packet reaches every connected PHY as if it was sent by a PHY at the
+     * given position.
+     *
+     * \param senderPosition The position of the transmitter.
+     * \param packet The PHY layer packet that is being sent over the channel.
+     * \param txPowerDbm The power of the transmission.
+     * \param txParams The set of parameters that are used by the transmitter.
+     * \param duration The on-air duration of this packet.
+     * \param frequencyMHz The frequency this transmission will happen at.
+     */
+    void Send(const Vector& senderPosition,
+              Ptr<Packet> packet,
+              double txPowerDbm,
+              LoraTxParameters txParams,
+              Time duration,
+              double frequencyMHz) const;
+
+    /**
+     * Callback invoked for each packet sent by a PHY of this partition, so
+     * that it can be forwarded to the other partitions of a distributed
+     * simulation.
+     *
+     * Its arguments are the position of the sender, the packet, the
+     * transmission power, the spreading factor, the on-air duration and the
+     * frequency of the transmission.
+     */
+    typedef Callback<void, Vector, Ptr<Packet>, double, uint8_t, Time, double> RemoteSendCallback;
+
+    /**
+     * Deliver to the PHYs of this partition a packet that was sent in another
+     * partition of a distributed simulation.
+     *
+     * \param senderPosition The position of the sender.
+     * \param packet The PHY layer packet that is being sent over the channel.
+     * \param txPowerDbm The power of the transmission.
+     * \param sf The spreading factor of the transmission.
+     * \param duration The on-air duration of this packet.
+     * \param frequencyMHz The frequency this transmission happens at.
+     * \param elapsed The time since the packet was sent, which is subtracted
+     * from the propagation delay towards each PHY.
+     */
+    void ReceiveRemote(Vector senderPosition,
+                       Ptr<Packet> packet,
+                       double txPowerDbm,
+                       uint8_t sf,
+                       Time duration,
+                       double frequencyMHz,
+                       Time elapsed) const;
+
+    /**
+     * Restrict deliveries to the PHYs of nodes belonging to a partition of a
+     * distributed simulation.
+     *
+     * PHYs that are not attached to a node are always considered local.
+     *
+     * \param systemId The system id of the local partition.
+     */
+    void SetSystemId(uint32_t systemId);
+
+    /**
+     * Set the callback used to forward packets sent in this partition to the
+     * other ones.
+     *
+     * \param callback The RemoteSendCallback instance.
+     */
+    void SetRemoteSendCallback(RemoteSendCallback callback);
+
     /**
      * Compute the received power when transmitting from a point to another one.
      *
@@ -155,6 +279,200 @@ class LoraChannel : public Channel
                       Ptr<MobilityModel> senderMobility,
                       Ptr<MobilityModel> receiverMobility) const;
 
+    /**
+     * Compute the received power of a transmission at several receivers.
+     *
+     * If IsBatchComputable returns true, the loss model chain is evaluated on
+     * all receivers at once, sampling each position only once. Otherwise, this
+     * is equivalent to calling GetRxPower for each receiver.
+     *
+     * \param txPowerDbm The power the transmitter is using, in dBm.
+     * \param senderMobility The mobility model of the sender.
+     * \param receivers The mobility models of the receivers.
+     * \param rxPowersDbm Output parameter for the power received by each
+     * receiver, in dBm.
+     */
+    void GetRxPowers(double txPowerDbm,
+                     Ptr<MobilityModel> senderMobility,
+                     const std::vector<Ptr<MobilityModel>>& receivers,
+                     std::vector<double>& rxPowersDbm) const;
+
+    /**
+     * Compute the received power of a transmission at a batch of positions.
+     *
+     * Receivers are treated as points: if IsBatchComputable returns false, the
+     * loss model chain is called on stand-in ConstantPositionMobilityModel
+     * objects, so models that rely on other properties of the mobility model
+     * (e.g., BuildingPenetrationLoss) must be used through the other overload.
+     * The link table is not used.
+     *
+     * \param txPowerDbm The power the transmitter is using, in dBm.
+     * \param senderPosition The position of the sender.
+     * \param receivers The positions of the receivers.
+     * \param rxPowersDbm Output parameter for the power received at each
+     * position, in dBm.
+     */
+    void GetRxPowers(double txPowerDbm,
+                     const Vector& senderPosition,
+                     const LoraPositionBatch& receivers,
+                     std::vector<double>& rxPowersDbm) const;
+
+    /**
+     * Whether the loss model chain can be evaluated on batches of positions.
+     *
+     * This is the case if the chain only contains
+     * LogDistancePropagationLossModel, FixedRssLossModel and
+     * RangePropagationLossModel instances, whose output only depends on the
+     * distance between the sender and the receiver.
+     *
+     * \return True if the batch kernel can be used, false otherwise.
+     */
+    bool IsBatchComputable() const;
+
+    /**
+     * Compute a conservative bound on the distance a transmission can reach.
+     *
+     * The bound is obtained by inverting the first LogDistancePropagationLossModel
+     * found in the loss model chain against the lowest sensitivity of gateway and
+     * end device PHYs, lowered by the isolation of the collision matrix (see
+     * LoraInterferenceHelper::GetMaxIsolationDb), since weaker signals can still
+     * destroy packets being received. Other models in the chain are assumed to
+     * only add loss, and the RangeCullingMargin attribute accounts for the sum
+     * of several weak signals and for models that can also provide a gain
+     * (e.g., shadowing).
+     *
+     * \param txPowerDbm The power the transmitter is using, in dBm.
+     * \return The maximum range [m], or infinity if the loss model cannot be
+     * inverted or any overlapping signal may destroy a packet.
+     */
+    double GetMaxRange(double txPowerDbm) const;
+
+    /**
+     * Whether link budgets computed by this channel can be cached.
+     *
+     * Caching is only allowed if the LinkCache attribute is set and either
+     * FreezeRandomLoss is set or the loss and delay models do not draw new
+     * random values at every call.
+     *
+     * \return True if the link cache is in use, false otherwise.
+     */
+    bool IsLinkCacheUsable() const;
+
+    /**
+     * Drop all link budgets currently held in the cache.
+     */
+    void ClearLinkCache();
+
+    /**
+     * Compute the link budget between each gateway connected to the channel
+     * and all other PHYs, and store it in a link table file.
+     *
+     * Links between end devices are not stored, so that the size of the table
+     * grows with the number of end devices times the number of gateways. The
+     * table records the number, roles and positions of the PHYs, and the
+     * parameters of the loss and delay models, so that LoadLinkTable can
+     * reject it in a different scenario. If the loss or delay models draw
+     * random values, the FreezeRandomLoss attribute must be set, and the table
+     * stores the draw of each link: all simulations loading it will then see
+     * the same realization of the links from and to gateways. Since the
+     * table stores the gain of each link, chains whose received power doesn't
+     * scale with the transmission power (see IsLossAdditive) can't be stored.
+     *
+     * \param filename The path of the file to write.
+     * \return True if the file was written, false otherwise.
+     */
+    bool SaveLinkTable(std::string filename) const;
+
+    /**
+     * Use a link table written by SaveLinkTable instead of the loss and delay
+     * models, for the links from and to gateways between PHYs that did not
+     * move since the table was loaded. Links between end devices are still
+     * computed by the models, through the link cache if enabled.
+     *
+     * The file is memory-mapped, so that it is only read as links are needed
+     * and can be shared by simulations running in parallel. Gains are stored
+     * in single precision, so received powers may differ from those computed
+     * by the loss model by a few millionths of dB. The table is dropped if PHYs
+     * are later added to or removed from the channel.
+     *
+     * \param filename The path of the file to read.
+     * \return True if the table was loaded, false if it could not be read or
+     * was computed for different PHYs or models.
+     */
+    bool LoadLinkTable(std::string filename);
+
+    /**
+     * Register an interval during which a PHY listens to the channel.
+     *
+     * If the ReceiverSubscriptions attribute is set, PHYs that subscribe are
+     * only notified of transmissions that overlap one of their intervals at the
+     * receiver. Transmissions that were skipped but are still on air are
+     * delivered right away if they overlap the new interval, so that the
+     * interference seen by the PHY is the same as if it always listened.
+     *
+     * \param phy The physical layer that listens.
+     * \param start The time the interval begins.
+     * \param end The time the interval ends (Time::Max () if unknown).
+     */
+    void Subscribe(Ptr<LoraPhy> phy, Time start, Time end);
+
+    /**
+     * Truncate all listening intervals of a PHY at a certain time.
+     *
+     * \param phy The physical layer that stops listening.
+     * \param end The time after which the PHY is not interested anymore.
+     */
+    void EndSubscriptions(Ptr<LoraPhy> phy, Time end);
+
+    /**
+     * Drop all listening intervals of a PHY, so that it is not notified of
+     * any transmission until it subscribes again.
+     *
+     * \param phy The physical layer to unsubscribe.
+     */
+    void Unsubscribe(Ptr<LoraPhy> phy);
+
+    /**
+     * Set whether transmissions are recorded once in a log shared by all PHYs.
+     *
+     * When set, the PHYs of the channel don't store the signals they hear in
+     * their interference helper. When a PHY finishes receiving a packet, it
+     * looks up the transmissions overlapping it in the log, and the power they
+     * have at the PHY is computed at that time (see GetInterferers). The
+     * memory used by each PHY then depends on the packets it is locked on,
+     * rather than on the traffic it overhears.
+     *
+     * \param shared Whether to use the shared log.
+     */
+    void SetSharedAirLog(bool shared);
+
+    /**
+     * Get whether transmissions are recorded once in a log shared by all PHYs.
+     *
+     * \return True if PHYs look up their interferers in the shared log.
+     */
+    bool GetSharedAirLog() const;
+
+    /**
+     * Collect the logged transmissions that overlap a packet at a receiver.
+     *
+     * The received power and propagation delay of each logged transmission on
+     * the frequency of the packet are computed through the link cache or link
+     * table if available, or through the loss and delay models otherwise,
+     * using the positions the PHYs have when this method is called.
+     * Transmissions of the receiver itself are skipped, as is the packet.
+     *
+     * \param receiver The PHY receiving the packet.
+     * \param event The packet being received.
+     * \param interferers The vector the overlapping signals are appended to.
+     */
+    void GetInterferers(Ptr<LoraPhy> receiver,
+                        Ptr<LoraInterferenceHelper::Event> event,
+                        std::vector<Ptr<LoraInterferenceHelper::Event>>& interferers) const;
+
+  protected:
+    void DoDispose() override;
+
   private:
     /**
      * Private method that is scheduled by LoraChannel's Send method to happen
@@ -169,6 +487,332 @@ class LoraChannel : public Channel
      */
     void Receive(uint32_t i, Ptr<Packet> packet, LoraChannelParameters parameters) const;
 
+    struct ReceptionBatch;
+
+    /**
+     * Private method that is scheduled by LoraChannel's Send method, when the
+     * BatchedDelivery attribute is set, once for each group of PHYs that
+     * belong to the same node and share the same (quantized) propagation delay.
+     *
+     * It runs in the context of that node, and calls the StartReceive method of
+     * each PHY in the batch, in the order in which they were visited by Send.
+     *
+     * \param batch The receptions to start.
+     */
+    void ReceiveBatch(Ptr<const ReceptionBatch> batch) const;
+
+    /**
+     * Schedule a ReceiveBatch call for each of the batches filled during the
+     * current Send call, and empty the set of pending batches.
+     *
+     * Batches starting at the same time are scheduled in the order in which
+     * their first PHY was visited by Send.
+     */
+    void FlushBatches() const;
+
+    /**
+     * Get a mobility model standing in for a transmitter that has none.
+     *
+     * The same model is returned at each call, unless the air log keeps the
+     * mobility model of each transmission: a new one is created then.
+     *
+     * \param position The position of the transmitter.
+     * \return The mobility model, at the given position.
+     */
+    Ptr<MobilityModel> GetSenderStandIn(const Vector& position) const;
+
+    /**
+     * Deliver a packet to all PHYs of this partition, except the sender.
+     *
+     * \param sender The phy that is sending this packet, or nullptr if it
+     * belongs to another partition.
+     * \param senderMobility The mobility model of the sender.
+     * \param packet The packet being sent.
+     * \param txPowerDbm The power of the transmission.
+     * \param txParams The set of parameters that are used by the transmitter.
+     * \param duration The on-air duration of this packet.
+     * \param frequencyMHz The frequency this transmission will happen at.
+     * \param elapsed The time since the packet was sent.
+     */
+    void Propagate(Ptr<LoraPhy> sender,
+                   Ptr<MobilityModel> senderMobility,
+                   Ptr<Packet> packet,
+                   double txPowerDbm,
+                   const LoraTxParameters& txParams,
+                   Time duration,
+                   double frequencyMHz,
+                   Time elapsed) const;
+
+    /**
+     * Whether the i-th PHY belongs to the local partition of the simulation.
+     *
+     * \param i The index of the phy.
+     * \return True if the phy is local, false otherwise.
+     */
+    bool IsLocal(uint32_t i) const;
+
+    /**
+     * Schedule the Receive call of the i-th PHY, given the propagation
+     * towards it.
+     *
+     * \param i The index of the receiving phy.
+     * \param packet The packet being sent.
+     * \param delay The propagation delay towards the phy.
+     * \param rxPowerDbm The power of the packet at the phy.
+     * \param txParams The set of parameters that are used by the transmitter.
+     * \param duration The on-air duration of this packet.
+     * \param frequencyMHz The frequency this transmission will happen at.
+     */
+    void Deliver(uint32_t i,
+                 Ptr<Packet> packet,
+                 Time delay,
+                 double rxPowerDbm,
+                 const LoraTxParameters& txParams,
+                 Time duration,
+                 double frequencyMHz) const;
+
+    /**
+     * Compute the link budget towards each of the receivers in m_targets,
+     * storing them in m_budgets.
+     *
+     * If the loss model chain can be evaluated in batches (see
+     * IsBatchComputable) and the delay model is a
+     * ConstantSpeedPropagationDelayModel, all budgets are computed by the batch
+     * kernel on the array of receiver positions. If the ComputeThreads
+     * attribute is larger than one and the loss and delay models are safe to
+     * use concurrently, budgets are computed by the worker pool. Since each
+     * budget only depends on the positions of the two PHYs, results are the
+     * same as those of the sequential computation.
+     *
+     * \param senderIndex The index of the sending phy, if the link cache can be
+     * used for this transmission, or a negative value otherwise.
+     * \param senderMobility The mobility model of the sender.
+     * \param txPowerDbm The power of the transmission.
+     */
+    void ComputeLinkBudgets(int64_t senderIndex,
+                            Ptr<MobilityModel> senderMobility,
+                            double txPowerDbm) const;
+
+    /**
+     * Whether the loss and delay models can be queried from several threads.
+     *
+     * This is the case if all models of the chain are deterministic functions
+     * of the positions of the PHYs (e.g., LogDistancePropagationLossModel and
+     * ConstantSpeedPropagationDelayModel). Models that draw random values are
+     * always computed on the simulator thread, so that draws don't depend on
+     * the number of threads.
+     *
+     * \return True if link budgets can be computed in parallel.
+     */
+    bool IsParallelSafe() const;
+
+    /**
+     * Create the worker pool and the proxy mobility models of its threads, if
+     * needed.
+     */
+    void StartWorkers() const;
+
+    /**
+     * A model of the loss chain, in the form evaluated by the batch kernel.
+     */
+    struct BatchLossStage
+    {
+        /**
+         * The kind of model.
+         */
+        enum Type
+        {
+            LOG_DISTANCE, //!< LogDistancePropagationLossModel
+            FIXED_RSS,    //!< FixedRssLossModel
+            RANGE         //!< RangePropagationLossModel
+        };
+
+        Type type;          //!< The kind of model
+        double distance;    //!< Reference distance (log distance) or range [m]
+        double lossOrRssDb; //!< Reference loss (log distance) or fixed rss [dB/dBm]
+        double exponent;    //!< Path loss exponent (log distance)
+    };
+
+    /**
+     * Translate the loss model chain in the stages of the batch kernel.
+     *
+     * \param stages Output parameter for the stages, in chain order.
+     * \return True if all models of the chain are supported, false otherwise.
+     */
+    bool GetBatchStages(std::vector<BatchLossStage>& stages) const;
+
+    /**
+     * Evaluate the loss model chain on a range of positions.
+     *
+     * The loops only depend on the arrays they write, so they can be
+     * vectorized by the compiler and run concurrently on disjoint ranges.
+     *
+     * \param txPowerDbm The power of the transmission.
+     * \param senderPosition The position of the sender.
+     * \param receivers The positions of the receivers.
+     * \param begin The first position to evaluate.
+     * \param end One past the last position to evaluate.
+     * \param stages The stages of the loss model chain.
+     * \param distances Output array for the distance [m] of each receiver.
+     * \param rxPowersDbm Output array for the power at each receiver.
+     */
+    void ComputeBatch(double txPowerDbm,
+                      const Vector& senderPosition,
+                      const LoraPositionBatch& receivers,
+                      std::size_t begin,
+                      std::size_t end,
+                      const std::vector<BatchLossStage>& stages,
+                      double* distances,
+                      double* rxPowersDbm) const;
+
+    /**
+     * Whether the loss or delay models draw new random values at every call.
+     *
+     * \return True if a stochastic model is in use, false otherwise.
+     */
+    bool HasRandomModels() const;
+
+    /**
+     * Whether the received power computed by the loss model chain is the
+     * transmission power plus a gain that doesn't depend on it.
+     *
+     * This is not the case if the chain contains a FixedRssLossModel, which
+     * returns the same received power whatever the transmission power, or a
+     * RangePropagationLossModel, which returns -1000 dBm out of its range.
+     *
+     * \return True if received powers can be scaled with the transmission power.
+     */
+    bool IsLossAdditive() const;
+
+    /**
+     * Compute the parameters identifying the current scenario in a link table.
+     *
+     * \param randomLoss Whether the table holds samples of random models.
+     * \return The signature of the scenario.
+     */
+    LoraLinkTable::Signature GetLinkTableSignature(bool randomLoss) const;
+
+    /**
+     * Whether a link table describes the PHYs and models of this channel.
+     *
+     * \param table The link table.
+     * \return True if the table can be used, false otherwise.
+     */
+    bool IsLinkTableValid(Ptr<const LoraLinkTable> table) const;
+
+    /**
+     * Compute the propagation delay and the received power from a sender to
+     * the i-th PHY, using the link table or the link cache if possible.
+     *
+     * \param i The index of the receiving phy.
+     * \param senderIndex The index of the sending phy, if the link table or the
+     * link cache can be used, or a negative value otherwise.
+     * \param senderMobility The mobility model of the sender.
+     * \param receiverMobility The mobility model of the receiver.
+     * \param txPowerDbm The power of the transmission.
+     * \param delay Output parameter for the propagation delay.
+     * \param rxPowerDbm Output parameter for the received power.
+     */
+    void GetLinkBudget(uint32_t i,
+                       int64_t senderIndex,
+                       Ptr<MobilityModel> senderMobility,
+                       Ptr<MobilityModel> receiverMobility,
+                       double txPowerDbm,
+                       Time& delay,
+                       double& rxPowerDbm) const;
+
+    /**
+     * Get the context to use for events scheduled for the i-th PHY.
+     *
+     * The context is cached when the PHY is added to the channel or, if the
+     * PHY is not attached to a node yet, the first time it is needed.
+     *
+     * \param i The index of the phy.
+     * \return The id of the node of the phy, or 0 if it has no NetDevice.
+     */
+    uint32_t GetContext(uint32_t i) const;
+
+    /**
+     * Whether the i-th PHY is interested in a signal occupying a time interval.
+     *
+     * \param i The index of the phy.
+     * \param start The time the signal begins at the receiver.
+     * \param end The time the signal ends at the receiver.
+     * \return True if the PHY doesn't use subscriptions or if the signal
+     * overlaps one of its listening intervals, false otherwise.
+     */
+    bool IsInterested(uint32_t i, Time start, Time end) const;
+
+    /**
+     * Deliver to the i-th PHY the transmissions it skipped that are still on
+     * air and overlap a new listening interval.
+     *
+     * \param i The index of the phy.
+     * \param start The time the listening interval begins.
+     * \param end The time the listening interval ends.
+     */
+    void BackFill(uint32_t i, Time start, Time end);
+
+    /**
+     * Drop the transmissions that ended at every receiver from the air log.
+     */
+    void PurgeAirLog() const;
+
+    /**
+     * Get the key of the spatial index cell containing a position.
+     *
+     * \param position The position to map to a cell.
+     * \return The key of the cell.
+     */
+    uint64_t GetCellKey(const Vector& position) const;
+
+    /**
+     * Refresh the data structures that map PHYs and their mobility models to
+     * their index in m_phyList.
+     *
+     * This also connects to the CourseChange trace source of mobility models
+     * that were not tracked yet, so that the spatial index and the link cache
+     * can follow node movements.
+     */
+    void TrackPhys() const;
+
+    /**
+     * (Re)build the spatial index from the current positions of all PHYs.
+     */
+    void BuildSpatialIndex() const;
+
+    /**
+     * Fill m_candidates with the sorted indexes of the PHYs that lie within a
+     * certain distance from a position, according to the spatial index.
+     *
+     * \param position The position of the transmitter.
+     * \param range The maximum distance [m] of the receivers to consider.
+     */
+    void CollectCandidates(const Vector& position, double range) const;
+
+    /**
+     * Check that the spatial index visited every PHY that a loop over all PHYs
+     * would deliver a transmission to at a power that can be received, or that
+     * can destroy a packet received at sensitivity, aborting the simulation
+     * otherwise.
+     *
+     * \param sender The phy that is sending the packet.
+     * \param senderMobility The mobility model of the sender.
+     * \param txPowerDbm The power of the transmission.
+     */
+    void ValidateCandidates(Ptr<LoraPhy> sender,
+                            Ptr<MobilityModel> senderMobility,
+                            double txPowerDbm) const;
+
+    /**
+     * Callback for the CourseChange trace source of the tracked mobility
+     * models, moving the associated PHYs to their new cell and invalidating
+     * their cached links.
+     *
+     * \param mobility The mobility model that changed course.
+     */
+    void CourseChanged(Ptr<const MobilityModel> mobility) const;
+
     /**
      * The vector containing the PHYs that are currently connected to the
      * channel.
@@ -192,6 +836,138 @@ class LoraChannel : public Channel
      * Callback for when a packet is being sent on the channel.
      */
     TracedCallback<Ptr<const Packet>> m_packetSent;
+
+    bool m_spatialIndexEnabled; //!< Whether to cull receivers through the spatial index
+    double m_cellSize;          //!< The side [m] of the cells of the spatial index
+    double m_cullingMarginDb;   //!< Margin [dB] added to the loss budget of the range bound
+    bool m_validateCulling;     //!< Whether to check culled receivers against brute force
+
+    /**
+     * Uniform grid over the x-y plane mapping each cell to the indexes of the
+     * PHYs it contains.
+     */
+    mutable std::unordered_map<uint64_t, std::vector<uint32_t>> m_grid;
+    mutable std::vector<uint64_t> m_phyCells; //!< The cell each PHY is currently stored in
+    mutable std::map<Ptr<MobilityModel>, std::vector<uint32_t>>
+        m_trackedMobility; //!< Mobility models we are connected to, with the PHYs using them
+    std::unordered_map<const LoraPhy*, uint32_t> m_phyIndexes; //!< Index of each PHY in m_phyList
+    mutable std::vector<bool> m_staticPhys;     //!< Whether each PHY notifies its movements
+    mutable std::vector<uint32_t> m_mobilePhys; //!< PHYs that may move without notice
+    mutable bool m_physDirty;                   //!< Whether PHYs need to be tracked again
+    mutable bool m_spatialIndexDirty;           //!< Whether the index needs to be rebuilt
+    mutable std::vector<uint32_t> m_candidates; //!< Scratch buffer for candidate receivers
+
+    /**
+     * A link budget between two PHYs, valid as long as neither of them moves.
+     */
+    struct LinkCacheEntry
+    {
+        double txPowerDbm;           //!< Transmission power the entry was computed for
+        double rxPowerDbm;           //!< Received power for a transmission at txPowerDbm
+        Time delay;                  //!< The propagation delay
+        uint32_t senderGeneration;   //!< Generation of the sender when computed
+        uint32_t receiverGeneration; //!< Generation of the receiver when computed
+    };
+
+    bool m_linkCacheEnabled;  //!< Whether to cache link budgets between PHYs
+    bool m_freezeRandomLoss;  //!< Whether to also cache links of stochastic models
+    mutable std::unordered_map<uint64_t, LinkCacheEntry>
+        m_linkCache; //!< Link budgets, keyed by (sender index, receiver index)
+    mutable std::vector<uint32_t>
+        m_generations; //!< Per-PHY counter, increased whenever the PHY moves
+
+    /**
+     * The listening intervals registered by a PHY.
+     */
+    struct ReceiverInterest
+    {
+        bool subscribed = false; //!< Whether deliveries are restricted to the intervals
+        std::vector<std::pair<Time, Time>> intervals; //!< Start and end of each interval
+    };
+
+    /**
+     * A transmission that may still be on air at some receiver.
+     */
+    struct AirRecord
+    {
+        Ptr<LoraPhy> sender;                 //!< The phy that sent the packet
+        int64_t senderIndex;                 //!< Index of the sender, for the link cache
+        Ptr<MobilityModel> senderMobility;   //!< Mobility of the sender when it transmitted
+        Ptr<Packet> packet;                  //!< The packet being sent
+        double txPowerDbm;                   //!< The power of the transmission
+        uint8_t sf;                          //!< The spreading factor of the transmission
+        Time start;                          //!< The time the transmission began
+        Time duration;                       //!< The on-air duration of the packet
+        double frequencyMHz;                 //!< The frequency of the transmission
+        std::vector<uint32_t> delivered;     //!< Subscribed PHYs that were notified
+    };
+
+    bool m_subscriptionsEnabled; //!< Whether PHYs can restrict deliveries to their intervals
+    std::vector<ReceiverInterest> m_interests; //!< Listening intervals of each PHY
+    mutable std::deque<AirRecord> m_airLog;    //!< Recent transmissions, for back-filling
+    mutable Time m_maxDelay;                   //!< Longest propagation delay seen so far
+    bool m_sharedAirLog;           //!< Whether PHYs look up their interferers in the air log
+    mutable Time m_maxAirDuration; //!< Longest on-air duration logged so far
+
+    /**
+     * The reception of a packet at one of the PHYs of a batch.
+     */
+    struct ReceptionRecord
+    {
+        uint32_t phyIndex; //!< The index of the receiving phy
+        double rxPowerDbm; //!< The power of the packet at the receiver
+        uint32_t context;  //!< The id of the node of the receiving phy
+    };
+
+    /**
+     * The receptions of a packet at all PHYs of a node sharing the same
+     * propagation delay.
+     */
+    struct ReceptionBatch : public SimpleRefCount<ReceptionBatch>
+    {
+        Ptr<Packet> packet;                   //!< The packet being received
+        uint8_t sf;                           //!< The spreading factor of the transmission
+        Time duration;                        //!< The on-air duration of the packet
+        double frequencyMHz;                  //!< The frequency of the transmission
+        std::vector<ReceptionRecord> records; //!< The receptions to start
+    };
+
+    bool m_batchedDelivery; //!< Whether to schedule one reception event per delay group
+    Time m_delayQuantum;    //!< Granularity used to group propagation delays
+    mutable std::map<std::pair<int64_t, uint32_t>, Ptr<ReceptionBatch>>
+        m_pendingBatches; //!< Batches of the current Send, keyed by delay time step and context
+    mutable std::vector<std::pair<int64_t, Ptr<ReceptionBatch>>>
+        m_batchOrder; //!< Batches of the current Send, in creation order
+    mutable std::vector<uint32_t> m_contexts; //!< Cached node id of each PHY
+
+    /**
+     * The propagation of a packet towards one of its receivers.
+     */
+    struct LinkBudget
+    {
+        Time delay;        //!< The propagation delay
+        double rxPowerDbm; //!< The power of the packet at the receiver
+    };
+
+    uint32_t m_computeThreads;                 //!< Number of threads used to compute link budgets
+    uint32_t m_parallelThreshold;              //!< Minimum number of receivers to use the threads
+    mutable std::vector<uint32_t> m_targets;   //!< Receivers of the packet being sent
+    mutable std::vector<LinkBudget> m_budgets; //!< Link budget towards each receiver
+    mutable std::vector<Vector> m_positions;   //!< Receiver positions, for the workers
+    mutable Ptr<WorkerPool> m_workers;         //!< Threads computing link budgets
+    mutable std::vector<std::pair<Ptr<MobilityModel>, Ptr<MobilityModel>>>
+        m_proxies; //!< Sender and receiver stand-ins owned by each thread
+    mutable Ptr<MobilityModel> m_senderStandIn; //!< Stands in for senders without a PHY
+
+    uint32_t m_systemId;                     //!< Local partition, or UINT32_MAX if there's none
+    RemoteSendCallback m_remoteSendCallback; //!< Forwards packets to the other partitions
+
+    mutable Ptr<const LoraLinkTable> m_linkTable; //!< Precomputed link budgets, if any
+
+    mutable std::vector<BatchLossStage> m_batchStages; //!< Scratch buffer for the kernel stages
+    mutable LoraPositionBatch m_receiverBatch;         //!< Scratch buffer for receiver positions
+    mutable std::vector<double> m_distances;           //!< Scratch buffer for receiver distances
+    mutable std::vector<double> m_rxPowers;            //!< Scratch buffer for received powers
 };
 
 } // namespace lorawan
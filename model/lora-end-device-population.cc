@@ -0,0 +1,370 @@
+/*
+ * Copyright (c) 2017 University of Padova
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#include "lora-end-device-population.h"
+
+#include "lora-frame-header.h"
+#include "lora-phy.h"
+#include "lora-tag.h"
+#include "lorawan-mac-header.h"
+
+#include "ns3/double.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+NS_LOG_COMPONENT_DEFINE("LoraEndDevicePopulation");
+
+NS_OBJECT_ENSURE_REGISTERED(LoraEndDevicePopulation);
+
+/// The spreading factor of each EU868 data rate
+static const uint8_t POPULATION_SF_FOR_DR[] = {12, 11, 10, 9, 8, 7, 7};
+
+/// The bandwidth of each EU868 data rate [Hz]
+static const uint32_t POPULATION_BANDWIDTH_FOR_DR[] =
+    {125000, 125000, 125000, 125000, 125000, 125000, 250000};
+
+TypeId
+LoraEndDevicePopulation::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::LoraEndDevicePopulation")
+            .SetParent<Object>()
+            .SetGroupName("lorawan")
+            .AddConstructor<LoraEndDevicePopulation>()
+            .AddAttribute("PacketSize",
+                          "The size of the application payload of packets, in bytes.",
+                          UintegerValue(10),
+                          MakeUintegerAccessor(&LoraEndDevicePopulation::m_packetSize),
+                          MakeUintegerChecker<uint8_t>())
+            .AddAttribute("DutyCycle",
+                          "The duty cycle of the sub-band of the frequencies devices use.",
+                          DoubleValue(0.01),
+                          MakeDoubleAccessor(&LoraEndDevicePopulation::m_dutyCycle),
+                          MakeDoubleChecker<double>(0, 1))
+            .AddTraceSource("StartSending",
+                            "Trace source indicating a device of the population sent a packet.",
+                            MakeTraceSourceAccessor(&LoraEndDevicePopulation::m_startSending),
+                            "ns3::LoraEndDevicePopulation::StartSendingTracedCallback");
+    return tid;
+}
+
+LoraEndDevicePopulation::LoraEndDevicePopulation()
+    : m_frequenciesMHz{868.1, 868.3, 868.5},
+      m_uniformRV(CreateObject<UniformRandomVariable>()),
+      m_stopTime(Time::Max()),
+      m_started(false),
+      m_packetSize(10),
+      m_dutyCycle(0.01)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+LoraEndDevicePopulation::~LoraEndDevicePopulation()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+LoraEndDevicePopulation::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+
+    m_nextEvent.Cancel();
+    m_channel = nullptr;
+    m_addressGenerator = nullptr;
+    m_uniformRV = nullptr;
+
+    Object::DoDispose();
+}
+
+void
+LoraEndDevicePopulation::SetChannel(Ptr<LoraChannel> channel)
+{
+    m_channel = channel;
+}
+
+void
+LoraEndDevicePopulation::SetAddressGenerator(Ptr<LoraDeviceAddressGenerator> generator)
+{
+    m_addressGenerator = generator;
+}
+
+void
+LoraEndDevicePopulation::SetFrequencies(std::vector<double> frequenciesMHz)
+{
+    NS_ASSERT(!frequenciesMHz.empty());
+
+    m_frequenciesMHz = std::move(frequenciesMHz);
+}
+
+void
+LoraEndDevicePopulation::Reserve(uint32_t nDevices)
+{
+    NS_LOG_FUNCTION(this << nDevices);
+
+    m_positions.x.reserve(nDevices);
+    m_positions.y.reserve(nDevices);
+    m_positions.z.reserve(nDevices);
+    m_dataRates.reserve(nDevices);
+    m_txPowersDbm.reserve(nDevices);
+    m_periods.reserve(nDevices);
+    m_nextPackets.reserve(nDevices);
+    m_nextAllowed.reserve(nDevices);
+    m_frameCounters.reserve(nDevices);
+    m_addresses.reserve(nDevices);
+    m_schedule.reserve(nDevices);
+}
+
+uint32_t
+LoraEndDevicePopulation::Add(const Vector& position, Time period, Time phase)
+{
+    NS_LOG_FUNCTION(this << position << period << phase);
+
+    NS_ASSERT(period.IsStrictlyPositive() && !phase.IsNegative());
+
+    if (!m_addressGenerator)
+    {
+        m_addressGenerator = CreateObject<LoraDeviceAddressGenerator>();
+    }
+
+    auto i = uint32_t(m_dataRates.size());
+    m_positions.Add(position);
+    m_dataRates.push_back(0);
+    m_txPowersDbm.push_back(14);
+    m_periods.push_back(period);
+    m_nextAllowed.push_back(Seconds(0));
+    m_frameCounters.push_back(0);
+    m_addresses.push_back(m_addressGenerator->NextAddress().Get());
+
+    // Until Start is called, the phase is kept as the time of the first packet
+    if (m_started)
+    {
+        m_nextPackets.push_back(Simulator::Now() + phase);
+        Push(m_nextPackets[i], i);
+        ScheduleNext();
+    }
+    else
+    {
+        m_nextPackets.push_back(phase);
+    }
+
+    return i;
+}
+
+void
+LoraEndDevicePopulation::Start(Time stopTime)
+{
+    NS_LOG_FUNCTION(this << stopTime);
+
+    NS_ABORT_MSG_IF(m_started, "The population was already started");
+    NS_ABORT_MSG_IF(!m_channel, "The population needs a channel to send packets on");
+
+    m_started = true;
+    m_stopTime = stopTime;
+
+    Time now = Simulator::Now();
+    m_schedule.clear();
+    for (uint32_t i = 0; i < m_nextPackets.size(); i++)
+    {
+        m_nextPackets[i] += now;
+        m_schedule.emplace_back(m_nextPackets[i].GetTimeStep(), i);
+    }
+    std::make_heap(m_schedule.begin(), m_schedule.end(), std::greater<>());
+
+    ScheduleNext();
+}
+
+uint32_t
+LoraEndDevicePopulation::GetN() const
+{
+    return uint32_t(m_dataRates.size());
+}
+
+const LoraPositionBatch&
+LoraEndDevicePopulation::GetPositions() const
+{
+    return m_positions;
+}
+
+LoraDeviceAddress
+LoraEndDevicePopulation::GetAddress(uint32_t i) const
+{
+    return LoraDeviceAddress(m_addresses.at(i));
+}
+
+void
+LoraEndDevicePopulation::SetDataRate(uint32_t i, uint8_t dataRate)
+{
+    NS_ASSERT_MSG(dataRate < sizeof(POPULATION_SF_FOR_DR), "Invalid EU868 data rate");
+
+    m_dataRates.at(i) = dataRate;
+}
+
+uint8_t
+LoraEndDevicePopulation::GetDataRate(uint32_t i) const
+{
+    return m_dataRates.at(i);
+}
+
+void
+LoraEndDevicePopulation::SetTxPower(uint32_t i, uint8_t txPowerDbm)
+{
+    m_txPowersDbm.at(i) = txPowerDbm;
+}
+
+uint8_t
+LoraEndDevicePopulation::GetTxPower(uint32_t i) const
+{
+    return m_txPowersDbm.at(i);
+}
+
+uint16_t
+LoraEndDevicePopulation::GetFrameCounter(uint32_t i) const
+{
+    return m_frameCounters.at(i);
+}
+
+std::size_t
+LoraEndDevicePopulation::GetBytesPerDevice()
+{
+    return 3 * sizeof(double) + 2 * sizeof(uint8_t) + 3 * sizeof(Time) + sizeof(uint16_t) +
+           sizeof(uint32_t) + sizeof(std::pair<int64_t, uint32_t>);
+}
+
+int64_t
+LoraEndDevicePopulation::AssignStreams(int64_t stream)
+{
+    NS_LOG_FUNCTION(this << stream);
+
+    m_uniformRV->SetStream(stream);
+    return 1;
+}
+
+void
+LoraEndDevicePopulation::Push(Time time, uint32_t i)
+{
+    m_schedule.emplace_back(time.GetTimeStep(), i);
+    std::push_heap(m_schedule.begin(), m_schedule.end(), std::greater<>());
+}
+
+void
+LoraEndDevicePopulation::ScheduleNext()
+{
+    if (m_schedule.empty())
+    {
+        return;
+    }
+
+    int64_t next = m_schedule.front().first;
+    if (m_nextEvent.IsPending() && int64_t(m_nextEvent.GetTs()) <= next)
+    {
+        return;
+    }
+
+    m_nextEvent.Cancel();
+    m_nextEvent = Simulator::Schedule(TimeStep(next) - Simulator::Now(),
+                                      &LoraEndDevicePopulation::SendDuePackets,
+                                      this);
+}
+
+void
+LoraEndDevicePopulation::SendDuePackets()
+{
+    NS_LOG_FUNCTION(this);
+
+    Time now = Simulator::Now();
+    while (!m_schedule.empty() && m_schedule.front().first <= now.GetTimeStep())
+    {
+        uint32_t i = m_schedule.front().second;
+        std::pop_heap(m_schedule.begin(), m_schedule.end(), std::greater<>());
+        m_schedule.pop_back();
+
+        // The packet generated at m_nextPackets[i] is still waiting for the duty cycle
+        if (now < m_nextAllowed[i])
+        {
+            Push(m_nextAllowed[i], i);
+            continue;
+        }
+
+        Send(i);
+
+        // Packets generated while the previous one was waiting are superseded by it
+        while (m_nextPackets[i] <= now)
+        {
+            m_nextPackets[i] += m_periods[i];
+        }
+        if (m_nextPackets[i] < m_stopTime)
+        {
+            Push(m_nextPackets[i], i);
+        }
+    }
+
+    ScheduleNext();
+}
+
+void
+LoraEndDevicePopulation::Send(uint32_t i)
+{
+    NS_LOG_FUNCTION(this << i);
+
+    uint8_t dataRate = m_dataRates[i];
+    m_frameCounters[i]++;
+
+    // Build the packet as ClassAEndDeviceLorawanMac and EndDeviceLoraPhy would
+    Ptr<Packet> packet = Create<Packet>(m_packetSize);
+
+    LoraFrameHeader frameHdr;
+    frameHdr.SetAsUplink();
+    frameHdr.SetFPort(1);
+    frameHdr.SetAddress(LoraDeviceAddress(m_addresses[i]));
+    frameHdr.SetAdr(false);
+    frameHdr.SetAdrAckReq(false);
+    frameHdr.SetFCnt(m_frameCounters[i]);
+    packet->AddHeader(frameHdr);
+
+    LorawanMacHeader macHdr;
+    macHdr.SetMType(LorawanMacHeader::UNCONFIRMED_DATA_UP);
+    macHdr.SetMajor(1);
+    packet->AddHeader(macHdr);
+
+    LoraTxParameters params;
+    params.sf = POPULATION_SF_FOR_DR[dataRate];
+    params.bandwidthHz = POPULATION_BANDWIDTH_FOR_DR[dataRate];
+    params.lowDataRateOptimizationEnabled = LoraPhy::GetTSym(params) > MilliSeconds(16);
+
+    LoraTag tag;
+    tag.SetSpreadingFactor(params.sf);
+    packet->AddPacketTag(tag);
+
+    Time duration = LoraPhy::GetOnAirTime(packet, params);
+    double frequencyMHz =
+        m_frequenciesMHz[m_uniformRV->GetInteger(0, uint32_t(m_frequenciesMHz.size()) - 1)];
+
+    m_channel->Send(Vector(m_positions.x[i], m_positions.y[i], m_positions.z[i]),
+                    packet,
+                    m_txPowersDbm[i],
+                    params,
+                    duration,
+                    frequencyMHz);
+
+    // Same waiting time as LogicalLoraChannelHelper::AddEvent
+    double timeOnAir = duration.GetSeconds();
+    m_nextAllowed[i] = Simulator::Now() + Seconds(timeOnAir / m_dutyCycle - timeOnAir);
+
+    m_startSending(packet, i);
+}
+
+} // namespace lorawan
+} // namespace ns3
@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2017 University of Padova
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#ifndef LORA_END_DEVICE_POPULATION_H
+#define LORA_END_DEVICE_POPULATION_H
+
+#include "lora-channel.h"
+#include "lora-device-address-generator.h"
+#include "lora-device-address.h"
+
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
+#include "ns3/object.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/traced-callback.h"
+#include "ns3/vector.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+/**
+ * \ingroup lorawan
+ *
+ * A set of uplink-only Class A end devices that periodically send unconfirmed
+ * packets, without a Node, NetDevice, MAC, PHY or application per device.
+ *
+ * The state of the devices is stored as a structure of arrays: position, data
+ * rate, transmission power, period, time of the next packet, time at which the
+ * duty cycle allows the next transmission, frame counter and address. Packets
+ * carry the same LorawanMacHeader, LoraFrameHeader and LoraTag as those sent
+ * by a ClassAEndDeviceLorawanMac, and are injected directly into the
+ * LoraChannel, so gateways and the NetworkServer handle them as any other
+ * uplink. Devices never listen: they don't open receive windows, and they can't
+ * be reconfigured by MAC commands.
+ *
+ * Transmissions are driven by a single pending event, for the device that
+ * sends next, instead of the application, MAC and PHY events of a Node. Each
+ * device picks one of the configured frequencies at random for each packet,
+ * and all frequencies are assumed to belong to the same sub-band (as the
+ * default EU868 channels), whose duty cycle is enforced per device. If the
+ * duty cycle prevents a packet from being sent when it is generated, it is
+ * sent as soon as it allows. Data rates follow the EU868 definitions.
+ */
+class LoraEndDevicePopulation : public Object
+{
+  public:
+    /**
+     *  Register this type.
+     *  \return The object TypeId.
+     */
+    static TypeId GetTypeId();
+
+    LoraEndDevicePopulation();           //!< Default constructor
+    ~LoraEndDevicePopulation() override; //!< Destructor
+
+    /**
+     * Set the channel devices transmit on.
+     *
+     * \param channel The channel.
+     */
+    void SetChannel(Ptr<LoraChannel> channel);
+
+    /**
+     * Set the generator assigning addresses to the devices added from now on.
+     *
+     * If no generator is set, one with the default network id and address is
+     * created.
+     *
+     * \param generator The address generator.
+     */
+    void SetAddressGenerator(Ptr<LoraDeviceAddressGenerator> generator);
+
+    /**
+     * Set the frequencies devices pick from for each transmission.
+     *
+     * \param frequenciesMHz The frequencies [MHz], which need to belong to the
+     * same sub-band.
+     */
+    void SetFrequencies(std::vector<double> frequenciesMHz);
+
+    /**
+     * Reserve memory for a number of devices.
+     *
+     * \param nDevices The number of devices the population will hold.
+     */
+    void Reserve(uint32_t nDevices);
+
+    /**
+     * Add a device to the population.
+     *
+     * \param position The position of the device.
+     * \param period The interval between the packets of the device.
+     * \param phase The delay, from the call to Start, before the first packet.
+     * \return The index of the device in the population.
+     */
+    uint32_t Add(const Vector& position, Time period, Time phase);
+
+    /**
+     * Start sending packets.
+     *
+     * Phases of the devices count from the time this method is called.
+     *
+     * \param stopTime No packet is generated at or after this time.
+     */
+    void Start(Time stopTime);
+
+    /**
+     * Get the number of devices in the population.
+     *
+     * \return The number of devices.
+     */
+    uint32_t GetN() const;
+
+    /**
+     * Get the positions of all devices.
+     *
+     * \return The positions, indexed by device.
+     */
+    const LoraPositionBatch& GetPositions() const;
+
+    /**
+     * Get the address of a device.
+     *
+     * \param i The index of the device.
+     * \return The address.
+     */
+    LoraDeviceAddress GetAddress(uint32_t i) const;
+
+    /**
+     * Set the data rate a device transmits at.
+     *
+     * \param i The index of the device.
+     * \param dataRate The EU868 data rate, between 0 and 6.
+     */
+    void SetDataRate(uint32_t i, uint8_t dataRate);
+
+    /**
+     * Get the data rate a device transmits at.
+     *
+     * \param i The index of the device.
+     * \return The data rate.
+     */
+    uint8_t GetDataRate(uint32_t i) const;
+
+    /**
+     * Set the power a device transmits at.
+     *
+     * \param i The index of the device.
+     * \param txPowerDbm The transmission power [dBm].
+     */
+    void SetTxPower(uint32_t i, uint8_t txPowerDbm);
+
+    /**
+     * Get the power a device transmits at.
+     *
+     * \param i The index of the device.
+     * \return The transmission power [dBm].
+     */
+    uint8_t GetTxPower(uint32_t i) const;
+
+    /**
+     * Get the frame counter of the last packet sent by a device.
+     *
+     * \param i The index of the device.
+     * \return The frame counter, or 0 if the device didn't send any packet.
+     */
+    uint16_t GetFrameCounter(uint32_t i) const;
+
+    /**
+     * Get the number of bytes used by the state of each device.
+     *
+     * \return The size of the state of a device, in bytes.
+     */
+    static std::size_t GetBytesPerDevice();
+
+    /**
+     * Assign a fixed random variable stream number to the random variables
+     * used by this population.
+     *
+     * \param stream The first stream index to use.
+     * \return The number of stream indices assigned.
+     */
+    int64_t AssignStreams(int64_t stream);
+
+    /**
+     * TracedCallback signature for packets sent by a device.
+     *
+     * \param packet The packet sent.
+     * \param index The index of the device in the population.
+     */
+    typedef void (*StartSendingTracedCallback)(Ptr<const Packet> packet, uint32_t index);
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    /**
+     * Send the packets of all devices that are due, and schedule the event
+     * for the next one.
+     */
+    void SendDuePackets();
+
+    /**
+     * Send a packet from a device.
+     *
+     * \param i The index of the device.
+     */
+    void Send(uint32_t i);
+
+    /**
+     * Add a device to the schedule of pending transmissions.
+     *
+     * \param time The time the device will need to be visited.
+     * \param i The index of the device.
+     */
+    void Push(Time time, uint32_t i);
+
+    /**
+     * Make sure the pending event fires for the first device of the schedule.
+     */
+    void ScheduleNext();
+
+    // Per-device state, indexed by device
+    LoraPositionBatch m_positions;         //!< The position of each device
+    std::vector<uint8_t> m_dataRates;      //!< The data rate of each device
+    std::vector<uint8_t> m_txPowersDbm;    //!< The transmission power of each device
+    std::vector<Time> m_periods;           //!< The interval between packets of each device
+    std::vector<Time> m_nextPackets;       //!< The time the next packet is generated
+    std::vector<Time> m_nextAllowed;       //!< The time the duty cycle allows a transmission
+    std::vector<uint16_t> m_frameCounters; //!< The frame counter of each device
+    std::vector<uint32_t> m_addresses;     //!< The address of each device
+
+    /// Min-heap of the times at which devices need to be visited, by device
+    std::vector<std::pair<int64_t, uint32_t>> m_schedule;
+
+    Ptr<LoraChannel> m_channel;                         //!< The channel packets are sent on
+    Ptr<LoraDeviceAddressGenerator> m_addressGenerator; //!< Assigns addresses to devices
+    std::vector<double> m_frequenciesMHz;               //!< The frequencies devices pick from
+    Ptr<UniformRandomVariable> m_uniformRV;             //!< Picks the frequency of each packet
+    EventId m_nextEvent;                                //!< The event sending the next packets
+    Time m_stopTime; //!< No packet is generated at or after this time
+    bool m_started;  //!< Whether Start was called
+
+    uint8_t m_packetSize; //!< The size of the application payload of packets
+    double m_dutyCycle;   //!< The duty cycle of the sub-band of the frequencies
+
+    /// The trace source fired when a device sends a packet
+    TracedCallback<Ptr<const Packet>, uint32_t> m_startSending;
+};
+
+} // namespace lorawan
+
+} // namespace ns3
+#endif /* LORA_END_DEVICE_POPULATION_H */
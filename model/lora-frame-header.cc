@@ -10,8 +10,6 @@
 
 #include "ns3/log.h"
 
-#include <bitset>
-
 namespace ns3
 {
 namespace lorawan
@@ -88,10 +86,10 @@ LoraFrameHeader::Serialize(Buffer::Iterator start) const
     start.WriteU16(m_fCnt);
 
     // FOpts field
-    for (auto it = m_macCommands.begin(); it != m_macCommands.end(); it++)
+    for (std::size_t i = 0; i < m_macCommands.GetN(); i++)
     {
         NS_LOG_DEBUG("Serializing a MAC command");
-        (*it)->Serialize(start);
+        SerializeMacCommand(m_macCommands.Get(i), start);
     }
 
     // FPort
@@ -113,7 +111,7 @@ LoraFrameHeader::Deserialize(Buffer::Iterator start)
     NS_LOG_FUNCTION_NOARGS();
 
     // Empty the list of MAC commands
-    m_macCommands.clear();
+    m_macCommands.Clear();
 
     // Read from buffer and save into local variables
     m_address.Set(start.ReadU32());
@@ -140,154 +138,20 @@ LoraFrameHeader::Deserialize(Buffer::Iterator start)
     NS_LOG_DEBUG("Starting deserialization of MAC commands");
     for (uint8_t byteNumber = 0; byteNumber < m_fOptsLen;)
     {
-        uint8_t cid = start.PeekU8();
-        NS_LOG_DEBUG("CID: " << unsigned(cid));
-
         // Divide Uplink and Downlink messages
         // This needs to be done because they have the same CID, and the context
         // about where this message will be Serialized/Deserialized (i.e., at the
         // end device or at the network server) is umportant.
-        if (m_isUplink)
-        {
-            switch (cid)
-            {
-            // In the case of Uplink messages, the network server will deserialize the
-            // request for a link check
-            case (0x02): {
-                NS_LOG_DEBUG("Creating a LinkCheckReq command");
-                Ptr<LinkCheckReq> command = Create<LinkCheckReq>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            case (0x03): {
-                NS_LOG_DEBUG("Creating a LinkAdrAns command");
-                Ptr<LinkAdrAns> command = Create<LinkAdrAns>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            case (0x04): {
-                NS_LOG_DEBUG("Creating a DutyCycleAns command");
-                Ptr<DutyCycleAns> command = Create<DutyCycleAns>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            case (0x05): {
-                NS_LOG_DEBUG("Creating a RxParamSetupAns command");
-                Ptr<RxParamSetupAns> command = Create<RxParamSetupAns>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            case (0x06): {
-                NS_LOG_DEBUG("Creating a DevStatusAns command");
-                Ptr<DevStatusAns> command = Create<DevStatusAns>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            case (0x07): {
-                NS_LOG_DEBUG("Creating a NewChannelAns command");
-                Ptr<NewChannelAns> command = Create<NewChannelAns>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            case (0x08): {
-                NS_LOG_DEBUG("Creating a RxTimingSetupAns command");
-                Ptr<RxTimingSetupAns> command = Create<RxTimingSetupAns>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            case (0x09): {
-                NS_LOG_DEBUG("Creating a TxParamSetupAns command");
-                Ptr<TxParamSetupAns> command = Create<TxParamSetupAns>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            case (0x0A): {
-                NS_LOG_DEBUG("Creating a DlChannelAns command");
-                Ptr<DlChannelAns> command = Create<DlChannelAns>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            default: {
-                NS_LOG_ERROR("CID not recognized during deserialization");
-            }
-            }
-        }
-        else
+        MacCommandValue command;
+        uint8_t size = DeserializeMacCommand(start, m_isUplink, command);
+        if (size == 0)
         {
-            switch (cid)
-            {
-            // In the case of Downlink messages, the end device will deserialize the
-            // answer to a link check
-            case (0x02): {
-                NS_LOG_DEBUG("Creating a LinkCheckAns command");
-                Ptr<LinkCheckAns> command = Create<LinkCheckAns>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            case (0x03): {
-                NS_LOG_DEBUG("Creating a LinkAdrReq command");
-                Ptr<LinkAdrReq> command = Create<LinkAdrReq>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            case (0x04): {
-                NS_LOG_DEBUG("Creating a DutyCycleReq command");
-                Ptr<DutyCycleReq> command = Create<DutyCycleReq>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            case (0x05): {
-                NS_LOG_DEBUG("Creating a RxParamSetupReq command");
-                Ptr<RxParamSetupReq> command = Create<RxParamSetupReq>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            case (0x06): {
-                NS_LOG_DEBUG("Creating a DevStatusReq command");
-                Ptr<DevStatusReq> command = Create<DevStatusReq>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            case (0x07): {
-                NS_LOG_DEBUG("Creating a NewChannelReq command");
-                Ptr<NewChannelReq> command = Create<NewChannelReq>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            case (0x08): {
-                NS_LOG_DEBUG("Creating a RxTimingSetupReq command");
-                Ptr<RxTimingSetupReq> command = Create<RxTimingSetupReq>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            case (0x09): {
-                NS_LOG_DEBUG("Creating a TxParamSetupReq command");
-                Ptr<TxParamSetupReq> command = Create<TxParamSetupReq>();
-                byteNumber += command->Deserialize(start);
-                m_macCommands.emplace_back(command);
-                break;
-            }
-            default: {
-                NS_LOG_ERROR("CID not recognized during deserialization");
-            }
-            }
+            // The length of an unknown command is unknown too: skip the rest of FOpts
+            start.Next(m_fOptsLen - byteNumber);
+            break;
         }
+        byteNumber += size;
+        m_macCommands.Add(command);
     }
 
     m_fPort = uint8_t(start.ReadU8());
@@ -308,9 +172,9 @@ LoraFrameHeader::Print(std::ostream& os) const
     os << "FOptsLen=" << unsigned(m_fOptsLen) << std::endl;
     os << "FCnt=" << unsigned(m_fCnt) << std::endl;
 
-    for (auto it = m_macCommands.begin(); it != m_macCommands.end(); it++)
+    for (std::size_t i = 0; i < m_macCommands.GetN(); i++)
     {
-        (*it)->Print(os);
+        PrintMacCommand(m_macCommands.Get(i), os);
     }
 
     os << "FPort=" << unsigned(m_fPort) << std::endl;
@@ -411,10 +275,9 @@ LoraFrameHeader::GetFOptsLen() const
 {
     // Sum the serialized length of all commands in the list
     uint8_t fOptsLen = 0;
-    std::list<Ptr<MacCommand>>::const_iterator it;
-    for (it = m_macCommands.begin(); it != m_macCommands.end(); it++)
+    for (std::size_t i = 0; i < m_macCommands.GetN(); i++)
     {
-        fOptsLen = fOptsLen + (*it)->GetSerializedSize();
+        fOptsLen = fOptsLen + GetMacCommandSize(m_macCommands.Get(i));
     }
     return fOptsLen;
 }
@@ -436,11 +299,7 @@ LoraFrameHeader::AddLinkCheckReq()
 {
     NS_LOG_FUNCTION_NOARGS();
 
-    Ptr<LinkCheckReq> command = Create<LinkCheckReq>();
-    m_macCommands.emplace_back(command);
-
-    NS_LOG_DEBUG("Command SerializedSize: " << unsigned(command->GetSerializedSize()));
-    m_fOptsLen += command->GetSerializedSize();
+    AddCommand(LinkCheckReqValue());
 }
 
 void
@@ -448,10 +307,10 @@ LoraFrameHeader::AddLinkCheckAns(uint8_t margin, uint8_t gwCnt)
 {
     NS_LOG_FUNCTION(this << unsigned(margin) << unsigned(gwCnt));
 
-    Ptr<LinkCheckAns> command = Create<LinkCheckAns>(margin, gwCnt);
-    m_macCommands.emplace_back(command);
-
-    m_fOptsLen += command->GetSerializedSize();
+    LinkCheckAnsValue command;
+    command.margin = margin;
+    command.gwCnt = gwCnt;
+    AddCommand(command);
 }
 
 void
@@ -475,10 +334,12 @@ LoraFrameHeader::AddLinkAdrReq(uint8_t dataRate,
     NS_LOG_DEBUG("Creating LinkAdrReq with: DR = " << unsigned(dataRate)
                                                    << " and txPower = " << unsigned(txPower));
 
-    Ptr<LinkAdrReq> command = Create<LinkAdrReq>(dataRate, txPower, channelMask, 0, repetitions);
-    m_macCommands.emplace_back(command);
-
-    m_fOptsLen += command->GetSerializedSize();
+    LinkAdrReqValue command;
+    command.dataRate = dataRate;
+    command.txPower = txPower;
+    command.channelMask = channelMask;
+    command.nbRep = repetitions;
+    AddCommand(command);
 }
 
 void
@@ -486,10 +347,11 @@ LoraFrameHeader::AddLinkAdrAns(bool powerAck, bool dataRateAck, bool channelMask
 {
     NS_LOG_FUNCTION(this << powerAck << dataRateAck << channelMaskAck);
 
-    Ptr<LinkAdrAns> command = Create<LinkAdrAns>(powerAck, dataRateAck, channelMaskAck);
-    m_macCommands.emplace_back(command);
-
-    m_fOptsLen += command->GetSerializedSize();
+    LinkAdrAnsValue command;
+    command.powerAck = powerAck;
+    command.dataRateAck = dataRateAck;
+    command.channelMaskAck = channelMaskAck;
+    AddCommand(command);
 }
 
 void
@@ -497,11 +359,9 @@ LoraFrameHeader::AddDutyCycleReq(uint8_t dutyCycle)
 {
     NS_LOG_FUNCTION(this << unsigned(dutyCycle));
 
-    Ptr<DutyCycleReq> command = Create<DutyCycleReq>(dutyCycle);
-
-    m_macCommands.emplace_back(command);
-
-    m_fOptsLen += command->GetSerializedSize();
+    DutyCycleReqValue command;
+    command.maxDCycle = dutyCycle;
+    AddCommand(command);
 }
 
 void
@@ -509,11 +369,7 @@ LoraFrameHeader::AddDutyCycleAns()
 {
     NS_LOG_FUNCTION(this);
 
-    Ptr<DutyCycleAns> command = Create<DutyCycleAns>();
-
-    m_macCommands.emplace_back(command);
-
-    m_fOptsLen += command->GetSerializedSize();
+    AddCommand(DutyCycleAnsValue());
 }
 
 void
@@ -524,11 +380,11 @@ LoraFrameHeader::AddRxParamSetupReq(uint8_t rx1DrOffset, uint8_t rx2DataRate, do
     // Evaluate whether to eliminate this assert in case new offsets can be defined.
     NS_ASSERT(0 <= rx1DrOffset && rx1DrOffset <= 5);
 
-    Ptr<RxParamSetupReq> command = Create<RxParamSetupReq>(rx1DrOffset, rx2DataRate, frequency);
-
-    m_macCommands.emplace_back(command);
-
-    m_fOptsLen += command->GetSerializedSize();
+    RxParamSetupReqValue command;
+    command.rx1DrOffset = rx1DrOffset;
+    command.rx2DataRate = rx2DataRate;
+    command.frequency = frequency;
+    AddCommand(command);
 }
 
 void
@@ -536,11 +392,7 @@ LoraFrameHeader::AddRxParamSetupAns()
 {
     NS_LOG_FUNCTION(this);
 
-    Ptr<RxParamSetupAns> command = Create<RxParamSetupAns>();
-
-    m_macCommands.emplace_back(command);
-
-    m_fOptsLen += command->GetSerializedSize();
+    AddCommand(RxParamSetupAnsValue());
 }
 
 void
@@ -548,11 +400,7 @@ LoraFrameHeader::AddDevStatusReq()
 {
     NS_LOG_FUNCTION(this);
 
-    Ptr<DevStatusReq> command = Create<DevStatusReq>();
-
-    m_macCommands.emplace_back(command);
-
-    m_fOptsLen += command->GetSerializedSize();
+    AddCommand(DevStatusReqValue());
 }
 
 void
@@ -563,12 +411,12 @@ LoraFrameHeader::AddNewChannelReq(uint8_t chIndex,
 {
     NS_LOG_FUNCTION(this);
 
-    Ptr<NewChannelReq> command =
-        Create<NewChannelReq>(chIndex, frequency, minDataRate, maxDataRate);
-
-    m_macCommands.emplace_back(command);
-
-    m_fOptsLen += command->GetSerializedSize();
+    NewChannelReqValue command;
+    command.chIndex = chIndex;
+    command.frequency = frequency;
+    command.minDataRate = minDataRate;
+    command.maxDataRate = maxDataRate;
+    AddCommand(command);
 }
 
 std::list<Ptr<MacCommand>>
@@ -576,6 +424,17 @@ LoraFrameHeader::GetCommands()
 {
     NS_LOG_FUNCTION_NOARGS();
 
+    std::list<Ptr<MacCommand>> commands;
+    for (std::size_t i = 0; i < m_macCommands.GetN(); i++)
+    {
+        commands.push_back(ToMacCommand(m_macCommands.Get(i)));
+    }
+    return commands;
+}
+
+const MacCommandList&
+LoraFrameHeader::GetCommandValues() const
+{
     return m_macCommands;
 }
 
@@ -584,8 +443,16 @@ LoraFrameHeader::AddCommand(Ptr<MacCommand> macCommand)
 {
     NS_LOG_FUNCTION(this << macCommand);
 
-    m_macCommands.push_back(macCommand);
-    m_fOptsLen += macCommand->GetSerializedSize();
+    AddCommand(ToMacCommandValue(macCommand));
+}
+
+void
+LoraFrameHeader::AddCommand(const MacCommandValue& macCommand)
+{
+    NS_LOG_FUNCTION(this << unsigned(GetMacCommandType(macCommand)));
+
+    m_macCommands.Add(macCommand);
+    m_fOptsLen += GetMacCommandSize(macCommand);
 }
 
 } // namespace lorawan
@@ -10,6 +10,7 @@
 #define LORA_FRAME_HEADER_H
 
 #include "lora-device-address.h"
+#include "mac-command-value.h"
 #include "mac-command.h"
 
 #include "ns3/header.h"
@@ -32,6 +33,10 @@ namespace lorawan
  * header is for an uplink or downlink message. This is necessary due to the
  * fact that UL and DL messages have subtly different structure and, hence,
  * serialization and deserialization schemes.
+ *
+ * MAC commands are stored by value in a MacCommandList, so that deserializing
+ * a frame doesn't allocate an object per command. The methods taking and
+ * returning Ptr<MacCommand> convert commands to and from MacCommand objects.
  */
 class LoraFrameHeader : public Header
 {
@@ -207,11 +212,23 @@ class LoraFrameHeader : public Header
      * Return a pointer to the first MacCommand of type T, or 0 if no such MacCommand exists
      * in this header.
      *
+     * \remark The command is a new object: prefer FindMacCommand, which doesn't allocate.
+     *
      * \return A pointer to a MacCommand of type T.
      */
     template <typename T>
     inline Ptr<T> GetMacCommand();
 
+    /**
+     * Find the first MAC command of a given type in this header.
+     *
+     * \tparam T The struct of the command, e.g., LinkCheckReqValue.
+     * \return A pointer to the fields of the command, or nullptr if no such command exists in
+     * this header.
+     */
+    template <typename T>
+    const T* FindMacCommand() const;
+
     /**
      * Add a LinkCheckReq command.
      */
@@ -300,10 +317,19 @@ class LoraFrameHeader : public Header
     /**
      * Return a list of pointers to all the MAC commands saved in this header.
      *
+     * \remark The commands are new objects: prefer GetCommandValues, which doesn't allocate.
+     *
      * \return The list of pointers to MacCommand objects.
      */
     std::list<Ptr<MacCommand>> GetCommands();
 
+    /**
+     * Get all the MAC commands saved in this header.
+     *
+     * \return The list of MAC commands.
+     */
+    const MacCommandList& GetCommandValues() const;
+
     /**
      * Add a predefined command to the list in this frame header.
      *
@@ -311,6 +337,13 @@ class LoraFrameHeader : public Header
      */
     void AddCommand(Ptr<MacCommand> macCommand);
 
+    /**
+     * Add a command to the list in this frame header.
+     *
+     * \param macCommand The MAC command to add.
+     */
+    void AddCommand(const MacCommandValue& macCommand);
+
   private:
     uint8_t m_fPort; //!< The FPort field
 
@@ -324,9 +357,7 @@ class LoraFrameHeader : public Header
 
     uint16_t m_fCnt; //!< The FCnt field
 
-    Buffer m_fOpts;                           //!< The FOpts field
-    std::list<Ptr<MacCommand>> m_macCommands; //!< List containing all the MacCommand instances that
-                                              //!< are contained in this LoraFrameHeader
+    MacCommandList m_macCommands; //!< The MAC commands of the FOpts field
 
     bool m_isUplink; //!< Whether this frame header is uplink or not
 };
@@ -336,18 +367,24 @@ Ptr<T>
 LoraFrameHeader::GetMacCommand()
 {
     // Iterate on MAC commands and try casting
-    std::list<Ptr<MacCommand>>::const_iterator it;
-    for (it = m_macCommands.begin(); it != m_macCommands.end(); ++it)
+    for (const auto& command : GetCommands())
     {
-        if (DynamicCast<T>(*it))
+        if (DynamicCast<T>(command))
         {
-            return DynamicCast<T>(*it);
+            return DynamicCast<T>(command);
         }
     }
 
     // If no command was found, return 0
     return nullptr;
 }
+
+template <typename T>
+const T*
+LoraFrameHeader::FindMacCommand() const
+{
+    return m_macCommands.Find<T>();
+}
 } // namespace lorawan
 
 } // namespace ns3
@@ -8,9 +8,12 @@
 
 #include "lora-interference-helper.h"
 
+#include "ns3/abort.h"
 #include "ns3/enum.h"
 #include "ns3/log.h"
 
+#include <algorithm>
+#include <cmath>
 #include <limits>
 
 namespace ns3
@@ -34,8 +37,28 @@ LoraInterferenceHelper::Event::Event(Time duration,
       m_endTime(m_startTime + duration),
       m_sf(spreadingFactor),
       m_rxPowerdBm(rxPowerdBm),
+      m_rxPowerMw(pow(10, rxPowerdBm / 10)),
       m_packet(packet),
-      m_frequencyMHz(frequencyMHz)
+      m_frequencyMHz(frequencyMHz),
+      m_pool(nullptr)
+{
+    // NS_LOG_FUNCTION_NOARGS ();
+}
+
+LoraInterferenceHelper::Event::Event(Time startTime,
+                                     Time duration,
+                                     double rxPowerdBm,
+                                     uint8_t spreadingFactor,
+                                     Ptr<Packet> packet,
+                                     double frequencyMHz)
+    : m_startTime(startTime),
+      m_endTime(m_startTime + duration),
+      m_sf(spreadingFactor),
+      m_rxPowerdBm(rxPowerdBm),
+      m_rxPowerMw(pow(10, rxPowerdBm / 10)),
+      m_packet(packet),
+      m_frequencyMHz(frequencyMHz),
+      m_pool(nullptr)
 {
     // NS_LOG_FUNCTION_NOARGS ();
 }
@@ -46,6 +69,23 @@ LoraInterferenceHelper::Event::~Event()
     // NS_LOG_FUNCTION_NOARGS ();
 }
 
+void
+LoraInterferenceHelper::Event::Reset(Time startTime,
+                                     Time duration,
+                                     double rxPowerdBm,
+                                     uint8_t spreadingFactor,
+                                     Ptr<Packet> packet,
+                                     double frequencyMHz)
+{
+    m_startTime = startTime;
+    m_endTime = startTime + duration;
+    m_sf = spreadingFactor;
+    m_rxPowerdBm = rxPowerdBm;
+    m_rxPowerMw = pow(10, rxPowerdBm / 10);
+    m_packet = packet;
+    m_frequencyMHz = frequencyMHz;
+}
+
 // Getters
 Time
 LoraInterferenceHelper::Event::GetStartTime() const
@@ -71,6 +111,12 @@ LoraInterferenceHelper::Event::GetRxPowerdBm() const
     return m_rxPowerdBm;
 }
 
+double
+LoraInterferenceHelper::Event::GetRxPowerMw() const
+{
+    return m_rxPowerMw;
+}
+
 uint8_t
 LoraInterferenceHelper::Event::GetSpreadingFactor() const
 {
@@ -137,6 +183,9 @@ std::vector<std::vector<double>> LoraInterferenceHelper::collisionSnirGoursaud =
 LoraInterferenceHelper::CollisionMatrix LoraInterferenceHelper::collisionMatrix =
     LoraInterferenceHelper::GOURSAUD;
 
+LoraInterferenceHelper::EnergyAccounting LoraInterferenceHelper::energyAccounting =
+    LoraInterferenceHelper::RECOMPUTE;
+
 NS_OBJECT_ENSURE_REGISTERED(LoraInterferenceHelper);
 
 void
@@ -147,13 +196,46 @@ LoraInterferenceHelper::SetCollisionMatrix(
     {
     case LoraInterferenceHelper::ALOHA:
         NS_LOG_DEBUG("Setting the ALOHA collision matrix");
-        m_collisionSnir = LoraInterferenceHelper::collisionSnirAloha;
+        m_collisionThresholds = GetCollisionThresholds(LoraInterferenceHelper::collisionSnirAloha);
         break;
     case LoraInterferenceHelper::GOURSAUD:
         NS_LOG_DEBUG("Setting the GOURSAUD collision matrix");
-        m_collisionSnir = LoraInterferenceHelper::collisionSnirGoursaud;
+        m_collisionThresholds =
+            GetCollisionThresholds(LoraInterferenceHelper::collisionSnirGoursaud);
         break;
     }
+
+    // Use the ALOHA policy only if the matrix wasn't modified: packets survive
+    // any interference of other SFs and no interference of their own
+    m_alohaCollisions = true;
+    for (std::size_t i = 0; i < N_SF; i++)
+    {
+        for (std::size_t j = 0; j < N_SF; j++)
+        {
+            m_alohaCollisions &= m_collisionThresholds.snirDb[N_SF * i + j] ==
+                                 (i == j ? inf : -inf);
+        }
+    }
+}
+
+LoraInterferenceHelper::CollisionThresholds
+LoraInterferenceHelper::GetCollisionThresholds(
+    const std::vector<std::vector<double>>& collisionSnir)
+{
+    NS_ABORT_MSG_IF(collisionSnir.size() != N_SF, "The collision matrix must be 6x6");
+
+    CollisionThresholds thresholds;
+    for (std::size_t i = 0; i < N_SF; i++)
+    {
+        NS_ABORT_MSG_IF(collisionSnir[i].size() != N_SF, "The collision matrix must be 6x6");
+        for (std::size_t j = 0; j < N_SF; j++)
+        {
+            // SNIR [dB] = 10 log10 (signal energy / interference energy)
+            thresholds.snirDb[N_SF * i + j] = collisionSnir[i][j];
+            thresholds.ratio[N_SF * i + j] = pow(10, collisionSnir[i][j] / 10);
+        }
+    }
+    return thresholds;
 }
 
 TypeId
@@ -166,13 +248,38 @@ LoraInterferenceHelper::GetTypeId()
 }
 
 LoraInterferenceHelper::LoraInterferenceHelper()
-    : m_collisionSnir(LoraInterferenceHelper::collisionSnirGoursaud)
+    : m_collisionThresholds(GetCollisionThresholds(LoraInterferenceHelper::collisionSnirGoursaud)),
+      m_alohaCollisions(false),
+      m_maxDuration(Seconds(0)),
+      m_energyAccounting(energyAccounting),
+      m_allocatedEvents(0),
+      m_recycledEvents(0),
+      m_retentionHorizon(oldEventThreshold),
+      m_maxEvents(10000),
+      m_nEvents(0),
+      m_peakEvents(0),
+      m_evictedEvents(0)
 {
     NS_LOG_FUNCTION(this);
 
     SetCollisionMatrix(collisionMatrix);
 }
 
+void
+LoraInterferenceHelper::SetEnergyAccounting(EnergyAccounting energyAccounting)
+{
+    m_energyAccounting = energyAccounting;
+}
+
+void
+LoraInterferenceHelper::SetInterferenceSource(InterferenceSource source)
+{
+    NS_LOG_FUNCTION(this);
+
+    ClearAllEvents();
+    m_interferenceSource = source;
+}
+
 LoraInterferenceHelper::~LoraInterferenceHelper()
 {
     NS_LOG_FUNCTION(this);
@@ -187,24 +294,63 @@ LoraInterferenceHelper::Add(Time duration,
                             Ptr<Packet> packet,
                             double frequencyMHz)
 {
-    NS_LOG_FUNCTION(this << duration.GetSeconds() << rxPower << unsigned(spreadingFactor) << packet
-                         << frequencyMHz);
+    return Add(Simulator::Now(), duration, rxPower, spreadingFactor, packet, frequencyMHz);
+}
+
+Ptr<LoraInterferenceHelper::Event>
+LoraInterferenceHelper::Add(Time startTime,
+                            Time duration,
+                            double rxPower,
+                            uint8_t spreadingFactor,
+                            Ptr<Packet> packet,
+                            double frequencyMHz)
+{
+    NS_LOG_FUNCTION(this << startTime.GetSeconds() << duration.GetSeconds() << rxPower
+                         << unsigned(spreadingFactor) << packet << frequencyMHz);
+
+    // Drop the events that expired first, so that they can be reused for this
+    // signal. Events are kept at least as long as this one, which may overlap
+    // them.
+    m_maxDuration = Max(m_maxDuration, duration);
+    CleanOldEvents();
 
     // Create an event based on the parameters
     Ptr<LoraInterferenceHelper::Event> event =
-        Create<LoraInterferenceHelper::Event>(duration,
-                                              rxPower,
-                                              spreadingFactor,
-                                              packet,
-                                              frequencyMHz);
+        AllocateEvent(startTime, duration, rxPower, spreadingFactor, packet, frequencyMHz);
 
-    // Add the event to the list
-    m_events.push_back(event);
+    // Interferers are provided by the source: only the receiver holds the event
+    if (!m_interferenceSource.IsNull())
+    {
+        return event;
+    }
 
-    // Clean the event list
-    if (m_events.size() > 100)
+    // Add the event to the events of its frequency, after those ending at the
+    // same time
+    EventBucket& bucket = m_events[frequencyMHz];
+    auto position = FindFirstEndingAfter(bucket, event->GetEndTime());
+    bucket.insert(position, event);
+    m_nEvents++;
+
+    // Credit the energy of the new event to the packets being received on
+    // this frequency
+    auto locked = m_lockedEvents.find(frequencyMHz);
+    if (locked != m_lockedEvents.end())
     {
-        CleanOldEvents();
+        for (auto& lockedEvent : locked->second)
+        {
+            AddInterferenceEnergy(lockedEvent.event, event, lockedEvent.energy);
+        }
+    }
+
+    EnforceMaxEvents();
+
+    if (m_nEvents > m_peakEvents)
+    {
+        m_peakEvents = m_nEvents;
+        if (!m_peakEventsCallback.IsNull())
+        {
+            m_peakEventsCallback(m_peakEvents);
+        }
     }
 
     return event;
@@ -215,24 +361,288 @@ LoraInterferenceHelper::CleanOldEvents()
 {
     NS_LOG_FUNCTION(this);
 
-    // Cycle the events, and clean up if an event is old.
-    for (auto it = m_events.begin(); it != m_events.end();)
+    for (auto& bucket : m_events)
     {
-        if ((*it)->GetEndTime() + oldEventThreshold < Simulator::Now())
-        {
-            it = m_events.erase(it);
-        }
-        else
+        CleanOldEvents(bucket.first, bucket.second);
+    }
+}
+
+void
+LoraInterferenceHelper::CleanOldEvents(double frequencyMHz, EventBucket& bucket)
+{
+    // Events that ended before any packet still on air started can't
+    // interfere anymore: since events are sorted by end time, they are at the
+    // front
+    Time threshold = Max(m_retentionHorizon, m_maxDuration);
+
+    // Forget the packets receivers locked on but never checked first, so that
+    // their events can go back to the pool
+    auto locked = m_lockedEvents.find(frequencyMHz);
+    if (locked != m_lockedEvents.end())
+    {
+        auto& lockedEvents = locked->second;
+        lockedEvents.erase(std::remove_if(lockedEvents.begin(),
+                                          lockedEvents.end(),
+                                          [threshold](const LockedEvent& lockedEvent) {
+                                              return lockedEvent.event->GetEndTime() + threshold <
+                                                     Simulator::Now();
+                                          }),
+                           lockedEvents.end());
+    }
+
+    while (!bucket.empty() && bucket.front()->GetEndTime() + threshold < Simulator::Now())
+    {
+        RetireEvent(bucket.front());
+        bucket.pop_front();
+        m_nEvents--;
+    }
+}
+
+void
+LoraInterferenceHelper::EnforceMaxEvents()
+{
+    while (m_nEvents > m_maxEvents)
+    {
+        // Evict the event that ended first, among all frequencies
+        EventBucket* oldest = nullptr;
+        for (auto& bucket : m_events)
         {
-            it++;
+            if (!bucket.second.empty() &&
+                (!oldest || bucket.second.front()->GetEndTime() < oldest->front()->GetEndTime()))
+            {
+                oldest = &bucket.second;
+            }
         }
+        NS_ASSERT(oldest);
+
+        NS_LOG_DEBUG("Evicting " << *oldest->front() << " to keep at most " << m_maxEvents
+                                 << " events");
+        RetireEvent(oldest->front());
+        oldest->pop_front();
+        m_nEvents--;
+        m_evictedEvents++;
+    }
+}
+
+void
+LoraInterferenceHelper::SetRetentionHorizon(Time retentionHorizon)
+{
+    NS_LOG_FUNCTION(this << retentionHorizon);
+
+    m_retentionHorizon = retentionHorizon;
+}
+
+Time
+LoraInterferenceHelper::GetRetentionHorizon() const
+{
+    return m_retentionHorizon;
+}
+
+void
+LoraInterferenceHelper::SetMaxEvents(uint32_t maxEvents)
+{
+    NS_LOG_FUNCTION(this << maxEvents);
+    NS_ABORT_MSG_IF(maxEvents == 0, "LoraInterferenceHelper needs to keep at least one event");
+
+    m_maxEvents = maxEvents;
+    EnforceMaxEvents();
+    if (m_freeEvents.size() > m_maxEvents)
+    {
+        m_freeEvents.resize(m_maxEvents);
+    }
+}
+
+uint32_t
+LoraInterferenceHelper::GetMaxEvents() const
+{
+    return m_maxEvents;
+}
+
+uint64_t
+LoraInterferenceHelper::GetNEvictedEvents() const
+{
+    return m_evictedEvents;
+}
+
+uint32_t
+LoraInterferenceHelper::GetPeakEvents() const
+{
+    return m_peakEvents;
+}
+
+void
+LoraInterferenceHelper::SetPeakEventsCallback(Callback<void, uint32_t> callback)
+{
+    m_peakEventsCallback = callback;
+}
+
+LoraInterferenceHelper::EventBucket::const_iterator
+LoraInterferenceHelper::FindFirstEndingAfter(const EventBucket& bucket, Time time)
+{
+    return std::upper_bound(bucket.begin(),
+                            bucket.end(),
+                            time,
+                            [](Time t, const Ptr<LoraInterferenceHelper::Event>& event) {
+                                return t < event->GetEndTime();
+                            });
+}
+
+Ptr<LoraInterferenceHelper::Event>
+LoraInterferenceHelper::AllocateEvent(Time startTime,
+                                      Time duration,
+                                      double rxPowerdBm,
+                                      uint8_t spreadingFactor,
+                                      Ptr<Packet> packet,
+                                      double frequencyMHz)
+{
+    if (m_freeEvents.empty())
+    {
+        m_allocatedEvents++;
+        Ptr<LoraInterferenceHelper::Event> event =
+            Create<LoraInterferenceHelper::Event>(startTime,
+                                                  duration,
+                                                  rxPowerdBm,
+                                                  spreadingFactor,
+                                                  packet,
+                                                  frequencyMHz);
+        event->m_pool = this;
+        return event;
+    }
+
+    m_recycledEvents++;
+    Ptr<LoraInterferenceHelper::Event> event = m_freeEvents.back();
+    m_freeEvents.pop_back();
+    event->Reset(startTime, duration, rxPowerdBm, spreadingFactor, packet, frequencyMHz);
+    return event;
+}
+
+void
+LoraInterferenceHelper::RetireEvent(Ptr<LoraInterferenceHelper::Event> event)
+{
+    // Besides the argument, only the bucket may hold the event for it to be
+    // reusable
+    if (event->m_pool == this && event->GetReferenceCount() <= 2 &&
+        m_freeEvents.size() < m_maxEvents)
+    {
+        event->m_packet = nullptr;
+        m_freeEvents.push_back(event);
+    }
+}
+
+uint64_t
+LoraInterferenceHelper::GetNAllocatedEvents() const
+{
+    return m_allocatedEvents;
+}
+
+uint64_t
+LoraInterferenceHelper::GetNRecycledEvents() const
+{
+    return m_recycledEvents;
+}
+
+double
+LoraInterferenceHelper::GetMaxIsolationDb()
+{
+    const auto& collisionSnir = collisionMatrix == LoraInterferenceHelper::ALOHA
+                                    ? collisionSnirAloha
+                                    : collisionSnirGoursaud;
+
+    double isolationDb = -std::numeric_limits<double>::infinity();
+    for (const auto& row : collisionSnir)
+    {
+        isolationDb = std::max(isolationDb, *std::max_element(row.begin(), row.end()));
+    }
+
+    // The ALOHA matrix uses the largest double to stand for infinity
+    if (isolationDb >= std::numeric_limits<double>::max())
+    {
+        return std::numeric_limits<double>::infinity();
+    }
+    return isolationDb;
+}
+
+void
+LoraInterferenceHelper::LockOnEvent(Ptr<LoraInterferenceHelper::Event> event)
+{
+    NS_LOG_FUNCTION(this << event);
+
+    if (m_energyAccounting != INCREMENTAL || !m_interferenceSource.IsNull())
+    {
+        return;
+    }
+
+    // Start from the energy of the events already registered: the following
+    // ones are credited as they are added
+    LockedEvent lockedEvent;
+    lockedEvent.event = event;
+    lockedEvent.energy.assign(6, 0);
+    const EventBucket& bucket = m_events[event->GetFrequency()];
+    for (auto it = FindFirstEndingAfter(bucket, event->GetStartTime()); it != bucket.end(); it++)
+    {
+        AddInterferenceEnergy(event, *it, lockedEvent.energy);
+    }
+
+    m_lockedEvents[event->GetFrequency()].push_back(lockedEvent);
+}
+
+void
+LoraInterferenceHelper::AddInterferenceEnergy(Ptr<LoraInterferenceHelper::Event> event,
+                                              Ptr<LoraInterferenceHelper::Event> interferer,
+                                              std::vector<double>& cumulativeInterferenceEnergy)
+{
+    // Skip the current event if it's the same that we want to analyze, and
+    // events that don't overlap with it
+    if (interferer == event || interferer->GetStartTime() >= event->GetEndTime() ||
+        interferer->GetEndTime() <= event->GetStartTime())
+    {
+        NS_LOG_DEBUG("Same event or non-overlapping event");
+        return;
     }
+
+    NS_LOG_DEBUG("Interferer on same channel");
+
+    // Gather information about this interferer
+    uint8_t interfererSf = interferer->GetSpreadingFactor();
+    double interfererPower = interferer->GetRxPowerdBm();
+    Time interfererStartTime = interferer->GetStartTime();
+    Time interfererEndTime = interferer->GetEndTime();
+
+    NS_LOG_INFO("Found an interferer: sf = " << unsigned(interfererSf)
+                                             << ", power = " << interfererPower
+                                             << ", start time = " << interfererStartTime
+                                             << ", end time = " << interfererEndTime);
+
+    // Compute the fraction of time the two events are overlapping
+    Time overlap = GetOverlapTime(event, interferer);
+
+    NS_LOG_DEBUG("The two events overlap for " << overlap.GetSeconds() << " s.");
+
+    // Compute the equivalent energy of the interference
+    // Power [mW] = 10^(Power[dBm]/10)
+    // Power [W] = Power [mW] / 1000
+    double interfererPowerW = interferer->GetRxPowerMw() / 1000;
+    // Energy [J] = Time [s] * Power [W]
+    double interferenceEnergy = overlap.GetSeconds() * interfererPowerW;
+    cumulativeInterferenceEnergy.at(unsigned(interfererSf) - 7) += interferenceEnergy;
+    NS_LOG_DEBUG("Interferer power in W: " << interfererPowerW);
+    NS_LOG_DEBUG("Interference energy: " << interferenceEnergy);
 }
 
 std::list<Ptr<LoraInterferenceHelper::Event>>
 LoraInterferenceHelper::GetInterferers()
 {
-    return m_events;
+    CleanOldEvents();
+
+    std::list<Ptr<LoraInterferenceHelper::Event>> interferers;
+    for (const auto& bucket : m_events)
+    {
+        for (const auto& entry : bucket.second)
+        {
+            interferers.push_back(entry);
+        }
+    }
+    return interferers;
 }
 
 void
@@ -242,10 +652,13 @@ LoraInterferenceHelper::PrintEvents(std::ostream& stream)
 
     stream << "Currently registered events:" << std::endl;
 
-    for (auto it = m_events.begin(); it != m_events.end(); it++)
+    for (const auto& bucket : m_events)
     {
-        (*it)->Print(stream);
-        stream << std::endl;
+        for (const auto& entry : bucket.second)
+        {
+            entry->Print(stream);
+            stream << std::endl;
+        }
     }
 }
 
@@ -254,119 +667,368 @@ LoraInterferenceHelper::IsDestroyedByInterference(Ptr<LoraInterferenceHelper::Ev
 {
     NS_LOG_FUNCTION(this << event);
 
-    NS_LOG_INFO("Current number of events in LoraInterferenceHelper: " << m_events.size());
+    // Interferers are only known to the source: compute their energy now
+    if (!m_interferenceSource.IsNull())
+    {
+        std::vector<double> cumulativeInterferenceEnergy(6, 0);
+        m_interferenceSource(event, m_sourceInterferers);
+        for (const auto& interferer : m_sourceInterferers)
+        {
+            AddInterferenceEnergy(event, interferer, cumulativeInterferenceEnergy);
+        }
+
+        // The source built these events: they don't belong to the pool
+        m_sourceInterferers.clear();
+        return GetDestroyingSf(event, cumulativeInterferenceEnergy);
+    }
+
+    // If a receiver locked on this event, the interference energy was
+    // accumulated while it was on air
+    double frequency = event->GetFrequency();
+    auto locked = m_lockedEvents.find(frequency);
+    if (locked != m_lockedEvents.end())
+    {
+        auto& lockedEvents = locked->second;
+        for (auto it = lockedEvents.begin(); it != lockedEvents.end(); it++)
+        {
+            if (it->event == event)
+            {
+                NS_LOG_INFO("Using the interference energy accumulated during reception");
+                std::vector<double> cumulativeInterferenceEnergy = std::move(it->energy);
+                lockedEvents.erase(it);
+                return GetDestroyingSf(event, cumulativeInterferenceEnergy);
+            }
+        }
+    }
 
     // We want to see the interference affecting this event: cycle through events
     // that overlap with this one and see whether it survives the interference or
     // not.
 
-    // Gather information about the event
-    double rxPowerDbm = event->GetRxPowerdBm();
-    uint8_t sf = event->GetSpreadingFactor();
-    double frequency = event->GetFrequency();
-
     // Handy information about the time frame when the packet was received
-    Time now = Simulator::Now();
-    Time duration = event->GetDuration();
-    Time packetStartTime = now - duration;
-
-    // Get the list of interfering events
-    std::list<Ptr<LoraInterferenceHelper::Event>>::iterator it;
+    Time packetStartTime = event->GetStartTime();
 
     // Energy for interferers of various SFs
     std::vector<double> cumulativeInterferenceEnergy(6, 0);
 
-    // Cycle over the events
-    for (it = m_events.begin(); it != m_events.end();)
+    // Only consider events on the same channel: we assume there's no
+    // interchannel interference
+    const EventBucket& bucket = m_events[frequency];
+
+    NS_LOG_INFO("Current number of events on this channel: " << bucket.size());
+
+    // Cycle over the events that end after the packet started
+    for (auto it = FindFirstEndingAfter(bucket, packetStartTime); it != bucket.end(); it++)
+    {
+        AddInterferenceEnergy(event, *it, cumulativeInterferenceEnergy);
+    }
+
+    return GetDestroyingSf(event, cumulativeInterferenceEnergy);
+}
+
+uint8_t
+LoraInterferenceHelper::IsAlreadyDestroyed(Ptr<LoraInterferenceHelper::Event> event)
+{
+    NS_LOG_FUNCTION(this << event);
+
+    // Use the energy accumulated so far if a receiver locked on the event
+    auto locked = m_lockedEvents.find(event->GetFrequency());
+    if (locked != m_lockedEvents.end())
+    {
+        for (const auto& lockedEvent : locked->second)
+        {
+            if (lockedEvent.event == event)
+            {
+                return GetDestroyingSf(event, lockedEvent.energy);
+            }
+        }
+    }
+
+    // The interference source also knows about signals that are still
+    // propagating towards the receiver: only count those that reached it, like
+    // the events registered in the buckets
+    std::vector<Ptr<LoraInterferenceHelper::Event>> overlapping;
+    GetOverlappingEvents(event, overlapping);
+
+    Time now = Simulator::Now();
+    std::vector<double> cumulativeInterferenceEnergy(6, 0);
+    for (const auto& interferer : overlapping)
+    {
+        if (interferer->GetStartTime() <= now)
+        {
+            AddInterferenceEnergy(event, interferer, cumulativeInterferenceEnergy);
+        }
+    }
+    return GetDestroyingSf(event, cumulativeInterferenceEnergy);
+}
+
+uint8_t
+LoraInterferenceHelper::IsDestroyedAfterCancellation(Ptr<LoraInterferenceHelper::Event> event,
+                                                     uint32_t maxCancellations,
+                                                     const double sensitivity[6],
+                                                     uint32_t& nCancelled)
+{
+    NS_LOG_FUNCTION(this << event << maxCancellations);
+
+    nCancelled = 0;
+    std::vector<Ptr<LoraInterferenceHelper::Event>> interferers;
+    GetOverlappingEvents(event, interferers);
+
+    // Try the strongest signals first
+    std::stable_sort(interferers.begin(),
+                     interferers.end(),
+                     [](const Ptr<LoraInterferenceHelper::Event>& first,
+                        const Ptr<LoraInterferenceHelper::Event>& second) {
+                         return first->GetRxPowerdBm() > second->GetRxPowerdBm();
+                     });
+
+    std::vector<Ptr<LoraInterferenceHelper::Event>> cancelled;
+    while (true)
     {
-        // Pointer to the current interferer
-        Ptr<LoraInterferenceHelper::Event> interferer = *it;
+        // Sum the energy of the signals that weren't cancelled, rather than
+        // subtracting from the total, so that no rounding residue is left
+        std::vector<double> cumulativeInterferenceEnergy(6, 0);
+        for (const auto& interferer : interferers)
+        {
+            if (interferer)
+            {
+                AddInterferenceEnergy(event, interferer, cumulativeInterferenceEnergy);
+            }
+        }
+        uint8_t destroyingSf = GetDestroyingSf(event, cumulativeInterferenceEnergy);
+        if (!destroyingSf || nCancelled == maxCancellations)
+        {
+            return destroyingSf;
+        }
 
-        // Only consider the current event if the channel is the same: we
-        // assume there's no interchannel interference. Also skip the current
-        // event if it's the same that we want to analyze.
-        if (!(interferer->GetFrequency() == frequency) || interferer == event)
+        // Decode and cancel the strongest decodable signal. Signals below the
+        // sensitivity only add to the interference: they can't be decoded.
+        auto decoded = std::find_if(
+            interferers.begin(),
+            interferers.end(),
+            [&](const Ptr<LoraInterferenceHelper::Event>& interferer) {
+                return interferer &&
+                       interferer->GetRxPowerdBm() >=
+                           sensitivity[unsigned(interferer->GetSpreadingFactor()) - 7] &&
+                       IsDecodable(interferer, cancelled);
+            });
+        if (decoded == interferers.end())
         {
-            NS_LOG_DEBUG("Different channel or same event");
-            it++;
-            continue; // Continues from the first line inside the for cycle
+            NS_LOG_DEBUG("No overlapping signal can be cancelled");
+            return destroyingSf;
         }
 
-        NS_LOG_DEBUG("Interferer on same channel");
+        NS_LOG_DEBUG("Cancelling " << **decoded);
+        cancelled.push_back(*decoded);
+        *decoded = nullptr;
+        nCancelled++;
+    }
+}
+
+Time
+LoraInterferenceHelper::GetOverlapEnd(Ptr<LoraInterferenceHelper::Event> event)
+{
+    std::vector<Ptr<LoraInterferenceHelper::Event>> overlapping;
+    GetOverlappingEvents(event, overlapping);
 
-        // Gather information about this interferer
-        uint8_t interfererSf = interferer->GetSpreadingFactor();
-        double interfererPower = interferer->GetRxPowerdBm();
-        Time interfererStartTime = interferer->GetStartTime();
-        Time interfererEndTime = interferer->GetEndTime();
+    Time overlapEnd = event->GetEndTime();
+    for (const auto& interferer : overlapping)
+    {
+        overlapEnd = Max(overlapEnd, interferer->GetEndTime());
+    }
+    return overlapEnd;
+}
+
+void
+LoraInterferenceHelper::GetOverlappingEvents(
+    Ptr<LoraInterferenceHelper::Event> event,
+    std::vector<Ptr<LoraInterferenceHelper::Event>>& overlapping)
+{
+    if (!m_interferenceSource.IsNull())
+    {
+        m_interferenceSource(event, overlapping);
+        return;
+    }
 
-        NS_LOG_INFO("Found an interferer: sf = " << unsigned(interfererSf)
-                                                 << ", power = " << interfererPower
-                                                 << ", start time = " << interfererStartTime
-                                                 << ", end time = " << interfererEndTime);
+    auto bucket = m_events.find(event->GetFrequency());
+    if (bucket == m_events.end())
+    {
+        return;
+    }
+    for (auto it = FindFirstEndingAfter(bucket->second, event->GetStartTime());
+         it != bucket->second.end();
+         it++)
+    {
+        if (*it != event && (*it)->GetStartTime() < event->GetEndTime())
+        {
+            overlapping.push_back(*it);
+        }
+    }
+}
 
-        // Compute the fraction of time the two events are overlapping
-        Time overlap = GetOverlapTime(event, interferer);
+bool
+LoraInterferenceHelper::IsDecodable(
+    Ptr<LoraInterferenceHelper::Event> event,
+    const std::vector<Ptr<LoraInterferenceHelper::Event>>& cancelled)
+{
+    auto sameSignal = [](const Ptr<LoraInterferenceHelper::Event>& first,
+                         const Ptr<LoraInterferenceHelper::Event>& second) {
+        return first == second ||
+               (first->GetPacket() && first->GetPacket() == second->GetPacket() &&
+                first->GetStartTime() == second->GetStartTime());
+    };
 
-        NS_LOG_DEBUG("The two events overlap for " << overlap.GetSeconds() << " s.");
+    std::vector<Ptr<LoraInterferenceHelper::Event>> overlapping;
+    GetOverlappingEvents(event, overlapping);
 
-        // Compute the equivalent energy of the interference
-        // Power [mW] = 10^(Power[dBm]/10)
-        // Power [W] = Power [mW] / 1000
-        double interfererPowerW = pow(10, interfererPower / 10) / 1000;
-        // Energy [J] = Time [s] * Power [W]
-        double interferenceEnergy = overlap.GetSeconds() * interfererPowerW;
-        cumulativeInterferenceEnergy.at(unsigned(interfererSf) - 7) += interferenceEnergy;
-        NS_LOG_DEBUG("Interferer power in W: " << interfererPowerW);
-        NS_LOG_DEBUG("Interference energy: " << interferenceEnergy);
-        it++;
+    std::vector<double> cumulativeInterferenceEnergy(6, 0);
+    for (const auto& interferer : overlapping)
+    {
+        bool isCancelled = std::any_of(cancelled.begin(),
+                                       cancelled.end(),
+                                       [&](const Ptr<LoraInterferenceHelper::Event>& c) {
+                                           return sameSignal(c, interferer);
+                                       });
+        if (!isCancelled)
+        {
+            AddInterferenceEnergy(event, interferer, cumulativeInterferenceEnergy);
+        }
     }
+    return GetDestroyingSf(event, cumulativeInterferenceEnergy) == 0;
+}
+
+uint8_t
+LoraInterferenceHelper::GetDestroyingSf(
+    Ptr<LoraInterferenceHelper::Event> event,
+    const std::vector<double>& cumulativeInterferenceEnergy) const
+{
+    if (m_alohaCollisions)
+    {
+        return EvaluateCollisions<AlohaCollisionPolicy>(event, cumulativeInterferenceEnergy);
+    }
+    return EvaluateCollisions<ThresholdCollisionPolicy>(event, cumulativeInterferenceEnergy);
+}
+
+template <class CollisionPolicy>
+uint8_t
+LoraInterferenceHelper::EvaluateCollisions(
+    Ptr<LoraInterferenceHelper::Event> event,
+    const std::vector<double>& cumulativeInterferenceEnergy) const
+{
+    // Compute the energy of the packet
+    // Energy [J] = Time [s] * Power [W]
+    double signalPowerW = event->GetRxPowerMw() / 1000;
+    double signalEnergy = event->GetDuration().GetSeconds() * signalPowerW;
+    NS_LOG_DEBUG("Signal power in W: " << signalPowerW);
+    NS_LOG_DEBUG("Signal energy: " << signalEnergy);
+
+    uint8_t destroyingSf = CollisionPolicy::GetDestroyingSf(m_collisionThresholds,
+                                                            event->GetSpreadingFactor(),
+                                                            signalEnergy,
+                                                            cumulativeInterferenceEnergy);
+    if (destroyingSf)
+    {
+        NS_LOG_DEBUG("Packet destroyed by interference with SF" << unsigned(destroyingSf));
+    }
+    else
+    {
+        // If we get to here, it means that the packet survived all interference
+        NS_LOG_DEBUG("Packet survived all interference");
+    }
+    return destroyingSf;
+}
+
+uint8_t
+LoraInterferenceHelper::ThresholdCollisionPolicy::GetDestroyingSf(
+    const CollisionThresholds& thresholds,
+    uint8_t sf,
+    double signalEnergy,
+    const std::vector<double>& cumulativeInterferenceEnergy)
+{
+    std::size_t row = N_SF * (unsigned(sf) - 7);
+    bool comparableSignal = signalEnergy > 0 && std::isfinite(signalEnergy);
 
     // For each spreading factor, check if there was destructive interference
-    for (auto currentSf = uint8_t(7); currentSf <= uint8_t(12); currentSf++)
-    {
-        NS_LOG_DEBUG("Cumulative Interference Energy: "
-                     << cumulativeInterferenceEnergy.at(unsigned(currentSf) - 7));
-
-        // Use the computed cumulativeInterferenceEnergy to determine whether the
-        // interference with this spreading factor destroys the packet
-        double signalPowerW = pow(10, rxPowerDbm / 10) / 1000;
-        double signalEnergy = duration.GetSeconds() * signalPowerW;
-        NS_LOG_DEBUG("Signal power in W: " << signalPowerW);
-        NS_LOG_DEBUG("Signal energy: " << signalEnergy);
-
-        // Check whether the packet survives the interference of this spreading factor
-        double snirIsolation = m_collisionSnir[unsigned(sf) - 7][unsigned(currentSf) - 7];
-        NS_LOG_DEBUG("The needed isolation to survive is " << snirIsolation << " dB");
-        double snir =
-            10 * log10(signalEnergy / cumulativeInterferenceEnergy.at(unsigned(currentSf) - 7));
-        NS_LOG_DEBUG("The current SNIR is " << snir << " dB");
-
-        if (snir >= snirIsolation)
+    for (std::size_t i = 0; i < N_SF; i++)
+    {
+        double interferenceEnergy = cumulativeInterferenceEnergy[i];
+        NS_LOG_DEBUG("Cumulative Interference Energy: " << interferenceEnergy);
+
+        // Compare the ratio of signal and interference energy with the
+        // threshold, unless they are too close to be sure to get the same
+        // result as with the SNIR in dB
+        if (comparableSignal && interferenceEnergy > 0)
         {
-            // Move on and check the rest of the interferers
-            NS_LOG_DEBUG("Packet survived interference with SF " << currentSf);
+            double ratio = signalEnergy / interferenceEnergy;
+            double minRatio = thresholds.ratio[row + i];
+            if (ratio > minRatio * (1 + RATIO_TOLERANCE))
+            {
+                continue;
+            }
+            if (ratio < minRatio * (1 - RATIO_TOLERANCE))
+            {
+                return uint8_t(7 + i);
+            }
         }
-        else
-        {
-            NS_LOG_DEBUG("Packet destroyed by interference with SF" << unsigned(currentSf));
 
-            return currentSf;
+        double snir = 10 * log10(signalEnergy / interferenceEnergy);
+        NS_LOG_DEBUG("The current SNIR is " << snir << " dB, the needed isolation to survive is "
+                                            << thresholds.snirDb[row + i] << " dB");
+        if (!(snir >= thresholds.snirDb[row + i]))
+        {
+            return uint8_t(7 + i);
         }
     }
-    // If we get to here, it means that the packet survived all interference
-    NS_LOG_DEBUG("Packet survived all interference");
 
     // Since the packet was not destroyed, we return 0.
     return uint8_t(0);
 }
 
+uint8_t
+LoraInterferenceHelper::AlohaCollisionPolicy::GetDestroyingSf(
+    const CollisionThresholds& thresholds,
+    uint8_t sf,
+    double signalEnergy,
+    const std::vector<double>& cumulativeInterferenceEnergy)
+{
+    // Packets without energy fail any SNIR check
+    if (!(signalEnergy > 0 && std::isfinite(signalEnergy)))
+    {
+        return ThresholdCollisionPolicy::GetDestroyingSf(thresholds,
+                                                         sf,
+                                                         signalEnergy,
+                                                         cumulativeInterferenceEnergy);
+    }
+
+    // Otherwise, only overlapping packets of the same SF destroy the packet
+    for (std::size_t i = 0; i < N_SF; i++)
+    {
+        double interferenceEnergy = cumulativeInterferenceEnergy[i];
+        bool sameSf = i == unsigned(sf) - 7;
+        if (interferenceEnergy > 0 && (sameSf || !(signalEnergy / interferenceEnergy > 0)))
+        {
+            return uint8_t(7 + i);
+        }
+    }
+    return uint8_t(0);
+}
+
 void
 LoraInterferenceHelper::ClearAllEvents()
 {
     NS_LOG_FUNCTION_NOARGS();
 
+    m_lockedEvents.clear();
+    for (const auto& bucket : m_events)
+    {
+        for (const auto& entry : bucket.second)
+        {
+            RetireEvent(entry);
+        }
+    }
     m_events.clear();
+    m_nEvents = 0;
+    m_maxDuration = Seconds(0);
 }
 
 Time
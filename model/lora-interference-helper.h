@@ -18,7 +18,11 @@
 #include "ns3/simulator.h"
 #include "ns3/traced-callback.h"
 
+#include <array>
+#include <deque>
 #include <list>
+#include <map>
+#include <vector>
 
 namespace ns3
 {
@@ -33,6 +37,25 @@ namespace lorawan
  * This class keeps a list of signals that are impinging on the antenna of the
  * device, in order to compute which ones can be correctly received and which
  * ones are lost due to interference.
+ *
+ * Signals are grouped by frequency and sorted by end time, so that checking a
+ * packet against interference only visits the signals on its frequency that
+ * end after it started, and signals that can't overlap any packet anymore are
+ * dropped from the front of each group.
+ *
+ * Old signals are dropped once the retention horizon after their end has
+ * passed, when new signals are added or the interferers are listed. No event
+ * is scheduled for this, so that idle receivers cost nothing to the
+ * simulator: a receiver that stops hearing signals keeps the last ones until
+ * it hears a new signal, which the cap on the number of signals a helper
+ * keeps bounds. When the cap is reached, the signals that ended first are
+ * evicted.
+ *
+ * Events are kept in a pool owned by the helper: when an event the helper
+ * allocated is dropped and nobody else holds a pointer to it, it is reused for
+ * a later signal instead of being freed, so that a helper allocates about as
+ * many events as the largest number of signals it tracked at the same time.
+ * The pool holds at most as many events as the cap on the number of signals.
  */
 class LoraInterferenceHelper
 {
@@ -61,6 +84,24 @@ class LoraInterferenceHelper
               Ptr<Packet> packet,
               double frequencyMHz);
 
+        /**
+         * Construct a new interference signal Event object that started at a
+         * given time.
+         *
+         * \param startTime The time the signal started impinging on the antenna.
+         * \param duration The duration in time.
+         * \param rxPowerdBm The power of the signal.
+         * \param spreadingFactor The modulation spreading factor.
+         * \param packet The packet transmitted.
+         * \param frequencyMHz The carrier frequency of the signal.
+         */
+        Event(Time startTime,
+              Time duration,
+              double rxPowerdBm,
+              uint8_t spreadingFactor,
+              Ptr<Packet> packet,
+              double frequencyMHz);
+
         ~Event(); //!< Destructor
 
         /**
@@ -91,6 +132,13 @@ class LoraInterferenceHelper
          */
         double GetRxPowerdBm() const;
 
+        /**
+         * Get the power of the event in the linear domain.
+         *
+         * \return The power in mW, computed when the event was created.
+         */
+        double GetRxPowerMw() const;
+
         /**
          * Get the spreading factor used by this signal.
          *
@@ -120,12 +168,33 @@ class LoraInterferenceHelper
         void Print(std::ostream& stream) const;
 
       private:
+        friend class LoraInterferenceHelper;
+
+        /**
+         * Reuse this event for a new signal.
+         *
+         * \param startTime The time the signal started impinging on the antenna.
+         * \param duration The duration in time.
+         * \param rxPowerdBm The power of the signal.
+         * \param spreadingFactor The modulation spreading factor.
+         * \param packet The packet transmitted.
+         * \param frequencyMHz The carrier frequency of the signal.
+         */
+        void Reset(Time startTime,
+                   Time duration,
+                   double rxPowerdBm,
+                   uint8_t spreadingFactor,
+                   Ptr<Packet> packet,
+                   double frequencyMHz);
+
         Time m_startTime;      //!< The time this signal begins (at the device).
         Time m_endTime;        //!< The time this signal ends (at the device).
         uint8_t m_sf;          //!< The spreading factor of this signal.
         double m_rxPowerdBm;   //!< The power of this event in dBm (at the device).
+        double m_rxPowerMw;    //!< The power of this event in mW (at the device).
         Ptr<Packet> m_packet;  //!< The packet this event was generated for.
         double m_frequencyMHz; //!<  The frequency this event was on.
+        const LoraInterferenceHelper* m_pool; //!< The helper whose pool the event belongs to
     };
 
     /**
@@ -137,6 +206,16 @@ class LoraInterferenceHelper
         ALOHA,
     };
 
+    /**
+     * Enumeration of the ways the interference energy affecting a packet is
+     * computed.
+     */
+    enum EnergyAccounting
+    {
+        RECOMPUTE,   //!< Sum the energy of all overlapping events at the end of reception
+        INCREMENTAL, //!< Accumulate energy as events are added during reception
+    };
+
     /**
      *  Register this type.
      *  \return The object TypeId.
@@ -163,9 +242,31 @@ class LoraInterferenceHelper
                                            Ptr<Packet> packet,
                                            double frequencyMHz);
 
+    /**
+     * Add an event that started impinging on the antenna at a given time.
+     *
+     * \param startTime The time the packet started being received.
+     * \param duration The duration of the packet.
+     * \param rxPower The received power in dBm.
+     * \param spreadingFactor The spreading factor used by the transmission.
+     * \param packet The packet carried by this transmission.
+     * \param frequencyMHz The frequency this event was sent at.
+     *
+     * \return The newly created event.
+     */
+    Ptr<LoraInterferenceHelper::Event> Add(Time startTime,
+                                           Time duration,
+                                           double rxPower,
+                                           uint8_t spreadingFactor,
+                                           Ptr<Packet> packet,
+                                           double frequencyMHz);
+
     /**
      * Get a list of the interferers currently registered at this InterferenceHelper.
      *
+     * Old events are deleted first. The list is built at each call, and is
+     * sorted by frequency and then by end time.
+     *
      * \return The list of pointers to interference Event objects.
      */
     std::list<Ptr<LoraInterferenceHelper::Event>> GetInterferers();
@@ -188,6 +289,113 @@ class LoraInterferenceHelper
      */
     uint8_t IsDestroyedByInterference(Ptr<LoraInterferenceHelper::Event> event);
 
+    /**
+     * Determine whether the signals registered so far are enough to destroy an
+     * event, before it ends.
+     *
+     * The interference affecting an event only grows as signals are added, so
+     * an event destroyed by the signals registered so far can't be received.
+     * Unlike IsDestroyedByInterference, this doesn't end the accumulation of
+     * energy for events a receiver locked on. With an interference source,
+     * the signals that reached the receiver so far are looked up in the source.
+     *
+     * \param event The event for which to check the outcome.
+     * \return The sf of the packets that already cause the loss, or 0 if the
+     * event may still be received.
+     */
+    uint8_t IsAlreadyDestroyed(Ptr<LoraInterferenceHelper::Event> event);
+
+    /**
+     * Determine whether an event is destroyed by interference at a receiver
+     * performing successive interference cancellation (SIC), i.e., first
+     * decoding some of the signals overlapping it and subtracting them.
+     *
+     * Overlapping signals are tried from the strongest to the weakest: a signal
+     * is decodable if its power is above the sensitivity of the receiver for
+     * its SF, and it survives the interference of the signals overlapping it
+     * that weren't cancelled yet. The strongest decodable signal is
+     * cancelled, its energy is removed from the per-SF interference affecting
+     * the event, and the event is checked again, until it survives, no signal
+     * is decodable or the maximum number of cancellations is reached.
+     *
+     * The interference energy is recomputed from the signals the helper keeps
+     * or from the interference source, so this method can be called after
+     * IsDestroyedByInterference, e.g., once the overlapping signals ended.
+     *
+     * \param event The event for which to check the outcome.
+     * \param maxCancellations The largest number of signals that can be
+     * cancelled.
+     * \param sensitivity The sensitivity [dBm] of the receiver for each SF,
+     * from SF7 to SF12.
+     * \param nCancelled Set to the number of signals that were cancelled.
+     * \return The sf of the packets that caused the loss, or 0 if there was no
+     * loss.
+     */
+    uint8_t IsDestroyedAfterCancellation(Ptr<LoraInterferenceHelper::Event> event,
+                                         uint32_t maxCancellations,
+                                         const double sensitivity[6],
+                                         uint32_t& nCancelled);
+
+    /**
+     * Get the time the last signal overlapping an event ends.
+     *
+     * \param event The event.
+     * \return The end time of the last overlapping signal, or the end time of
+     * the event if no signal ends after it.
+     */
+    Time GetOverlapEnd(Ptr<LoraInterferenceHelper::Event> event);
+
+    /**
+     * Notify the helper that a receiver locked on an event, so that the
+     * interference affecting it is accumulated as new events are added.
+     *
+     * With INCREMENTAL energy accounting, the energy of the events that were
+     * already registered is computed here, and each event added until the end
+     * of reception credits its overlap energy to the event. The
+     * IsDestroyedByInterference call for this event then only compares the
+     * accumulated energies against the collision matrix. Events nobody locks on
+     * don't accumulate energy. With RECOMPUTE energy accounting, this method
+     * does nothing.
+     *
+     * \param event The event the receiver locked on.
+     */
+    void LockOnEvent(Ptr<LoraInterferenceHelper::Event> event);
+
+    /**
+     * Set the way interference energy is computed.
+     *
+     * This only affects events locked on after the call.
+     *
+     * \param energyAccounting The energy accounting method.
+     */
+    void SetEnergyAccounting(EnergyAccounting energyAccounting);
+
+    /**
+     * Callback collecting the signals that overlap an event, as seen by the
+     * receiver of the helper, from a log kept outside of the helper.
+     *
+     * The first argument is the event being received, and the second one the
+     * vector to fill with the overlapping signals. The event itself must not
+     * be included.
+     */
+    typedef Callback<void,
+                     Ptr<LoraInterferenceHelper::Event>,
+                     std::vector<Ptr<LoraInterferenceHelper::Event>>&>
+        InterferenceSource;
+
+    /**
+     * Set the source of the signals interfering with received packets.
+     *
+     * When a source is set, the helper drops the events it currently keeps and
+     * doesn't store the events that are added anymore, so that GetInterferers
+     * returns an empty list. IsDestroyedByInterference asks the source for the
+     * signals overlapping the event instead, and the energy accounting method
+     * is ignored. A null callback restores the default behavior.
+     *
+     * \param source The source of interfering signals.
+     */
+    void SetInterferenceSource(InterferenceSource source);
+
     /**
      * Compute the time duration in which two given events are overlapping.
      *
@@ -206,10 +414,97 @@ class LoraInterferenceHelper
 
     /**
      * Delete old events in this LoraInterferenceHelper.
+     *
+     * Events are old if they ended more than the retention horizon ago, and
+     * can't overlap any event that is still being received (i.e., they ended
+     * before the longest event added so far could have started).
      */
     void CleanOldEvents();
 
+    /**
+     * Set how long events are kept after they end.
+     *
+     * This should be the longest time on air allowed on the channels the
+     * receiver listens to (see LorawanMac::GetMaxOnAirTime). Events are kept at
+     * least as long as the longest event added so far, in any case.
+     *
+     * \param retentionHorizon The retention horizon.
+     */
+    void SetRetentionHorizon(Time retentionHorizon);
+
+    /**
+     * Get how long events are kept after they end.
+     *
+     * \return The retention horizon.
+     */
+    Time GetRetentionHorizon() const;
+
+    /**
+     * Set the maximum number of events this helper keeps.
+     *
+     * \param maxEvents The maximum number of events.
+     */
+    void SetMaxEvents(uint32_t maxEvents);
+
+    /**
+     * Get the maximum number of events this helper keeps.
+     *
+     * \return The maximum number of events.
+     */
+    uint32_t GetMaxEvents() const;
+
+    /**
+     * Get the number of events evicted because the maximum number of events
+     * was reached, before their retention horizon passed.
+     *
+     * \return The number of evicted events.
+     */
+    uint64_t GetNEvictedEvents() const;
+
+    /**
+     * Get the largest number of events this helper kept at the same time.
+     *
+     * \return The peak number of events.
+     */
+    uint32_t GetPeakEvents() const;
+
+    /**
+     * Set the callback to invoke when the peak number of events increases.
+     *
+     * \param callback The callback, taking the new peak.
+     */
+    void SetPeakEventsCallback(Callback<void, uint32_t> callback);
+
+    /**
+     * Get the number of events this helper allocated on the heap.
+     *
+     * Each event takes sizeof(LoraInterferenceHelper::Event) bytes, plus the
+     * allocator overhead.
+     *
+     * \return The number of allocated events.
+     */
+    uint64_t GetNAllocatedEvents() const;
+
+    /**
+     * Get the number of signals that reused an event of the pool instead of
+     * allocating a new one.
+     *
+     * \return The number of reused events.
+     */
+    uint64_t GetNRecycledEvents() const;
+
+    /**
+     * Get the largest isolation of the collision matrix new helpers use, i.e.,
+     * how much weaker than a packet a signal can be while still destroying it
+     * on its own.
+     *
+     * \return The isolation [dB], or infinity if any overlapping signal of the
+     * same SF destroys packets, as with the ALOHA collision matrix.
+     */
+    static double GetMaxIsolationDb();
+
     static CollisionMatrix collisionMatrix; //!< Collision matrix type set by the constructor
+    static EnergyAccounting energyAccounting; //!< Energy accounting method set by the constructor
 
     static std::vector<std::vector<double>> collisionSnirAloha;    //!< ALOHA collision matrix
     static std::vector<std::vector<double>> collisionSnirGoursaud; //!< GOURSAUD collision matrix
@@ -224,12 +519,242 @@ class LoraInterferenceHelper
      */
     void SetCollisionMatrix(enum CollisionMatrix collisionMatrix);
 
-    std::vector<std::vector<double>> m_collisionSnir; //!< The matrix containing information about
-                                                      //!< how packets survive interference
-    std::list<Ptr<LoraInterferenceHelper::Event>>
-        m_events; //!< List of the events this LoraInterferenceHelper is keeping track of
-    static Time oldEventThreshold; //!< The threshold after which an event is considered old and
-                                   //!< removed from the list
+    /**
+     * The events on a frequency, sorted by their end time.
+     *
+     * Expired events are popped from the front in constant time, while new
+     * events are usually inserted close to the back.
+     */
+    typedef std::deque<Ptr<LoraInterferenceHelper::Event>> EventBucket;
+
+    /**
+     * Find the first event of a frequency that ends after a given time.
+     *
+     * \param bucket The events of the frequency.
+     * \param time The time.
+     * \return An iterator to the first event ending after time.
+     */
+    static EventBucket::const_iterator FindFirstEndingAfter(const EventBucket& bucket, Time time);
+
+    /**
+     * Get an event from the pool, or allocate one if the pool is empty.
+     *
+     * \param startTime The time the signal started impinging on the antenna.
+     * \param duration The duration in time.
+     * \param rxPowerdBm The power of the signal.
+     * \param spreadingFactor The modulation spreading factor.
+     * \param packet The packet transmitted.
+     * \param frequencyMHz The carrier frequency of the signal.
+     * \return The event.
+     */
+    Ptr<LoraInterferenceHelper::Event> AllocateEvent(Time startTime,
+                                                     Time duration,
+                                                     double rxPowerdBm,
+                                                     uint8_t spreadingFactor,
+                                                     Ptr<Packet> packet,
+                                                     double frequencyMHz);
+
+    /**
+     * Return a dropped event to the pool, if it was allocated by this helper,
+     * nobody else holds a pointer to it and the pool holds less than the
+     * maximum number of events.
+     *
+     * \param event The event.
+     */
+    void RetireEvent(Ptr<LoraInterferenceHelper::Event> event);
+
+    /**
+     * An event a receiver locked on, with the interference energy accumulated
+     * so far.
+     */
+    struct LockedEvent
+    {
+        Ptr<LoraInterferenceHelper::Event> event; //!< The event being received
+        std::vector<double> energy; //!< Interference energy [J] of each SF, from SF7 to SF12
+    };
+
+    /**
+     * Delete the old events of a frequency.
+     *
+     * \param frequencyMHz The frequency.
+     * \param bucket The events of the frequency.
+     */
+    void CleanOldEvents(double frequencyMHz, EventBucket& bucket);
+
+    /**
+     * Evict the events that ended first until the number of events is within
+     * the cap.
+     */
+    void EnforceMaxEvents();
+
+    /**
+     * Add the energy each event on the same frequency delivers to an event
+     * during their overlap to the per-SF energies.
+     *
+     * \param event The event affected by interference.
+     * \param interferer The interfering event.
+     * \param cumulativeInterferenceEnergy The energy of each SF, from SF7 to
+     * SF12.
+     */
+    void AddInterferenceEnergy(Ptr<LoraInterferenceHelper::Event> event,
+                               Ptr<LoraInterferenceHelper::Event> interferer,
+                               std::vector<double>& cumulativeInterferenceEnergy);
+
+    /**
+     * Collect the signals on the same frequency that overlap an event, from
+     * the events the helper keeps or from the interference source.
+     *
+     * \param event The event.
+     * \param overlapping The vector to append the overlapping signals to.
+     */
+    void GetOverlappingEvents(Ptr<LoraInterferenceHelper::Event> event,
+                              std::vector<Ptr<LoraInterferenceHelper::Event>>& overlapping);
+
+    /**
+     * Check whether a signal survives the interference of the signals
+     * overlapping it, except those that were cancelled.
+     *
+     * Signals returned by the interference source are new events at each
+     * call, so signals are matched by packet and start time.
+     *
+     * \param event The signal to check.
+     * \param cancelled The signals that were cancelled.
+     * \return True if the signal can be decoded.
+     */
+    bool IsDecodable(Ptr<LoraInterferenceHelper::Event> event,
+                     const std::vector<Ptr<LoraInterferenceHelper::Event>>& cancelled);
+
+    /**
+     * Compare the interference energy affecting an event against the
+     * collision matrix, with the policy matching the matrix.
+     *
+     * \param event The event for which to check the outcome.
+     * \param cumulativeInterferenceEnergy The energy of each SF, from SF7 to
+     * SF12.
+     * \return The sf of the packets that caused the loss, or 0 if there was no
+     * loss.
+     */
+    uint8_t GetDestroyingSf(Ptr<LoraInterferenceHelper::Event> event,
+                            const std::vector<double>& cumulativeInterferenceEnergy) const;
+
+    /**
+     * Compare the interference energy affecting an event against the
+     * collision matrix.
+     *
+     * \tparam CollisionPolicy The way the energies are compared, i.e.,
+     * ThresholdCollisionPolicy or AlohaCollisionPolicy.
+     * \param event The event for which to check the outcome.
+     * \param cumulativeInterferenceEnergy The energy of each SF, from SF7 to
+     * SF12.
+     * \return The sf of the packets that caused the loss, or 0 if there was no
+     * loss.
+     */
+    template <class CollisionPolicy>
+    uint8_t EvaluateCollisions(Ptr<LoraInterferenceHelper::Event> event,
+                               const std::vector<double>& cumulativeInterferenceEnergy) const;
+
+    /**
+     * The number of spreading factors, from SF7 to SF12.
+     */
+    static constexpr std::size_t N_SF = 6;
+
+    /**
+     * The relative distance from a threshold below which the ratio of signal
+     * and interference energy is compared in dB, to get the same outcome as
+     * with the logarithm.
+     */
+    static constexpr double RATIO_TOLERANCE = 1e-9;
+
+    /**
+     * A collision matrix, flattened: the entry for a desired signal of SF i
+     * and interferers of SF j is at index N_SF * (i - 7) + (j - 7).
+     */
+    struct CollisionThresholds
+    {
+        std::array<double, N_SF * N_SF> snirDb; //!< The minimum SNIR [dB]
+        std::array<double, N_SF * N_SF> ratio;  //!< The minimum SNIR as an energy ratio
+    };
+
+    /**
+     * Collision policy comparing the SNIR of each spreading factor against
+     * the thresholds of any collision matrix.
+     *
+     * Energies are compared in the linear domain, and the SNIR in dB is only
+     * computed when the ratio is too close to the threshold to tell.
+     */
+    struct ThresholdCollisionPolicy
+    {
+        /**
+         * Find the spreading factor whose interference destroys a packet.
+         *
+         * \param thresholds The collision matrix.
+         * \param sf The spreading factor of the packet.
+         * \param signalEnergy The energy of the packet [J].
+         * \param cumulativeInterferenceEnergy The energy of each SF [J].
+         * \return The sf of the packets that caused the loss, or 0 if there
+         * was no loss.
+         */
+        static uint8_t GetDestroyingSf(const CollisionThresholds& thresholds,
+                                       uint8_t sf,
+                                       double signalEnergy,
+                                       const std::vector<double>& cumulativeInterferenceEnergy);
+    };
+
+    /**
+     * Collision policy of the ALOHA collision matrix: a packet is destroyed
+     * by any overlapping packet of the same spreading factor.
+     */
+    struct AlohaCollisionPolicy
+    {
+        /**
+         * Find the spreading factor whose interference destroys a packet.
+         *
+         * \param thresholds The collision matrix.
+         * \param sf The spreading factor of the packet.
+         * \param signalEnergy The energy of the packet [J].
+         * \param cumulativeInterferenceEnergy The energy of each SF [J].
+         * \return The sf of the packets that caused the loss, or 0 if there
+         * was no loss.
+         */
+        static uint8_t GetDestroyingSf(const CollisionThresholds& thresholds,
+                                       uint8_t sf,
+                                       double signalEnergy,
+                                       const std::vector<double>& cumulativeInterferenceEnergy);
+    };
+
+    /**
+     * Flatten a collision matrix and convert its thresholds to energy ratios.
+     *
+     * \param collisionSnir The collision matrix, by rows of desired SF.
+     * \return The thresholds.
+     */
+    static CollisionThresholds GetCollisionThresholds(
+        const std::vector<std::vector<double>>& collisionSnir);
+
+    CollisionThresholds m_collisionThresholds; //!< The matrix containing information about
+                                               //!< how packets survive interference
+    bool m_alohaCollisions; //!< Whether the collision matrix is the ALOHA one
+    std::map<double, EventBucket>
+        m_events;       //!< The events this LoraInterferenceHelper is keeping track of, by frequency
+    Time m_maxDuration; //!< The longest duration of the events added so far
+    EnergyAccounting m_energyAccounting; //!< The way interference energy is computed
+    std::vector<Ptr<LoraInterferenceHelper::Event>>
+        m_freeEvents;            //!< Dropped events that can be reused
+    uint64_t m_allocatedEvents; //!< The number of events allocated on the heap
+    uint64_t m_recycledEvents;  //!< The number of events reused from the pool
+    std::map<double, std::vector<LockedEvent>>
+        m_lockedEvents; //!< Events receivers locked on, by frequency
+    Time m_retentionHorizon;  //!< How long events are kept after they end
+    uint32_t m_maxEvents;     //!< The maximum number of events
+    uint32_t m_nEvents;       //!< The number of events currently kept
+    uint32_t m_peakEvents;    //!< The largest number of events kept at the same time
+    uint64_t m_evictedEvents; //!< The number of events evicted by the cap
+    Callback<void, uint32_t> m_peakEventsCallback; //!< Invoked when m_peakEvents increases
+    InterferenceSource
+        m_interferenceSource; //!< Provides the interferers, if events are not stored
+    std::vector<Ptr<LoraInterferenceHelper::Event>>
+        m_sourceInterferers; //!< Interferers returned by m_interferenceSource
+    static Time oldEventThreshold; //!< The default retention horizon
 };
 
 /**
@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2017 University of Padova
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#include "lora-link-table.h"
+
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+NS_LOG_COMPONENT_DEFINE("LoraLinkTable");
+
+const uint64_t LoraLinkTable::HASH_INIT = 14695981039346656037ULL;
+
+/**
+ * The header at the beginning of a link table file.
+ */
+struct LoraLinkTableFileHeader
+{
+    char magic[8];         //!< Identifies link table files
+    uint32_t version;      //!< Version of the file format
+    uint32_t byteOrder;    //!< Detects files written with a different byte order
+    uint32_t nPhys;        //!< The number of PHYs of the channel
+    uint32_t nGateways;    //!< The number of gateway PHYs of the channel
+    uint32_t randomLoss;   //!< Whether the table holds frozen random loss samples
+    uint32_t reserved;     //!< Keeps the hashes aligned, always 0
+    uint64_t topologyHash; //!< Hash of the positions of the PHYs
+    uint64_t modelHash;    //!< Hash of the loss and delay model parameters
+};
+
+static const char LINK_TABLE_MAGIC[8] = {'L', 'O', 'R', 'A', 'L', 'I', 'N', 'K'};
+static const uint32_t LINK_TABLE_VERSION = 2;
+static const uint32_t LINK_TABLE_BYTE_ORDER = 0x01020304;
+
+bool
+LoraLinkTable::Write(const std::string& filename,
+                     const Signature& signature,
+                     const std::vector<uint32_t>& gateways,
+                     const std::vector<float>& gainsDb,
+                     const std::vector<uint32_t>& delays)
+{
+    NS_LOG_FUNCTION(filename << signature.nPhys << signature.nGateways);
+
+    std::size_t nLinks = 2 * std::size_t(signature.nGateways) * signature.nPhys;
+    NS_ASSERT(gateways.size() == signature.nGateways);
+    NS_ASSERT(gainsDb.size() == nLinks && delays.size() == nLinks);
+
+    LoraLinkTableFileHeader header;
+    std::memcpy(header.magic, LINK_TABLE_MAGIC, sizeof(header.magic));
+    header.version = LINK_TABLE_VERSION;
+    header.byteOrder = LINK_TABLE_BYTE_ORDER;
+    header.nPhys = signature.nPhys;
+    header.nGateways = signature.nGateways;
+    header.randomLoss = signature.randomLoss;
+    header.reserved = 0;
+    header.topologyHash = signature.topologyHash;
+    header.modelHash = signature.modelHash;
+
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(gateways.data()),
+               gateways.size() * sizeof(uint32_t));
+    file.write(reinterpret_cast<const char*>(gainsDb.data()), nLinks * sizeof(float));
+    file.write(reinterpret_cast<const char*>(delays.data()), nLinks * sizeof(uint32_t));
+    file.close();
+
+    if (!file)
+    {
+        NS_LOG_WARN("Could not write link table " << filename);
+        return false;
+    }
+    return true;
+}
+
+Ptr<LoraLinkTable>
+LoraLinkTable::Open(const std::string& filename)
+{
+    NS_LOG_FUNCTION(filename);
+
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        NS_LOG_WARN("Could not open link table " << filename);
+        return nullptr;
+    }
+
+    struct stat status;
+    if (fstat(fd, &status) != 0 || std::size_t(status.st_size) < sizeof(LoraLinkTableFileHeader))
+    {
+        NS_LOG_WARN("Link table " << filename << " is truncated");
+        close(fd);
+        return nullptr;
+    }
+
+    std::size_t size = status.st_size;
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        NS_LOG_WARN("Could not map link table " << filename);
+        return nullptr;
+    }
+
+    // The table owns the mapping from now on, and releases it if invalid
+    Ptr<LoraLinkTable> table = Ptr<LoraLinkTable>(new LoraLinkTable(), false);
+    table->m_mapping = mapping;
+    table->m_size = size;
+
+    LoraLinkTableFileHeader header;
+    std::memcpy(&header, mapping, sizeof(header));
+    if (std::memcmp(header.magic, LINK_TABLE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != LINK_TABLE_VERSION || header.byteOrder != LINK_TABLE_BYTE_ORDER)
+    {
+        NS_LOG_WARN(filename << " is not a link table, or was written by an incompatible "
+                             << "version or machine");
+        return nullptr;
+    }
+
+    std::size_t nLinks = 2 * std::size_t(header.nGateways) * header.nPhys;
+    if (header.nGateways > header.nPhys ||
+        size != sizeof(header) + header.nGateways * sizeof(uint32_t) +
+                    nLinks * (sizeof(float) + sizeof(uint32_t)))
+    {
+        NS_LOG_WARN("Link table " << filename << " has the wrong size for " << header.nPhys
+                                  << " PHYs and " << header.nGateways << " gateways");
+        return nullptr;
+    }
+
+    // Index the rows of the gateways
+    const char* data = static_cast<const char*>(mapping) + sizeof(header);
+    const auto* gateways = reinterpret_cast<const uint32_t*>(data);
+    table->m_gatewayRows.assign(header.nPhys, -1);
+    for (uint32_t row = 0; row < header.nGateways; row++)
+    {
+        if (gateways[row] >= header.nPhys || table->m_gatewayRows[gateways[row]] >= 0)
+        {
+            NS_LOG_WARN("Link table " << filename << " has an invalid gateway index");
+            return nullptr;
+        }
+        table->m_gatewayRows[gateways[row]] = row;
+    }
+    data += header.nGateways * sizeof(uint32_t);
+
+    table->m_signature.nPhys = header.nPhys;
+    table->m_signature.nGateways = header.nGateways;
+    table->m_signature.topologyHash = header.topologyHash;
+    table->m_signature.modelHash = header.modelHash;
+    table->m_signature.randomLoss = header.randomLoss;
+    table->m_gainsDb = reinterpret_cast<const float*>(data);
+    table->m_delays = reinterpret_cast<const uint32_t*>(data + nLinks * sizeof(float));
+
+    NS_LOG_DEBUG("Mapped link table " << filename << " with " << header.nPhys << " PHYs and "
+                                      << header.nGateways << " gateways");
+
+    return table;
+}
+
+LoraLinkTable::LoraLinkTable()
+    : m_signature{0, 0, 0, 0, false},
+      m_mapping(nullptr),
+      m_size(0),
+      m_gainsDb(nullptr),
+      m_delays(nullptr)
+{
+}
+
+LoraLinkTable::~LoraLinkTable()
+{
+    if (m_mapping)
+    {
+        munmap(m_mapping, m_size);
+    }
+}
+
+const LoraLinkTable::Signature&
+LoraLinkTable::GetSignature() const
+{
+    return m_signature;
+}
+
+bool
+LoraLinkTable::HasLink(uint32_t sender, uint32_t receiver) const
+{
+    NS_ASSERT(sender < m_signature.nPhys && receiver < m_signature.nPhys);
+
+    return m_gatewayRows[sender] >= 0 || m_gatewayRows[receiver] >= 0;
+}
+
+std::size_t
+LoraLinkTable::GetLinkIndex(uint32_t sender, uint32_t receiver) const
+{
+    NS_ASSERT_MSG(HasLink(sender, receiver), "Links between end devices are not in the table");
+
+    // Uplinks are in the even row of the gateway, downlinks in the odd one
+    if (m_gatewayRows[receiver] >= 0)
+    {
+        return std::size_t(2 * m_gatewayRows[receiver]) * m_signature.nPhys + sender;
+    }
+    return std::size_t(2 * m_gatewayRows[sender] + 1) * m_signature.nPhys + receiver;
+}
+
+double
+LoraLinkTable::GetGainDb(uint32_t sender, uint32_t receiver) const
+{
+    return m_gainsDb[GetLinkIndex(sender, receiver)];
+}
+
+uint32_t
+LoraLinkTable::GetDelay(uint32_t sender, uint32_t receiver) const
+{
+    return m_delays[GetLinkIndex(sender, receiver)];
+}
+
+uint64_t
+LoraLinkTable::Hash(uint64_t hash, const void* data, std::size_t size)
+{
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    for (std::size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+} // namespace lorawan
+} // namespace ns3
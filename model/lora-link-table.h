@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2017 University of Padova
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#ifndef LORA_LINK_TABLE_H
+#define LORA_LINK_TABLE_H
+
+#include "ns3/simple-ref-count.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+/**
+ * \ingroup lorawan
+ *
+ * A read-only table of the link budgets between the gateways of a LoraChannel
+ * and all other PHYs, stored in a binary file that is memory-mapped when
+ * loaded.
+ *
+ * For each link from or to a gateway, the table holds the received power of a
+ * transmission at 0 dBm and the propagation delay. The file starts with a
+ * header recording the number of PHYs and gateways, a hash of their positions
+ * and a hash of the parameters of the loss and delay models, so that tables
+ * computed for a different scenario can be detected. It then lists the index
+ * of each gateway, followed by two rows per gateway (links from all PHYs to the
+ * gateway, and from the gateway to all PHYs) of gains as float and of delays as
+ * uint32_t time steps. Links between two end devices are not stored, so the
+ * table takes 16 bytes per end device and gateway, instead of 8 bytes per pair
+ * of PHYs. The file uses the byte order of the machine that wrote it, and is
+ * rejected by machines with a different one.
+ */
+class LoraLinkTable : public SimpleRefCount<LoraLinkTable>
+{
+  public:
+    /**
+     * The parameters identifying the scenario a table was computed for.
+     */
+    struct Signature
+    {
+        uint32_t nPhys;        //!< The number of PHYs of the channel
+        uint32_t nGateways;    //!< The number of gateway PHYs of the channel
+        uint64_t topologyHash; //!< Hash of the positions of the PHYs
+        uint64_t modelHash;    //!< Hash of the loss and delay model parameters
+        bool randomLoss;       //!< Whether the table holds frozen random loss samples
+    };
+
+    /**
+     * Write a table to a file.
+     *
+     * \param filename The path of the file.
+     * \param signature The parameters identifying the scenario.
+     * \param gateways The index of each of the nGateways gateway PHYs.
+     * \param gainsDb The received power [dBm] of a transmission at 0 dBm from PHY
+     * i to the k-th gateway at index 2 * k * nPhys + i, and from the k-th
+     * gateway to PHY j at index (2 * k + 1) * nPhys + j.
+     * \param delays The propagation delay, in time steps, with the same layout.
+     * \return True if the file was written, false otherwise.
+     */
+    static bool Write(const std::string& filename,
+                      const Signature& signature,
+                      const std::vector<uint32_t>& gateways,
+                      const std::vector<float>& gainsDb,
+                      const std::vector<uint32_t>& delays);
+
+    /**
+     * Map a table written by Write in memory.
+     *
+     * \param filename The path of the file.
+     * \return The table, or nullptr if the file can't be read or is not a
+     * valid link table.
+     */
+    static Ptr<LoraLinkTable> Open(const std::string& filename);
+
+    ~LoraLinkTable(); //!< Destructor, unmaps the file
+
+    /**
+     * Get the parameters identifying the scenario the table was computed for.
+     *
+     * \return The signature of the table.
+     */
+    const Signature& GetSignature() const;
+
+    /**
+     * Check whether the table holds a link, i.e., whether either end is a
+     * gateway.
+     *
+     * \param sender The index of the sending PHY.
+     * \param receiver The index of the receiving PHY.
+     * \return True if the link is in the table.
+     */
+    bool HasLink(uint32_t sender, uint32_t receiver) const;
+
+    /**
+     * Get the received power of a transmission at 0 dBm, over a link in the
+     * table.
+     *
+     * \param sender The index of the sending PHY.
+     * \param receiver The index of the receiving PHY.
+     * \return The gain [dB] of the link.
+     */
+    double GetGainDb(uint32_t sender, uint32_t receiver) const;
+
+    /**
+     * Get the propagation delay of a link in the table.
+     *
+     * \param sender The index of the sending PHY.
+     * \param receiver The index of the receiving PHY.
+     * \return The delay, in time steps.
+     */
+    uint32_t GetDelay(uint32_t sender, uint32_t receiver) const;
+
+    /**
+     * Update a 64-bit FNV-1a hash with some bytes.
+     *
+     * \param hash The current value of the hash.
+     * \param data The bytes to add.
+     * \param size The number of bytes.
+     * \return The updated hash.
+     */
+    static uint64_t Hash(uint64_t hash, const void* data, std::size_t size);
+
+    static const uint64_t HASH_INIT; //!< The initial value of a hash
+
+  private:
+    LoraLinkTable(); //!< Tables are only created by Open
+
+    /**
+     * Get the position of a link in the rows of the table.
+     *
+     * \param sender The index of the sending PHY.
+     * \param receiver The index of the receiving PHY, one of the two being a
+     * gateway.
+     * \return The index of the link in the gain and delay rows.
+     */
+    std::size_t GetLinkIndex(uint32_t sender, uint32_t receiver) const;
+
+    Signature m_signature;              //!< The parameters identifying the scenario
+    void* m_mapping;                    //!< The start of the mapped file
+    std::size_t m_size;                 //!< The size of the mapped file
+    const float* m_gainsDb;             //!< The gain rows, inside the mapping
+    const uint32_t* m_delays;           //!< The delay rows, inside the mapping
+    std::vector<int64_t> m_gatewayRows; //!< The row of each PHY, or -1 if not a gateway
+};
+
+} // namespace lorawan
+
+} // namespace ns3
+#endif /* LORA_LINK_TABLE_H */
@@ -10,6 +10,7 @@
 
 #include "ns3/log.h"
 #include "ns3/simulator.h"
+#include "ns3/uinteger.h"
 
 #include <algorithm>
 
@@ -61,12 +62,27 @@ LoraPhy::GetTypeId()
                             "could not be correctly received because"
                             "its received power is below the sensitivity of the receiver",
                             MakeTraceSourceAccessor(&LoraPhy::m_underSensitivity),
-                            "ns3::Packet::TracedCallback");
+                            "ns3::Packet::TracedCallback")
+            .AddTraceSource("InterferenceEventsPeak",
+                            "The largest number of signals kept at the same time "
+                            "by the interference helper",
+                            MakeTraceSourceAccessor(&LoraPhy::m_peakInterferenceEvents),
+                            "ns3::TracedValueCallback::Uint32")
+            .AddAttribute("MaxInterferenceEvents",
+                          "The maximum number of signals kept by the interference helper. "
+                          "When it is reached, the signals that ended first are evicted.",
+                          UintegerValue(10000),
+                          MakeUintegerAccessor(&LoraPhy::SetMaxInterferenceEvents,
+                                               &LoraPhy::GetMaxInterferenceEvents),
+                          MakeUintegerChecker<uint32_t>(1));
     return tid;
 }
 
 LoraPhy::LoraPhy()
+    : m_peakInterferenceEvents(0)
 {
+    m_interference.SetPeakEventsCallback(
+        MakeCallback(&LoraPhy::NotifyPeakInterferenceEvents, this));
 }
 
 LoraPhy::~LoraPhy()
@@ -146,6 +162,76 @@ LoraPhy::SetTxFinishedCallback(TxFinishedCallback callback)
     m_txFinishedCallback = callback;
 }
 
+void
+LoraPhy::AddInterferer(Ptr<Packet> packet,
+                       double rxPowerDbm,
+                       uint8_t sf,
+                       Time startTime,
+                       Time duration,
+                       double frequencyMHz)
+{
+    NS_LOG_FUNCTION(this << packet << rxPowerDbm << unsigned(sf) << startTime << duration
+                         << frequencyMHz);
+
+    m_interference.Add(startTime, duration, rxPowerDbm, sf, packet, frequencyMHz);
+}
+
+void
+LoraPhy::SetInterferenceRetentionHorizon(Time retentionHorizon)
+{
+    NS_LOG_FUNCTION(this << retentionHorizon);
+
+    m_interference.SetRetentionHorizon(retentionHorizon);
+}
+
+const LoraInterferenceHelper&
+LoraPhy::GetInterferenceHelper() const
+{
+    return m_interference;
+}
+
+void
+LoraPhy::SetSharedAirLog(bool shared)
+{
+    NS_LOG_FUNCTION(this << shared);
+
+    if (shared)
+    {
+        m_interference.SetInterferenceSource(MakeCallback(&LoraPhy::GetSharedInterferers, this));
+    }
+    else
+    {
+        m_interference.SetInterferenceSource(LoraInterferenceHelper::InterferenceSource());
+    }
+}
+
+void
+LoraPhy::GetSharedInterferers(Ptr<LoraInterferenceHelper::Event> event,
+                              std::vector<Ptr<LoraInterferenceHelper::Event>>& interferers)
+{
+    NS_ASSERT(m_channel);
+
+    m_channel->GetInterferers(this, event, interferers);
+}
+
+void
+LoraPhy::SetMaxInterferenceEvents(uint32_t maxEvents)
+{
+    m_interference.SetMaxEvents(maxEvents);
+}
+
+uint32_t
+LoraPhy::GetMaxInterferenceEvents() const
+{
+    return m_interference.GetMaxEvents();
+}
+
+void
+LoraPhy::NotifyPeakInterferenceEvents(uint32_t peakEvents)
+{
+    m_peakInterferenceEvents = peakEvents;
+}
+
 Time
 LoraPhy::GetTSym(LoraTxParameters txParams)
 {
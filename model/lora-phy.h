@@ -18,6 +18,7 @@
 #include "ns3/node.h"
 #include "ns3/nstime.h"
 #include "ns3/object.h"
+#include "ns3/traced-value.h"
 
 #include <list>
 
@@ -129,6 +130,56 @@ class LoraPhy : public Object
      */
     virtual void EndReceive(Ptr<Packet> packet, Ptr<LoraInterferenceHelper::Event> event) = 0;
 
+    /**
+     * Register a signal that is already impinging on the antenna as interference.
+     *
+     * This method is called by LoraChannel when a PHY starts listening while a
+     * packet is on air: the PHY can't lock on the packet anymore, but the
+     * packet still interferes with the ones the PHY will try to receive.
+     *
+     * \param packet The interfering packet.
+     * \param rxPowerDbm The power of the interfering packet.
+     * \param sf The Spreading Factor of the interfering packet.
+     * \param startTime The time the packet started arriving at this PHY.
+     * \param duration The on air time of the packet.
+     * \param frequencyMHz The frequency the packet is being transmitted on.
+     */
+    void AddInterferer(Ptr<Packet> packet,
+                       double rxPowerDbm,
+                       uint8_t sf,
+                       Time startTime,
+                       Time duration,
+                       double frequencyMHz);
+
+    /**
+     * Set how long the interference helper of this PHY keeps signals after
+     * they end.
+     *
+     * \param retentionHorizon The longest time on air of the packets this PHY
+     * can hear.
+     */
+    void SetInterferenceRetentionHorizon(Time retentionHorizon);
+
+    /**
+     * Get the interference helper of this PHY, e.g., to read its event
+     * counters.
+     *
+     * \return The LoraInterferenceHelper of this PHY.
+     */
+    const LoraInterferenceHelper& GetInterferenceHelper() const;
+
+    /**
+     * Set whether this PHY takes interferers from the air log of its channel.
+     *
+     * In this case the interference helper of the PHY doesn't store the
+     * signals it hears: the signals overlapping a packet are looked up in the
+     * channel's log when its reception ends. This is set by LoraChannel,
+     * according to its SharedAirLog attribute.
+     *
+     * \param shared Whether to use the channel's air log.
+     */
+    void SetSharedAirLog(bool shared);
+
     /**
      * Instruct the PHY to send a packet according to some parameters.
      *
@@ -266,8 +317,45 @@ class LoraPhy : public Object
      */
     virtual void TxFinished(Ptr<const Packet> packet) = 0;
 
+    /**
+     * Set the maximum number of signals the interference helper keeps.
+     *
+     * \param maxEvents The maximum number of signals.
+     */
+    void SetMaxInterferenceEvents(uint32_t maxEvents);
+
+    /**
+     * Get the maximum number of signals the interference helper keeps.
+     *
+     * \return The maximum number of signals.
+     */
+    uint32_t GetMaxInterferenceEvents() const;
+
+    /**
+     * Record a new peak of the number of signals kept by the interference
+     * helper.
+     *
+     * \param peakEvents The new peak.
+     */
+    void NotifyPeakInterferenceEvents(uint32_t peakEvents);
+
+    /**
+     * Collect the signals overlapping an event from the air log of the channel.
+     *
+     * \param event The event being received.
+     * \param interferers The vector to fill with the overlapping signals.
+     */
+    void GetSharedInterferers(Ptr<LoraInterferenceHelper::Event> event,
+                              std::vector<Ptr<LoraInterferenceHelper::Event>>& interferers);
+
     Ptr<MobilityModel> m_mobility; //!< The mobility model associated to this PHY.
 
+    /**
+     * The largest number of signals the interference helper kept at the same
+     * time.
+     */
+    TracedValue<uint32_t> m_peakInterferenceEvents;
+
   protected:
     // Member objects
 
@@ -13,6 +13,8 @@
 #include "ns3/pointer.h"
 #include "ns3/simulator.h"
 
+#include <algorithm>
+
 namespace ns3
 {
 namespace lorawan
@@ -72,6 +74,7 @@ LoraRadioEnergyModel::LoraRadioEnergyModel()
     NS_LOG_FUNCTION(this);
     m_currentState = EndDeviceLoraPhy::SLEEP; // initially STANDBY
     m_lastUpdateTime = Seconds(0.0);
+    m_lastSourceUpdateTime = Seconds(0.0);
     m_nPendingChangeState = 0;
     m_isSupersededChangeState = false;
     m_energyDepletionCallback.Nullify();
@@ -82,6 +85,10 @@ LoraRadioEnergyModel::LoraRadioEnergyModel()
     // set callback for updating the tx current
     m_listener->SetUpdateTxCurrentCallback(
         MakeCallback(&LoraRadioEnergyModel::SetTxCurrentFromModel, this));
+    // set callbacks for lazy receive windows
+    m_listener->SetLazyReceiveWindowCallbacks(
+        MakeCallback(&LoraRadioEnergyModel::AddLazyReceiveWindow, this),
+        MakeCallback(&LoraRadioEnergyModel::ClearLazyReceiveWindows, this));
 }
 
 LoraRadioEnergyModel::~LoraRadioEnergyModel()
@@ -96,13 +103,38 @@ LoraRadioEnergyModel::SetEnergySource(Ptr<EnergySource> source)
     NS_LOG_FUNCTION(this << source);
     NS_ASSERT(source);
     m_source = source;
+    m_lastSourceUpdateTime = Simulator::Now();
 }
 
 double
 LoraRadioEnergyModel::GetTotalEnergyConsumption() const
 {
     NS_LOG_FUNCTION(this);
-    return m_totalEnergyConsumption;
+
+    if (m_currentState != EndDeviceLoraPhy::SLEEP || m_lazyReceiveWindows.empty() || !m_source)
+    {
+        return m_totalEnergyConsumption;
+    }
+
+    // Charge the time spent in SLEEP up to the last edge of a lazy window, as
+    // the state change at that edge would have
+    Time now = Simulator::Now();
+    Time lastEdge = m_lastUpdateTime;
+    for (const auto& window : m_lazyReceiveWindows)
+    {
+        for (Time edge : {window.first, window.second})
+        {
+            if (edge > lastEdge && edge <= now)
+            {
+                lastEdge = edge;
+            }
+        }
+    }
+
+    double sleepEnergy = (lastEdge - m_lastUpdateTime).GetSeconds() * m_sleepCurrentA *
+                         m_source->GetSupplyVoltage();
+    return m_totalEnergyConsumption + sleepEnergy +
+           GetLazyReceiveWindowEnergy(m_lastUpdateTime, lastEdge);
 }
 
 double
@@ -228,7 +260,8 @@ LoraRadioEnergyModel::ChangeState(int newState)
         energyToDecrease = duration.GetSeconds() * m_rxCurrentA * supplyVoltage;
         break;
     case EndDeviceLoraPhy::SLEEP:
-        energyToDecrease = duration.GetSeconds() * m_sleepCurrentA * supplyVoltage;
+        energyToDecrease = duration.GetSeconds() * m_sleepCurrentA * supplyVoltage +
+                           GetLazyReceiveWindowEnergy(m_lastUpdateTime, Simulator::Now());
         break;
     default:
         NS_FATAL_ERROR("LoraRadioEnergyModel:Undefined radio state: " << m_currentState);
@@ -245,6 +278,23 @@ LoraRadioEnergyModel::ChangeState(int newState)
     // notify energy source
     m_source->UpdateEnergySource();
 
+    // forget the lazy windows that were charged, to both this model and the
+    // source, and all of them if we wake up
+    if (newState != EndDeviceLoraPhy::SLEEP)
+    {
+        m_lazyReceiveWindows.clear();
+    }
+    else
+    {
+        Time now = m_lastUpdateTime;
+        m_lazyReceiveWindows.erase(std::remove_if(m_lazyReceiveWindows.begin(),
+                                                  m_lazyReceiveWindows.end(),
+                                                  [now](const std::pair<Time, Time>& window) {
+                                                      return window.second <= now;
+                                                  }),
+                                   m_lazyReceiveWindows.end());
+    }
+
     // in case the energy source is found to be depleted during the last update, a callback might be
     // invoked that might cause a change in the Lora PHY state (e.g., the PHY is put into SLEEP
     // mode). This in turn causes a new call to this member function, with the consequence that the
@@ -305,6 +355,34 @@ LoraRadioEnergyModel::GetPhyListener()
     return m_listener;
 }
 
+void
+LoraRadioEnergyModel::AddLazyReceiveWindow(Time start, Time end)
+{
+    NS_LOG_FUNCTION(this << start << end);
+    NS_ASSERT(start <= end);
+    m_lazyReceiveWindows.emplace_back(start, end);
+}
+
+void
+LoraRadioEnergyModel::ClearLazyReceiveWindows()
+{
+    NS_LOG_FUNCTION(this);
+
+    // The part of the windows that already elapsed is still to be charged, and
+    // will be at the next state change
+    Time now = Simulator::Now();
+    for (auto& window : m_lazyReceiveWindows)
+    {
+        window.second = std::min(window.second, now);
+    }
+    m_lazyReceiveWindows.erase(std::remove_if(m_lazyReceiveWindows.begin(),
+                                              m_lazyReceiveWindows.end(),
+                                              [](const std::pair<Time, Time>& window) {
+                                                  return window.first >= window.second;
+                                              }),
+                               m_lazyReceiveWindows.end());
+}
+
 /*
  * Private functions start here.
  */
@@ -321,6 +399,12 @@ double
 LoraRadioEnergyModel::DoGetCurrentA() const
 {
     NS_LOG_FUNCTION(this);
+
+    // The source charges the current over the time since it last asked for it
+    Time now = Simulator::Now();
+    Time sinceSourceUpdate = now - m_lastSourceUpdateTime;
+    m_lastSourceUpdateTime = now;
+
     switch (m_currentState)
     {
     case EndDeviceLoraPhy::STANDBY:
@@ -330,12 +414,39 @@ LoraRadioEnergyModel::DoGetCurrentA() const
     case EndDeviceLoraPhy::RX:
         return m_rxCurrentA;
     case EndDeviceLoraPhy::SLEEP:
+        // Report the average current over that time, so that the source is
+        // charged for the lazy receive windows in it
+        if (m_source && !m_lazyReceiveWindows.empty() && sinceSourceUpdate.IsStrictlyPositive())
+        {
+            return m_sleepCurrentA +
+                   GetLazyReceiveWindowEnergy(now - sinceSourceUpdate, now) /
+                       (m_source->GetSupplyVoltage() * sinceSourceUpdate.GetSeconds());
+        }
         return m_sleepCurrentA;
     default:
         NS_FATAL_ERROR("LoraRadioEnergyModel:Undefined radio state:" << m_currentState);
     }
 }
 
+double
+LoraRadioEnergyModel::GetLazyReceiveWindowEnergy(Time start, Time end) const
+{
+    NS_LOG_FUNCTION(this << start << end);
+
+    Time overlap = Seconds(0);
+    for (const auto& window : m_lazyReceiveWindows)
+    {
+        Time from = std::max(window.first, start);
+        Time to = std::min(window.second, end);
+        if (from < to)
+        {
+            overlap += to - from;
+        }
+    }
+
+    return overlap.GetSeconds() * (m_idleCurrentA - m_sleepCurrentA) * m_source->GetSupplyVoltage();
+}
+
 void
 LoraRadioEnergyModel::SetLoraRadioState(const EndDeviceLoraPhy::State state)
 {
@@ -392,6 +503,17 @@ LoraRadioEnergyModelPhyListener::SetUpdateTxCurrentCallback(UpdateTxCurrentCallb
     m_updateTxCurrentCallback = callback;
 }
 
+void
+LoraRadioEnergyModelPhyListener::SetLazyReceiveWindowCallbacks(
+    LazyReceiveWindowCallback windowCallback,
+    Callback<void> clearedCallback)
+{
+    NS_LOG_FUNCTION(this);
+    NS_ASSERT(!windowCallback.IsNull() && !clearedCallback.IsNull());
+    m_lazyReceiveWindowCallback = windowCallback;
+    m_lazyReceiveWindowsClearedCallback = clearedCallback;
+}
+
 void
 LoraRadioEnergyModelPhyListener::NotifyRxStart()
 {
@@ -441,6 +563,28 @@ LoraRadioEnergyModelPhyListener::NotifyStandby()
     m_changeStateCallback(EndDeviceLoraPhy::STANDBY);
 }
 
+void
+LoraRadioEnergyModelPhyListener::NotifyLazyReceiveWindow(Time start, Time end)
+{
+    NS_LOG_FUNCTION(this << start << end);
+    if (m_lazyReceiveWindowCallback.IsNull())
+    {
+        NS_FATAL_ERROR("LoraRadioEnergyModelPhyListener:Lazy receive window callback not set!");
+    }
+    m_lazyReceiveWindowCallback(start, end);
+}
+
+void
+LoraRadioEnergyModelPhyListener::NotifyLazyReceiveWindowsCleared()
+{
+    NS_LOG_FUNCTION(this);
+    if (m_lazyReceiveWindowsClearedCallback.IsNull())
+    {
+        NS_FATAL_ERROR("LoraRadioEnergyModelPhyListener:Lazy receive window callback not set!");
+    }
+    m_lazyReceiveWindowsClearedCallback();
+}
+
 /*
  * Private function state here.
  */
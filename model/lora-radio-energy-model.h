@@ -36,6 +36,11 @@ class LoraRadioEnergyModelPhyListener : public EndDeviceLoraPhyListener
      */
     typedef Callback<void, double> UpdateTxCurrentCallback;
 
+    /**
+     * Callback type for announcing a lazy receive window.
+     */
+    typedef Callback<void, Time, Time> LazyReceiveWindowCallback;
+
     LoraRadioEnergyModelPhyListener();           //!< Default constructor
     ~LoraRadioEnergyModelPhyListener() override; //!< Destructor
 
@@ -53,6 +58,15 @@ class LoraRadioEnergyModelPhyListener : public EndDeviceLoraPhyListener
      */
     void SetUpdateTxCurrentCallback(UpdateTxCurrentCallback callback);
 
+    /**
+     * Sets the callbacks used to forward lazy receive windows.
+     *
+     * \param windowCallback Callback invoked when a window is announced.
+     * \param clearedCallback Callback invoked when the windows are dropped.
+     */
+    void SetLazyReceiveWindowCallbacks(LazyReceiveWindowCallback windowCallback,
+                                       Callback<void> clearedCallback);
+
     /**
      * Switches the LoraRadioEnergyModel to RX state.
      *
@@ -80,6 +94,21 @@ class LoraRadioEnergyModelPhyListener : public EndDeviceLoraPhyListener
      */
     void NotifyStandby() override;
 
+    /**
+     * Forwards the window to the LoraRadioEnergyModel.
+     *
+     * \param start The time the window begins.
+     * \param end The time the window ends.
+     *
+     * Defined in ns3::LoraEndDevicePhyListener.
+     */
+    void NotifyLazyReceiveWindow(Time start, Time end) override;
+
+    /**
+     * Defined in ns3::LoraEndDevicePhyListener.
+     */
+    void NotifyLazyReceiveWindowsCleared() override;
+
   private:
     /**
      * A helper function that makes scheduling m_changeStateCallback possible.
@@ -97,6 +126,12 @@ class LoraRadioEnergyModelPhyListener : public EndDeviceLoraPhyListener
      * the nominal tx power used to transmit the current frame.
      */
     UpdateTxCurrentCallback m_updateTxCurrentCallback;
+
+    /// Callback used to forward lazy receive windows to the LoraRadioEnergyModel.
+    LazyReceiveWindowCallback m_lazyReceiveWindowCallback;
+
+    /// Callback used to notify the LoraRadioEnergyModel that lazy windows were dropped.
+    Callback<void> m_lazyReceiveWindowsClearedCallback;
 };
 
 /**
@@ -118,6 +153,16 @@ class LoraRadioEnergyModelPhyListener : public EndDeviceLoraPhyListener
  * Energy calculation: For each transaction, this model notifies EnergySource
  * object. The EnergySource object will query this model for the total current.
  * Then the EnergySource object uses the total current to calculate energy.
+ *
+ * Lazy receive windows announced by the PHY while in SLEEP are charged at the
+ * STANDBY current in closed form, when the radio leaves the SLEEP state or
+ * when the total energy consumption is queried, so that totals match those of
+ * a radio that switched to STANDBY for the windows. Energy sources are not
+ * notified at the edges of lazy windows: in SLEEP, the current reported to the
+ * source is the average one since the source last asked for it, so that the
+ * source is charged for the windows at its next update (e.g., when its
+ * remaining energy is queried). This assumes that only the source asks this
+ * model for its current.
  */
 class LoraRadioEnergyModel : public DeviceEnergyModel
 {
@@ -276,11 +321,25 @@ class LoraRadioEnergyModel : public DeviceEnergyModel
      */
     LoraRadioEnergyModelPhyListener* GetPhyListener();
 
+    /**
+     * Charge an interval spent in SLEEP at the STANDBY current.
+     *
+     * \param start The time the interval begins.
+     * \param end The time the interval ends.
+     */
+    void AddLazyReceiveWindow(Time start, Time end);
+
+    /**
+     * Drop the intervals added with AddLazyReceiveWindow that are not over.
+     */
+    void ClearLazyReceiveWindows();
+
   private:
     void DoDispose() override;
 
     /**
-     * \return Current draw of device, at current state.
+     * \return Current draw of device, at current state. In SLEEP, this is the
+     * average current since the previous call, including lazy receive windows.
      *
      * Implements DeviceEnergyModel::GetCurrentA.
      */
@@ -294,6 +353,16 @@ class LoraRadioEnergyModel : public DeviceEnergyModel
      */
     void SetLoraRadioState(const EndDeviceLoraPhy::State state);
 
+    /**
+     * Compute the energy spent in excess of the SLEEP current because of lazy
+     * receive windows.
+     *
+     * \param start The beginning of the interval spent in SLEEP.
+     * \param end The end of the interval spent in SLEEP.
+     * \return The energy [J] to charge on top of the SLEEP current.
+     */
+    double GetLazyReceiveWindowEnergy(Time start, Time end) const;
+
     Ptr<EnergySource> m_source; ///< energy source
 
     // Member variables for current draw in different radio modes.
@@ -310,6 +379,7 @@ class LoraRadioEnergyModel : public DeviceEnergyModel
     // State variables.
     EndDeviceLoraPhy::State m_currentState; ///< current state the radio is in
     Time m_lastUpdateTime;                  ///< time stamp of previous energy update
+    mutable Time m_lastSourceUpdateTime;    ///< time the source last asked for the current
 
     uint8_t m_nPendingChangeState;  ///< pending state change
     bool m_isSupersededChangeState; ///< superseded change state
@@ -322,6 +392,9 @@ class LoraRadioEnergyModel : public DeviceEnergyModel
 
     /// EndDeviceLoraPhy listener
     LoraRadioEnergyModelPhyListener* m_listener;
+
+    /// Lazy receive windows to charge at the STANDBY current
+    std::vector<std::pair<Time, Time>> m_lazyReceiveWindows;
 };
 
 } // namespace lorawan
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2017 University of Padova
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#include "lorawan-frame-view.h"
+
+#include "ns3/log.h"
+
+namespace ns3
+{
+namespace lorawan
+{
+
+NS_LOG_COMPONENT_DEFINE("LorawanFrameView");
+
+LorawanFrameView::LorawanFrameView()
+    : m_mType(LorawanMacHeader::PROPRIETARY),
+      m_address(LoraDeviceAddress(0, 0)),
+      m_fCtrl(0),
+      m_fCnt(0),
+      m_size(0)
+{
+}
+
+LorawanFrameView::LorawanFrameView(Ptr<const Packet> packet)
+    : LorawanFrameView()
+{
+    packet->PeekHeader(*this);
+}
+
+LorawanFrameView::~LorawanFrameView()
+{
+}
+
+TypeId
+LorawanFrameView::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("LorawanFrameView").SetParent<Header>().AddConstructor<LorawanFrameView>();
+    return tid;
+}
+
+TypeId
+LorawanFrameView::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+uint32_t
+LorawanFrameView::GetSerializedSize() const
+{
+    return m_size;
+}
+
+void
+LorawanFrameView::Serialize(Buffer::Iterator start) const
+{
+    NS_FATAL_ERROR("LorawanFrameView is read-only");
+}
+
+uint32_t
+LorawanFrameView::Deserialize(Buffer::Iterator start)
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    m_macCommands.Clear();
+
+    // MHDR, with the layout of LorawanMacHeader
+    m_mType = start.ReadU8() >> 5;
+    m_size = 1;
+    if (!IsDataMessage())
+    {
+        m_fCtrl = 0;
+        return m_size;
+    }
+
+    // FHDR, with the layout of LoraFrameHeader
+    m_address.Set(start.ReadU32());
+    m_fCtrl = start.ReadU8();
+    m_fCnt = start.ReadU16();
+    m_size += 7;
+
+    uint8_t fOptsLen = GetFOptsLen();
+    for (uint8_t byteNumber = 0; byteNumber < fOptsLen;)
+    {
+        MacCommandValue command;
+        uint8_t size = DeserializeMacCommand(start, IsUplink(), command);
+        if (size == 0)
+        {
+            // The length of an unknown command is unknown too: skip the rest of FOpts
+            break;
+        }
+        byteNumber += size;
+        m_macCommands.Add(command);
+    }
+    m_size += fOptsLen;
+
+    NS_LOG_DEBUG("Parsed frame of MType " << unsigned(m_mType) << " from " << m_address.Print()
+                                          << ", FCnt " << m_fCnt);
+
+    return m_size;
+}
+
+void
+LorawanFrameView::Print(std::ostream& os) const
+{
+    os << "MessageType=" << unsigned(m_mType) << std::endl;
+    if (IsDataMessage())
+    {
+        os << "Address=" << m_address.Print() << std::endl;
+        os << "ADR=" << GetAdr() << std::endl;
+        os << "ADRAckReq=" << GetAdrAckReq() << std::endl;
+        os << "ACK=" << GetAck() << std::endl;
+        os << "FPending=" << GetFPending() << std::endl;
+        os << "FOptsLen=" << unsigned(GetFOptsLen()) << std::endl;
+        os << "FCnt=" << unsigned(m_fCnt) << std::endl;
+        for (std::size_t i = 0; i < m_macCommands.GetN(); i++)
+        {
+            PrintMacCommand(m_macCommands.Get(i), os);
+        }
+    }
+}
+
+uint8_t
+LorawanFrameView::GetMType() const
+{
+    return m_mType;
+}
+
+bool
+LorawanFrameView::IsUplink() const
+{
+    return (m_mType == LorawanMacHeader::JOIN_REQUEST) ||
+           (m_mType == LorawanMacHeader::UNCONFIRMED_DATA_UP) ||
+           (m_mType == LorawanMacHeader::CONFIRMED_DATA_UP);
+}
+
+bool
+LorawanFrameView::IsDataMessage() const
+{
+    return (m_mType == LorawanMacHeader::UNCONFIRMED_DATA_UP) ||
+           (m_mType == LorawanMacHeader::UNCONFIRMED_DATA_DOWN) ||
+           (m_mType == LorawanMacHeader::CONFIRMED_DATA_UP) ||
+           (m_mType == LorawanMacHeader::CONFIRMED_DATA_DOWN);
+}
+
+LoraDeviceAddress
+LorawanFrameView::GetAddress() const
+{
+    return m_address;
+}
+
+uint16_t
+LorawanFrameView::GetFCnt() const
+{
+    return m_fCnt;
+}
+
+bool
+LorawanFrameView::GetAdr() const
+{
+    return (m_fCtrl >> 7) & 0b1;
+}
+
+bool
+LorawanFrameView::GetAdrAckReq() const
+{
+    return (m_fCtrl >> 6) & 0b1;
+}
+
+bool
+LorawanFrameView::GetAck() const
+{
+    return (m_fCtrl >> 5) & 0b1;
+}
+
+bool
+LorawanFrameView::GetFPending() const
+{
+    return (m_fCtrl >> 4) & 0b1;
+}
+
+uint8_t
+LorawanFrameView::GetFOptsLen() const
+{
+    return m_fCtrl & 0b1111;
+}
+
+const MacCommandList&
+LorawanFrameView::GetCommands() const
+{
+    return m_macCommands;
+}
+
+} // namespace lorawan
+} // namespace ns3
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2017 University of Padova
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#ifndef LORAWAN_FRAME_VIEW_H
+#define LORAWAN_FRAME_VIEW_H
+
+#include "lora-device-address.h"
+#include "lorawan-mac-header.h"
+#include "mac-command-value.h"
+
+#include "ns3/header.h"
+#include "ns3/packet.h"
+
+namespace ns3
+{
+namespace lorawan
+{
+
+/**
+ * \ingroup lorawan
+ *
+ * A read-only view of the MHDR and FHDR of a LoRaWAN frame.
+ *
+ * Reading the headers of a received packet with LorawanMacHeader and
+ * LoraFrameHeader requires copying the packet and removing the headers from
+ * the copy. A view is filled with Packet::PeekHeader instead, which parses the
+ * MType, DevAddr, FCtrl, FCnt and FOpts fields in place from the buffer of the
+ * packet, leaving the packet untouched.
+ *
+ * The direction of the frame, which is needed to tell uplink and downlink MAC
+ * commands apart, is taken from the MType. Frames that are not data messages
+ * only have their MHDR parsed.
+ *
+ * \remark A view can't be serialized: use LorawanMacHeader and LoraFrameHeader
+ * to build frames.
+ */
+class LorawanFrameView : public Header
+{
+  public:
+    LorawanFrameView(); //!< Default constructor
+
+    /**
+     * Construct the view of the headers of a packet.
+     *
+     * \param packet The packet, starting with the MHDR.
+     */
+    LorawanFrameView(Ptr<const Packet> packet);
+
+    ~LorawanFrameView() override; //!< Destructor
+
+    // Methods inherited from Header
+
+    /**
+     *  Register this type.
+     *  \return The object TypeId.
+     */
+    static TypeId GetTypeId();
+    TypeId GetInstanceTypeId() const override;
+
+    /**
+     * Return the number of bytes parsed by the last call to Deserialize.
+     *
+     * \return The size of the MHDR and FHDR, FPort excluded, in bytes.
+     */
+    uint32_t GetSerializedSize() const override;
+
+    /**
+     * Not supported, since the view is read-only.
+     *
+     * \param start A pointer to the buffer that would be filled.
+     */
+    void Serialize(Buffer::Iterator start) const override;
+
+    /**
+     * Parse the MHDR and FHDR of a frame.
+     *
+     * \param start A pointer to the buffer we need to parse.
+     * \return The number of parsed bytes.
+     */
+    uint32_t Deserialize(Buffer::Iterator start) override;
+
+    /**
+     * Print the parsed fields in a human-readable format.
+     *
+     * \param os The std::ostream on which to print the fields.
+     */
+    void Print(std::ostream& os) const override;
+
+    /**
+     * Get the message type.
+     *
+     * \return The MType, as in LorawanMacHeader::MType.
+     */
+    uint8_t GetMType() const;
+
+    /**
+     * Check whether the frame is an uplink message.
+     *
+     * \return True if the frame is an uplink message.
+     */
+    bool IsUplink() const;
+
+    /**
+     * Check whether the frame is a data message, and hence has a FHDR.
+     *
+     * \return True if the MType is one of the data messages.
+     */
+    bool IsDataMessage() const;
+
+    /**
+     * Get the DevAddr field.
+     *
+     * \return The address of the end device.
+     */
+    LoraDeviceAddress GetAddress() const;
+
+    /**
+     * Get the FCnt field.
+     *
+     * \return The frame counter.
+     */
+    uint16_t GetFCnt() const;
+
+    /**
+     * Get the ADR bit of the FCtrl field.
+     *
+     * \return The value of the ADR bit.
+     */
+    bool GetAdr() const;
+
+    /**
+     * Get the ADRACKReq bit of the FCtrl field.
+     *
+     * \return The value of the ADRACKReq bit.
+     */
+    bool GetAdrAckReq() const;
+
+    /**
+     * Get the ACK bit of the FCtrl field.
+     *
+     * \return The value of the ACK bit.
+     */
+    bool GetAck() const;
+
+    /**
+     * Get the FPending bit of the FCtrl field.
+     *
+     * \return The value of the FPending bit.
+     */
+    bool GetFPending() const;
+
+    /**
+     * Get the FOptsLen field of the FCtrl field.
+     *
+     * \return The length of the FOpts field, in bytes.
+     */
+    uint8_t GetFOptsLen() const;
+
+    /**
+     * Get the MAC commands of the FOpts field.
+     *
+     * \return The list of MAC commands.
+     */
+    const MacCommandList& GetCommands() const;
+
+    /**
+     * Find the first MAC command of a given type in the FOpts field.
+     *
+     * \tparam T The struct of the command, e.g., LinkCheckReqValue.
+     * \return A pointer to the fields of the command, or nullptr if the frame
+     * doesn't contain such a command.
+     */
+    template <typename T>
+    const T* FindMacCommand() const;
+
+  private:
+    uint8_t m_mType;              //!< The MType field of the MHDR
+    LoraDeviceAddress m_address;  //!< The DevAddr field
+    uint8_t m_fCtrl;              //!< The FCtrl field
+    uint16_t m_fCnt;              //!< The FCnt field
+    MacCommandList m_macCommands; //!< The MAC commands of the FOpts field
+    uint32_t m_size;              //!< The number of bytes parsed
+};
+
+template <typename T>
+const T*
+LorawanFrameView::FindMacCommand() const
+{
+    return m_macCommands.Find<T>();
+}
+
+} // namespace lorawan
+} // namespace ns3
+
+#endif /* LORAWAN_FRAME_VIEW_H */
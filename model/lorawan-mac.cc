@@ -173,6 +173,38 @@ LorawanMac::GetNPreambleSymbols() const
     return m_nPreambleSymbols;
 }
 
+Time
+LorawanMac::GetMaxOnAirTime()
+{
+    NS_LOG_FUNCTION(this);
+
+    // MAC header, frame header with the longest options and frame port
+    const uint32_t maxOverhead = 1 + 7 + 15 + 1;
+
+    Time maxOnAirTime = Seconds(0);
+    for (uint8_t dataRate = 0;
+         dataRate < m_sfForDataRate.size() && dataRate < m_bandwidthForDataRate.size() &&
+         dataRate < m_maxAppPayloadForDataRate.size();
+         dataRate++)
+    {
+        LoraTxParameters params;
+        params.sf = GetSfFromDataRate(dataRate);
+        params.bandwidthHz = GetBandwidthFromDataRate(dataRate);
+        if (params.sf == 0 || params.bandwidthHz == 0)
+        {
+            continue;
+        }
+        params.nPreamble = m_nPreambleSymbols;
+        params.crcEnabled = true;
+        params.lowDataRateOptimizationEnabled = LoraPhy::GetTSym(params) > MilliSeconds(16);
+
+        Ptr<Packet> frame = Create<Packet>(m_maxAppPayloadForDataRate.at(dataRate) + maxOverhead);
+        maxOnAirTime = Max(maxOnAirTime, LoraPhy::GetOnAirTime(frame, params));
+    }
+
+    return maxOnAirTime;
+}
+
 void
 LorawanMac::SetReplyDataRateMatrix(ReplyDataRateMatrix replyDataRateMatrix)
 {
@@ -212,6 +212,17 @@ class LorawanMac : public Object
      */
     int GetNPreambleSymbols() const;
 
+    /**
+     * Get the longest time on air of an uplink frame in this MAC's region.
+     *
+     * This is the time on air of a frame carrying the maximum application
+     * payload, the longest frame header and the frame port, at the data rate
+     * for which it is longest.
+     *
+     * \return The longest time on air, or zero if no data rate is configured.
+     */
+    Time GetMaxOnAirTime();
+
   protected:
     /**
      * The trace source that is fired when a packet cannot be sent because of duty
@@ -0,0 +1,511 @@
+/*
+ * Copyright (c) 2017 University of Padova
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#include "mac-command-value.h"
+
+#include "ns3/log.h"
+
+#include <cmath>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+NS_LOG_COMPONENT_DEFINE("MacCommandValue");
+
+/// The type of each alternative of MacCommandValue
+static const MacCommandType MAC_COMMAND_TYPES[] = {LINK_CHECK_REQ,
+                                                   LINK_CHECK_ANS,
+                                                   LINK_ADR_REQ,
+                                                   LINK_ADR_ANS,
+                                                   DUTY_CYCLE_REQ,
+                                                   DUTY_CYCLE_ANS,
+                                                   RX_PARAM_SETUP_REQ,
+                                                   RX_PARAM_SETUP_ANS,
+                                                   DEV_STATUS_REQ,
+                                                   DEV_STATUS_ANS,
+                                                   NEW_CHANNEL_REQ,
+                                                   NEW_CHANNEL_ANS,
+                                                   RX_TIMING_SETUP_REQ,
+                                                   RX_TIMING_SETUP_ANS,
+                                                   TX_PARAM_SETUP_REQ,
+                                                   TX_PARAM_SETUP_ANS,
+                                                   DL_CHANNEL_ANS};
+
+/// The serialized size of each alternative of MacCommandValue, as in the MacCommand subclasses
+static const uint8_t MAC_COMMAND_SIZES[] = {1, 3, 5, 2, 2, 1, 5, 2, 1, 3, 6, 2, 2, 1, 1, 1, 1};
+
+static_assert(sizeof(MAC_COMMAND_TYPES) / sizeof(MAC_COMMAND_TYPES[0]) ==
+                      std::variant_size_v<MacCommandValue> &&
+                  sizeof(MAC_COMMAND_SIZES) == std::variant_size_v<MacCommandValue>,
+              "A MacCommandValue alternative is missing its type or size");
+
+std::list<int>
+LinkAdrReqValue::GetEnabledChannelsList() const
+{
+    std::list<int> channelIndices;
+    for (int i = 0; i < 16; i++)
+    {
+        if (channelMask & (0b1 << i)) // Take channel mask's i-th bit
+        {
+            channelIndices.push_back(i);
+        }
+    }
+    return channelIndices;
+}
+
+double
+DutyCycleReqValue::GetMaximumAllowedDutyCycle() const
+{
+    // Check if we need to turn off completely
+    if (maxDCycle == 255)
+    {
+        return 0;
+    }
+
+    if (maxDCycle == 0)
+    {
+        return 1;
+    }
+
+    return 1 / std::pow(2, double(maxDCycle));
+}
+
+enum MacCommandType
+GetMacCommandType(const MacCommandValue& command)
+{
+    return MAC_COMMAND_TYPES[command.index()];
+}
+
+uint8_t
+GetMacCommandSize(const MacCommandValue& command)
+{
+    return MAC_COMMAND_SIZES[command.index()];
+}
+
+/**
+ * Write a frequency in Hz as the 24-bit Frequency field, in units of 100 Hz,
+ * most significant byte first.
+ *
+ * \param frequency The frequency, in Hz.
+ * \param start The buffer iterator to write to.
+ */
+static void
+WriteFrequency(double frequency, Buffer::Iterator& start)
+{
+    auto encodedFrequency = uint32_t(frequency / 100);
+    start.WriteU8((encodedFrequency & 0xff0000) >> 16); // Most significant byte
+    start.WriteU8((encodedFrequency & 0xff00) >> 8);    // Middle byte
+    start.WriteU8(encodedFrequency & 0xff);             // Least significant byte
+}
+
+/**
+ * Read a 24-bit Frequency field.
+ *
+ * \param start The buffer iterator to read from.
+ * \return The frequency, in Hz.
+ */
+static double
+ReadFrequency(Buffer::Iterator& start)
+{
+    uint32_t encodedFrequency = uint32_t(start.ReadU8()) << 16;
+    encodedFrequency |= uint32_t(start.ReadU8()) << 8;
+    encodedFrequency |= uint32_t(start.ReadU8());
+    return double(encodedFrequency) * 100;
+}
+
+void
+SerializeMacCommand(const MacCommandValue& command, Buffer::Iterator& start)
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    // Write the CID
+    start.WriteU8(MacCommand::GetCIDFromMacCommand(GetMacCommandType(command)));
+
+    // Write the data, with the same encoding as the MacCommand subclasses
+    if (const auto* linkCheckAns = std::get_if<LinkCheckAnsValue>(&command))
+    {
+        start.WriteU8(linkCheckAns->margin);
+        start.WriteU8(linkCheckAns->gwCnt);
+    }
+    else if (const auto* linkAdrReq = std::get_if<LinkAdrReqValue>(&command))
+    {
+        start.WriteU8(linkAdrReq->dataRate << 4 | (linkAdrReq->txPower & 0b1111));
+        start.WriteU16(linkAdrReq->channelMask);
+        start.WriteU8(linkAdrReq->chMaskCntl << 4 | (linkAdrReq->nbRep & 0b1111));
+    }
+    else if (const auto* linkAdrAns = std::get_if<LinkAdrAnsValue>(&command))
+    {
+        start.WriteU8((uint8_t(linkAdrAns->powerAck) << 2) |
+                      (uint8_t(linkAdrAns->dataRateAck) << 1) |
+                      uint8_t(linkAdrAns->channelMaskAck));
+    }
+    else if (const auto* dutyCycleReq = std::get_if<DutyCycleReqValue>(&command))
+    {
+        start.WriteU8(dutyCycleReq->maxDCycle);
+    }
+    else if (const auto* rxParamSetupReq = std::get_if<RxParamSetupReqValue>(&command))
+    {
+        start.WriteU8((rxParamSetupReq->rx1DrOffset & 0b111) << 4 |
+                      (rxParamSetupReq->rx2DataRate & 0b1111));
+        WriteFrequency(rxParamSetupReq->frequency, start);
+    }
+    else if (const auto* rxParamSetupAns = std::get_if<RxParamSetupAnsValue>(&command))
+    {
+        start.WriteU8(uint8_t(rxParamSetupAns->rx1DrOffsetAck) << 2 |
+                      uint8_t(rxParamSetupAns->rx2DataRateAck) << 1 |
+                      uint8_t(rxParamSetupAns->channelAck));
+    }
+    else if (const auto* devStatusAns = std::get_if<DevStatusAnsValue>(&command))
+    {
+        start.WriteU8(devStatusAns->battery);
+        start.WriteU8(devStatusAns->margin);
+    }
+    else if (const auto* newChannelReq = std::get_if<NewChannelReqValue>(&command))
+    {
+        start.WriteU8(newChannelReq->chIndex);
+        WriteFrequency(newChannelReq->frequency, start);
+        start.WriteU8((newChannelReq->maxDataRate << 4) | (newChannelReq->minDataRate & 0xf));
+    }
+    else if (const auto* newChannelAns = std::get_if<NewChannelAnsValue>(&command))
+    {
+        start.WriteU8((uint8_t(newChannelAns->dataRateRangeOk) << 1) |
+                      uint8_t(newChannelAns->channelFrequencyOk));
+    }
+    else if (const auto* rxTimingSetupReq = std::get_if<RxTimingSetupReqValue>(&command))
+    {
+        start.WriteU8(rxTimingSetupReq->delay & 0xf);
+    }
+    // The other commands only consist in the CID
+}
+
+uint8_t
+DeserializeMacCommand(Buffer::Iterator& start, bool isUplink, MacCommandValue& command)
+{
+    NS_LOG_FUNCTION(isUplink);
+
+    uint8_t cid = start.PeekU8();
+    NS_LOG_DEBUG("CID: " << unsigned(cid));
+
+    // Uplink and downlink commands have the same CIDs
+    if (isUplink)
+    {
+        switch (cid)
+        {
+        case (0x02): {
+            command = LinkCheckReqValue();
+            break;
+        }
+        case (0x03): {
+            LinkAdrAnsValue linkAdrAns;
+            Buffer::Iterator it = start;
+            it.Next();
+            uint8_t byte = it.ReadU8();
+            linkAdrAns.powerAck = byte & 0b100;
+            linkAdrAns.dataRateAck = byte & 0b10;
+            linkAdrAns.channelMaskAck = byte & 0b1;
+            command = linkAdrAns;
+            break;
+        }
+        case (0x04): {
+            command = DutyCycleAnsValue();
+            break;
+        }
+        case (0x05): {
+            RxParamSetupAnsValue rxParamSetupAns;
+            Buffer::Iterator it = start;
+            it.Next();
+            uint8_t byte = it.ReadU8();
+            rxParamSetupAns.rx1DrOffsetAck = (byte & 0b100) >> 2;
+            rxParamSetupAns.rx2DataRateAck = (byte & 0b10) >> 1;
+            rxParamSetupAns.channelAck = byte & 0b1;
+            command = rxParamSetupAns;
+            break;
+        }
+        case (0x06): {
+            DevStatusAnsValue devStatusAns;
+            Buffer::Iterator it = start;
+            it.Next();
+            devStatusAns.battery = it.ReadU8();
+            devStatusAns.margin = it.ReadU8() & 0b111111;
+            command = devStatusAns;
+            break;
+        }
+        case (0x07): {
+            NewChannelAnsValue newChannelAns;
+            Buffer::Iterator it = start;
+            it.Next();
+            uint8_t byte = it.ReadU8();
+            newChannelAns.dataRateRangeOk = (byte & 0b10) >> 1;
+            newChannelAns.channelFrequencyOk = byte & 0b1;
+            command = newChannelAns;
+            break;
+        }
+        case (0x08): {
+            command = RxTimingSetupAnsValue();
+            break;
+        }
+        case (0x09): {
+            command = TxParamSetupAnsValue();
+            break;
+        }
+        case (0x0A): {
+            command = DlChannelAnsValue();
+            break;
+        }
+        default: {
+            NS_LOG_ERROR("CID not recognized during deserialization");
+            return 0;
+        }
+        }
+    }
+    else
+    {
+        switch (cid)
+        {
+        case (0x02): {
+            LinkCheckAnsValue linkCheckAns;
+            Buffer::Iterator it = start;
+            it.Next();
+            linkCheckAns.margin = it.ReadU8();
+            linkCheckAns.gwCnt = it.ReadU8();
+            command = linkCheckAns;
+            break;
+        }
+        case (0x03): {
+            LinkAdrReqValue linkAdrReq;
+            Buffer::Iterator it = start;
+            it.Next();
+            uint8_t firstByte = it.ReadU8();
+            linkAdrReq.dataRate = firstByte >> 4;
+            linkAdrReq.txPower = firstByte & 0b1111;
+            linkAdrReq.channelMask = it.ReadU16();
+            uint8_t fourthByte = it.ReadU8();
+            linkAdrReq.chMaskCntl = fourthByte >> 4;
+            linkAdrReq.nbRep = fourthByte & 0b1111;
+            command = linkAdrReq;
+            break;
+        }
+        case (0x04): {
+            DutyCycleReqValue dutyCycleReq;
+            Buffer::Iterator it = start;
+            it.Next();
+            dutyCycleReq.maxDCycle = it.ReadU8();
+            command = dutyCycleReq;
+            break;
+        }
+        case (0x05): {
+            RxParamSetupReqValue rxParamSetupReq;
+            Buffer::Iterator it = start;
+            it.Next();
+            uint8_t firstByte = it.ReadU8();
+            rxParamSetupReq.rx1DrOffset = (firstByte & 0b1110000) >> 4;
+            rxParamSetupReq.rx2DataRate = firstByte & 0b1111;
+            rxParamSetupReq.frequency = ReadFrequency(it);
+            command = rxParamSetupReq;
+            break;
+        }
+        case (0x06): {
+            command = DevStatusReqValue();
+            break;
+        }
+        case (0x07): {
+            NewChannelReqValue newChannelReq;
+            Buffer::Iterator it = start;
+            it.Next();
+            newChannelReq.chIndex = it.ReadU8();
+            newChannelReq.frequency = ReadFrequency(it);
+            uint8_t dataRateByte = it.ReadU8();
+            newChannelReq.maxDataRate = dataRateByte >> 4;
+            newChannelReq.minDataRate = dataRateByte & 0xf;
+            command = newChannelReq;
+            break;
+        }
+        case (0x08): {
+            RxTimingSetupReqValue rxTimingSetupReq;
+            Buffer::Iterator it = start;
+            it.Next();
+            rxTimingSetupReq.delay = it.ReadU8() & 0xf;
+            command = rxTimingSetupReq;
+            break;
+        }
+        case (0x09): {
+            command = TxParamSetupReqValue();
+            break;
+        }
+        default: {
+            NS_LOG_ERROR("CID not recognized during deserialization");
+            return 0;
+        }
+        }
+    }
+
+    uint8_t size = GetMacCommandSize(command);
+    start.Next(size);
+    return size;
+}
+
+void
+PrintMacCommand(const MacCommandValue& command, std::ostream& os)
+{
+    // Printing is not performance sensitive, so reuse the MacCommand format
+    ToMacCommand(command)->Print(os);
+}
+
+Ptr<MacCommand>
+ToMacCommand(const MacCommandValue& command)
+{
+    NS_LOG_FUNCTION_NOARGS();
+
+    Ptr<MacCommand> object;
+    switch (GetMacCommandType(command))
+    {
+    case (LINK_CHECK_REQ):
+        object = Create<LinkCheckReq>();
+        break;
+    case (LINK_CHECK_ANS):
+        object = Create<LinkCheckAns>();
+        break;
+    case (LINK_ADR_REQ):
+        object = Create<LinkAdrReq>();
+        break;
+    case (LINK_ADR_ANS):
+        object = Create<LinkAdrAns>();
+        break;
+    case (DUTY_CYCLE_REQ):
+        object = Create<DutyCycleReq>();
+        break;
+    case (DUTY_CYCLE_ANS):
+        object = Create<DutyCycleAns>();
+        break;
+    case (RX_PARAM_SETUP_REQ):
+        object = Create<RxParamSetupReq>();
+        break;
+    case (RX_PARAM_SETUP_ANS):
+        object = Create<RxParamSetupAns>();
+        break;
+    case (DEV_STATUS_REQ):
+        object = Create<DevStatusReq>();
+        break;
+    case (DEV_STATUS_ANS):
+        object = Create<DevStatusAns>();
+        break;
+    case (NEW_CHANNEL_REQ):
+        object = Create<NewChannelReq>();
+        break;
+    case (NEW_CHANNEL_ANS):
+        object = Create<NewChannelAns>();
+        break;
+    case (RX_TIMING_SETUP_REQ):
+        object = Create<RxTimingSetupReq>();
+        break;
+    case (RX_TIMING_SETUP_ANS):
+        object = Create<RxTimingSetupAns>();
+        break;
+    case (TX_PARAM_SETUP_REQ):
+        object = Create<TxParamSetupReq>();
+        break;
+    case (TX_PARAM_SETUP_ANS):
+        object = Create<TxParamSetupAns>();
+        break;
+    case (DL_CHANNEL_ANS):
+        object = Create<DlChannelAns>();
+        break;
+    default:
+        NS_FATAL_ERROR("MAC command type without MacCommand subclass");
+    }
+
+    // The wire format is the contract between the two representations
+    Buffer buffer;
+    buffer.AddAtStart(GetMacCommandSize(command));
+    Buffer::Iterator it = buffer.Begin();
+    SerializeMacCommand(command, it);
+    it = buffer.Begin();
+    object->Deserialize(it);
+
+    return object;
+}
+
+MacCommandValue
+ToMacCommandValue(Ptr<const MacCommand> command)
+{
+    NS_LOG_FUNCTION(command);
+
+    // Only LinkCheckReq and answers other than LinkCheckAns travel in uplink
+    bool isUplink;
+    switch (command->GetCommandType())
+    {
+    case (LINK_CHECK_REQ):
+    case (LINK_ADR_ANS):
+    case (DUTY_CYCLE_ANS):
+    case (RX_PARAM_SETUP_ANS):
+    case (DEV_STATUS_ANS):
+    case (NEW_CHANNEL_ANS):
+    case (RX_TIMING_SETUP_ANS):
+    case (TX_PARAM_SETUP_ANS):
+    case (DL_CHANNEL_ANS):
+        isUplink = true;
+        break;
+    default:
+        isUplink = false;
+    }
+
+    Buffer buffer;
+    buffer.AddAtStart(command->GetSerializedSize());
+    Buffer::Iterator it = buffer.Begin();
+    command->Serialize(it);
+    it = buffer.Begin();
+
+    MacCommandValue value;
+    uint8_t size = DeserializeMacCommand(it, isUplink, value);
+    NS_ABORT_MSG_IF(size == 0, "MacCommand without MacCommandValue alternative");
+
+    return value;
+}
+
+MacCommandList::MacCommandList()
+    : m_size(0)
+{
+}
+
+void
+MacCommandList::Add(const MacCommandValue& command)
+{
+    if (m_size < INLINE_COMMANDS)
+    {
+        m_inline[m_size] = command;
+    }
+    else
+    {
+        m_overflow.push_back(command);
+    }
+    m_size++;
+}
+
+void
+MacCommandList::Clear()
+{
+    m_overflow.clear();
+    m_size = 0;
+}
+
+std::size_t
+MacCommandList::GetN() const
+{
+    return m_size;
+}
+
+const MacCommandValue&
+MacCommandList::Get(std::size_t i) const
+{
+    NS_ASSERT(i < m_size);
+
+    return i < INLINE_COMMANDS ? m_inline[i] : m_overflow[i - INLINE_COMMANDS];
+}
+
+} // namespace lorawan
+} // namespace ns3
@@ -0,0 +1,383 @@
+/*
+ * Copyright (c) 2017 University of Padova
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#ifndef MAC_COMMAND_VALUE_H
+#define MAC_COMMAND_VALUE_H
+
+#include "mac-command.h"
+
+#include "ns3/buffer.h"
+#include "ns3/ptr.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <ostream>
+#include <variant>
+#include <vector>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+/**
+ * \ingroup lorawan
+ *
+ * The fields of a LinkCheckReq command, which has none.
+ */
+struct LinkCheckReqValue
+{
+};
+
+/**
+ * \ingroup lorawan
+ *
+ * The fields of a LinkCheckAns command.
+ */
+struct LinkCheckAnsValue
+{
+    uint8_t margin = 0; //!< The demodulation margin
+    uint8_t gwCnt = 0;  //!< The gateway count
+};
+
+/**
+ * \ingroup lorawan
+ *
+ * The fields of a LinkAdrReq command.
+ */
+struct LinkAdrReqValue
+{
+    uint8_t dataRate = 0;     //!< The DataRate field
+    uint8_t txPower = 0;      //!< The TXPower field
+    uint16_t channelMask = 0; //!< The ChMask field
+    uint8_t chMaskCntl = 0;   //!< The ChMaskCntl field
+    uint8_t nbRep = 0;        //!< The NbTrans field
+
+    /**
+     * Get the indices of the channels enabled by the ChMask field.
+     *
+     * \return The list of enabled channel indices.
+     */
+    std::list<int> GetEnabledChannelsList() const;
+};
+
+/**
+ * \ingroup lorawan
+ *
+ * The fields of a LinkAdrAns command.
+ */
+struct LinkAdrAnsValue
+{
+    bool powerAck = false;       //!< The PowerACK field
+    bool dataRateAck = false;    //!< The DataRateACK field
+    bool channelMaskAck = false; //!< The ChannelMaskACK field
+};
+
+/**
+ * \ingroup lorawan
+ *
+ * The fields of a DutyCycleReq command.
+ */
+struct DutyCycleReqValue
+{
+    uint8_t maxDCycle = 0; //!< The MaxDutyCycle field
+
+    /**
+     * Get the maximum duty cycle encoded by the MaxDutyCycle field.
+     *
+     * \return The duty cycle, in fraction form.
+     */
+    double GetMaximumAllowedDutyCycle() const;
+};
+
+/**
+ * \ingroup lorawan
+ *
+ * The fields of a DutyCycleAns command, which has none.
+ */
+struct DutyCycleAnsValue
+{
+};
+
+/**
+ * \ingroup lorawan
+ *
+ * The fields of a RxParamSetupReq command.
+ */
+struct RxParamSetupReqValue
+{
+    uint8_t rx1DrOffset = 0; //!< The RX1DROffset field
+    uint8_t rx2DataRate = 0; //!< The RX2DataRate field
+    double frequency = 0;    //!< The Frequency field, _in Hz_
+};
+
+/**
+ * \ingroup lorawan
+ *
+ * The fields of a RxParamSetupAns command.
+ */
+struct RxParamSetupAnsValue
+{
+    bool rx1DrOffsetAck = false; //!< The RX1DROffsetACK field
+    bool rx2DataRateAck = false; //!< The RX2DataRateACK field
+    bool channelAck = false;     //!< The ChannelACK field
+};
+
+/**
+ * \ingroup lorawan
+ *
+ * The fields of a DevStatusReq command, which has none.
+ */
+struct DevStatusReqValue
+{
+};
+
+/**
+ * \ingroup lorawan
+ *
+ * The fields of a DevStatusAns command.
+ */
+struct DevStatusAnsValue
+{
+    uint8_t battery = 0; //!< The Battery field
+    uint8_t margin = 0;  //!< The RadioStatus field
+};
+
+/**
+ * \ingroup lorawan
+ *
+ * The fields of a NewChannelReq command.
+ */
+struct NewChannelReqValue
+{
+    uint8_t chIndex = 0;     //!< The ChIndex field
+    double frequency = 0;    //!< The Frequency field, in Hz
+    uint8_t minDataRate = 0; //!< The MinDR field
+    uint8_t maxDataRate = 0; //!< The MaxDR field
+};
+
+/**
+ * \ingroup lorawan
+ *
+ * The fields of a NewChannelAns command.
+ */
+struct NewChannelAnsValue
+{
+    bool dataRateRangeOk = false;    //!< The Data-rate range ok field
+    bool channelFrequencyOk = false; //!< The Channel frequency ok field
+};
+
+/**
+ * \ingroup lorawan
+ *
+ * The fields of a RxTimingSetupReq command.
+ */
+struct RxTimingSetupReqValue
+{
+    uint8_t delay = 0; //!< The Del field
+};
+
+/**
+ * \ingroup lorawan
+ *
+ * The fields of a RxTimingSetupAns command, which has none.
+ */
+struct RxTimingSetupAnsValue
+{
+};
+
+/**
+ * \ingroup lorawan
+ *
+ * The fields of a TxParamSetupReq command, which are not modeled.
+ */
+struct TxParamSetupReqValue
+{
+};
+
+/**
+ * \ingroup lorawan
+ *
+ * The fields of a TxParamSetupAns command, which has none.
+ */
+struct TxParamSetupAnsValue
+{
+};
+
+/**
+ * \ingroup lorawan
+ *
+ * The fields of a DlChannelAns command, which are not modeled.
+ */
+struct DlChannelAnsValue
+{
+};
+
+/**
+ * \ingroup lorawan
+ *
+ * A MAC command stored by value, without the heap allocation of a MacCommand
+ * object. The alternatives follow the order of the MacCommandType enum.
+ */
+using MacCommandValue = std::variant<LinkCheckReqValue,
+                                     LinkCheckAnsValue,
+                                     LinkAdrReqValue,
+                                     LinkAdrAnsValue,
+                                     DutyCycleReqValue,
+                                     DutyCycleAnsValue,
+                                     RxParamSetupReqValue,
+                                     RxParamSetupAnsValue,
+                                     DevStatusReqValue,
+                                     DevStatusAnsValue,
+                                     NewChannelReqValue,
+                                     NewChannelAnsValue,
+                                     RxTimingSetupReqValue,
+                                     RxTimingSetupAnsValue,
+                                     TxParamSetupReqValue,
+                                     TxParamSetupAnsValue,
+                                     DlChannelAnsValue>;
+
+/**
+ * Get the type of a MAC command.
+ *
+ * \param command The MAC command.
+ * \return The type of the command.
+ */
+enum MacCommandType GetMacCommandType(const MacCommandValue& command);
+
+/**
+ * Get the serialized size of a MAC command, CID included.
+ *
+ * \param command The MAC command.
+ * \return The number of bytes the command takes up.
+ */
+uint8_t GetMacCommandSize(const MacCommandValue& command);
+
+/**
+ * Serialize a MAC command according to the LoRaWAN standard.
+ *
+ * \param command The MAC command.
+ * \param start The buffer iterator to write to, which is advanced.
+ */
+void SerializeMacCommand(const MacCommandValue& command, Buffer::Iterator& start);
+
+/**
+ * Deserialize a MAC command.
+ *
+ * Uplink and downlink commands share their CIDs, so the direction of the frame
+ * is needed to tell them apart.
+ *
+ * \param start The buffer iterator to read from, which is advanced past the
+ * command if its CID is known.
+ * \param isUplink Whether the command comes from an uplink frame.
+ * \param command The MAC command to fill.
+ * \return The number of bytes consumed, or 0 if the CID is not recognized.
+ */
+uint8_t DeserializeMacCommand(Buffer::Iterator& start, bool isUplink, MacCommandValue& command);
+
+/**
+ * Print a MAC command in the format of MacCommand::Print.
+ *
+ * \param command The MAC command.
+ * \param os The std::ostream instance on which to print the MAC command.
+ */
+void PrintMacCommand(const MacCommandValue& command, std::ostream& os);
+
+/**
+ * Create a MacCommand object with the fields of a MAC command value, for code
+ * using the Ptr-based API.
+ *
+ * \param command The MAC command.
+ * \return A new MacCommand object of the corresponding subclass.
+ */
+Ptr<MacCommand> ToMacCommand(const MacCommandValue& command);
+
+/**
+ * Get the value of the fields of a MacCommand object.
+ *
+ * \param command The MAC command object.
+ * \return The MAC command value.
+ */
+MacCommandValue ToMacCommandValue(Ptr<const MacCommand> command);
+
+/**
+ * \ingroup lorawan
+ *
+ * The list of MAC commands of a frame, stored by value.
+ *
+ * The first few commands are stored inline, so that most frames don't need
+ * any heap allocation to hold their commands.
+ */
+class MacCommandList
+{
+  public:
+    MacCommandList(); //!< Default constructor
+
+    /**
+     * Add a command at the end of the list.
+     *
+     * \param command The MAC command.
+     */
+    void Add(const MacCommandValue& command);
+
+    /**
+     * Remove all commands.
+     */
+    void Clear();
+
+    /**
+     * Get the number of commands in the list.
+     *
+     * \return The number of commands.
+     */
+    std::size_t GetN() const;
+
+    /**
+     * Get a command of the list.
+     *
+     * \param i The index of the command.
+     * \return The MAC command.
+     */
+    const MacCommandValue& Get(std::size_t i) const;
+
+    /**
+     * Find the first command of a given type.
+     *
+     * \tparam T The struct of the command, e.g., LinkCheckReqValue.
+     * \return A pointer to the fields of the command, or nullptr if the list
+     * doesn't contain such a command.
+     */
+    template <typename T>
+    const T* Find() const;
+
+  private:
+    static const std::size_t INLINE_COMMANDS = 4; //!< The number of commands stored inline
+
+    std::array<MacCommandValue, INLINE_COMMANDS> m_inline; //!< The first commands
+    std::vector<MacCommandValue> m_overflow;               //!< The commands beyond the first ones
+    uint8_t m_size;                                        //!< The number of commands
+};
+
+template <typename T>
+const T*
+MacCommandList::Find() const
+{
+    for (std::size_t i = 0; i < GetN(); i++)
+    {
+        if (const T* command = std::get_if<T>(&Get(i)))
+        {
+            return command;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace lorawan
+} // namespace ns3
+
+#endif /* MAC_COMMAND_VALUE_H */
@@ -870,8 +870,8 @@ NewChannelReq::Deserialize(Buffer::Iterator& start)
     start.ReadU8();
     // Read the data
     m_chIndex = start.ReadU8();
-    uint32_t encodedFrequency = 0;
-    encodedFrequency |= uint32_t(start.ReadU16()) << 8;
+    uint32_t encodedFrequency = uint32_t(start.ReadU8()) << 16; // Most significant byte first
+    encodedFrequency |= uint32_t(start.ReadU8()) << 8;
     encodedFrequency |= uint32_t(start.ReadU8());
     m_frequency = double(encodedFrequency) * 100;
     uint8_t dataRateByte = start.ReadU8();
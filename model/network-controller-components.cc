@@ -8,6 +8,8 @@
 
 #include "network-controller-components.h"
 
+#include "lorawan-frame-view.h"
+
 namespace ns3
 {
 namespace lorawan
@@ -33,6 +35,13 @@ NetworkControllerComponent::~NetworkControllerComponent()
 {
 }
 
+bool
+NetworkControllerComponent::HandlesMType(uint8_t mType) const
+{
+    return mType == LorawanMacHeader::UNCONFIRMED_DATA_UP ||
+           mType == LorawanMacHeader::CONFIRMED_DATA_UP;
+}
+
 ////////////////////////////////
 // ConfirmedMessagesComponent //
 ////////////////////////////////
@@ -54,32 +63,31 @@ ConfirmedMessagesComponent::~ConfirmedMessagesComponent()
 {
 }
 
+bool
+ConfirmedMessagesComponent::HandlesMType(uint8_t mType) const
+{
+    return mType == LorawanMacHeader::CONFIRMED_DATA_UP;
+}
+
 void
-ConfirmedMessagesComponent::OnReceivedPacket(Ptr<const Packet> packet,
-                                             Ptr<EndDeviceStatus> status,
+ConfirmedMessagesComponent::OnReceivedPacket(const UplinkContext& context,
                                              Ptr<NetworkStatus> networkStatus)
 {
-    NS_LOG_FUNCTION(this->GetTypeId() << packet << networkStatus);
+    NS_LOG_FUNCTION(this->GetTypeId() << context.packet << networkStatus);
 
     // Check whether the received packet requires an acknowledgment.
-    LorawanMacHeader mHdr;
-    LoraFrameHeader fHdr;
-    fHdr.SetAsUplink();
-    Ptr<Packet> myPacket = packet->Copy();
-    myPacket->RemoveHeader(mHdr);
-    myPacket->RemoveHeader(fHdr);
+    NS_LOG_INFO("Received packet headers: " << context.frame);
 
-    NS_LOG_INFO("Received packet Mac Header: " << mHdr);
-    NS_LOG_INFO("Received packet Frame Header: " << fHdr);
-
-    if (mHdr.GetMType() == LorawanMacHeader::CONFIRMED_DATA_UP)
+    if (context.frame.GetMType() == LorawanMacHeader::CONFIRMED_DATA_UP)
     {
+        Ptr<EndDeviceStatus> status = context.status;
+
         NS_LOG_INFO("Packet requires confirmation");
 
         // Set up the ACK bit on the reply
         status->m_reply.frameHeader.SetAsDownlink();
         status->m_reply.frameHeader.SetAck(true);
-        status->m_reply.frameHeader.SetAddress(fHdr.GetAddress());
+        status->m_reply.frameHeader.SetAddress(context.address);
         status->m_reply.macHeader.SetMType(LorawanMacHeader::UNCONFIRMED_DATA_DOWN);
         status->m_reply.needsReply = true;
 
@@ -132,12 +140,17 @@ LinkCheckComponent::~LinkCheckComponent()
 {
 }
 
+bool
+LinkCheckComponent::HandlesMType(uint8_t mType) const
+{
+    return false;
+}
+
 void
-LinkCheckComponent::OnReceivedPacket(Ptr<const Packet> packet,
-                                     Ptr<EndDeviceStatus> status,
+LinkCheckComponent::OnReceivedPacket(const UplinkContext& context,
                                      Ptr<NetworkStatus> networkStatus)
 {
-    NS_LOG_FUNCTION(this->GetTypeId() << packet << networkStatus);
+    NS_LOG_FUNCTION(this->GetTypeId() << context.packet << networkStatus);
 
     // We will only act just before reply, when all Gateways will have received
     // the packet.
@@ -149,17 +162,10 @@ LinkCheckComponent::BeforeSendingReply(Ptr<EndDeviceStatus> status,
 {
     NS_LOG_FUNCTION(this << status << networkStatus);
 
-    Ptr<Packet> myPacket = status->GetLastPacketReceivedFromDevice()->Copy();
-    LorawanMacHeader mHdr;
-    LoraFrameHeader fHdr;
-    fHdr.SetAsUplink();
-    myPacket->RemoveHeader(mHdr);
-    myPacket->RemoveHeader(fHdr);
-
-    Ptr<LinkCheckReq> command = fHdr.GetMacCommand<LinkCheckReq>();
+    LorawanFrameView frame(status->GetLastPacketReceivedFromDevice());
 
-    // GetMacCommand returns 0 if no command is found
-    if (command)
+    // FindMacCommand returns nullptr if no command is found
+    if (frame.FindMacCommand<LinkCheckReqValue>())
     {
         status->m_reply.needsReply = true;
 
@@ -167,8 +173,8 @@ LinkCheckComponent::BeforeSendingReply(Ptr<EndDeviceStatus> status,
         // margin
         uint8_t gwCount = status->GetLastReceivedPacketInfo().gwList.size();
 
-        Ptr<LinkCheckAns> replyCommand = Create<LinkCheckAns>();
-        replyCommand->SetGwCnt(gwCount);
+        LinkCheckAnsValue replyCommand;
+        replyCommand.gwCnt = gwCount;
         status->m_reply.frameHeader.SetAsDownlink();
         status->m_reply.frameHeader.AddCommand(replyCommand);
         status->m_reply.macHeader.SetMType(LorawanMacHeader::UNCONFIRMED_DATA_DOWN);
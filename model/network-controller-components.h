@@ -10,6 +10,7 @@
 #define NETWORK_CONTROLLER_COMPONENTS_H
 
 #include "network-status.h"
+#include "uplink-context.h"
 
 #include "ns3/log.h"
 #include "ns3/object.h"
@@ -34,6 +35,10 @@ class NetworkStatus;
  * This is the class that is meant to be extended by all NetworkController
  * components, and provides a common interface for the NetworkController to
  * query available components and prompt them to act on new packet arrivals.
+ *
+ * Components declare the message types of the uplink packets they act on with
+ * HandlesMType, so that the NetworkController doesn't call them for other
+ * packets.
  */
 class NetworkControllerComponent : public Object
 {
@@ -47,16 +52,27 @@ class NetworkControllerComponent : public Object
     NetworkControllerComponent();           //!< Default constructor
     ~NetworkControllerComponent() override; //!< Destructor
 
+    /**
+     * Check whether the component acts on uplink packets of a message type.
+     *
+     * The NetworkController only calls OnReceivedPacket for the packets of the message types
+     * handled by the component. By default, components handle unconfirmed and confirmed data
+     * uplinks.
+     *
+     * \param mType The message type, as in LorawanMacHeader::MType.
+     * \return True if OnReceivedPacket must be called for packets of this message type.
+     */
+    virtual bool HandlesMType(uint8_t mType) const;
+
     // Virtual methods whose implementation is left to child classes
     /**
      * Function called as a new uplink packet is received by the NetworkServer application.
      *
-     * \param packet The newly received packet.
-     * \param status A pointer to the status of the end device that sent the packet.
+     * \param context The context of the newly received packet, with the status of the end device
+     * that sent it.
      * \param networkStatus A pointer to the NetworkStatus object.
      */
-    virtual void OnReceivedPacket(Ptr<const Packet> packet,
-                                  Ptr<EndDeviceStatus> status,
+    virtual void OnReceivedPacket(const UplinkContext& context,
                                   Ptr<NetworkStatus> networkStatus) = 0;
     /**
      * Function called as a downlink reply is about to leave the NetworkServer application.
@@ -92,17 +108,22 @@ class ConfirmedMessagesComponent : public NetworkControllerComponent
     ConfirmedMessagesComponent();           //!< Default constructor
     ~ConfirmedMessagesComponent() override; //!< Destructor
 
+    /**
+     * Only confirmed data uplinks require an acknowledgment.
+     *
+     * \param mType The message type.
+     * \return True if mType is CONFIRMED_DATA_UP.
+     */
+    bool HandlesMType(uint8_t mType) const override;
+
     /**
      * This method checks whether the received packet requires an acknowledgment
      * and sets up the appropriate reply in case it does.
      *
-     * \param packet The newly received packet.
-     * \param status A pointer to the EndDeviceStatus object of the sender.
+     * \param context The context of the newly received packet.
      * \param networkStatus A pointer to the NetworkStatus object.
      */
-    void OnReceivedPacket(Ptr<const Packet> packet,
-                          Ptr<EndDeviceStatus> status,
-                          Ptr<NetworkStatus> networkStatus) override;
+    void OnReceivedPacket(const UplinkContext& context, Ptr<NetworkStatus> networkStatus) override;
 
     void BeforeSendingReply(Ptr<EndDeviceStatus> status, Ptr<NetworkStatus> networkStatus) override;
 
@@ -126,17 +147,23 @@ class LinkCheckComponent : public NetworkControllerComponent
     LinkCheckComponent();           //!< Default constructor
     ~LinkCheckComponent() override; //!< Destructor
 
+    /**
+     * LinkCheckReq commands are only answered just before the reply, when all
+     * gateways have received the packet.
+     *
+     * \param mType The message type.
+     * \return False.
+     */
+    bool HandlesMType(uint8_t mType) const override;
+
     /**
      * This method checks whether the received packet requires an acknowledgment
      * and sets up the appropriate reply in case it does.
      *
-     * \param packet The newly received packet.
-     * \param status A pointer to the EndDeviceStatus object of the sender.
+     * \param context The context of the newly received packet.
      * \param networkStatus A pointer to the NetworkStatus object.
      */
-    void OnReceivedPacket(Ptr<const Packet> packet,
-                          Ptr<EndDeviceStatus> status,
-                          Ptr<NetworkStatus> networkStatus) override;
+    void OnReceivedPacket(const UplinkContext& context, Ptr<NetworkStatus> networkStatus) override;
 
     void BeforeSendingReply(Ptr<EndDeviceStatus> status, Ptr<NetworkStatus> networkStatus) override;
 
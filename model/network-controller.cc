@@ -48,21 +48,25 @@ NetworkController::Install(Ptr<NetworkControllerComponent> component)
 {
     NS_LOG_FUNCTION(this);
     m_components.push_back(component);
+
+    for (uint8_t mType = 0; mType < m_componentsByMType.size(); mType++)
+    {
+        if (component->HandlesMType(mType))
+        {
+            m_componentsByMType[mType].push_back(component);
+        }
+    }
 }
 
 void
-NetworkController::OnNewPacket(Ptr<const Packet> packet)
+NetworkController::OnNewPacket(const UplinkContext& context)
 {
-    NS_LOG_FUNCTION(this << packet);
+    NS_LOG_FUNCTION(this << context.packet);
 
-    // NOTE As a future optimization, we can allow components to register their
-    // callbacks and only be called in case a certain MAC command is contained.
-    // For now, we call all components.
-
-    // Inform each component about the new packet
-    for (auto it = m_components.begin(); it != m_components.end(); ++it)
+    // Inform the components handling this message type about the new packet
+    for (const auto& component : m_componentsByMType[context.frame.GetMType()])
     {
-        (*it)->OnReceivedPacket(packet, m_status->GetEndDeviceStatus(packet), m_status);
+        component->OnReceivedPacket(context, m_status);
     }
 }
 
@@ -11,10 +11,14 @@
 
 #include "network-controller-components.h"
 #include "network-status.h"
+#include "uplink-context.h"
 
 #include "ns3/object.h"
 #include "ns3/packet.h"
 
+#include <array>
+#include <vector>
+
 namespace ns3
 {
 namespace lorawan
@@ -29,6 +33,10 @@ class NetworkControllerComponent;
  * This class collects a series of components that deal with various aspects
  * of managing the network, and queries them for action when a new packet is
  * received or other events occur in the network.
+ *
+ * Each new packet is only passed to the components that handle its message
+ * type, as reported by NetworkControllerComponent::HandlesMType when the
+ * component is installed.
  */
 class NetworkController : public Object
 {
@@ -59,9 +67,9 @@ class NetworkController : public Object
     /**
      * Method that is called by the NetworkServer application when a new packet is received.
      *
-     * \param packet The newly received packet.
+     * \param context The context of the newly received packet.
      */
-    void OnNewPacket(Ptr<const Packet> packet);
+    void OnNewPacket(const UplinkContext& context);
 
     /**
      * Method that is called by the NetworkScheduler just before sending a reply
@@ -75,6 +83,8 @@ class NetworkController : public Object
     Ptr<NetworkStatus> m_status; //!< A pointer to the NetworkStatus object.
     std::list<Ptr<NetworkControllerComponent>>
         m_components; //!< List of NetworkControllerComponent objects.
+    std::array<std::vector<Ptr<NetworkControllerComponent>>, 8>
+        m_componentsByMType; //!< The components handling each MType, in installation order.
 };
 
 } // namespace lorawan
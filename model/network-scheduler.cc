@@ -39,30 +39,19 @@ NetworkScheduler::~NetworkScheduler()
 }
 
 void
-NetworkScheduler::OnReceivedPacket(Ptr<const Packet> packet)
+NetworkScheduler::OnReceivedPacket(const UplinkContext& context)
 {
-    NS_LOG_FUNCTION(packet);
-
-    // Get the current packet's frame counter
-    Ptr<Packet> packetCopy = packet->Copy();
-    LorawanMacHeader receivedMacHdr;
-    packetCopy->RemoveHeader(receivedMacHdr);
-    LoraFrameHeader receivedFrameHdr;
-    receivedFrameHdr.SetAsUplink();
-    packetCopy->RemoveHeader(receivedFrameHdr);
+    NS_LOG_FUNCTION(context.packet);
 
     // Need to decide whether to schedule a receive window
-    if (!m_status->GetEndDeviceStatus(packet)->HasReceiveWindowOpportunityScheduled())
+    if (!context.status->HasReceiveWindowOpportunityScheduled())
     {
-        // Extract the address
-        LoraDeviceAddress deviceAddress = receivedFrameHdr.GetAddress();
-
         // Schedule OnReceiveWindowOpportunity event
-        m_status->GetEndDeviceStatus(packet)->SetReceiveWindowOpportunity(
+        context.status->SetReceiveWindowOpportunity(
             Simulator::Schedule(Seconds(1),
                                 &NetworkScheduler::OnReceiveWindowOpportunity,
                                 this,
-                                deviceAddress,
+                                context.address,
                                 1)); // This will be the first receive window
     }
 }
@@ -14,6 +14,7 @@
 #include "lorawan-mac-header.h"
 #include "network-controller.h"
 #include "network-status.h"
+#include "uplink-context.h"
 
 #include "ns3/core-module.h"
 #include "ns3/object.h"
@@ -61,9 +62,9 @@ class NetworkScheduler : public Object
      *
      * This function schedules the OnReceiveWindowOpportunity events 1 and 2 seconds later.
      *
-     * \param packet A pointer to the new Packet instance.
+     * \param context The context of the new packet, with the status of its sender.
      */
-    void OnReceivedPacket(Ptr<const Packet> packet);
+    void OnReceivedPacket(const UplinkContext& context);
 
     /**
      * Method that is scheduled after packet arrival in order to take action on
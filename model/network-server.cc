@@ -15,6 +15,7 @@
 #include "lorawan-mac-header.h"
 #include "mac-command.h"
 #include "network-status.h"
+#include "uplink-context.h"
 
 #include "ns3/net-device.h"
 #include "ns3/node-container.h"
@@ -140,6 +141,17 @@ NetworkServer::AddNode(Ptr<Node> node)
     m_status->AddNode(edLorawanMac);
 }
 
+void
+NetworkServer::AddPopulation(Ptr<LoraEndDevicePopulation> population)
+{
+    NS_LOG_FUNCTION(this << population);
+
+    for (uint32_t i = 0; i < population->GetN(); i++)
+    {
+        m_status->AddNode(population->GetAddress(i));
+    }
+}
+
 bool
 NetworkServer::Receive(Ptr<NetDevice> device,
                        Ptr<const Packet> packet,
@@ -148,20 +160,26 @@ NetworkServer::Receive(Ptr<NetDevice> device,
 {
     NS_LOG_FUNCTION(this << packet << protocol << address);
 
-    // Create a copy of the packet
-    Ptr<Packet> myPacket = packet->Copy();
+    // Parse the packet once, and share the result with all the modules
+    UplinkContext context(packet, address);
+    context.status = m_status->GetEndDeviceStatus(context.address);
+    if (!context.status)
+    {
+        NS_LOG_ERROR("Dropping packet from unknown device " << context.address);
+        return true;
+    }
 
     // Fire the trace source
     m_receivedPacket(packet);
 
     // Inform the scheduler of the newly arrived packet
-    m_scheduler->OnReceivedPacket(packet);
+    m_scheduler->OnReceivedPacket(context);
 
     // Inform the status of the newly arrived packet
-    m_status->OnReceivedPacket(packet, address);
+    m_status->OnReceivedPacket(context);
 
     // Inform the controller of the newly arrived packet
-    m_controller->OnNewPacket(packet);
+    m_controller->OnNewPacket(context);
 
     return true;
 }
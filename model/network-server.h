@@ -13,6 +13,7 @@
 #include "class-a-end-device-lorawan-mac.h"
 #include "gateway-status.h"
 #include "lora-device-address.h"
+#include "lora-end-device-population.h"
 #include "network-controller.h"
 #include "network-scheduler.h"
 #include "network-status.h"
@@ -81,6 +82,14 @@ class NetworkServer : public Application
      */
     void AddNode(Ptr<Node> node);
 
+    /**
+     * Inform the NetworkServer application that the devices of a population are connected to
+     * the network.
+     *
+     * \param population The population of end devices.
+     */
+    void AddPopulation(Ptr<LoraEndDevicePopulation> population);
+
     /**
      * Add the gateway to the list of gateways connected to this network server.
      *
@@ -12,6 +12,7 @@
 #include "end-device-status.h"
 #include "gateway-status.h"
 #include "lora-device-address.h"
+#include "lorawan-frame-view.h"
 
 #include "ns3/log.h"
 #include "ns3/net-device.h"
@@ -68,6 +69,20 @@ NetworkStatus::AddNode(Ptr<ClassAEndDeviceLorawanMac> edMac)
     }
 }
 
+void
+NetworkStatus::AddNode(LoraDeviceAddress edAddress)
+{
+    NS_LOG_FUNCTION(this << edAddress);
+
+    if (m_endDeviceStatuses.find(edAddress) == m_endDeviceStatuses.end())
+    {
+        Ptr<EndDeviceStatus> edStatus = CreateObject<EndDeviceStatus>(edAddress, nullptr);
+        m_endDeviceStatuses.insert(
+            std::pair<LoraDeviceAddress, Ptr<EndDeviceStatus>>(edAddress, edStatus));
+        NS_LOG_DEBUG("Added to the list a device with address " << edAddress.Print());
+    }
+}
+
 void
 NetworkStatus::AddGateway(Address& address, Ptr<GatewayStatus> gwStatus)
 {
@@ -85,24 +100,13 @@ NetworkStatus::AddGateway(Address& address, Ptr<GatewayStatus> gwStatus)
 }
 
 void
-NetworkStatus::OnReceivedPacket(Ptr<const Packet> packet, const Address& gwAddress)
+NetworkStatus::OnReceivedPacket(const UplinkContext& context)
 {
-    NS_LOG_FUNCTION(this << packet << gwAddress);
-
-    // Create a copy of the packet
-    Ptr<Packet> myPacket = packet->Copy();
-
-    // Extract the headers
-    LorawanMacHeader macHdr;
-    myPacket->RemoveHeader(macHdr);
-    LoraFrameHeader frameHdr;
-    frameHdr.SetAsUplink();
-    myPacket->RemoveHeader(frameHdr);
+    NS_LOG_FUNCTION(this << context.packet << context.gwAddress);
 
     // Update the correct EndDeviceStatus object
-    LoraDeviceAddress edAddr = frameHdr.GetAddress();
-    NS_LOG_DEBUG("Node address: " << edAddr);
-    m_endDeviceStatuses.at(edAddr)->InsertReceivedPacket(packet, gwAddress);
+    NS_LOG_DEBUG("Node address: " << context.address);
+    context.status->InsertReceivedPacket(context);
 }
 
 bool
@@ -193,22 +197,7 @@ NetworkStatus::GetEndDeviceStatus(Ptr<const Packet> packet)
 {
     NS_LOG_FUNCTION(this << packet);
 
-    // Get the address
-    LorawanMacHeader mHdr;
-    LoraFrameHeader fHdr;
-    Ptr<Packet> myPacket = packet->Copy();
-    myPacket->RemoveHeader(mHdr);
-    myPacket->RemoveHeader(fHdr);
-    auto it = m_endDeviceStatuses.find(fHdr.GetAddress());
-    if (it != m_endDeviceStatuses.end())
-    {
-        return (*it).second;
-    }
-    else
-    {
-        NS_LOG_ERROR("EndDeviceStatus not found");
-        return nullptr;
-    }
+    return GetEndDeviceStatus(LorawanFrameView(packet).GetAddress());
 }
 
 Ptr<EndDeviceStatus>
@@ -15,6 +15,7 @@
 #include "gateway-status.h"
 #include "lora-device-address.h"
 #include "network-scheduler.h"
+#include "uplink-context.h"
 
 #include <iterator>
 
@@ -53,6 +54,17 @@ class NetworkStatus : public Object
      */
     void AddNode(Ptr<ClassAEndDeviceLorawanMac> edMac);
 
+    /**
+     * Add a device without a MAC layer object, such as a device of a
+     * LoraEndDevicePopulation, to the ones that are tracked by this NetworkStatus object.
+     *
+     * Since its MAC can't be queried, the device must not send confirmed packets or request
+     * Adaptive Data Rate (ADR).
+     *
+     * \param edAddress The address of the device to be tracked.
+     */
+    void AddNode(LoraDeviceAddress edAddress);
+
     /**
      * Add a new gateway to the list of gateways connected to the network.
      *
@@ -67,10 +79,9 @@ class NetworkStatus : public Object
     /**
      * Update network status on a received packet.
      *
-     * \param packet The received packet.
-     * \param gwaddress Address of the gateway this packet was received from.
+     * \param context The context of the received packet, with the status of its sender.
      */
-    void OnReceivedPacket(Ptr<const Packet> packet, const Address& gwaddress);
+    void OnReceivedPacket(const UplinkContext& context);
 
     /**
      * Return whether the specified device needs a reply.
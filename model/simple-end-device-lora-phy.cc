@@ -112,6 +112,10 @@ SimpleEndDeviceLoraPhy::StartReceive(Ptr<Packet> packet,
     Ptr<LoraInterferenceHelper::Event> event;
     event = m_interference.Add(duration, rxPowerDbm, sf, packet, frequencyMHz);
 
+    // If we are asleep during a lazy receive window, the upper layer wakes us
+    // up as it would have at the beginning of the window
+    OpenLazyReceiveWindow();
+
     // Switch on the current PHY state
     switch (m_state)
     {
@@ -214,6 +218,7 @@ SimpleEndDeviceLoraPhy::StartReceive(Ptr<Packet> packet,
             // Switch to RX state
             // EndReceive will handle the switch back to STANDBY state
             SwitchToRx();
+            m_interference.LockOnEvent(event);
 
             // Schedule the end of the reception of the packet
             NS_LOG_INFO("Scheduling reception of a packet. End in " << duration.GetSeconds()
@@ -61,31 +61,31 @@ SimpleGatewayLoraPhy::Send(Ptr<Packet> packet,
     NS_LOG_DEBUG("Duration of packet: " << duration << ", SF" << unsigned(txParams.sf));
 
     // Interrupt all receive operations
-    std::list<Ptr<SimpleGatewayLoraPhy::ReceptionPath>>::iterator it;
-    for (it = m_receptionPaths.begin(); it != m_receptionPaths.end(); ++it)
+    for (uint32_t index = 0; index < m_receptionPaths.size() && m_occupiedReceptionPaths > 0;
+         index++)
     {
-        Ptr<SimpleGatewayLoraPhy::ReceptionPath> currentPath = *it;
+        ReceptionPath& currentPath = m_receptionPaths[index];
 
-        if (!currentPath->IsAvailable()) // Reception path is occupied
+        if (!currentPath.IsAvailable()) // Reception path is occupied
         {
             // Call the callback for reception interrupted by transmission
             // Fire the trace source
             if (m_device)
             {
-                m_noReceptionBecauseTransmitting(currentPath->GetEvent()->GetPacket(),
+                m_noReceptionBecauseTransmitting(currentPath.GetEvent()->GetPacket(),
                                                  m_device->GetNode()->GetId());
             }
             else
             {
-                m_noReceptionBecauseTransmitting(currentPath->GetEvent()->GetPacket(), 0);
+                m_noReceptionBecauseTransmitting(currentPath.GetEvent()->GetPacket(), 0);
             }
 
             // Cancel the scheduled EndReceive call
-            Simulator::Cancel(currentPath->GetEndReceive());
+            Simulator::Cancel(currentPath.GetEndReceive());
 
             // Free it
             // This also resets all parameters like packet and endReceive call
-            currentPath->Free();
+            FreeReceptionPath(index);
         }
     }
 
@@ -144,80 +144,160 @@ SimpleGatewayLoraPhy::StartReceive(Ptr<Packet> packet,
     Ptr<LoraInterferenceHelper::Event> event;
     event = m_interference.Add(duration, rxPowerDbm, sf, packet, frequencyMHz);
 
-    // Cycle over the receive paths to check availability to receive the packet
-    std::list<Ptr<SimpleGatewayLoraPhy::ReceptionPath>>::iterator it;
+    // With preamble capture, release the paths of the receptions this signal
+    // destroys, so that it can take one of them
+    bool capture = m_preambleCapture && m_sicDepth == 0;
+    if (capture)
+    {
+        ReleaseDestroyedReceptions(frequencyMHz);
+    }
 
-    for (it = m_receptionPaths.begin(); it != m_receptionPaths.end(); ++it)
+    // Take one of the available receive paths of the board listening to this
+    // frequency, if any
+    uint32_t board = GetBoard(frequencyMHz);
+    if (HasAvailableReceptionPath(board))
     {
-        Ptr<SimpleGatewayLoraPhy::ReceptionPath> currentPath = *it;
+        // See whether the reception power is above or below the sensitivity
+        // for that spreading factor
+        double sensitivity = SimpleGatewayLoraPhy::sensitivity[unsigned(sf) - 7];
 
-        // If the receive path is available and listening on the channel of
-        // interest, we have a candidate
-        if (currentPath->IsAvailable())
+        if (rxPowerDbm < sensitivity) // Packet arrived below sensitivity
         {
-            // See whether the reception power is above or below the sensitivity
-            // for that spreading factor
-            double sensitivity = SimpleGatewayLoraPhy::sensitivity[unsigned(sf) - 7];
+            NS_LOG_INFO("Dropping packet reception of packet with sf = "
+                        << unsigned(sf) << " because under the sensitivity of " << sensitivity
+                        << " dBm");
+
+            if (m_device)
+            {
+                m_underSensitivity(packet, m_device->GetNode()->GetId());
+            }
+            else
+            {
+                m_underSensitivity(packet, 0);
+            }
 
-            if (rxPowerDbm < sensitivity) // Packet arrived below sensitivity
+            // Since the packet is below sensitivity, it makes no sense to
+            // search for another ReceivePath
+            return;
+        }
+        else // We have sufficient sensitivity to start receiving
+        {
+            // With preamble capture, don't lock on a packet the signals
+            // overlapping it already destroy
+            uint8_t destroyingSf = capture ? m_interference.IsAlreadyDestroyed(event) : 0;
+            if (destroyingSf != uint8_t(0))
             {
                 NS_LOG_INFO("Dropping packet reception of packet with sf = "
-                            << unsigned(sf) << " because under the sensitivity of " << sensitivity
-                            << " dBm");
-
-                if (m_device)
-                {
-                    m_underSensitivity(packet, m_device->GetNode()->GetId());
-                }
-                else
-                {
-                    m_underSensitivity(packet, 0);
-                }
-
-                // Since the packet is below sensitivity, it makes no sense to
-                // search for another ReceivePath
+                            << unsigned(sf) << " because the signals overlapping it destroy it");
+
+                m_phyRxEndTrace(packet);
+                NotifyReception(packet, event, destroyingSf);
                 return;
             }
-            else // We have sufficient sensitivity to start receiving
-            {
-                NS_LOG_INFO("Scheduling reception of a packet, occupying one demodulator");
 
-                // Block this resource
-                currentPath->LockOnEvent(event);
-                m_occupiedReceptionPaths++;
+            NS_LOG_INFO("Scheduling reception of a packet, occupying one demodulator");
 
-                // Schedule the end of the reception of the packet
-                EventId endReceiveEventId =
-                    Simulator::Schedule(duration, &LoraPhy::EndReceive, this, packet, event);
+            // Block this resource
+            uint32_t index = LockReceptionPath(board, event);
+            m_interference.LockOnEvent(event);
 
-                currentPath->SetEndReceive(endReceiveEventId);
+            // Schedule the end of the reception of the packet, remembering the
+            // path to free
+            EventId endReceiveEventId = Simulator::Schedule(duration,
+                                                            &SimpleGatewayLoraPhy::EndReceiveOnPath,
+                                                            this,
+                                                            index,
+                                                            packet,
+                                                            event);
 
-                // Make sure we don't go on searching for other ReceivePaths
-                return;
-            }
+            m_receptionPaths[index].SetEndReceive(endReceiveEventId);
+
+            // Make sure we don't go on searching for other ReceivePaths
+            return;
         }
     }
     // If we get to this point, there are no demodulators we can use
     NS_LOG_INFO("Dropping packet reception of packet with sf = "
                 << unsigned(sf) << " and frequency " << frequencyMHz
-                << "MHz because no suitable demodulator was found");
+                << "MHz because no suitable demodulator was found on board " << board);
 
-    // Fire the trace source
-    if (m_device)
+    // Fire the trace sources
+    NotifyNoMoreDemodulators(packet, board);
+}
+
+void
+SimpleGatewayLoraPhy::EndReceive(Ptr<Packet> packet, Ptr<LoraInterferenceHelper::Event> event)
+{
+    NS_LOG_FUNCTION(this << packet << *event);
+
+    EvaluateReception(packet, event);
+
+    // Search for the demodulator that was locked on this event to free it.
+    uint32_t index = FindReceptionPath(event);
+    if (index < m_receptionPaths.size())
     {
-        m_noMoreDemodulators(packet, m_device->GetNode()->GetId());
+        FreeReceptionPath(index);
     }
-    else
+}
+
+void
+SimpleGatewayLoraPhy::EndReceiveOnPath(uint32_t index,
+                                       Ptr<Packet> packet,
+                                       Ptr<LoraInterferenceHelper::Event> event)
+{
+    NS_LOG_FUNCTION(this << index << packet << *event);
+
+    EvaluateReception(packet, event);
+
+    // Free the demodulator that was locked on this event. If the paths were
+    // reset in the meantime, the path may have moved or been removed.
+    if (index >= m_receptionPaths.size() || m_receptionPaths[index].IsAvailable() ||
+        m_receptionPaths[index].GetEvent() != event)
     {
-        m_noMoreDemodulators(packet, 0);
+        index = FindReceptionPath(event);
+    }
+    if (index < m_receptionPaths.size())
+    {
+        FreeReceptionPath(index);
     }
 }
 
 void
-SimpleGatewayLoraPhy::EndReceive(Ptr<Packet> packet, Ptr<LoraInterferenceHelper::Event> event)
+SimpleGatewayLoraPhy::ReleaseDestroyedReceptions(double frequencyMHz)
 {
-    NS_LOG_FUNCTION(this << packet << *event);
+    NS_LOG_FUNCTION(this << frequencyMHz);
+
+    for (uint32_t index = 0; index < m_receptionPaths.size() && m_occupiedReceptionPaths > 0;
+         index++)
+    {
+        ReceptionPath& currentPath = m_receptionPaths[index];
+        if (currentPath.IsAvailable() || currentPath.GetEvent()->GetFrequency() != frequencyMHz)
+        {
+            continue;
+        }
+
+        Ptr<LoraInterferenceHelper::Event> event = currentPath.GetEvent();
+        if (!m_interference.IsAlreadyDestroyed(event))
+        {
+            continue;
+        }
+
+        NS_LOG_INFO("Releasing the reception path of a packet destroyed by interference");
 
+        // End the reception now, with the interference accumulated so far
+        Simulator::Cancel(currentPath.GetEndReceive());
+        FreeReceptionPath(index);
+
+        Ptr<Packet> packet = event->GetPacket();
+        m_phyRxEndTrace(packet);
+        NotifyReception(packet, event, m_interference.IsDestroyedByInterference(event));
+    }
+}
+
+void
+SimpleGatewayLoraPhy::EvaluateReception(Ptr<Packet> packet,
+                                        Ptr<LoraInterferenceHelper::Event> event)
+{
     // Call the trace source
     m_phyRxEndTrace(packet);
 
@@ -227,6 +307,65 @@ SimpleGatewayLoraPhy::EndReceive(Ptr<Packet> packet, Ptr<LoraInterferenceHelper:
     uint8_t packetDestroyed = 0;
     packetDestroyed = m_interference.IsDestroyedByInterference(event);
 
+    // With SIC, the packet may still be recovered once the signals overlapping
+    // it are over and can be decoded
+    if (packetDestroyed != uint8_t(0) && m_sicDepth > 0)
+    {
+        Time overlapEnd = m_interference.GetOverlapEnd(event);
+        if (overlapEnd > Simulator::Now())
+        {
+            Simulator::Schedule(overlapEnd - Simulator::Now(),
+                                &SimpleGatewayLoraPhy::EvaluateCancellation,
+                                this,
+                                packet,
+                                event);
+        }
+        else
+        {
+            EvaluateCancellation(packet, event);
+        }
+        return;
+    }
+
+    NotifyReception(packet, event, packetDestroyed);
+}
+
+void
+SimpleGatewayLoraPhy::EvaluateCancellation(Ptr<Packet> packet,
+                                           Ptr<LoraInterferenceHelper::Event> event)
+{
+    NS_LOG_FUNCTION(this << packet << *event);
+
+    uint32_t nCancelled = 0;
+    uint8_t packetDestroyed =
+        m_interference.IsDestroyedAfterCancellation(event,
+                                                    m_sicDepth,
+                                                    SimpleGatewayLoraPhy::sensitivity,
+                                                    nCancelled);
+
+    if (packetDestroyed == uint8_t(0))
+    {
+        NS_LOG_INFO("Packet recovered after cancelling " << nCancelled << " signals");
+
+        // Fire the trace source
+        if (m_device)
+        {
+            m_recoveredBySic(packet, m_device->GetNode()->GetId());
+        }
+        else
+        {
+            m_recoveredBySic(packet, 0);
+        }
+    }
+
+    NotifyReception(packet, event, packetDestroyed);
+}
+
+void
+SimpleGatewayLoraPhy::NotifyReception(Ptr<Packet> packet,
+                                      Ptr<LoraInterferenceHelper::Event> event,
+                                      uint8_t packetDestroyed)
+{
     // Check whether the packet was destroyed
     if (packetDestroyed != uint8_t(0))
     {
@@ -281,22 +420,6 @@ SimpleGatewayLoraPhy::EndReceive(Ptr<Packet> packet, Ptr<LoraInterferenceHelper:
             m_rxOkCallback(packet);
         }
     }
-
-    // Search for the demodulator that was locked on this event to free it.
-
-    std::list<Ptr<SimpleGatewayLoraPhy::ReceptionPath>>::iterator it;
-
-    for (it = m_receptionPaths.begin(); it != m_receptionPaths.end(); ++it)
-    {
-        Ptr<SimpleGatewayLoraPhy::ReceptionPath> currentPath = *it;
-
-        if (currentPath->GetEvent() == event)
-        {
-            currentPath->Free();
-            m_occupiedReceptionPaths--;
-            return;
-        }
-    }
 }
 
 } // namespace lorawan
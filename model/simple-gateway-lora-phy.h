@@ -58,6 +58,55 @@ class SimpleGatewayLoraPhy : public GatewayLoraPhy
               double txPowerDbm) override;
 
   private:
+    /**
+     * Finish the reception of a packet, freeing the reception path it was
+     * locked on without searching for it.
+     *
+     * \param index The index of the reception path locked on the packet.
+     * \param packet The packet being received.
+     * \param event The LoraInterferenceHelper Event of the packet.
+     */
+    void EndReceiveOnPath(uint32_t index,
+                          Ptr<Packet> packet,
+                          Ptr<LoraInterferenceHelper::Event> event);
+
+    /**
+     * End the receptions on a frequency that the signals registered so far
+     * already destroy, releasing their reception paths.
+     *
+     * \param frequencyMHz The frequency of the new signal.
+     */
+    void ReleaseDestroyedReceptions(double frequencyMHz);
+
+    /**
+     * Determine whether a packet survived interference, and notify the trace
+     * sources and upper layer accordingly.
+     *
+     * \param packet The packet being received.
+     * \param event The LoraInterferenceHelper Event of the packet.
+     */
+    void EvaluateReception(Ptr<Packet> packet, Ptr<LoraInterferenceHelper::Event> event);
+
+    /**
+     * Check again a packet lost to interference, after cancelling the signals
+     * overlapping it that can be decoded, up to the SIC depth.
+     *
+     * \param packet The packet being received.
+     * \param event The LoraInterferenceHelper Event of the packet.
+     */
+    void EvaluateCancellation(Ptr<Packet> packet, Ptr<LoraInterferenceHelper::Event> event);
+
+    /**
+     * Notify the trace sources and upper layer of the outcome of a reception.
+     *
+     * \param packet The packet being received.
+     * \param event The LoraInterferenceHelper Event of the packet.
+     * \param packetDestroyed The sf of the packets that caused the loss, or 0
+     * if the packet was received.
+     */
+    void NotifyReception(Ptr<Packet> packet,
+                         Ptr<LoraInterferenceHelper::Event> event,
+                         uint8_t packetDestroyed);
 };
 
 } // namespace lorawan
@@ -38,7 +38,6 @@ SubBand::SubBand(double firstFrequency,
     : m_firstFrequency(firstFrequency),
       m_lastFrequency(lastFrequency),
       m_dutyCycle(dutyCycle),
-      m_nextTransmissionTime(Seconds(0)),
       m_maxTxPowerDbm(maxTxPowerDbm)
 {
     NS_LOG_FUNCTION(this << firstFrequency << lastFrequency << dutyCycle << maxTxPowerDbm);
@@ -74,18 +73,6 @@ SubBand::BelongsToSubBand(Ptr<LogicalLoraChannel> logicalChannel) const
     return BelongsToSubBand(frequency);
 }
 
-void
-SubBand::SetNextTransmissionTime(Time nextTime)
-{
-    m_nextTransmissionTime = nextTime;
-}
-
-Time
-SubBand::GetNextTransmissionTime()
-{
-    return m_nextTransmissionTime;
-}
-
 void
 SubBand::SetMaxTxPowerDbm(double maxTxPowerDbm)
 {
@@ -26,6 +26,11 @@ class LogicalLoraChannel;
  *
  * Class representing a SubBand, i.e., a frequency band subject to some
  * regulations on duty cycle and transmission power.
+ *
+ * SubBands can be shared by many devices through a LogicalLoraChannelPlan, so
+ * they don't hold the state of the duty cycle: each LogicalLoraChannelHelper
+ * keeps the time its device can transmit again on each SubBand (see
+ * LogicalLoraChannelHelper::GetWaitingTime).
  */
 class SubBand : public Object
 {
@@ -71,26 +76,6 @@ class SubBand : public Object
      */
     double GetDutyCycle() const;
 
-    /**
-     * Update the next transmission time.
-     *
-     * This function is used by LogicalLoraChannelHelper, which computes the time
-     * based on the SubBand's duty cycle and on the transmission duration.
-     *
-     * \param nextTime The future time from which transmission should be allowed
-     * again.
-     */
-    void SetNextTransmissionTime(Time nextTime);
-
-    /**
-     * Returns the next time from which transmission on this subband will be
-     * possible.
-     *
-     * \return The next time at which transmission in this SubBand will be
-     * allowed.
-     */
-    Time GetNextTransmissionTime();
-
     /**
      * Return whether or not a frequency belongs to this SubBand.
      *
@@ -124,11 +109,10 @@ class SubBand : public Object
     double GetMaxTxPowerDbm() const;
 
   private:
-    double m_firstFrequency;     //!< Starting frequency of the subband, in MHz
-    double m_lastFrequency;      //!< Ending frequency of the subband, in MHz
-    double m_dutyCycle;          //!< The duty cycle that needs to be enforced on this subband
-    Time m_nextTransmissionTime; //!< The next time a transmission will be allowed in this subband
-    double m_maxTxPowerDbm; //!< The maximum transmission power that is admitted on this subband
+    double m_firstFrequency; //!< Starting frequency of the subband, in MHz
+    double m_lastFrequency;  //!< Ending frequency of the subband, in MHz
+    double m_dutyCycle;      //!< The duty cycle that needs to be enforced on this subband
+    double m_maxTxPowerDbm;  //!< The maximum transmission power that is admitted on this subband
 };
 } // namespace lorawan
 } // namespace ns3
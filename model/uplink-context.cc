@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#include "uplink-context.h"
+
+#include "end-device-status.h"
+#include "lora-tag.h"
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+namespace ns3
+{
+namespace lorawan
+{
+
+NS_LOG_COMPONENT_DEFINE("UplinkContext");
+
+UplinkContext::UplinkContext(Ptr<const Packet> receivedPacket, const Address& gatewayAddress)
+    : packet(receivedPacket),
+      frame(receivedPacket),
+      address(frame.GetAddress()),
+      status(nullptr),
+      gwAddress(gatewayAddress),
+      arrivalTime(Simulator::Now())
+{
+    NS_LOG_FUNCTION(receivedPacket << gatewayAddress);
+
+    // The gateway reports the reception parameters in the LoraTag
+    LoraTag tag;
+    if (receivedPacket->PeekPacketTag(tag))
+    {
+        sf = tag.GetSpreadingFactor();
+        frequency = tag.GetFrequency();
+        rxPower = tag.GetReceivePower();
+    }
+    else
+    {
+        NS_LOG_WARN("Packet without LoraTag: unknown reception parameters");
+    }
+}
+
+} // namespace lorawan
+} // namespace ns3
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2018 University of Padova
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#ifndef UPLINK_CONTEXT_H
+#define UPLINK_CONTEXT_H
+
+#include "lora-device-address.h"
+#include "lorawan-frame-view.h"
+
+#include "ns3/address.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+
+namespace ns3
+{
+namespace lorawan
+{
+
+class EndDeviceStatus;
+
+/**
+ * \ingroup lorawan
+ *
+ * The information about an uplink packet received by the NetworkServer.
+ *
+ * The NetworkServer parses each packet it receives once, and passes the
+ * resulting context to the NetworkScheduler, the NetworkStatus and the
+ * components of the NetworkController, which don't need to parse the packet or
+ * look up the status of its sender again.
+ */
+struct UplinkContext
+{
+    /**
+     * Parse the headers and the LoraTag of a packet received from a gateway.
+     *
+     * The status of the sender is left empty, since it is resolved by the
+     * NetworkStatus.
+     *
+     * \param receivedPacket The packet received.
+     * \param gatewayAddress The address of the gateway that forwarded the packet.
+     */
+    UplinkContext(Ptr<const Packet> receivedPacket, const Address& gatewayAddress);
+
+    Ptr<const Packet> packet;    //!< The received packet
+    LorawanFrameView frame;      //!< The MHDR and FHDR of the packet
+    LoraDeviceAddress address;   //!< The DevAddr of the sender
+    Ptr<EndDeviceStatus> status; //!< The status of the sender, null if unknown
+    Address gwAddress;           //!< The address of the gateway that forwarded the packet
+    uint8_t sf = 0;              //!< The spreading factor of the packet
+    double frequency = 0;        //!< The carrier frequency of the packet [MHz]
+    double rxPower = 0;          //!< The power received by the gateway [dBm]
+    Time arrivalTime;            //!< The time of arrival at the NetworkServer
+};
+
+} // namespace lorawan
+} // namespace ns3
+
+#endif /* UPLINK_CONTEXT_H */
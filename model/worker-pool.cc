@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2017 University of Padova
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#include "worker-pool.h"
+
+#include "ns3/assert.h"
+
+namespace ns3
+{
+namespace lorawan
+{
+
+WorkerPool::WorkerPool(uint32_t nThreads)
+    : m_job(nullptr),
+      m_nItems(0),
+      m_generation(0),
+      m_pending(0),
+      m_stop(false)
+{
+    NS_ASSERT(nThreads >= 1);
+
+    for (uint32_t thread = 1; thread < nThreads; thread++)
+    {
+        m_threads.emplace_back(&WorkerPool::Work, this, thread);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_start.notify_all();
+
+    for (auto& thread : m_threads)
+    {
+        thread.join();
+    }
+}
+
+uint32_t
+WorkerPool::GetNThreads() const
+{
+    return m_threads.size() + 1;
+}
+
+void
+WorkerPool::Run(uint32_t nItems, const Job& job)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &job;
+        m_nItems = nItems;
+        m_pending = m_threads.size();
+        m_generation++;
+    }
+    m_start.notify_all();
+
+    // The calling thread takes care of the first chunk
+    RunChunk(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this]() { return m_pending == 0; });
+    m_job = nullptr;
+}
+
+void
+WorkerPool::Work(uint32_t thread)
+{
+    uint64_t generation = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_start.wait(lock, [this, generation]() {
+                return m_stop || m_generation != generation;
+            });
+            if (m_stop)
+            {
+                return;
+            }
+            generation = m_generation;
+        }
+
+        RunChunk(thread);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pending--;
+        }
+        m_done.notify_one();
+    }
+}
+
+void
+WorkerPool::RunChunk(uint32_t thread)
+{
+    uint32_t nThreads = GetNThreads();
+    uint32_t begin = uint64_t(m_nItems) * thread / nThreads;
+    uint32_t end = uint64_t(m_nItems) * (thread + 1) / nThreads;
+    if (begin < end)
+    {
+        (*m_job)(thread, begin, end);
+    }
+}
+
+} // namespace lorawan
+} // namespace ns3
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2017 University of Padova
+ *
+ * SPDX-License-Identifier: GPL-2.0-only
+ */
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include "ns3/simple-ref-count.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ns3
+{
+namespace lorawan
+{
+
+/**
+ * \ingroup lorawan
+ *
+ * A fixed set of threads that split a range of work items among themselves.
+ *
+ * The range is divided in contiguous chunks, one per thread, so that the
+ * items each thread processes only depend on the size of the range and on the
+ * number of threads. The thread calling Run processes the first chunk and
+ * returns when all chunks are done: jobs must not touch the simulator or any
+ * object that is shared among chunks.
+ */
+class WorkerPool : public SimpleRefCount<WorkerPool>
+{
+  public:
+    /**
+     * The function processing a chunk of items.
+     *
+     * Its arguments are the index of the thread running it, and the first and
+     * one past the last item of the chunk.
+     */
+    typedef std::function<void(uint32_t, uint32_t, uint32_t)> Job;
+
+    /**
+     * Create the pool, starting all threads except the calling one.
+     *
+     * \param nThreads The total number of threads, including the caller of Run.
+     */
+    WorkerPool(uint32_t nThreads);
+
+    ~WorkerPool(); //!< Destructor, joins all threads
+
+    /**
+     * Get the number of threads of the pool, including the caller of Run.
+     *
+     * \return The number of threads.
+     */
+    uint32_t GetNThreads() const;
+
+    /**
+     * Process the items in [0, nItems) and wait for completion.
+     *
+     * \param nItems The number of items.
+     * \param job The function to run on each chunk.
+     */
+    void Run(uint32_t nItems, const Job& job);
+
+  private:
+    /**
+     * Loop of the background threads.
+     *
+     * \param thread The index of the thread.
+     */
+    void Work(uint32_t thread);
+
+    /**
+     * Run the job on the chunk of a thread.
+     *
+     * \param thread The index of the thread.
+     */
+    void RunChunk(uint32_t thread);
+
+    std::vector<std::thread> m_threads; //!< The background threads
+    std::mutex m_mutex;                 //!< Protects the fields below
+    std::condition_variable m_start;    //!< Signals a new job to the background threads
+    std::condition_variable m_done;     //!< Signals the completion of a chunk
+    const Job* m_job;                   //!< The job being run
+    uint32_t m_nItems;                  //!< The number of items of the job
+    uint64_t m_generation;              //!< Increased at each job
+    uint32_t m_pending;                 //!< Background chunks still running
+    bool m_stop;                        //!< Whether threads should exit
+};
+
+} // namespace lorawan
+
+} // namespace ns3
+#endif /* WORKER_POOL_H */
@@ -7,17 +7,31 @@
  */
 
 // Include headers of classes to test
+#include "utilities.h"
+
+#include "ns3/basic-energy-source-helper.h"
+#include "ns3/boolean.h"
 #include "ns3/constant-position-mobility-model.h"
+#include "ns3/constant-velocity-mobility-model.h"
+#include "ns3/double.h"
 #include "ns3/log.h"
+#include "ns3/lora-end-device-population.h"
 #include "ns3/lora-helper.h"
+#include "ns3/lora-radio-energy-model-helper.h"
+#include "ns3/lorawan-frame-view.h"
 #include "ns3/mobility-helper.h"
 #include "ns3/one-shot-sender-helper.h"
+#include "ns3/pointer.h"
+#include "ns3/random-variable-stream.h"
 #include "ns3/simple-end-device-lora-phy.h"
 #include "ns3/simple-gateway-lora-phy.h"
+#include "ns3/uinteger.h"
 
 // An essential include is test.h
 #include "ns3/test.h"
 
+#include <fstream>
+
 using namespace ns3;
 using namespace lorawan;
 
@@ -37,6 +51,16 @@ class InterferenceTest : public TestCase
 
   private:
     void DoRun() override;
+
+    /**
+     * Interference source providing three weak signals overlapping each
+     * event.
+     *
+     * \param event The event being received.
+     * \param interferers The vector to fill with the overlapping signals.
+     */
+    void ProvideInterferers(Ptr<LoraInterferenceHelper::Event> event,
+                            std::vector<Ptr<LoraInterferenceHelper::Event>>& interferers);
 };
 
 // Add some help text to this case to describe what it is intended to test
@@ -50,6 +74,21 @@ InterferenceTest::~InterferenceTest()
 {
 }
 
+void
+InterferenceTest::ProvideInterferers(Ptr<LoraInterferenceHelper::Event> event,
+                                     std::vector<Ptr<LoraInterferenceHelper::Event>>& interferers)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        interferers.push_back(Create<LoraInterferenceHelper::Event>(event->GetStartTime(),
+                                                                     event->GetDuration(),
+                                                                     -140,
+                                                                     event->GetSpreadingFactor(),
+                                                                     nullptr,
+                                                                     event->GetFrequency()));
+    }
+}
+
 // This method is the pure virtual method from class TestCase that every
 // TestCase must implement
 void
@@ -185,6 +224,167 @@ InterferenceTest::DoRun()
                           0,
                           "Packet did not survive interference as expected");
     interferenceHelper.ClearAllEvents();
+
+    // Events that end before the packet starts or start after it ends are ignored
+    event = interferenceHelper.Add(Seconds(5), Seconds(2), 14, 7, nullptr, frequency);
+    interferenceHelper.Add(Seconds(0), Seconds(5), 14 + 16, 7, nullptr, frequency);
+    interferenceHelper.Add(Seconds(7), Seconds(2), 14 + 16, 7, nullptr, frequency);
+    interferenceHelper.Add(Seconds(5), Seconds(2), 14 + 16, 7, nullptr, differentFrequency);
+    NS_TEST_EXPECT_MSG_EQ(interferenceHelper.IsDestroyedByInterference(event),
+                          0,
+                          "Packet was destroyed by non-overlapping interference");
+    NS_TEST_EXPECT_MSG_EQ(interferenceHelper.GetInterferers().size(),
+                          4,
+                          "Unexpected number of registered events");
+
+    // Overlapping events are found regardless of their end time
+    interferenceHelper.Add(Seconds(6), Seconds(3), 14 + 16, 7, nullptr, frequency);
+    NS_TEST_EXPECT_MSG_EQ(interferenceHelper.IsDestroyedByInterference(event),
+                          7,
+                          "Packet was not destroyed by interference as expected");
+    interferenceHelper.ClearAllEvents();
+
+    // Energy accumulated during reception gives the same outcomes as the
+    // energy summed at the end of it, for interferers added before and after
+    // the receiver locked on the packet
+    for (auto energyAccounting :
+         {LoraInterferenceHelper::RECOMPUTE, LoraInterferenceHelper::INCREMENTAL})
+    {
+        interferenceHelper.SetEnergyAccounting(energyAccounting);
+
+        // Same spreading factor interference is cumulative
+        interferenceHelper.Add(Seconds(0), Seconds(2), 14 + 16, 8, nullptr, frequency);
+        event = interferenceHelper.Add(Seconds(1), Seconds(2), 14, 7, nullptr, frequency);
+        interferenceHelper.LockOnEvent(event);
+        interferenceHelper.Add(Seconds(1), Seconds(2), 14 + 16, 8, nullptr, frequency);
+        interferenceHelper.Add(Seconds(2), Seconds(2), 14 + 16, 8, nullptr, frequency);
+        interferenceHelper.Add(Seconds(3), Seconds(2), 14 + 16, 8, nullptr, frequency);
+        interferenceHelper.Add(Seconds(1), Seconds(2), 14 + 16, 8, nullptr, differentFrequency);
+        NS_TEST_EXPECT_MSG_EQ(interferenceHelper.IsDestroyedByInterference(event),
+                              8,
+                              "Packet was not destroyed by interference as expected");
+        interferenceHelper.ClearAllEvents();
+
+        // Interference is not cumulative between different SFs
+        interferenceHelper.Add(Seconds(0), Seconds(2), 14 + 16, 8, nullptr, frequency);
+        event = interferenceHelper.Add(Seconds(1), Seconds(2), 14, 7, nullptr, frequency);
+        interferenceHelper.LockOnEvent(event);
+        interferenceHelper.Add(Seconds(1), Seconds(2), 14 + 16, 9, nullptr, frequency);
+        interferenceHelper.Add(Seconds(1), Seconds(2), 14 + 16, 10, nullptr, frequency);
+        NS_TEST_EXPECT_MSG_EQ(interferenceHelper.IsDestroyedByInterference(event),
+                              0,
+                              "Packet did not survive interference as expected");
+        interferenceHelper.ClearAllEvents();
+    }
+
+    // With the ALOHA collision matrix, any overlap with a packet of the same
+    // SF destroys the packet, regardless of power
+    LoraInterferenceHelper::collisionMatrix = LoraInterferenceHelper::ALOHA;
+    LoraInterferenceHelper alohaHelper;
+    LoraInterferenceHelper::collisionMatrix = LoraInterferenceHelper::GOURSAUD;
+    event = alohaHelper.Add(Seconds(0), Seconds(2), 14, 7, nullptr, frequency);
+    alohaHelper.Add(Seconds(1.9), Seconds(2), 14 - 100, 7, nullptr, frequency);
+    NS_TEST_EXPECT_MSG_EQ(alohaHelper.IsDestroyedByInterference(event),
+                          7,
+                          "Packet was not destroyed by interference as expected");
+    alohaHelper.ClearAllEvents();
+
+    event = alohaHelper.Add(Seconds(0), Seconds(2), 14, 7, nullptr, frequency);
+    alohaHelper.Add(Seconds(0), Seconds(2), 14 + 100, 8, nullptr, frequency);
+    alohaHelper.Add(Seconds(2), Seconds(2), 14 + 100, 7, nullptr, frequency);
+    NS_TEST_EXPECT_MSG_EQ(alohaHelper.IsDestroyedByInterference(event),
+                          0,
+                          "Packet did not survive interference as expected");
+    alohaHelper.ClearAllEvents();
+
+    // Events that are dropped are reused for later signals
+    LoraInterferenceHelper pooledHelper;
+    for (int i = 0; i < 10; i++)
+    {
+        Simulator::Schedule(Seconds(10 * i), [&pooledHelper, frequency]() {
+            pooledHelper.Add(Seconds(1), 14, 7, nullptr, frequency);
+        });
+    }
+    Simulator::Stop(Seconds(100));
+    Simulator::Run();
+    NS_TEST_EXPECT_MSG_EQ(pooledHelper.GetNAllocatedEvents(),
+                          1,
+                          "Dropped events were not reused");
+    NS_TEST_EXPECT_MSG_EQ(pooledHelper.GetNRecycledEvents(), 9, "Dropped events were not reused");
+
+    // Old events are dropped even if no new event is added
+    NS_TEST_EXPECT_MSG_EQ(pooledHelper.GetInterferers().size(),
+                          0,
+                          "Old events were not dropped");
+    NS_TEST_EXPECT_MSG_EQ(pooledHelper.GetPeakEvents(), 1, "Unexpected peak number of events");
+    Simulator::Destroy();
+
+    // The pool keeps at most as many events as the helper
+    LoraInterferenceHelper cappedHelper;
+    for (int i = 0; i < 4; i++)
+    {
+        cappedHelper.Add(Seconds(1), 14, 7, nullptr, frequency);
+    }
+    cappedHelper.ClearAllEvents();
+    cappedHelper.SetMaxEvents(2);
+    for (int i = 0; i < 4; i++)
+    {
+        cappedHelper.Add(Seconds(1), 14, 7, nullptr, frequency);
+    }
+    NS_TEST_EXPECT_MSG_EQ(cappedHelper.GetNAllocatedEvents(),
+                          5,
+                          "The pool kept more events than the cap");
+    NS_TEST_EXPECT_MSG_EQ(cappedHelper.GetNRecycledEvents(), 3, "Evicted events were not reused");
+    cappedHelper.ClearAllEvents();
+
+    // Signals provided by an interference source are not added to the pool
+    LoraInterferenceHelper sourcedHelper;
+    sourcedHelper.SetInterferenceSource(
+        MakeCallback(&InterferenceTest::ProvideInterferers, this));
+    for (int i = 0; i < 3; i++)
+    {
+        event = sourcedHelper.Add(Seconds(1), 14, 7, nullptr, frequency);
+        NS_TEST_EXPECT_MSG_EQ(sourcedHelper.IsDestroyedByInterference(event),
+                              0,
+                              "Packet did not survive weak interference");
+    }
+    NS_TEST_EXPECT_MSG_EQ(sourcedHelper.GetNAllocatedEvents(),
+                          3,
+                          "Unexpected number of allocated events");
+    NS_TEST_EXPECT_MSG_EQ(sourcedHelper.GetNRecycledEvents(),
+                          0,
+                          "Signals of the interference source entered the pool");
+
+    // Events are kept for the retention horizon after they end
+    LoraInterferenceHelper boundedHelper;
+    boundedHelper.SetRetentionHorizon(Seconds(5));
+    boundedHelper.Add(Seconds(1), 14, 12, nullptr, frequency);
+    Simulator::Stop(Seconds(5.5));
+    Simulator::Run();
+    NS_TEST_EXPECT_MSG_EQ(boundedHelper.GetInterferers().size(),
+                          1,
+                          "Event was dropped before the retention horizon");
+    Simulator::Stop(Seconds(1));
+    Simulator::Run();
+    NS_TEST_EXPECT_MSG_EQ(boundedHelper.GetInterferers().size(),
+                          0,
+                          "Event was not dropped after the retention horizon");
+    Simulator::Destroy();
+
+    // The number of events is capped, and the events that ended first are
+    // evicted
+    boundedHelper.SetMaxEvents(2);
+    boundedHelper.Add(Seconds(3), 14, 12, nullptr, frequency);
+    boundedHelper.Add(Seconds(1), 14, 7, nullptr, differentFrequency);
+    boundedHelper.Add(Seconds(2), 14, 9, nullptr, frequency);
+    NS_TEST_EXPECT_MSG_EQ(boundedHelper.GetInterferers().size(), 2, "Events were not evicted");
+    NS_TEST_EXPECT_MSG_EQ(boundedHelper.GetNEvictedEvents(), 1, "Unexpected number of evictions");
+    NS_TEST_EXPECT_MSG_EQ(boundedHelper.GetInterferers().front()->GetFrequency(),
+                          frequency,
+                          "The event that ended first was not evicted");
+    NS_TEST_EXPECT_MSG_EQ(boundedHelper.GetPeakEvents(), 2, "Unexpected peak number of events");
+    boundedHelper.ClearAllEvents();
+    Simulator::Destroy();
 }
 
 /**
@@ -421,6 +621,57 @@ HeaderTest::DoRun()
     NS_TEST_EXPECT_MSG_EQ(linkCheckAns->GetGwCnt(),
                           1,
                           "Removed header's MAC command contents don't match");
+
+    /////////////////////////////////////
+    // Test the LorawanFrameView class //
+    /////////////////////////////////////
+    LoraFrameHeader uplinkFrameHdr;
+    uplinkFrameHdr.SetAsUplink();
+    uplinkFrameHdr.SetAdr(true);
+    uplinkFrameHdr.SetFCnt(300);
+    uplinkFrameHdr.SetAddress(LoraDeviceAddress(56, 1864));
+    uplinkFrameHdr.AddLinkCheckReq();
+    uplinkFrameHdr.AddLinkAdrAns(true, false, true);
+    LorawanMacHeader uplinkMacHdr;
+    uplinkMacHdr.SetMType(LorawanMacHeader::CONFIRMED_DATA_UP);
+
+    Ptr<Packet> uplink = Create<Packet>(10);
+    uplink->AddHeader(uplinkFrameHdr);
+    uplink->AddHeader(uplinkMacHdr);
+
+    LorawanFrameView view(uplink);
+    NS_TEST_EXPECT_MSG_EQ(uplink->GetSize(), 22, "The view modified the packet");
+    NS_TEST_EXPECT_MSG_EQ(unsigned(view.GetMType()),
+                          unsigned(LorawanMacHeader::CONFIRMED_DATA_UP),
+                          "View has the wrong MType");
+    NS_TEST_EXPECT_MSG_EQ(view.IsUplink(), true, "View has the wrong direction");
+    NS_TEST_EXPECT_MSG_EQ((view.GetAddress() == LoraDeviceAddress(56, 1864)),
+                          true,
+                          "View has the wrong address");
+    NS_TEST_EXPECT_MSG_EQ(view.GetFCnt(), 300, "View has the wrong FCnt");
+    NS_TEST_EXPECT_MSG_EQ(view.GetAdr(), true, "View has the wrong ADR bit");
+    NS_TEST_EXPECT_MSG_EQ(view.GetAck(), false, "View has the wrong ACK bit");
+    NS_TEST_EXPECT_MSG_EQ(unsigned(view.GetFOptsLen()), 3, "View has the wrong FOptsLen");
+    NS_TEST_EXPECT_MSG_EQ(view.GetCommands().GetN(), 2, "View has the wrong MAC commands");
+    const LinkAdrAnsValue* viewLinkAdrAns = view.FindMacCommand<LinkAdrAnsValue>();
+    NS_TEST_ASSERT_MSG_EQ((viewLinkAdrAns != nullptr), true, "View is missing a MAC command");
+    NS_TEST_EXPECT_MSG_EQ(viewLinkAdrAns->channelMaskAck,
+                          true,
+                          "View has the wrong MAC command contents");
+    NS_TEST_EXPECT_MSG_EQ(view.GetSerializedSize(), 11, "View parsed the wrong number of bytes");
+
+    // The view takes the direction of MAC commands from the MType
+    Ptr<Packet> downlink = Create<Packet>(10);
+    downlink->AddHeader(frameHdr);
+    downlink->AddHeader(macHdr);
+
+    LorawanFrameView downlinkView(downlink);
+    NS_TEST_EXPECT_MSG_EQ(downlinkView.IsUplink(), false, "View has the wrong direction");
+    const LinkCheckAnsValue* viewLinkCheckAns = downlinkView.FindMacCommand<LinkCheckAnsValue>();
+    NS_TEST_ASSERT_MSG_EQ((viewLinkCheckAns != nullptr), true, "View is missing a MAC command");
+    NS_TEST_EXPECT_MSG_EQ(unsigned(viewLinkCheckAns->margin),
+                          10,
+                          "View has the wrong MAC command contents");
 }
 
 /**
@@ -860,256 +1111,356 @@ ReceivePathTest::DoRun()
 /**
  * \ingroup lorawan
  *
- * It tests functionality of the LogicalLoraChannel, SubBand and LogicalLoraChannelHelper classes
+ * It tests that gateway reception paths are taken and released as packets come and go
  */
-class LogicalLoraChannelTest : public TestCase
+class ReceptionPathPoolTest : public TestCase
 {
   public:
-    LogicalLoraChannelTest();           //!< Default constructor
-    ~LogicalLoraChannelTest() override; //!< Destructor
+    ReceptionPathPoolTest();           //!< Default constructor
+    ~ReceptionPathPoolTest() override; //!< Destructor
 
   private:
     void DoRun() override;
+
+    /**
+     * Callback for tracing OccupiedReceptionPaths.
+     *
+     * \param oldValue The old value.
+     * \param newValue The new value.
+     */
+    void OccupiedReceptionPaths(int oldValue, int newValue);
+
+    /**
+     * Callback for tracing LostPacketBecauseNoMoreReceivers.
+     *
+     * \param packet The packet lost.
+     * \param node The receiver node id if any, 0 otherwise.
+     */
+    void NoMoreDemodulators(Ptr<const Packet> packet, uint32_t node);
+
+    /**
+     * Callback for tracing LostPacketBecauseNoMoreReceiversOnBoard.
+     *
+     * \param packet The packet lost.
+     * \param node The receiver node id if any, 0 otherwise.
+     * \param board The board that had no reception path available.
+     */
+    void NoMoreDemodulatorsOnBoard(Ptr<const Packet> packet, uint32_t node, uint32_t board);
+
+    /**
+     * Callback for tracing ReceivedPacket.
+     *
+     * \param packet The packet received.
+     * \param node The receiver node id if any, 0 otherwise.
+     */
+    void ReceivedPacket(Ptr<const Packet> packet, uint32_t node);
+
+    int m_noMoreDemodulatorsCalls = 0;   //!< Counter for LostPacketBecauseNoMoreReceivers calls
+    int m_receivedPacketCalls = 0;       //!< Counter for ReceivedPacket calls
+    int m_occupiedReceptionPaths = 0;    //!< Current number of OccupiedReceptionPaths
+    int m_maxOccupiedReceptionPaths = 0; //!< Max number of concurrent OccupiedReceptionPaths
+    std::vector<int> m_noMoreDemodulatorsOnBoardCalls =
+        std::vector<int>(2, 0); //!< Counters for LostPacketBecauseNoMoreReceiversOnBoard calls
 };
 
 // Add some help text to this case to describe what it is intended to test
-LogicalLoraChannelTest::LogicalLoraChannelTest()
-    : TestCase("Verify that LogicalLoraChannel and LogicalLoraChannelHelper work as expected")
+ReceptionPathPoolTest::ReceptionPathPoolTest()
+    : TestCase("Verify that reception paths are locked and freed")
 {
 }
 
 // Reminder that the test case should clean up after itself
-LogicalLoraChannelTest::~LogicalLoraChannelTest()
+ReceptionPathPoolTest::~ReceptionPathPoolTest()
 {
 }
 
-// This method is the pure virtual method from class TestCase that every
-// TestCase must implement
 void
-LogicalLoraChannelTest::DoRun()
+ReceptionPathPoolTest::OccupiedReceptionPaths(int oldValue, int newValue)
 {
-    NS_LOG_DEBUG("LogicalLoraChannelTest");
+    NS_LOG_FUNCTION(oldValue << newValue);
 
-    /////////////////////////////
-    // Test LogicalLoraChannel //
-    /////////////////////////////
+    m_occupiedReceptionPaths = newValue;
+    if (m_maxOccupiedReceptionPaths < newValue)
+    {
+        m_maxOccupiedReceptionPaths = newValue;
+    }
+}
 
-    // Setup
-    Ptr<LogicalLoraChannel> channel1 = CreateObject<LogicalLoraChannel>(868);
-    Ptr<LogicalLoraChannel> channel2 = CreateObject<LogicalLoraChannel>(868);
-    Ptr<LogicalLoraChannel> channel3 = CreateObject<LogicalLoraChannel>(868.1);
-    Ptr<LogicalLoraChannel> channel4 = CreateObject<LogicalLoraChannel>(868.001);
+void
+ReceptionPathPoolTest::NoMoreDemodulators(Ptr<const Packet> packet, uint32_t node)
+{
+    NS_LOG_FUNCTION(packet << node);
 
-    // Equality between channels
-    // Test the == and != operators
-    NS_TEST_EXPECT_MSG_EQ(channel1, channel2, "== operator doesn't work as expected");
-    NS_TEST_EXPECT_MSG_NE(channel1, channel3, "!= operator doesn't work as expected");
-    NS_TEST_EXPECT_MSG_NE(channel1, channel4, "!= operator doesn't work as expected");
+    m_noMoreDemodulatorsCalls++;
+}
 
-    //////////////////
-    // Test SubBand //
-    //////////////////
+void
+ReceptionPathPoolTest::NoMoreDemodulatorsOnBoard(Ptr<const Packet> packet,
+                                                 uint32_t node,
+                                                 uint32_t board)
+{
+    NS_LOG_FUNCTION(packet << node << board);
 
-    // Setup
-    SubBand subBand(868, 868.7, 0.01, 14);
-    Ptr<LogicalLoraChannel> channel5 = CreateObject<LogicalLoraChannel>(870);
+    m_noMoreDemodulatorsOnBoardCalls.at(board)++;
+}
 
-    // Test BelongsToSubBand
-    NS_TEST_EXPECT_MSG_EQ(subBand.BelongsToSubBand(channel3),
-                          true,
-                          "BelongsToSubBand does not behave as expected");
-    NS_TEST_EXPECT_MSG_EQ(subBand.BelongsToSubBand(channel3->GetFrequency()),
-                          true,
-                          "BelongsToSubBand does not behave as expected");
-    NS_TEST_EXPECT_MSG_EQ(subBand.BelongsToSubBand(channel5),
-                          false,
-                          "BelongsToSubBand does not behave as expected");
+void
+ReceptionPathPoolTest::ReceivedPacket(Ptr<const Packet> packet, uint32_t node)
+{
+    NS_LOG_FUNCTION(packet << node);
 
-    ///////////////////////////////////
-    // Test LogicalLoraChannelHelper //
-    ///////////////////////////////////
+    m_receivedPacketCalls++;
+}
 
-    // Setup
-    Ptr<LogicalLoraChannelHelper> channelHelper = CreateObject<LogicalLoraChannelHelper>();
-    SubBand subBand1(869, 869.4, 0.1, 27);
-    channel1 = CreateObject<LogicalLoraChannel>(868.1);
-    channel2 = CreateObject<LogicalLoraChannel>(868.3);
-    channel3 = CreateObject<LogicalLoraChannel>(868.5);
-    channel4 = CreateObject<LogicalLoraChannel>(869.1);
-    channel5 = CreateObject<LogicalLoraChannel>(869.3);
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+ReceptionPathPoolTest::DoRun()
+{
+    NS_LOG_DEBUG("ReceptionPathPoolTest");
+
+    Ptr<SimpleGatewayLoraPhy> gatewayPhy = CreateObject<SimpleGatewayLoraPhy>();
+    gatewayPhy->TraceConnectWithoutContext(
+        "LostPacketBecauseNoMoreReceivers",
+        MakeCallback(&ReceptionPathPoolTest::NoMoreDemodulators, this));
+    gatewayPhy->TraceConnectWithoutContext(
+        "ReceivedPacket",
+        MakeCallback(&ReceptionPathPoolTest::ReceivedPacket, this));
+    gatewayPhy->TraceConnectWithoutContext(
+        "OccupiedReceptionPaths",
+        MakeCallback(&ReceptionPathPoolTest::OccupiedReceptionPaths, this));
+
+    int nPaths = 16;
+    for (int i = 0; i < nPaths; i++)
+    {
+        gatewayPhy->AddReceptionPath();
+    }
 
-    // Channel diagram
-    //
-    // Channels      1      2      3                     4       5
-    // SubBands  868 ----- 0.1% ----- 868.7       869 ----- 1% ----- 869.4
+    // One more packet than paths arrives at the same time, on different
+    // frequencies so that they don't interfere. Once they end, the same number
+    // of packets can be received again.
+    for (int i = 0; i <= nPaths; i++)
+    {
+        for (auto start : {Seconds(1), Seconds(3)})
+        {
+            Simulator::Schedule(start,
+                                &SimpleGatewayLoraPhy::StartReceive,
+                                gatewayPhy,
+                                Create<Packet>(10),
+                                -20,
+                                7,
+                                Seconds(1),
+                                868.1 + 0.2 * i);
+        }
+    }
 
-    // Add SubBands and LogicalLoraChannels to the helper
-    channelHelper->AddSubBand(&subBand);
-    channelHelper->AddSubBand(&subBand1);
-    channelHelper->AddChannel(channel1);
-    channelHelper->AddChannel(channel2);
-    channelHelper->AddChannel(channel3);
-    channelHelper->AddChannel(channel4);
-    channelHelper->AddChannel(channel5);
+    Simulator::Stop(Hours(1));
+    Simulator::Run();
+    Simulator::Destroy();
 
-    // Duty Cycle tests
-    // (high level duty cycle behavior)
-    ///////////////////////////////////
+    NS_TEST_EXPECT_MSG_EQ(m_receivedPacketCalls, 2 * nPaths, "Unexpected number of receptions");
+    NS_TEST_EXPECT_MSG_EQ(m_noMoreDemodulatorsCalls, 2, "Unexpected number of lost packets");
+    NS_TEST_EXPECT_MSG_EQ(m_maxOccupiedReceptionPaths, nPaths, "Not all paths were used");
+    NS_TEST_EXPECT_MSG_EQ(m_occupiedReceptionPaths, 0, "Some paths were not freed");
 
-    channelHelper->AddEvent(Seconds(2), channel1);
-    Time expectedTimeOff = Seconds(2 / 0.01 - 2);
+    // A board with two paths serves two frequencies, while board 0 keeps one
+    // path for the others
+    m_receivedPacketCalls = 0;
+    gatewayPhy = CreateObject<SimpleGatewayLoraPhy>();
+    gatewayPhy->TraceConnectWithoutContext(
+        "ReceivedPacket",
+        MakeCallback(&ReceptionPathPoolTest::ReceivedPacket, this));
+    gatewayPhy->TraceConnectWithoutContext(
+        "LostPacketBecauseNoMoreReceiversOnBoard",
+        MakeCallback(&ReceptionPathPoolTest::NoMoreDemodulatorsOnBoard, this));
+    gatewayPhy->AddReceptionPath();
+    uint32_t board = gatewayPhy->AddBoard(2, 2);
+    gatewayPhy->AddBoardFrequency(board, 868.1);
+    gatewayPhy->AddBoardFrequency(board, 868.3);
+
+    NS_TEST_EXPECT_MSG_EQ(board, 1, "Unexpected board index");
+    NS_TEST_EXPECT_MSG_EQ(gatewayPhy->GetBoard(868.3), board, "Frequency not dispatched to board");
+    NS_TEST_EXPECT_MSG_EQ(gatewayPhy->GetBoard(868.5), 0, "Frequency not dispatched to board 0");
+
+    for (auto frequencyMHz : {868.1, 868.3, 868.3, 868.5, 868.5})
+    {
+        Simulator::Schedule(Seconds(1),
+                            &SimpleGatewayLoraPhy::StartReceive,
+                            gatewayPhy,
+                            Create<Packet>(10),
+                            -20,
+                            7,
+                            Seconds(1),
+                            frequencyMHz);
+    }
 
-    // Waiting time is computed correctly
-    NS_TEST_EXPECT_MSG_EQ(channelHelper->GetWaitingTime(channel1),
-                          expectedTimeOff,
-                          "Waiting time doesn't behave as expected");
+    Simulator::Stop(Hours(1));
+    Simulator::Run();
+    Simulator::Destroy();
 
-    // Duty Cycle involves the whole SubBand, not just a channel
-    NS_TEST_EXPECT_MSG_EQ(channelHelper->GetWaitingTime(channel2),
-                          expectedTimeOff,
-                          "Waiting time doesn't behave as expected");
-    NS_TEST_EXPECT_MSG_EQ(channelHelper->GetWaitingTime(channel3),
-                          expectedTimeOff,
-                          "Waiting time doesn't behave as expected");
+    NS_TEST_EXPECT_MSG_EQ(m_receivedPacketCalls, 3, "Unexpected number of receptions");
+    NS_TEST_EXPECT_MSG_EQ(m_noMoreDemodulatorsOnBoardCalls[0], 1, "Unexpected losses on board 0");
+    NS_TEST_EXPECT_MSG_EQ(m_noMoreDemodulatorsOnBoardCalls[1], 1, "Unexpected losses on board 1");
+    NS_TEST_EXPECT_MSG_EQ(gatewayPhy->GetNLostPacketsNoMoreReceivers(board),
+                          1,
+                          "Board counter doesn't match the trace source");
 
-    // Other bands are not affected by this transmission
-    NS_TEST_EXPECT_MSG_EQ(channelHelper->GetWaitingTime(channel4),
-                          Time(0),
-                          "Waiting time affects other subbands");
-    NS_TEST_EXPECT_MSG_EQ(channelHelper->GetWaitingTime(channel5),
-                          Time(0),
-                          "Waiting time affects other subbands");
+    // Resetting the reception paths only removes the ones of board 0
+    gatewayPhy->ResetReceptionPaths();
+    NS_TEST_EXPECT_MSG_EQ(gatewayPhy->GetNBoards(), 2, "Boards were removed");
 }
 
 /**
  * \ingroup lorawan
  *
- * It tests the correctness of the LoraPhy::GetOnAirTime calculator against a number of pre-sourced
- * time values of known scenarios
+ * It tests the recovery of packets by gateways performing successive
+ * interference cancellation
  */
-class TimeOnAirTest : public TestCase
+class SicTest : public TestCase
 {
   public:
-    TimeOnAirTest();           //!< Default constructor
-    ~TimeOnAirTest() override; //!< Destructor
+    SicTest();           //!< Default constructor
+    ~SicTest() override; //!< Destructor
 
   private:
     void DoRun() override;
+
+    /**
+     * Callback for tracing ReceivedPacket.
+     *
+     * \param packet The packet received.
+     * \param node The receiver node id if any, 0 otherwise.
+     */
+    void ReceivedPacket(Ptr<const Packet> packet, uint32_t node);
+
+    /**
+     * Callback for tracing RecoveredPacketBySic.
+     *
+     * \param packet The packet recovered.
+     * \param node The receiver node id if any, 0 otherwise.
+     */
+    void RecoveredPacket(Ptr<const Packet> packet, uint32_t node);
+
+    int m_receivedPacketCalls = 0;  //!< Counter for ReceivedPacket calls
+    int m_recoveredPacketCalls = 0; //!< Counter for RecoveredPacketBySic calls
 };
 
 // Add some help text to this case to describe what it is intended to test
-TimeOnAirTest::TimeOnAirTest()
-    : TestCase(
-          "Verify that LoraPhy's function to compute the time on air of a packet works as expected")
+SicTest::SicTest()
+    : TestCase("Verify that gateways recover packets with successive interference cancellation")
 {
 }
 
 // Reminder that the test case should clean up after itself
-TimeOnAirTest::~TimeOnAirTest()
+SicTest::~SicTest()
+{
+}
+
+void
+SicTest::ReceivedPacket(Ptr<const Packet> packet, uint32_t node)
+{
+    NS_LOG_FUNCTION(packet << node);
+
+    m_receivedPacketCalls++;
+}
+
+void
+SicTest::RecoveredPacket(Ptr<const Packet> packet, uint32_t node)
 {
+    NS_LOG_FUNCTION(packet << node);
+
+    m_recoveredPacketCalls++;
 }
 
 // This method is the pure virtual method from class TestCase that every
 // TestCase must implement
 void
-TimeOnAirTest::DoRun()
+SicTest::DoRun()
 {
-    NS_LOG_DEBUG("TimeOnAirTest");
+    NS_LOG_DEBUG("SicTest");
 
-    Ptr<Packet> packet;
-    Time duration;
+    // A weak packet overlaps with two stronger packets, one at its beginning
+    // and one at its end, that don't overlap each other. The strong packets
+    // are received, but both need to be cancelled to recover the weak one.
+    for (uint32_t sicDepth : {0, 1, 2})
+    {
+        m_receivedPacketCalls = 0;
+        m_recoveredPacketCalls = 0;
+
+        Ptr<SimpleGatewayLoraPhy> gatewayPhy = CreateObject<SimpleGatewayLoraPhy>();
+        gatewayPhy->SetAttribute("SicDepth", UintegerValue(sicDepth));
+        gatewayPhy->TraceConnectWithoutContext("ReceivedPacket",
+                                               MakeCallback(&SicTest::ReceivedPacket, this));
+        gatewayPhy->TraceConnectWithoutContext("RecoveredPacketBySic",
+                                               MakeCallback(&SicTest::RecoveredPacket, this));
+        for (int i = 0; i < 3; i++)
+        {
+            gatewayPhy->AddReceptionPath();
+        }
+
+        for (auto packet : {std::make_pair(Seconds(1), -100.0),
+                            std::make_pair(Seconds(0.3), -90.0),
+                            std::make_pair(Seconds(1.5), -90.0)})
+        {
+            Simulator::Schedule(packet.first,
+                                &SimpleGatewayLoraPhy::StartReceive,
+                                gatewayPhy,
+                                Create<Packet>(10),
+                                packet.second,
+                                7,
+                                Seconds(1),
+                                868.1);
+        }
+
+        Simulator::Stop(Hours(1));
+        Simulator::Run();
+        Simulator::Destroy();
+
+        NS_TEST_EXPECT_MSG_EQ(m_receivedPacketCalls,
+                              sicDepth == 2 ? 3 : 2,
+                              "Unexpected number of receptions with SIC depth " << sicDepth);
+        NS_TEST_EXPECT_MSG_EQ(m_recoveredPacketCalls,
+                              sicDepth == 2 ? 1 : 0,
+                              "Unexpected number of recovered packets with SIC depth "
+                                  << sicDepth);
+    }
 
-    // Available parameters:
-    // PayloadSize, SF, HeaderDisabled, CodingRate, Bandwidth, nPreambleSyms, crcEnabled,
-    // lowDROptimization
-
-    // Starting parameters
-    packet = Create<Packet>(10);
-    LoraTxParameters txParams;
-    txParams.sf = 7;
-    txParams.headerDisabled = false;
-    txParams.codingRate = 1;
-    txParams.bandwidthHz = 125000;
-    txParams.nPreamble = 8;
-    txParams.crcEnabled = true;
-    txParams.lowDataRateOptimizationEnabled = false;
-
-    duration = LoraPhy::GetOnAirTime(packet, txParams);
-    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.041216, 0.0001, "Unexpected duration");
-
-    txParams.sf = 8;
-    duration = LoraPhy::GetOnAirTime(packet, txParams);
-    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.072192, 0.0001, "Unexpected duration");
-
-    txParams.headerDisabled = true;
-    duration = LoraPhy::GetOnAirTime(packet, txParams);
-    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.072192, 0.0001, "Unexpected duration");
-
-    txParams.codingRate = 2;
-    duration = LoraPhy::GetOnAirTime(packet, txParams);
-    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.078336, 0.0001, "Unexpected duration");
-
-    txParams.nPreamble = 10;
-    duration = LoraPhy::GetOnAirTime(packet, txParams);
-    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.082432, 0.0001, "Unexpected duration");
-
-    txParams.lowDataRateOptimizationEnabled = true;
-    duration = LoraPhy::GetOnAirTime(packet, txParams);
-    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.082432, 0.0001, "Unexpected duration");
-
-    txParams.sf = 10;
-    duration = LoraPhy::GetOnAirTime(packet, txParams);
-    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.280576, 0.0001, "Unexpected duration");
-
-    txParams.bandwidthHz = 250000;
-    duration = LoraPhy::GetOnAirTime(packet, txParams);
-    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.14028, 0.0001, "Unexpected duration");
-
-    txParams.bandwidthHz = 500000;
-    duration = LoraPhy::GetOnAirTime(packet, txParams);
-    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.070144, 0.0001, "Unexpected duration");
-
-    txParams.headerDisabled = false;
-    duration = LoraPhy::GetOnAirTime(packet, txParams);
-    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.082432, 0.0001, "Unexpected duration");
-
-    txParams.nPreamble = 8;
-    duration = LoraPhy::GetOnAirTime(packet, txParams);
-    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.078336, 0.0001, "Unexpected duration");
-
-    txParams.sf = 12;
-    duration = LoraPhy::GetOnAirTime(packet, txParams);
-    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.264192, 0.0001, "Unexpected duration");
-
-    packet = Create<Packet>(50);
-    duration = LoraPhy::GetOnAirTime(packet, txParams);
-    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.657408, 0.0001, "Unexpected duration");
-
-    txParams.bandwidthHz = 125000;
-    duration = LoraPhy::GetOnAirTime(packet, txParams);
-    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 2.629632, 0.0001, "Unexpected duration");
-
-    txParams.codingRate = 1;
-    duration = LoraPhy::GetOnAirTime(packet, txParams);
-    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 2.301952, 0.0001, "Unexpected duration");
+    // The same signals can only be cancelled if the receiver is sensitive
+    // enough to decode them
+    LoraInterferenceHelper helper;
+    Ptr<LoraInterferenceHelper::Event> event =
+        helper.Add(Seconds(1), Seconds(1), -100, 7, nullptr, 868.1);
+    helper.Add(Seconds(0.3), Seconds(1), -90, 7, nullptr, 868.1);
+    helper.Add(Seconds(1.5), Seconds(1), -90, 7, nullptr, 868.1);
+    const double deafSensitivity[6] = {-85, -85, -85, -85, -85, -85};
+    uint32_t nCancelled = 0;
+    NS_TEST_EXPECT_MSG_EQ(
+        helper.IsDestroyedAfterCancellation(event, 2, GatewayLoraPhy::sensitivity, nCancelled),
+        0,
+        "Packet was not recovered by cancelling signals above sensitivity");
+    NS_TEST_EXPECT_MSG_EQ(nCancelled, 2, "Unexpected number of cancelled signals");
+    NS_TEST_EXPECT_MSG_EQ(
+        helper.IsDestroyedAfterCancellation(event, 2, deafSensitivity, nCancelled),
+        7,
+        "Packet was recovered by cancelling signals below sensitivity");
+    NS_TEST_EXPECT_MSG_EQ(nCancelled, 0, "Signals below sensitivity were cancelled");
+    helper.ClearAllEvents();
 }
 
 /**
  * \ingroup lorawan
  *
- * It tests sending packets over a LoRa physical channel between multiple devices and the resulting
- * possible outcomes
+ * It tests the early release of the reception paths of packets destroyed by
+ * interference
  */
-class PhyConnectivityTest : public TestCase
+class PreambleCaptureTest : public TestCase
 {
   public:
-    PhyConnectivityTest();           //!< Default constructor
-    ~PhyConnectivityTest() override; //!< Destructor
+    PreambleCaptureTest();           //!< Default constructor
+    ~PreambleCaptureTest() override; //!< Destructor
 
-    /**
-     * Reset counters and end devices' PHYs for new sub test case.
-     */
-    void Reset();
+  private:
+    void DoRun() override;
 
     /**
      * Callback for tracing ReceivedPacket.
@@ -1119,14 +1470,6 @@ class PhyConnectivityTest : public TestCase
      */
     void ReceivedPacket(Ptr<const Packet> packet, uint32_t node);
 
-    /**
-     * Callback for tracing LostPacketBecauseUnderSensitivity.
-     *
-     * \param packet The packet lost.
-     * \param node The receiver node id if any, 0 otherwise.
-     */
-    void UnderSensitivity(Ptr<const Packet> packet, uint32_t node);
-
     /**
      * Callback for tracing LostPacketBecauseInterference.
      *
@@ -1136,434 +1479,2459 @@ class PhyConnectivityTest : public TestCase
     void Interference(Ptr<const Packet> packet, uint32_t node);
 
     /**
-     * Callback for tracing LostPacketBecauseWrongFrequency.
+     * Callback for tracing LostPacketBecauseNoMoreReceivers.
      *
      * \param packet The packet lost.
      * \param node The receiver node id if any, 0 otherwise.
      */
-    void WrongFrequency(Ptr<const Packet> packet, uint32_t node);
+    void NoMoreDemodulators(Ptr<const Packet> packet, uint32_t node);
 
     /**
-     * Callback for tracing LostPacketBecauseWrongSpreadingFactor.
+     * Callback for tracing OccupiedReceptionPaths.
      *
-     * \param packet The packet lost.
-     * \param node The receiver node id if any, 0 otherwise.
+     * \param oldValue The old value.
+     * \param newValue The new value.
      */
-    void WrongSf(Ptr<const Packet> packet, uint32_t node);
+    void OccupiedReceptionPaths(int oldValue, int newValue);
 
     /**
-     * Compare two packets to check if they are equal.
+     * Send the packets of the scenario through a channel to a gateway using
+     * preamble capture.
      *
-     * \param packet1 A first packet.
-     * \param packet2 A second packet.
-     * \return True if their unique identifiers are equal,
-     * \return false otherwise.
+     * \param shared Whether the channel uses the shared air log.
      */
-    bool IsSamePacket(Ptr<Packet> packet1, Ptr<Packet> packet2);
-
-  private:
-    void DoRun() override;
-
-    Ptr<LoraChannel> channel;           //!< The LoRa channel used for tests
-    Ptr<SimpleEndDeviceLoraPhy> edPhy1; //!< The first end device's PHY layer used in tests
-    Ptr<SimpleEndDeviceLoraPhy> edPhy2; //!< The second end device's PHY layer used in tests
-    Ptr<SimpleEndDeviceLoraPhy> edPhy3; //!< The third end device's PHY layer used in tests
+    void RunChannelScenario(bool shared);
 
-    Ptr<Packet> m_latestReceivedPacket; //!< Pointer to track the last received packet
-    int m_receivedPacketCalls = 0;      //!< Counter for ReceivedPacket calls
-    int m_underSensitivityCalls = 0;    //!< Counter for LostPacketBecauseUnderSensitivity calls
-    int m_interferenceCalls = 0;        //!< Counter for LostPacketBecauseInterference calls
-    int m_wrongSfCalls = 0;             //!< Counter for LostPacketBecauseWrongSpreadingFactor calls
-    int m_wrongFrequencyCalls = 0;      //!< Counter for LostPacketBecauseWrongFrequency calls
+    int m_receivedPacketCalls = 0;       //!< Counter for ReceivedPacket calls
+    int m_interferenceCalls = 0;         //!< Counter for LostPacketBecauseInterference calls
+    int m_noMoreDemodulatorsCalls = 0;   //!< Counter for LostPacketBecauseNoMoreReceivers calls
+    int m_maxOccupiedReceptionPaths = 0; //!< Max number of concurrent OccupiedReceptionPaths
 };
 
 // Add some help text to this case to describe what it is intended to test
-PhyConnectivityTest::PhyConnectivityTest()
-    : TestCase("Verify that PhyConnectivity works as expected")
+PreambleCaptureTest::PreambleCaptureTest()
+    : TestCase("Verify that gateways release the paths of packets destroyed by interference")
 {
 }
 
 // Reminder that the test case should clean up after itself
-PhyConnectivityTest::~PhyConnectivityTest()
+PreambleCaptureTest::~PreambleCaptureTest()
 {
 }
 
 void
-PhyConnectivityTest::ReceivedPacket(Ptr<const Packet> packet, uint32_t node)
+PreambleCaptureTest::ReceivedPacket(Ptr<const Packet> packet, uint32_t node)
 {
     NS_LOG_FUNCTION(packet << node);
 
     m_receivedPacketCalls++;
-
-    m_latestReceivedPacket = packet->Copy();
 }
 
 void
-PhyConnectivityTest::UnderSensitivity(Ptr<const Packet> packet, uint32_t node)
+PreambleCaptureTest::Interference(Ptr<const Packet> packet, uint32_t node)
 {
     NS_LOG_FUNCTION(packet << node);
 
-    m_underSensitivityCalls++;
+    m_interferenceCalls++;
 }
 
 void
-PhyConnectivityTest::Interference(Ptr<const Packet> packet, uint32_t node)
+PreambleCaptureTest::NoMoreDemodulators(Ptr<const Packet> packet, uint32_t node)
 {
     NS_LOG_FUNCTION(packet << node);
 
-    m_interferenceCalls++;
+    m_noMoreDemodulatorsCalls++;
 }
 
 void
-PhyConnectivityTest::WrongSf(Ptr<const Packet> packet, uint32_t node)
+PreambleCaptureTest::OccupiedReceptionPaths(int oldValue, int newValue)
 {
-    NS_LOG_FUNCTION(packet << node);
+    NS_LOG_FUNCTION(oldValue << newValue);
 
-    m_wrongSfCalls++;
+    if (m_maxOccupiedReceptionPaths < newValue)
+    {
+        m_maxOccupiedReceptionPaths = newValue;
+    }
 }
 
 void
-PhyConnectivityTest::WrongFrequency(Ptr<const Packet> packet, uint32_t node)
+PreambleCaptureTest::RunChannelScenario(bool shared)
 {
-    NS_LOG_FUNCTION(packet << node);
-
-    m_wrongFrequencyCalls++;
-}
+    m_receivedPacketCalls = 0;
+    m_interferenceCalls = 0;
+    m_noMoreDemodulatorsCalls = 0;
+    m_maxOccupiedReceptionPaths = 0;
+
+    Ptr<LoraChannel> channel = CreateChannel();
+    channel->SetAttribute("SharedAirLog", BooleanValue(shared));
+
+    Ptr<SimpleGatewayLoraPhy> gatewayPhy = CreateObject<SimpleGatewayLoraPhy>();
+    gatewayPhy->SetAttribute("PreambleCapture", BooleanValue(true));
+    gatewayPhy->TraceConnectWithoutContext(
+        "ReceivedPacket",
+        MakeCallback(&PreambleCaptureTest::ReceivedPacket, this));
+    gatewayPhy->TraceConnectWithoutContext("LostPacketBecauseInterference",
+                                           MakeCallback(&PreambleCaptureTest::Interference, this));
+    gatewayPhy->TraceConnectWithoutContext(
+        "LostPacketBecauseNoMoreReceivers",
+        MakeCallback(&PreambleCaptureTest::NoMoreDemodulators, this));
+    gatewayPhy->TraceConnectWithoutContext(
+        "OccupiedReceptionPaths",
+        MakeCallback(&PreambleCaptureTest::OccupiedReceptionPaths, this));
+    gatewayPhy->AddReceptionPath();
+    gatewayPhy->AddReceptionPath();
+    Ptr<ConstantPositionMobilityModel> gatewayMobility =
+        CreateObject<ConstantPositionMobilityModel>();
+    gatewayMobility->SetPosition(Vector(0.0, 0.0, 0.0));
+    gatewayPhy->SetMobility(gatewayMobility);
+    gatewayPhy->SetChannel(channel);
+    channel->Add(gatewayPhy);
+
+    // The same packets as above, received 10 dB apart since the senders only
+    // differ in their transmission power
+    LoraTxParameters txParams;
+    txParams.sf = 7;
+    for (auto packet : {std::make_pair(Seconds(1), 14.0),
+                        std::make_pair(Seconds(1.01), 24.0),
+                        std::make_pair(Seconds(1.02), 14.0)})
+    {
+        Ptr<SimpleEndDeviceLoraPhy> phy = CreateObject<SimpleEndDeviceLoraPhy>();
+        Ptr<ConstantPositionMobilityModel> mobility =
+            CreateObject<ConstantPositionMobilityModel>();
+        mobility->SetPosition(Vector(600.0, 0.0, 0.0));
+        phy->SetMobility(mobility);
+        phy->SetChannel(channel);
+        channel->Add(phy);
+
+        Simulator::Schedule(packet.first,
+                            &SimpleEndDeviceLoraPhy::Send,
+                            phy,
+                            Create<Packet>(10),
+                            txParams,
+                            868.1,
+                            packet.second);
+    }
 
-bool
-PhyConnectivityTest::IsSamePacket(Ptr<Packet> packet1, Ptr<Packet> packet2)
-{
-    return packet1->GetUid() == packet2->GetUid();
+    Simulator::Stop(Hours(1));
+    Simulator::Run();
+    Simulator::Destroy();
 }
 
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
 void
-PhyConnectivityTest::Reset()
+PreambleCaptureTest::DoRun()
 {
-    m_receivedPacketCalls = 0;
-    m_underSensitivityCalls = 0;
-    m_interferenceCalls = 0;
-    m_wrongSfCalls = 0;
-    m_wrongFrequencyCalls = 0;
+    NS_LOG_DEBUG("PreambleCaptureTest");
+
+    // A weak packet is followed by a stronger one that destroys it, and by
+    // another weak one that the stronger one destroys. Without capture, the
+    // first two take the only paths and the third is lost for lack of paths.
+    // With capture, the first packet releases its path when the stronger one
+    // arrives, and the third one doesn't take a path.
+    for (bool capture : {false, true})
+    {
+        m_receivedPacketCalls = 0;
+        m_interferenceCalls = 0;
+        m_noMoreDemodulatorsCalls = 0;
+        m_maxOccupiedReceptionPaths = 0;
+
+        Ptr<SimpleGatewayLoraPhy> gatewayPhy = CreateObject<SimpleGatewayLoraPhy>();
+        gatewayPhy->SetAttribute("PreambleCapture", BooleanValue(capture));
+        gatewayPhy->TraceConnectWithoutContext(
+            "ReceivedPacket",
+            MakeCallback(&PreambleCaptureTest::ReceivedPacket, this));
+        gatewayPhy->TraceConnectWithoutContext(
+            "LostPacketBecauseInterference",
+            MakeCallback(&PreambleCaptureTest::Interference, this));
+        gatewayPhy->TraceConnectWithoutContext(
+            "LostPacketBecauseNoMoreReceivers",
+            MakeCallback(&PreambleCaptureTest::NoMoreDemodulators, this));
+        gatewayPhy->TraceConnectWithoutContext(
+            "OccupiedReceptionPaths",
+            MakeCallback(&PreambleCaptureTest::OccupiedReceptionPaths, this));
+        gatewayPhy->AddReceptionPath();
+        gatewayPhy->AddReceptionPath();
+
+        for (auto packet : {std::make_pair(Seconds(1), -100.0),
+                            std::make_pair(Seconds(1.5), -90.0),
+                            std::make_pair(Seconds(1.6), -100.0)})
+        {
+            Simulator::Schedule(packet.first,
+                                &SimpleGatewayLoraPhy::StartReceive,
+                                gatewayPhy,
+                                Create<Packet>(10),
+                                packet.second,
+                                7,
+                                Seconds(1),
+                                868.1);
+        }
+
+        Simulator::Stop(Hours(1));
+        Simulator::Run();
+        Simulator::Destroy();
+
+        NS_TEST_EXPECT_MSG_EQ(m_receivedPacketCalls, 1, "The strong packet was not received");
+        NS_TEST_EXPECT_MSG_EQ(m_interferenceCalls,
+                              capture ? 2 : 1,
+                              "Unexpected number of packets lost to interference");
+        NS_TEST_EXPECT_MSG_EQ(m_noMoreDemodulatorsCalls,
+                              capture ? 0 : 1,
+                              "Unexpected number of packets lost for lack of paths");
+        NS_TEST_EXPECT_MSG_EQ(m_maxOccupiedReceptionPaths,
+                              capture ? 1 : 2,
+                              "Unexpected number of occupied paths");
+    }
 
-    Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel>();
-    loss->SetPathLossExponent(3.76);
-    loss->SetReference(1, 7.7);
+    // Capture works the same when interferers are looked up in the shared air log
+    for (bool shared : {false, true})
+    {
+        RunChannelScenario(shared);
+
+        NS_TEST_EXPECT_MSG_EQ(m_receivedPacketCalls, 1, "The strong packet was not received");
+        NS_TEST_EXPECT_MSG_EQ(m_interferenceCalls,
+                              2,
+                              "Destroyed packets not released with shared log " << shared);
+        NS_TEST_EXPECT_MSG_EQ(m_noMoreDemodulatorsCalls,
+                              0,
+                              "Packets lost for lack of paths with shared log " << shared);
+        NS_TEST_EXPECT_MSG_EQ(m_maxOccupiedReceptionPaths,
+                              1,
+                              "Unexpected number of occupied paths with shared log " << shared);
+    }
+}
 
-    Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel>();
+/**
+ * \ingroup lorawan
+ *
+ * It tests functionality of the LogicalLoraChannel, SubBand and LogicalLoraChannelHelper classes
+ */
+class LogicalLoraChannelTest : public TestCase
+{
+  public:
+    LogicalLoraChannelTest();           //!< Default constructor
+    ~LogicalLoraChannelTest() override; //!< Destructor
 
-    // Create the channel
-    channel = CreateObject<LoraChannel>(loss, delay);
+  private:
+    void DoRun() override;
+};
 
-    // Connect PHYs
-    edPhy1 = CreateObject<SimpleEndDeviceLoraPhy>();
-    edPhy2 = CreateObject<SimpleEndDeviceLoraPhy>();
-    edPhy3 = CreateObject<SimpleEndDeviceLoraPhy>();
+// Add some help text to this case to describe what it is intended to test
+LogicalLoraChannelTest::LogicalLoraChannelTest()
+    : TestCase("Verify that LogicalLoraChannel and LogicalLoraChannelHelper work as expected")
+{
+}
 
-    edPhy1->SetFrequency(868.1);
-    edPhy2->SetFrequency(868.1);
-    edPhy3->SetFrequency(868.1);
+// Reminder that the test case should clean up after itself
+LogicalLoraChannelTest::~LogicalLoraChannelTest()
+{
+}
 
-    Ptr<ConstantPositionMobilityModel> mob1 = CreateObject<ConstantPositionMobilityModel>();
-    Ptr<ConstantPositionMobilityModel> mob2 = CreateObject<ConstantPositionMobilityModel>();
-    Ptr<ConstantPositionMobilityModel> mob3 = CreateObject<ConstantPositionMobilityModel>();
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+LogicalLoraChannelTest::DoRun()
+{
+    NS_LOG_DEBUG("LogicalLoraChannelTest");
 
-    mob1->SetPosition(Vector(0.0, 0.0, 0.0));
-    mob2->SetPosition(Vector(10.0, 0.0, 0.0));
-    mob3->SetPosition(Vector(20.0, 0.0, 0.0));
+    /////////////////////////////
+    // Test LogicalLoraChannel //
+    /////////////////////////////
 
-    edPhy1->SetMobility(mob1);
-    edPhy2->SetMobility(mob2);
-    edPhy3->SetMobility(mob3);
+    // Setup
+    Ptr<LogicalLoraChannel> channel1 = CreateObject<LogicalLoraChannel>(868);
+    Ptr<LogicalLoraChannel> channel2 = CreateObject<LogicalLoraChannel>(868);
+    Ptr<LogicalLoraChannel> channel3 = CreateObject<LogicalLoraChannel>(868.1);
+    Ptr<LogicalLoraChannel> channel4 = CreateObject<LogicalLoraChannel>(868.001);
 
-    edPhy1->SwitchToStandby();
-    edPhy2->SwitchToStandby();
-    edPhy3->SwitchToStandby();
+    // Equality between channels
+    // Test the == and != operators
+    NS_TEST_EXPECT_MSG_EQ(channel1, channel2, "== operator doesn't work as expected");
+    NS_TEST_EXPECT_MSG_NE(channel1, channel3, "!= operator doesn't work as expected");
+    NS_TEST_EXPECT_MSG_NE(channel1, channel4, "!= operator doesn't work as expected");
 
-    channel->Add(edPhy1);
-    channel->Add(edPhy2);
-    channel->Add(edPhy3);
+    //////////////////
+    // Test SubBand //
+    //////////////////
 
-    edPhy1->SetChannel(channel);
-    edPhy2->SetChannel(channel);
-    edPhy3->SetChannel(channel);
+    // Setup
+    SubBand subBand(868, 868.7, 0.01, 14);
+    Ptr<LogicalLoraChannel> channel5 = CreateObject<LogicalLoraChannel>(870);
+
+    // Test BelongsToSubBand
+    NS_TEST_EXPECT_MSG_EQ(subBand.BelongsToSubBand(channel3),
+                          true,
+                          "BelongsToSubBand does not behave as expected");
+    NS_TEST_EXPECT_MSG_EQ(subBand.BelongsToSubBand(channel3->GetFrequency()),
+                          true,
+                          "BelongsToSubBand does not behave as expected");
+    NS_TEST_EXPECT_MSG_EQ(subBand.BelongsToSubBand(channel5),
+                          false,
+                          "BelongsToSubBand does not behave as expected");
+
+    ///////////////////////////////////
+    // Test LogicalLoraChannelHelper //
+    ///////////////////////////////////
+
+    // Setup
+    Ptr<LogicalLoraChannelHelper> channelHelper = CreateObject<LogicalLoraChannelHelper>();
+    SubBand subBand1(869, 869.4, 0.1, 27);
+    channel1 = CreateObject<LogicalLoraChannel>(868.1);
+    channel2 = CreateObject<LogicalLoraChannel>(868.3);
+    channel3 = CreateObject<LogicalLoraChannel>(868.5);
+    channel4 = CreateObject<LogicalLoraChannel>(869.1);
+    channel5 = CreateObject<LogicalLoraChannel>(869.3);
+
+    // Channel diagram
+    //
+    // Channels      1      2      3                     4       5
+    // SubBands  868 ----- 0.1% ----- 868.7       869 ----- 1% ----- 869.4
+
+    // Add SubBands and LogicalLoraChannels to the helper
+    channelHelper->AddSubBand(&subBand);
+    channelHelper->AddSubBand(&subBand1);
+    channelHelper->AddChannel(channel1);
+    channelHelper->AddChannel(channel2);
+    channelHelper->AddChannel(channel3);
+    channelHelper->AddChannel(channel4);
+    channelHelper->AddChannel(channel5);
+
+    // Duty Cycle tests
+    // (high level duty cycle behavior)
+    ///////////////////////////////////
+
+    channelHelper->AddEvent(Seconds(2), channel1);
+    Time expectedTimeOff = Seconds(2 / 0.01 - 2);
+
+    // Waiting time is computed correctly
+    NS_TEST_EXPECT_MSG_EQ(channelHelper->GetWaitingTime(channel1),
+                          expectedTimeOff,
+                          "Waiting time doesn't behave as expected");
+
+    // Duty Cycle involves the whole SubBand, not just a channel
+    NS_TEST_EXPECT_MSG_EQ(channelHelper->GetWaitingTime(channel2),
+                          expectedTimeOff,
+                          "Waiting time doesn't behave as expected");
+    NS_TEST_EXPECT_MSG_EQ(channelHelper->GetWaitingTime(channel3),
+                          expectedTimeOff,
+                          "Waiting time doesn't behave as expected");
+
+    // Other bands are not affected by this transmission
+    NS_TEST_EXPECT_MSG_EQ(channelHelper->GetWaitingTime(channel4),
+                          Time(0),
+                          "Waiting time affects other subbands");
+    NS_TEST_EXPECT_MSG_EQ(channelHelper->GetWaitingTime(channel5),
+                          Time(0),
+                          "Waiting time affects other subbands");
+
+    // Channel selection
+    ////////////////////
+
+    // Only channels of the free SubBand can be picked, with equal probability
+    NS_TEST_EXPECT_MSG_EQ(channelHelper->GetMinWaitingTime(),
+                          Time(0),
+                          "A free SubBand doesn't allow transmitting now");
+    Ptr<UniformRandomVariable> uniformRV = CreateObject<UniformRandomVariable>();
+    uniformRV->SetStream(0);
+    int picked4 = 0;
+    int picked5 = 0;
+    for (int i = 0; i < 100; i++)
+    {
+        Ptr<LogicalLoraChannel> channel = channelHelper->GetChannelForTx(uniformRV);
+        picked4 += (channel == channel4);
+        picked5 += (channel == channel5);
+    }
+    NS_TEST_EXPECT_MSG_EQ(picked4 + picked5, 100, "A channel of a busy SubBand was picked");
+    NS_TEST_EXPECT_MSG_GT(picked4, 0, "A channel of the free SubBand was never picked");
+    NS_TEST_EXPECT_MSG_GT(picked5, 0, "A channel of the free SubBand was never picked");
+
+    // The earliest SubBand determines the waiting time
+    channelHelper->AddEvent(Seconds(1), channel4);
+    NS_TEST_EXPECT_MSG_EQ(channelHelper->GetMinWaitingTime(),
+                          Seconds(1 / 0.1 - 1),
+                          "Waiting time doesn't come from the earliest SubBand");
+    NS_TEST_EXPECT_MSG_EQ(bool(channelHelper->GetChannelForTx(uniformRV)),
+                          false,
+                          "A channel was picked while all SubBands are busy");
+
+    // Disabled channels are not considered
+    channelHelper->DisableChannel(3);
+    channelHelper->DisableChannel(4);
+    NS_TEST_EXPECT_MSG_EQ(channelHelper->GetMinWaitingTime(),
+                          expectedTimeOff,
+                          "Disabled channels affect the waiting time");
+    channelHelper->EnableChannel(4);
+    NS_TEST_EXPECT_MSG_EQ(channelHelper->GetMinWaitingTime(),
+                          Seconds(1 / 0.1 - 1),
+                          "Enabled channels don't affect the waiting time");
+
+    // Shared channel plans
+    ///////////////////////
+
+    Ptr<LogicalLoraChannelPlan> plan = Create<LogicalLoraChannelPlan>();
+    plan->AddSubBand(CreateObject<SubBand>(868, 868.6, 0.01, 14));
+    plan->AddChannel(channel1);
+    plan->AddChannel(channel2);
+    Ptr<LogicalLoraChannelHelper> helperA = CreateObject<LogicalLoraChannelHelper>(plan);
+    Ptr<LogicalLoraChannelHelper> helperB = CreateObject<LogicalLoraChannelHelper>(plan);
+
+    // Duty cycle and channel mask are kept by each device
+    helperA->AddEvent(Seconds(1), channel1);
+    NS_TEST_EXPECT_MSG_EQ(helperA->GetWaitingTime(channel2),
+                          Seconds(1 / 0.01 - 1),
+                          "Waiting time doesn't behave as expected");
+    NS_TEST_EXPECT_MSG_EQ(helperB->GetWaitingTime(channel2),
+                          Time(0),
+                          "A transmission affects another device sharing the plan");
+    helperA->DisableChannel(0);
+    NS_TEST_EXPECT_MSG_EQ(helperA->IsChannelEnabled(0), false, "The channel was not disabled");
+    NS_TEST_EXPECT_MSG_EQ(helperB->IsChannelEnabled(0),
+                          true,
+                          "The channel mask affects another device sharing the plan");
+    NS_TEST_EXPECT_MSG_EQ(channel1->IsEnabledForUplink(), true, "The shared channel was changed");
+
+    // Changing channels copies the plan, leaving other devices untouched
+    helperA->SetChannel(1, CreateObject<LogicalLoraChannel>(868.5));
+    NS_TEST_EXPECT_MSG_EQ(helperA->GetChannelPlan() != plan, true, "The plan was not copied");
+    NS_TEST_EXPECT_MSG_EQ(helperB->GetChannelPlan() == plan, true, "The plan was copied");
+    NS_TEST_EXPECT_MSG_EQ(helperA->GetChannelList()[1]->GetFrequency(),
+                          868.5,
+                          "The channel was not changed");
+    NS_TEST_EXPECT_MSG_EQ(helperB->GetChannelList()[1]->GetFrequency(),
+                          868.3,
+                          "A channel change affects another device sharing the plan");
+    NS_TEST_EXPECT_MSG_EQ(helperA->IsChannelEnabled(0), false, "The channel mask was lost");
+    NS_TEST_EXPECT_MSG_EQ(helperA->GetWaitingTime(channel1),
+                          Seconds(1 / 0.01 - 1),
+                          "The duty cycle timers were lost");
+
+    // A shared plan is only counted once
+    NS_TEST_EXPECT_MSG_LT(helperB->GetMemoryUsage(),
+                          helperA->GetMemoryUsage(),
+                          "A shared plan is not split among its devices");
+}
+
+/**
+ * \ingroup lorawan
+ *
+ * It tests the correctness of the LoraPhy::GetOnAirTime calculator against a number of pre-sourced
+ * time values of known scenarios
+ */
+class TimeOnAirTest : public TestCase
+{
+  public:
+    TimeOnAirTest();           //!< Default constructor
+    ~TimeOnAirTest() override; //!< Destructor
+
+  private:
+    void DoRun() override;
+};
+
+// Add some help text to this case to describe what it is intended to test
+TimeOnAirTest::TimeOnAirTest()
+    : TestCase(
+          "Verify that LoraPhy's function to compute the time on air of a packet works as expected")
+{
+}
+
+// Reminder that the test case should clean up after itself
+TimeOnAirTest::~TimeOnAirTest()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+TimeOnAirTest::DoRun()
+{
+    NS_LOG_DEBUG("TimeOnAirTest");
+
+    Ptr<Packet> packet;
+    Time duration;
+
+    // Available parameters:
+    // PayloadSize, SF, HeaderDisabled, CodingRate, Bandwidth, nPreambleSyms, crcEnabled,
+    // lowDROptimization
+
+    // Starting parameters
+    packet = Create<Packet>(10);
+    LoraTxParameters txParams;
+    txParams.sf = 7;
+    txParams.headerDisabled = false;
+    txParams.codingRate = 1;
+    txParams.bandwidthHz = 125000;
+    txParams.nPreamble = 8;
+    txParams.crcEnabled = true;
+    txParams.lowDataRateOptimizationEnabled = false;
+
+    duration = LoraPhy::GetOnAirTime(packet, txParams);
+    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.041216, 0.0001, "Unexpected duration");
+
+    txParams.sf = 8;
+    duration = LoraPhy::GetOnAirTime(packet, txParams);
+    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.072192, 0.0001, "Unexpected duration");
+
+    txParams.headerDisabled = true;
+    duration = LoraPhy::GetOnAirTime(packet, txParams);
+    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.072192, 0.0001, "Unexpected duration");
+
+    txParams.codingRate = 2;
+    duration = LoraPhy::GetOnAirTime(packet, txParams);
+    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.078336, 0.0001, "Unexpected duration");
+
+    txParams.nPreamble = 10;
+    duration = LoraPhy::GetOnAirTime(packet, txParams);
+    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.082432, 0.0001, "Unexpected duration");
+
+    txParams.lowDataRateOptimizationEnabled = true;
+    duration = LoraPhy::GetOnAirTime(packet, txParams);
+    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.082432, 0.0001, "Unexpected duration");
+
+    txParams.sf = 10;
+    duration = LoraPhy::GetOnAirTime(packet, txParams);
+    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.280576, 0.0001, "Unexpected duration");
+
+    txParams.bandwidthHz = 250000;
+    duration = LoraPhy::GetOnAirTime(packet, txParams);
+    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.14028, 0.0001, "Unexpected duration");
+
+    txParams.bandwidthHz = 500000;
+    duration = LoraPhy::GetOnAirTime(packet, txParams);
+    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.070144, 0.0001, "Unexpected duration");
+
+    txParams.headerDisabled = false;
+    duration = LoraPhy::GetOnAirTime(packet, txParams);
+    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.082432, 0.0001, "Unexpected duration");
+
+    txParams.nPreamble = 8;
+    duration = LoraPhy::GetOnAirTime(packet, txParams);
+    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.078336, 0.0001, "Unexpected duration");
+
+    txParams.sf = 12;
+    duration = LoraPhy::GetOnAirTime(packet, txParams);
+    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.264192, 0.0001, "Unexpected duration");
+
+    packet = Create<Packet>(50);
+    duration = LoraPhy::GetOnAirTime(packet, txParams);
+    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 0.657408, 0.0001, "Unexpected duration");
+
+    txParams.bandwidthHz = 125000;
+    duration = LoraPhy::GetOnAirTime(packet, txParams);
+    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 2.629632, 0.0001, "Unexpected duration");
+
+    txParams.codingRate = 1;
+    duration = LoraPhy::GetOnAirTime(packet, txParams);
+    NS_TEST_EXPECT_MSG_EQ_TOL(duration.GetSeconds(), 2.301952, 0.0001, "Unexpected duration");
+}
+
+/**
+ * \ingroup lorawan
+ *
+ * It tests sending packets over a LoRa physical channel between multiple devices and the resulting
+ * possible outcomes
+ */
+class PhyConnectivityTest : public TestCase
+{
+  public:
+    PhyConnectivityTest();           //!< Default constructor
+    ~PhyConnectivityTest() override; //!< Destructor
+
+    /**
+     * Reset counters and end devices' PHYs for new sub test case.
+     */
+    void Reset();
+
+    /**
+     * Callback for tracing ReceivedPacket.
+     *
+     * \param packet The packet received.
+     * \param node The receiver node id if any, 0 otherwise.
+     */
+    void ReceivedPacket(Ptr<const Packet> packet, uint32_t node);
+
+    /**
+     * Callback for tracing LostPacketBecauseUnderSensitivity.
+     *
+     * \param packet The packet lost.
+     * \param node The receiver node id if any, 0 otherwise.
+     */
+    void UnderSensitivity(Ptr<const Packet> packet, uint32_t node);
+
+    /**
+     * Callback for tracing LostPacketBecauseInterference.
+     *
+     * \param packet The packet lost.
+     * \param node The receiver node id if any, 0 otherwise.
+     */
+    void Interference(Ptr<const Packet> packet, uint32_t node);
+
+    /**
+     * Callback for tracing LostPacketBecauseWrongFrequency.
+     *
+     * \param packet The packet lost.
+     * \param node The receiver node id if any, 0 otherwise.
+     */
+    void WrongFrequency(Ptr<const Packet> packet, uint32_t node);
+
+    /**
+     * Callback for tracing LostPacketBecauseWrongSpreadingFactor.
+     *
+     * \param packet The packet lost.
+     * \param node The receiver node id if any, 0 otherwise.
+     */
+    void WrongSf(Ptr<const Packet> packet, uint32_t node);
+
+    /**
+     * Compare two packets to check if they are equal.
+     *
+     * \param packet1 A first packet.
+     * \param packet2 A second packet.
+     * \return True if their unique identifiers are equal,
+     * \return false otherwise.
+     */
+    bool IsSamePacket(Ptr<Packet> packet1, Ptr<Packet> packet2);
+
+  private:
+    void DoRun() override;
+
+    Ptr<LoraChannel> channel;           //!< The LoRa channel used for tests
+    Ptr<SimpleEndDeviceLoraPhy> edPhy1; //!< The first end device's PHY layer used in tests
+    Ptr<SimpleEndDeviceLoraPhy> edPhy2; //!< The second end device's PHY layer used in tests
+    Ptr<SimpleEndDeviceLoraPhy> edPhy3; //!< The third end device's PHY layer used in tests
+
+    Ptr<Packet> m_latestReceivedPacket; //!< Pointer to track the last received packet
+    int m_receivedPacketCalls = 0;      //!< Counter for ReceivedPacket calls
+    int m_underSensitivityCalls = 0;    //!< Counter for LostPacketBecauseUnderSensitivity calls
+    int m_interferenceCalls = 0;        //!< Counter for LostPacketBecauseInterference calls
+    int m_wrongSfCalls = 0;             //!< Counter for LostPacketBecauseWrongSpreadingFactor calls
+    int m_wrongFrequencyCalls = 0;      //!< Counter for LostPacketBecauseWrongFrequency calls
+};
+
+// Add some help text to this case to describe what it is intended to test
+PhyConnectivityTest::PhyConnectivityTest()
+    : TestCase("Verify that PhyConnectivity works as expected")
+{
+}
+
+// Reminder that the test case should clean up after itself
+PhyConnectivityTest::~PhyConnectivityTest()
+{
+}
+
+void
+PhyConnectivityTest::ReceivedPacket(Ptr<const Packet> packet, uint32_t node)
+{
+    NS_LOG_FUNCTION(packet << node);
+
+    m_receivedPacketCalls++;
+
+    m_latestReceivedPacket = packet->Copy();
+}
+
+void
+PhyConnectivityTest::UnderSensitivity(Ptr<const Packet> packet, uint32_t node)
+{
+    NS_LOG_FUNCTION(packet << node);
+
+    m_underSensitivityCalls++;
+}
+
+void
+PhyConnectivityTest::Interference(Ptr<const Packet> packet, uint32_t node)
+{
+    NS_LOG_FUNCTION(packet << node);
+
+    m_interferenceCalls++;
+}
+
+void
+PhyConnectivityTest::WrongSf(Ptr<const Packet> packet, uint32_t node)
+{
+    NS_LOG_FUNCTION(packet << node);
+
+    m_wrongSfCalls++;
+}
+
+void
+PhyConnectivityTest::WrongFrequency(Ptr<const Packet> packet, uint32_t node)
+{
+    NS_LOG_FUNCTION(packet << node);
+
+    m_wrongFrequencyCalls++;
+}
+
+bool
+PhyConnectivityTest::IsSamePacket(Ptr<Packet> packet1, Ptr<Packet> packet2)
+{
+    return packet1->GetUid() == packet2->GetUid();
+}
+
+void
+PhyConnectivityTest::Reset()
+{
+    m_receivedPacketCalls = 0;
+    m_underSensitivityCalls = 0;
+    m_interferenceCalls = 0;
+    m_wrongSfCalls = 0;
+    m_wrongFrequencyCalls = 0;
+
+    Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel>();
+    loss->SetPathLossExponent(3.76);
+    loss->SetReference(1, 7.7);
+
+    Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel>();
+
+    // Create the channel
+    channel = CreateObject<LoraChannel>(loss, delay);
+
+    // Connect PHYs
+    edPhy1 = CreateObject<SimpleEndDeviceLoraPhy>();
+    edPhy2 = CreateObject<SimpleEndDeviceLoraPhy>();
+    edPhy3 = CreateObject<SimpleEndDeviceLoraPhy>();
+
+    edPhy1->SetFrequency(868.1);
+    edPhy2->SetFrequency(868.1);
+    edPhy3->SetFrequency(868.1);
+
+    Ptr<ConstantPositionMobilityModel> mob1 = CreateObject<ConstantPositionMobilityModel>();
+    Ptr<ConstantPositionMobilityModel> mob2 = CreateObject<ConstantPositionMobilityModel>();
+    Ptr<ConstantPositionMobilityModel> mob3 = CreateObject<ConstantPositionMobilityModel>();
+
+    mob1->SetPosition(Vector(0.0, 0.0, 0.0));
+    mob2->SetPosition(Vector(10.0, 0.0, 0.0));
+    mob3->SetPosition(Vector(20.0, 0.0, 0.0));
+
+    edPhy1->SetMobility(mob1);
+    edPhy2->SetMobility(mob2);
+    edPhy3->SetMobility(mob3);
+
+    edPhy1->SwitchToStandby();
+    edPhy2->SwitchToStandby();
+    edPhy3->SwitchToStandby();
+
+    channel->Add(edPhy1);
+    channel->Add(edPhy2);
+    channel->Add(edPhy3);
+
+    edPhy1->SetChannel(channel);
+    edPhy2->SetChannel(channel);
+    edPhy3->SetChannel(channel);
 
     // Listen for a specific SpreadingFactor
     edPhy1->SetSpreadingFactor(12);
     edPhy2->SetSpreadingFactor(12);
     edPhy3->SetSpreadingFactor(12);
 
-    // Listen on a specific frequency
-    edPhy1->SetFrequency(868.1);
-    edPhy2->SetFrequency(868.1);
-    edPhy3->SetFrequency(868.1);
+    // Listen on a specific frequency
+    edPhy1->SetFrequency(868.1);
+    edPhy2->SetFrequency(868.1);
+    edPhy3->SetFrequency(868.1);
+
+    edPhy1->TraceConnectWithoutContext("ReceivedPacket",
+                                       MakeCallback(&PhyConnectivityTest::ReceivedPacket, this));
+    edPhy2->TraceConnectWithoutContext("ReceivedPacket",
+                                       MakeCallback(&PhyConnectivityTest::ReceivedPacket, this));
+    edPhy3->TraceConnectWithoutContext("ReceivedPacket",
+                                       MakeCallback(&PhyConnectivityTest::ReceivedPacket, this));
+
+    edPhy1->TraceConnectWithoutContext("LostPacketBecauseUnderSensitivity",
+                                       MakeCallback(&PhyConnectivityTest::UnderSensitivity, this));
+    edPhy2->TraceConnectWithoutContext("LostPacketBecauseUnderSensitivity",
+                                       MakeCallback(&PhyConnectivityTest::UnderSensitivity, this));
+    edPhy3->TraceConnectWithoutContext("LostPacketBecauseUnderSensitivity",
+                                       MakeCallback(&PhyConnectivityTest::UnderSensitivity, this));
+
+    edPhy1->TraceConnectWithoutContext("LostPacketBecauseInterference",
+                                       MakeCallback(&PhyConnectivityTest::Interference, this));
+    edPhy2->TraceConnectWithoutContext("LostPacketBecauseInterference",
+                                       MakeCallback(&PhyConnectivityTest::Interference, this));
+    edPhy3->TraceConnectWithoutContext("LostPacketBecauseInterference",
+                                       MakeCallback(&PhyConnectivityTest::Interference, this));
+
+    edPhy1->TraceConnectWithoutContext("LostPacketBecauseWrongFrequency",
+                                       MakeCallback(&PhyConnectivityTest::WrongFrequency, this));
+    edPhy2->TraceConnectWithoutContext("LostPacketBecauseWrongFrequency",
+                                       MakeCallback(&PhyConnectivityTest::WrongFrequency, this));
+    edPhy3->TraceConnectWithoutContext("LostPacketBecauseWrongFrequency",
+                                       MakeCallback(&PhyConnectivityTest::WrongFrequency, this));
+
+    edPhy1->TraceConnectWithoutContext("LostPacketBecauseWrongSpreadingFactor",
+                                       MakeCallback(&PhyConnectivityTest::WrongSf, this));
+    edPhy2->TraceConnectWithoutContext("LostPacketBecauseWrongSpreadingFactor",
+                                       MakeCallback(&PhyConnectivityTest::WrongSf, this));
+    edPhy3->TraceConnectWithoutContext("LostPacketBecauseWrongSpreadingFactor",
+                                       MakeCallback(&PhyConnectivityTest::WrongSf, this));
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+PhyConnectivityTest::DoRun()
+{
+    NS_LOG_DEBUG("PhyConnectivityTest");
+
+    // Setup
+    ////////
+
+    Reset();
+
+    LoraTxParameters txParams;
+    txParams.sf = 12;
+
+    uint8_t buffer[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    Ptr<Packet> packet = Create<Packet>(buffer, 10);
+
+    // Testing
+    //////////
+
+    // Basic packet delivery test
+    /////////////////////////////
+
+    Simulator::Schedule(Seconds(2),
+                        &SimpleEndDeviceLoraPhy::Send,
+                        edPhy1,
+                        packet,
+                        txParams,
+                        868.1,
+                        14);
+
+    Simulator::Stop(Hours(2));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    NS_TEST_EXPECT_MSG_EQ(
+        m_receivedPacketCalls,
+        2,
+        "Channel skipped some PHYs when delivering a packet"); // All PHYs except the sender
+
+    Reset();
+
+    // Sleeping PHYs do not receive the packet
+
+    edPhy2->SwitchToSleep();
+
+    Simulator::Schedule(Seconds(2),
+                        &SimpleEndDeviceLoraPhy::Send,
+                        edPhy1,
+                        packet,
+                        txParams,
+                        868.1,
+                        14);
+
+    Simulator::Stop(Hours(2));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    NS_TEST_EXPECT_MSG_EQ(
+        m_receivedPacketCalls,
+        1,
+        "Packet was received by a PHY in SLEEP mode"); // All PHYs in Standby except the sender
+
+    Reset();
+
+    // Packet that arrives under sensitivity is received correctly if the spreading factor increases
+
+    txParams.sf = 7;
+    edPhy2->SetSpreadingFactor(7);
+    DynamicCast<ConstantPositionMobilityModel>(edPhy2->GetMobility())
+        ->SetPosition(Vector(2990, 0, 0));
+
+    Simulator::Schedule(Seconds(2),
+                        &SimpleEndDeviceLoraPhy::Send,
+                        edPhy1,
+                        packet,
+                        txParams,
+                        868.1,
+                        14);
+
+    Simulator::Stop(Hours(2));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    NS_TEST_EXPECT_MSG_EQ(
+        m_underSensitivityCalls,
+        1,
+        "Packet that should have been lost because of low receive power was received");
+
+    Reset();
+
+    // Try again using a packet with higher spreading factor
+    txParams.sf = 8;
+    edPhy2->SetSpreadingFactor(8);
+    DynamicCast<ConstantPositionMobilityModel>(edPhy2->GetMobility())
+        ->SetPosition(Vector(2990, 0, 0));
+
+    Simulator::Schedule(Seconds(2),
+                        &SimpleEndDeviceLoraPhy::Send,
+                        edPhy1,
+                        packet,
+                        txParams,
+                        868.1,
+                        14);
+
+    Simulator::Stop(Hours(2));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    NS_TEST_EXPECT_MSG_EQ(m_underSensitivityCalls,
+                          0,
+                          "Packets that should have arrived above sensitivity were under it");
+
+    Reset();
+
+    // Packets can be destroyed by interference
+
+    txParams.sf = 12;
+    Simulator::Schedule(Seconds(2),
+                        &SimpleEndDeviceLoraPhy::Send,
+                        edPhy1,
+                        packet,
+                        txParams,
+                        868.1,
+                        14);
+    Simulator::Schedule(Seconds(2),
+                        &SimpleEndDeviceLoraPhy::Send,
+                        edPhy3,
+                        packet,
+                        txParams,
+                        868.1,
+                        14);
+
+    Simulator::Stop(Hours(2));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    NS_TEST_EXPECT_MSG_EQ(m_interferenceCalls,
+                          1,
+                          "Packets that should be destroyed by interference weren't");
+
+    Reset();
+
+    // Packets can be lost because the PHY is not listening on the right frequency
+
+    Simulator::Schedule(Seconds(2),
+                        &SimpleEndDeviceLoraPhy::Send,
+                        edPhy1,
+                        packet,
+                        txParams,
+                        868.3,
+                        14);
+
+    Simulator::Stop(Hours(2));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    NS_TEST_EXPECT_MSG_EQ(m_wrongFrequencyCalls,
+                          2,
+                          "Packets were received even though PHY was on a different frequency");
+
+    Reset();
+
+    // Packets can be lost because the PHY is not listening for the right spreading factor
+
+    txParams.sf = 8; // Send with 8, listening for 12
+    Simulator::Schedule(Seconds(2),
+                        &SimpleEndDeviceLoraPhy::Send,
+                        edPhy1,
+                        packet,
+                        txParams,
+                        868.1,
+                        14);
+
+    Simulator::Stop(Hours(2));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    NS_TEST_EXPECT_MSG_EQ(
+        m_wrongSfCalls,
+        2,
+        "Packets were received even though PHY was listening for a different spreading factor.");
+
+    Reset();
+
+    // Sending of packets
+    /////////////////////
+
+    // The very same packet arrives at the other PHY
+    Simulator::Schedule(Seconds(2),
+                        &SimpleEndDeviceLoraPhy::Send,
+                        edPhy1,
+                        packet,
+                        txParams,
+                        868.1,
+                        14);
+
+    Simulator::Stop(Hours(2));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    NS_TEST_EXPECT_MSG_EQ(IsSamePacket(packet, m_latestReceivedPacket),
+                          true,
+                          "Packet changed contents when going through the channel");
+
+    Reset();
+
+    // Correct state transitions
+    ////////////////////////////
+
+    // PHY switches to STANDBY after TX and RX
+
+    Simulator::Schedule(Seconds(2),
+                        &SimpleEndDeviceLoraPhy::Send,
+                        edPhy1,
+                        packet,
+                        txParams,
+                        868.1,
+                        14);
+
+    Simulator::Stop(Hours(2));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    NS_TEST_EXPECT_MSG_EQ(edPhy1->GetState(),
+                          SimpleEndDeviceLoraPhy::STANDBY,
+                          "State didn't switch to STANDBY as expected");
+    NS_TEST_EXPECT_MSG_EQ(edPhy2->GetState(),
+                          SimpleEndDeviceLoraPhy::STANDBY,
+                          "State didn't switch to STANDBY as expected");
+}
+
+/**
+ * \ingroup lorawan
+ *
+ * It tests that the LoraChannel spatial index only skips receivers that are out of range
+ */
+class SpatialIndexTest : public TestCase
+{
+  public:
+    SpatialIndexTest();           //!< Default constructor
+    ~SpatialIndexTest() override; //!< Destructor
+
+  private:
+    void DoRun() override;
+
+    /**
+     * Send a packet received close to the sensitivity of a gateway, and a
+     * packet that reaches the gateway below sensitivity while it is on air.
+     *
+     * \param spatialIndex Whether the channel uses the spatial index.
+     * \return The number of packets the gateway lost to interference.
+     */
+    int RunInterferenceScenario(bool spatialIndex);
+
+    int m_receivedPacketCalls = 0; //!< Counter for ReceivedPacket calls
+    int m_packetSentCalls = 0;     //!< Counter for PacketSent calls
+    int m_interferenceCalls = 0;   //!< Counter for LostPacketBecauseInterference calls
+};
+
+// Add some help text to this case to describe what it is intended to test
+SpatialIndexTest::SpatialIndexTest()
+    : TestCase("Verify that the LoraChannel spatial index culls only unreachable receivers")
+{
+}
+
+// Reminder that the test case should clean up after itself
+SpatialIndexTest::~SpatialIndexTest()
+{
+}
+
+int
+SpatialIndexTest::RunInterferenceScenario(bool spatialIndex)
+{
+    m_interferenceCalls = 0;
+
+    Ptr<LoraChannel> channel = CreateChannel();
+    channel->SetAttribute("SpatialIndex", BooleanValue(spatialIndex));
+    channel->SetAttribute("ValidateRangeCulling", BooleanValue(spatialIndex));
+
+    Ptr<SimpleGatewayLoraPhy> gatewayPhy = CreateObject<SimpleGatewayLoraPhy>();
+    Ptr<ConstantPositionMobilityModel> gatewayMobility =
+        CreateObject<ConstantPositionMobilityModel>();
+    gatewayMobility->SetPosition(Vector(0.0, 0.0, 0.0));
+    gatewayPhy->SetMobility(gatewayMobility);
+    gatewayPhy->AddReceptionPath();
+    gatewayPhy->SetChannel(channel);
+    CountPhyTrace(gatewayPhy, "LostPacketBecauseInterference", &m_interferenceCalls);
+    channel->Add(gatewayPhy);
+
+    // The first packet reaches the gateway at -140 dBm, the second one at
+    // -144 dBm: below the sensitivity of -142.5 dBm, but strong enough to
+    // destroy the first one
+    std::vector<Ptr<SimpleEndDeviceLoraPhy>> phys =
+        CreateEndDevicePhys(channel, {7780, -9939}, false);
+
+    ScheduleSend(Seconds(2), phys[0]);
+    ScheduleSend(Seconds(2.1), phys[1]);
+
+    Simulator::Stop(Hours(1));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    return m_interferenceCalls;
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+SpatialIndexTest::DoRun()
+{
+    NS_LOG_DEBUG("SpatialIndexTest");
+
+    Ptr<LoraChannel> channel = CreateChannel();
+    channel->SetAttribute("SpatialIndex", BooleanValue(true));
+    channel->SetAttribute("ValidateRangeCulling", BooleanValue(true));
+    CountPacketsSent(channel, &m_packetSentCalls);
+
+    // At 14 dBm, the range of the channel is of about 24 km: 9 km to reach the
+    // sensitivity, widened by the isolation and the margin
+    NS_TEST_EXPECT_MSG_EQ_TOL(channel->GetMaxRange(14),
+                              24153.4,
+                              0.1,
+                              "Unexpected maximum range for the log distance model");
+    channel->SetAttribute("RangeCullingMargin", DoubleValue(0));
+    NS_TEST_EXPECT_MSG_EQ_TOL(channel->GetMaxRange(14),
+                              13092.5,
+                              0.1,
+                              "Unexpected maximum range without margin");
+    channel->SetAttribute("RangeCullingMargin", DoubleValue(10));
+
+    // Two PHYs are close to the sender, one is far away from it
+    std::vector<Ptr<SimpleEndDeviceLoraPhy>> phys =
+        CreateEndDevicePhys(channel, {0, 10, 20, 50000}, true);
+    for (const auto& phy : phys)
+    {
+        CountPhyTrace(phy, "ReceivedPacket", &m_receivedPacketCalls);
+    }
+
+    // A PHY that moves without firing CourseChange: it is out of range of the
+    // first packet, and 30 m away from the sender when the second one is sent
+    Ptr<ConstantVelocityMobilityModel> velocityMobility =
+        CreateObject<ConstantVelocityMobilityModel>();
+    velocityMobility->SetPosition(Vector(-60030, 0.0, 0.0));
+    velocityMobility->SetVelocity(Vector(3000, 0.0, 0.0));
+    Ptr<SimpleEndDeviceLoraPhy> movingPhy = CreateObject<SimpleEndDeviceLoraPhy>();
+    movingPhy->SetMobility(velocityMobility);
+    movingPhy->SetFrequency(868.1);
+    movingPhy->SetSpreadingFactor(12);
+    movingPhy->SwitchToStandby();
+    movingPhy->SetChannel(channel);
+    CountPhyTrace(movingPhy, "ReceivedPacket", &m_receivedPacketCalls);
+    channel->Add(movingPhy);
+
+    ScheduleSend(Seconds(2), phys[0]);
+
+    // Once the far PHYs move in range, they receive packets too
+    Simulator::Schedule(Seconds(10),
+                        &MobilityModel::SetPosition,
+                        phys[3]->GetMobility(),
+                        Vector(30, 0.0, 0.0));
+    ScheduleSend(Seconds(20), phys[0]);
+
+    Simulator::Stop(Hours(1));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    NS_TEST_EXPECT_MSG_EQ(m_packetSentCalls, 2 + 4, "Spatial index did not cull the far PHYs");
+    NS_TEST_EXPECT_MSG_EQ(m_receivedPacketCalls, 2 + 4, "Some PHY in range was skipped");
+
+    // Signals below sensitivity are delivered, since they still interfere
+    NS_TEST_EXPECT_MSG_EQ(RunInterferenceScenario(false),
+                          1,
+                          "The packet was not destroyed by the signal below sensitivity");
+    NS_TEST_EXPECT_MSG_EQ(RunInterferenceScenario(true),
+                          1,
+                          "Spatial index culled a signal below sensitivity");
+}
+
+/**
+ * \ingroup lorawan
+ *
+ * An end device PHY that records the power of the packets reaching it
+ */
+class RxPowerProbePhy : public SimpleEndDeviceLoraPhy
+{
+  public:
+    void StartReceive(Ptr<Packet> packet,
+                      double rxPowerDbm,
+                      uint8_t sf,
+                      Time duration,
+                      double frequencyMHz) override
+    {
+        m_rxPowersDbm.push_back(rxPowerDbm);
+    }
+
+    std::vector<double> m_rxPowersDbm; //!< The power of each packet that reached the PHY
+};
+
+/**
+ * \ingroup lorawan
+ *
+ * It tests that the link cache gives the received powers of the loss model until PHYs move
+ */
+class LinkCacheTest : public TestCase
+{
+  public:
+    LinkCacheTest();           //!< Default constructor
+    ~LinkCacheTest() override; //!< Destructor
+
+  private:
+    void DoRun() override;
+
+    /**
+     * Create a channel with the link cache enabled, connected to a sender and a
+     * receiver PHY.
+     *
+     * \param loss The loss model chain.
+     * \param freezeRandomLoss The value of the FreezeRandomLoss attribute.
+     * \return The channel.
+     */
+    Ptr<LoraChannel> CreateChannel(Ptr<PropagationLossModel> loss, bool freezeRandomLoss);
+
+    /**
+     * Send a packet from the sender to the receiver.
+     *
+     * \param txPowerDbm The power of the transmission.
+     * \return The power of the packet at the receiver.
+     */
+    double Transmit(double txPowerDbm);
+
+    Ptr<SimpleEndDeviceLoraPhy> m_sender; //!< The sending PHY
+    Ptr<RxPowerProbePhy> m_receiver;      //!< The receiving PHY
+    Ptr<LoraChannel> m_channel;           //!< The channel
+};
+
+// Add some help text to this case to describe what it is intended to test
+LinkCacheTest::LinkCacheTest()
+    : TestCase("Verify that the link cache matches the loss model")
+{
+}
+
+// Reminder that the test case should clean up after itself
+LinkCacheTest::~LinkCacheTest()
+{
+}
+
+Ptr<LoraChannel>
+LinkCacheTest::CreateChannel(Ptr<PropagationLossModel> loss, bool freezeRandomLoss)
+{
+    m_channel = CreateObject<LoraChannel>(loss, CreateObject<ConstantSpeedPropagationDelayModel>());
+    m_channel->SetAttribute("LinkCache", BooleanValue(true));
+    m_channel->SetAttribute("FreezeRandomLoss", BooleanValue(freezeRandomLoss));
+
+    m_sender = CreateObject<SimpleEndDeviceLoraPhy>();
+    m_receiver = CreateObject<RxPowerProbePhy>();
+    std::vector<Ptr<EndDeviceLoraPhy>> phys = {m_sender, m_receiver};
+    for (std::size_t i = 0; i < phys.size(); i++)
+    {
+        Ptr<ConstantPositionMobilityModel> mobility =
+            CreateObject<ConstantPositionMobilityModel>();
+        mobility->SetPosition(Vector(1000.0 * i, 0.0, 0.0));
+        phys[i]->SetMobility(mobility);
+        phys[i]->SetChannel(m_channel);
+        m_channel->Add(phys[i]);
+    }
+
+    return m_channel;
+}
+
+double
+LinkCacheTest::Transmit(double txPowerDbm)
+{
+    LoraTxParameters txParams;
+    txParams.sf = 12;
+    m_channel->Send(m_sender, Create<Packet>(10), txPowerDbm, txParams, Seconds(1), 868.1);
+    Simulator::Run();
+
+    return m_receiver->m_rxPowersDbm.back();
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+LinkCacheTest::DoRun()
+{
+    NS_LOG_DEBUG("LinkCacheTest");
+
+    // Cached links follow the loss model, also when the transmission power changes
+    Ptr<LogDistancePropagationLossModel> logDistance =
+        CreateObject<LogDistancePropagationLossModel>();
+    logDistance->SetPathLossExponent(3.76);
+    logDistance->SetReference(1, 7.7);
+    CreateChannel(logDistance, false);
+    NS_TEST_EXPECT_MSG_EQ(m_channel->IsLinkCacheUsable(), true, "Link cache not used");
+
+    Ptr<MobilityModel> senderMobility = m_sender->GetMobility();
+    Ptr<MobilityModel> receiverMobility = m_receiver->GetMobility();
+    for (double txPowerDbm : {14.0, 14.0, 2.0})
+    {
+        NS_TEST_EXPECT_MSG_EQ_TOL(Transmit(txPowerDbm),
+                                  logDistance->CalcRxPower(txPowerDbm,
+                                                           senderMobility,
+                                                           receiverMobility),
+                                  1e-9,
+                                  "Cached link differs from the model at " << txPowerDbm << " dBm");
+    }
+
+    // Links are computed again when either end moves
+    receiverMobility->SetPosition(Vector(3000, 0.0, 0.0));
+    NS_TEST_EXPECT_MSG_EQ_TOL(Transmit(14),
+                              logDistance->CalcRxPower(14, senderMobility, receiverMobility),
+                              1e-9,
+                              "Link of a moved PHY was taken from the cache");
+    Simulator::Destroy();
+
+    // Links of PHYs that move without firing CourseChange are not cached
+    CreateChannel(logDistance, false);
+    Ptr<ConstantVelocityMobilityModel> velocityMobility =
+        CreateObject<ConstantVelocityMobilityModel>();
+    velocityMobility->SetPosition(Vector(1000, 0.0, 0.0));
+    velocityMobility->SetVelocity(Vector(100, 0.0, 0.0));
+    m_receiver->SetMobility(velocityMobility);
+    Transmit(14);
+    Simulator::Stop(Seconds(10));
+    Simulator::Run();
+    NS_TEST_EXPECT_MSG_EQ_TOL(Transmit(14),
+                              logDistance->CalcRxPower(14,
+                                                       m_sender->GetMobility(),
+                                                       velocityMobility),
+                              1e-9,
+                              "Link of a PHY moving at constant velocity was taken from the cache");
+    Simulator::Destroy();
+
+    // The received power of a FixedRssLossModel doesn't depend on the transmission power
+    Ptr<FixedRssLossModel> fixedRss = CreateObject<FixedRssLossModel>();
+    fixedRss->SetRss(-80);
+    CreateChannel(fixedRss, false);
+    NS_TEST_EXPECT_MSG_EQ_TOL(Transmit(14), -80, 1e-9, "Wrong cached fixed RSS");
+    NS_TEST_EXPECT_MSG_EQ_TOL(Transmit(2), -80, 1e-9, "Fixed RSS shifted by the tx power");
+    Simulator::Destroy();
+
+    // Random draws are only cached if FreezeRandomLoss is set
+    Ptr<UniformRandomVariable> variable = CreateObject<UniformRandomVariable>();
+    variable->SetAttribute("Min", DoubleValue(0));
+    variable->SetAttribute("Max", DoubleValue(20));
+    Ptr<RandomPropagationLossModel> random = CreateObject<RandomPropagationLossModel>();
+    random->SetAttribute("Variable", PointerValue(variable));
+
+    CreateChannel(random, false);
+    NS_TEST_EXPECT_MSG_EQ(m_channel->IsLinkCacheUsable(),
+                          false,
+                          "Random draws cached without FreezeRandomLoss");
+    double first = Transmit(14);
+    NS_TEST_EXPECT_MSG_NE(Transmit(14), first, "Random loss frozen without FreezeRandomLoss");
+    Simulator::Destroy();
+
+    CreateChannel(random, true);
+    NS_TEST_EXPECT_MSG_EQ(m_channel->IsLinkCacheUsable(), true, "Link cache not used");
+    first = Transmit(14);
+    NS_TEST_EXPECT_MSG_EQ(Transmit(14), first, "Random loss not frozen with FreezeRandomLoss");
+    NS_TEST_EXPECT_MSG_EQ_TOL(Transmit(10), first - 4, 1e-9, "Frozen draw not reused");
+
+    // Clearing the cache draws new values
+    m_channel->ClearLinkCache();
+    NS_TEST_EXPECT_MSG_NE(Transmit(14), first, "Link cache not cleared");
+    Simulator::Destroy();
+}
+
+/**
+ * \ingroup lorawan
+ *
+ * It tests that receiver subscriptions skip idle PHYs without changing their interference
+ */
+class ReceiverSubscriptionsTest : public TestCase
+{
+  public:
+    ReceiverSubscriptionsTest();           //!< Default constructor
+    ~ReceiverSubscriptionsTest() override; //!< Destructor
+
+  private:
+    void DoRun() override;
+
+    int m_interferenceCalls = 0; //!< Counter for LostPacketBecauseInterference calls
+    int m_packetSentCalls = 0;   //!< Counter for PacketSent calls
+};
+
+// Add some help text to this case to describe what it is intended to test
+ReceiverSubscriptionsTest::ReceiverSubscriptionsTest()
+    : TestCase("Verify that PHYs starting to listen see packets that are already on air")
+{
+}
+
+// Reminder that the test case should clean up after itself
+ReceiverSubscriptionsTest::~ReceiverSubscriptionsTest()
+{
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+ReceiverSubscriptionsTest::DoRun()
+{
+    NS_LOG_DEBUG("ReceiverSubscriptionsTest");
+
+    Ptr<LoraChannel> channel = CreateChannel();
+    channel->SetAttribute("ReceiverSubscriptions", BooleanValue(true));
+    CountPacketsSent(channel, &m_packetSentCalls);
+
+    // All PHYs start in SLEEP, so that they are not interested in any packet
+    std::vector<Ptr<SimpleEndDeviceLoraPhy>> phys =
+        CreateEndDevicePhys(channel, {0, 10, 20}, false);
+    CountPhyTrace(phys[0], "LostPacketBecauseInterference", &m_interferenceCalls);
+
+    // The first PHY wakes up while the strong packet is on air, and then tries
+    // to lock on the weaker one
+    ScheduleSend(Seconds(2), phys[1]);
+    Simulator::Schedule(Seconds(2.1), &SimpleEndDeviceLoraPhy::SwitchToStandby, phys[0]);
+    ScheduleSend(Seconds(2.2), phys[2]);
+
+    Simulator::Stop(Hours(1));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    NS_TEST_EXPECT_MSG_EQ(m_packetSentCalls, 1, "Sleeping or transmitting PHYs were notified");
+    NS_TEST_EXPECT_MSG_EQ(m_interferenceCalls,
+                          1,
+                          "Packet already on air was not accounted as interference");
+}
+
+/**
+ * \ingroup lorawan
+ *
+ * It tests that looking up interferers in the shared air log of the LoraChannel gives the same
+ * receptions as storing them at each PHY
+ */
+class SharedAirLogTest : public TestCase
+{
+  public:
+    SharedAirLogTest();           //!< Default constructor
+    ~SharedAirLogTest() override; //!< Destructor
+
+  private:
+    void DoRun() override;
+
+    /**
+     * Send two overlapping packets and count the outcomes at a third PHY.
+     *
+     * \param shared Whether the channel uses the shared air log.
+     * \return The largest number of signals stored by the receiving PHY.
+     */
+    uint32_t RunScenario(bool shared);
+
+    int m_interferenceCalls = 0; //!< Counter for LostPacketBecauseInterference calls
+};
+
+// Add some help text to this case to describe what it is intended to test
+SharedAirLogTest::SharedAirLogTest()
+    : TestCase("Verify that the shared air log doesn't change reception outcomes")
+{
+}
+
+// Reminder that the test case should clean up after itself
+SharedAirLogTest::~SharedAirLogTest()
+{
+}
+
+uint32_t
+SharedAirLogTest::RunScenario(bool shared)
+{
+    Ptr<LoraChannel> channel = CreateChannel();
+
+    // The receiver locks on the packet of the farthest PHY, which is then
+    // destroyed by the stronger packet of the closest one. The senders sleep,
+    // so that they can transmit at any time.
+    std::vector<Ptr<SimpleEndDeviceLoraPhy>> phys =
+        CreateEndDevicePhys(channel, {0, 20, 10}, false);
+    phys[0]->SwitchToStandby();
+    CountPhyTrace(phys[0], "LostPacketBecauseInterference", &m_interferenceCalls);
+
+    // PHYs that were already added to the channel switch to the log
+    channel->SetAttribute("SharedAirLog", BooleanValue(shared));
+
+    ScheduleSend(Seconds(2), phys[1]);
+    ScheduleSend(Seconds(2.2), phys[2]);
+
+    Simulator::Stop(Hours(1));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    return phys[0]->GetInterferenceHelper().GetPeakEvents();
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+SharedAirLogTest::DoRun()
+{
+    NS_LOG_DEBUG("SharedAirLogTest");
+
+    uint32_t storedEvents = RunScenario(false);
+    int interferenceCalls = m_interferenceCalls;
+
+    m_interferenceCalls = 0;
+    uint32_t sharedStoredEvents = RunScenario(true);
+
+    NS_TEST_EXPECT_MSG_EQ(interferenceCalls, 1, "Unexpected number of interfered packets");
+    NS_TEST_EXPECT_MSG_EQ(m_interferenceCalls,
+                          interferenceCalls,
+                          "The shared air log changed the interfered packets");
+    NS_TEST_EXPECT_MSG_EQ(storedEvents, 2, "The receiver didn't store the signals it heard");
+    NS_TEST_EXPECT_MSG_EQ(sharedStoredEvents, 0, "The receiver stored signals with the shared log");
+}
 
-    edPhy1->TraceConnectWithoutContext("ReceivedPacket",
-                                       MakeCallback(&PhyConnectivityTest::ReceivedPacket, this));
-    edPhy2->TraceConnectWithoutContext("ReceivedPacket",
-                                       MakeCallback(&PhyConnectivityTest::ReceivedPacket, this));
-    edPhy3->TraceConnectWithoutContext("ReceivedPacket",
-                                       MakeCallback(&PhyConnectivityTest::ReceivedPacket, this));
+/**
+ * \ingroup lorawan
+ *
+ * It tests that batched delivery on the LoraChannel gives the same receptions as per-PHY events
+ */
+class BatchedDeliveryTest : public TestCase
+{
+  public:
+    BatchedDeliveryTest();           //!< Default constructor
+    ~BatchedDeliveryTest() override; //!< Destructor
 
-    edPhy1->TraceConnectWithoutContext("LostPacketBecauseUnderSensitivity",
-                                       MakeCallback(&PhyConnectivityTest::UnderSensitivity, this));
-    edPhy2->TraceConnectWithoutContext("LostPacketBecauseUnderSensitivity",
-                                       MakeCallback(&PhyConnectivityTest::UnderSensitivity, this));
-    edPhy3->TraceConnectWithoutContext("LostPacketBecauseUnderSensitivity",
-                                       MakeCallback(&PhyConnectivityTest::UnderSensitivity, this));
+  private:
+    void DoRun() override;
 
-    edPhy1->TraceConnectWithoutContext("LostPacketBecauseInterference",
-                                       MakeCallback(&PhyConnectivityTest::Interference, this));
-    edPhy2->TraceConnectWithoutContext("LostPacketBecauseInterference",
-                                       MakeCallback(&PhyConnectivityTest::Interference, this));
-    edPhy3->TraceConnectWithoutContext("LostPacketBecauseInterference",
-                                       MakeCallback(&PhyConnectivityTest::Interference, this));
+    /**
+     * Send a packet to a set of end devices and count the outcomes.
+     *
+     * \param batched Whether the channel uses batched delivery.
+     */
+    void RunScenario(bool batched);
 
-    edPhy1->TraceConnectWithoutContext("LostPacketBecauseWrongFrequency",
-                                       MakeCallback(&PhyConnectivityTest::WrongFrequency, this));
-    edPhy2->TraceConnectWithoutContext("LostPacketBecauseWrongFrequency",
-                                       MakeCallback(&PhyConnectivityTest::WrongFrequency, this));
-    edPhy3->TraceConnectWithoutContext("LostPacketBecauseWrongFrequency",
-                                       MakeCallback(&PhyConnectivityTest::WrongFrequency, this));
+    int m_receivedPacketCalls = 0;   //!< Counter for ReceivedPacket calls
+    int m_underSensitivityCalls = 0; //!< Counter for LostPacketBecauseUnderSensitivity calls
+};
 
-    edPhy1->TraceConnectWithoutContext("LostPacketBecauseWrongSpreadingFactor",
-                                       MakeCallback(&PhyConnectivityTest::WrongSf, this));
-    edPhy2->TraceConnectWithoutContext("LostPacketBecauseWrongSpreadingFactor",
-                                       MakeCallback(&PhyConnectivityTest::WrongSf, this));
-    edPhy3->TraceConnectWithoutContext("LostPacketBecauseWrongSpreadingFactor",
-                                       MakeCallback(&PhyConnectivityTest::WrongSf, this));
+// Add some help text to this case to describe what it is intended to test
+BatchedDeliveryTest::BatchedDeliveryTest()
+    : TestCase("Verify that batched delivery doesn't change reception outcomes")
+{
+}
+
+// Reminder that the test case should clean up after itself
+BatchedDeliveryTest::~BatchedDeliveryTest()
+{
+}
+
+void
+BatchedDeliveryTest::RunScenario(bool batched)
+{
+    Ptr<LoraChannel> channel = CreateChannel();
+    channel->SetAttribute("BatchedDelivery", BooleanValue(batched));
+
+    // Receivers close to each other share the same delay group
+    std::vector<Ptr<SimpleEndDeviceLoraPhy>> phys =
+        CreateEndDevicePhys(channel, {0, 10, 20, 30, 5000, 20000}, true);
+    for (const auto& phy : phys)
+    {
+        CountPhyTrace(phy, "ReceivedPacket", &m_receivedPacketCalls);
+        CountPhyTrace(phy, "LostPacketBecauseUnderSensitivity", &m_underSensitivityCalls);
+    }
+
+    ScheduleSend(Seconds(2), phys[0]);
+
+    Simulator::Stop(Hours(1));
+    Simulator::Run();
+    Simulator::Destroy();
 }
 
 // This method is the pure virtual method from class TestCase that every
 // TestCase must implement
 void
-PhyConnectivityTest::DoRun()
+BatchedDeliveryTest::DoRun()
 {
-    NS_LOG_DEBUG("PhyConnectivityTest");
+    NS_LOG_DEBUG("BatchedDeliveryTest");
 
-    // Setup
-    ////////
+    RunScenario(false);
+    int receivedPacketCalls = m_receivedPacketCalls;
+    int underSensitivityCalls = m_underSensitivityCalls;
 
-    Reset();
+    m_receivedPacketCalls = 0;
+    m_underSensitivityCalls = 0;
+    RunScenario(true);
 
-    LoraTxParameters txParams;
-    txParams.sf = 12;
+    NS_TEST_EXPECT_MSG_EQ(receivedPacketCalls, 4, "Unexpected number of receptions");
+    NS_TEST_EXPECT_MSG_EQ(underSensitivityCalls, 1, "Unexpected number of lost packets");
+    NS_TEST_EXPECT_MSG_EQ(m_receivedPacketCalls,
+                          receivedPacketCalls,
+                          "Batched delivery changed the receptions");
+    NS_TEST_EXPECT_MSG_EQ(m_underSensitivityCalls,
+                          underSensitivityCalls,
+                          "Batched delivery changed the lost packets");
+}
 
-    uint8_t buffer[10] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
-    Ptr<Packet> packet = Create<Packet>(buffer, 10);
+/**
+ * \ingroup lorawan
+ *
+ * It tests that batched receptions run in the context of the receiving node
+ */
+class BatchedDeliveryContextTest : public TestCase
+{
+  public:
+    BatchedDeliveryContextTest();           //!< Default constructor
+    ~BatchedDeliveryContextTest() override; //!< Destructor
 
-    // Testing
-    //////////
+  private:
+    void DoRun() override;
+};
 
-    // Basic packet delivery test
-    /////////////////////////////
+// Add some help text to this case to describe what it is intended to test
+BatchedDeliveryContextTest::BatchedDeliveryContextTest()
+    : TestCase("Verify that gateways receiving a batched packet are all tracked")
+{
+}
 
-    Simulator::Schedule(Seconds(2),
-                        &SimpleEndDeviceLoraPhy::Send,
-                        edPhy1,
-                        packet,
-                        txParams,
-                        868.1,
-                        14);
+// Reminder that the test case should clean up after itself
+BatchedDeliveryContextTest::~BatchedDeliveryContextTest()
+{
+}
 
-    Simulator::Stop(Hours(2));
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+BatchedDeliveryContextTest::DoRun()
+{
+    NS_LOG_DEBUG("BatchedDeliveryContextTest");
+
+    Ptr<LoraChannel> channel = CreateChannel();
+    channel->SetAttribute("BatchedDelivery", BooleanValue(true));
+    channel->SetAttribute("DelayQuantum", TimeValue(MilliSeconds(1)));
+
+    // Two gateways at the same distance from the end device share the same delay
+    Ptr<ListPositionAllocator> allocator = CreateObject<ListPositionAllocator>();
+    allocator->Add(Vector(0, 0, 0));
+    allocator->Add(Vector(100, 0, 0));
+    allocator->Add(Vector(-100, 0, 0));
+    MobilityHelper mobility;
+    mobility.SetPositionAllocator(allocator);
+    mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+
+    NodeContainer endDevices;
+    endDevices.Create(1);
+    NodeContainer gateways;
+    gateways.Create(2);
+    mobility.Install(endDevices);
+    mobility.Install(gateways);
+
+    LoraPhyHelper phyHelper;
+    phyHelper.SetChannel(channel);
+    LorawanMacHelper macHelper;
+    LoraHelper helper;
+    helper.EnablePacketTracking();
+
+    phyHelper.SetDeviceType(LoraPhyHelper::ED);
+    macHelper.SetDeviceType(LorawanMacHelper::ED_A);
+    helper.Install(phyHelper, macHelper, endDevices);
+
+    phyHelper.SetDeviceType(LoraPhyHelper::GW);
+    macHelper.SetDeviceType(LorawanMacHelper::GW);
+    helper.Install(phyHelper, macHelper, gateways);
+
+    LorawanMacHelper::SetSpreadingFactorsUp(endDevices, gateways, channel);
+    CreateNetworkServer(endDevices, gateways);
+
+    Simulator::Schedule(Seconds(1),
+                        &NetDevice::Send,
+                        endDevices.Get(0)->GetDevice(0),
+                        Create<Packet>(10),
+                        Address(),
+                        0);
+
+    Simulator::Stop(Seconds(10));
     Simulator::Run();
+
+    LoraPacketTracker& tracker = helper.GetPacketTracker();
+    for (uint32_t i = 0; i < gateways.GetN(); i++)
+    {
+        NS_TEST_EXPECT_MSG_EQ(
+            tracker.CountMacPacketsPerGw(Seconds(0), Seconds(10), gateways.Get(i)->GetId()),
+            "1.000000 1.000000",
+            "Reception at gateway " << i << " not tracked");
+    }
+
     Simulator::Destroy();
+}
 
-    NS_TEST_EXPECT_MSG_EQ(
-        m_receivedPacketCalls,
-        2,
-        "Channel skipped some PHYs when delivering a packet"); // All PHYs except the sender
+/**
+ * \ingroup lorawan
+ *
+ * It tests that computing link budgets on multiple threads doesn't change reception outcomes
+ */
+class ParallelLinkBudgetTest : public TestCase
+{
+  public:
+    ParallelLinkBudgetTest();           //!< Default constructor
+    ~ParallelLinkBudgetTest() override; //!< Destructor
 
-    Reset();
+  private:
+    void DoRun() override;
+
+    /**
+     * Send a packet to a line of end devices and record which of them receive it.
+     *
+     * \param threads The number of threads used by the channel.
+     * \return The number of the PHY that received the packet, for each PHY.
+     */
+    std::vector<int> RunScenario(uint32_t threads);
+};
+
+// Add some help text to this case to describe what it is intended to test
+ParallelLinkBudgetTest::ParallelLinkBudgetTest()
+    : TestCase("Verify that parallel link budgets match the sequential ones")
+{
+}
+
+// Reminder that the test case should clean up after itself
+ParallelLinkBudgetTest::~ParallelLinkBudgetTest()
+{
+}
+
+std::vector<int>
+ParallelLinkBudgetTest::RunScenario(uint32_t threads)
+{
+    Ptr<LoraChannel> channel = CreateChannel();
+    channel->SetAttribute("ComputeThreads", UintegerValue(threads));
+    channel->SetAttribute("ParallelThreshold", UintegerValue(1));
+
+    // Receivers span both sides of the sensitivity threshold
+    std::vector<int> receptions(300, 0);
+    std::vector<double> positions;
+    for (uint32_t i = 0; i <= receptions.size(); i++)
+    {
+        positions.push_back(50.0 * i);
+    }
+    std::vector<Ptr<SimpleEndDeviceLoraPhy>> phys = CreateEndDevicePhys(channel, positions, true);
+    for (uint32_t i = 1; i < phys.size(); i++)
+    {
+        CountPhyTrace(phys[i], "ReceivedPacket", &receptions[i - 1]);
+    }
+
+    ScheduleSend(Seconds(2), phys[0]);
+
+    Simulator::Stop(Hours(1));
+    Simulator::Run();
+    Simulator::Destroy();
+
+    return receptions;
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+ParallelLinkBudgetTest::DoRun()
+{
+    NS_LOG_DEBUG("ParallelLinkBudgetTest");
+
+    std::vector<int> sequential = RunScenario(1);
+    std::vector<int> parallel = RunScenario(4);
+
+    int received = 0;
+    for (std::size_t i = 0; i < sequential.size(); i++)
+    {
+        received += sequential[i];
+        NS_TEST_EXPECT_MSG_EQ(parallel[i],
+                              sequential[i],
+                              "Reception outcome of PHY " << i + 1 << " changed with threads");
+    }
+
+    // Only the receivers within about 6.5 km can lock on the packet
+    NS_TEST_EXPECT_MSG_EQ(received, 129, "Unexpected number of receptions");
+}
+
+/**
+ * \ingroup lorawan
+ *
+ * It tests that link tables reproduce the loss model and are rejected in other scenarios
+ */
+class LinkTableTest : public TestCase
+{
+  public:
+    LinkTableTest();           //!< Default constructor
+    ~LinkTableTest() override; //!< Destructor
+
+  private:
+    void DoRun() override;
+
+    /**
+     * Create a channel connected to a line of PHYs.
+     *
+     * \param positions The x coordinate of each PHY.
+     * \param exponent The exponent of the log distance loss model.
+     * \param gateway The index of the only gateway PHY, the others being end
+     * devices.
+     * \param mobility Output parameter for the mobility model of each PHY.
+     * \return The channel.
+     */
+    Ptr<LoraChannel> CreateChannel(const std::vector<double>& positions,
+                                   double exponent,
+                                   std::size_t gateway,
+                                   std::vector<Ptr<MobilityModel>>& mobility);
+};
+
+// Add some help text to this case to describe what it is intended to test
+LinkTableTest::LinkTableTest()
+    : TestCase("Verify that link tables replace the loss model only in their scenario")
+{
+}
+
+// Reminder that the test case should clean up after itself
+LinkTableTest::~LinkTableTest()
+{
+}
+
+Ptr<LoraChannel>
+LinkTableTest::CreateChannel(const std::vector<double>& positions,
+                             double exponent,
+                             std::size_t gateway,
+                             std::vector<Ptr<MobilityModel>>& mobility)
+{
+    Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel>();
+    loss->SetPathLossExponent(exponent);
+    loss->SetReference(1, 7.7);
+
+    Ptr<PropagationDelayModel> delay = CreateObject<ConstantSpeedPropagationDelayModel>();
+
+    Ptr<LoraChannel> channel = CreateObject<LoraChannel>(loss, delay);
+    mobility.clear();
+    for (std::size_t i = 0; i < positions.size(); i++)
+    {
+        Ptr<LoraPhy> phy;
+        if (i == gateway)
+        {
+            phy = CreateObject<SimpleGatewayLoraPhy>();
+        }
+        else
+        {
+            phy = CreateObject<SimpleEndDeviceLoraPhy>();
+        }
+        Ptr<ConstantPositionMobilityModel> phyMobility =
+            CreateObject<ConstantPositionMobilityModel>();
+        phyMobility->SetPosition(Vector(positions[i], 0.0, 0.0));
+        phy->SetMobility(phyMobility);
+        phy->SetChannel(channel);
+        channel->Add(phy);
+        mobility.push_back(phyMobility);
+    }
+
+    return channel;
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+LinkTableTest::DoRun()
+{
+    NS_LOG_DEBUG("LinkTableTest");
+
+    std::string filename = CreateTempDirFilename("link-table.bin");
+    std::vector<double> positions = {0, 10, 500, 7000};
+    std::vector<Ptr<MobilityModel>> mobility;
+
+    Ptr<LoraChannel> channel = CreateChannel(positions, 3.76, 0, mobility);
+    NS_TEST_ASSERT_MSG_EQ(channel->SaveLinkTable(filename), true, "Could not write link table");
+
+    // Only the links from and to the gateway are stored, after a 48 byte
+    // header and the index of the gateway
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    NS_TEST_EXPECT_MSG_EQ(std::size_t(file.tellg()),
+                          48 + 4 + 2 * positions.size() * 8,
+                          "Link table doesn't only hold the links of the gateway");
+    file.close();
+
+    // The same scenario gets the received powers from the table
+    Ptr<LogDistancePropagationLossModel> reference =
+        CreateObject<LogDistancePropagationLossModel>();
+    reference->SetPathLossExponent(3.76);
+    reference->SetReference(1, 7.7);
+    channel = CreateChannel(positions, 3.76, 0, mobility);
+    NS_TEST_ASSERT_MSG_EQ(channel->LoadLinkTable(filename), true, "Could not load link table");
+    for (std::size_t i = 0; i < positions.size(); i++)
+    {
+        for (std::size_t j = 0; j < positions.size(); j++)
+        {
+            if (i != j)
+            {
+                NS_TEST_EXPECT_MSG_EQ_TOL(channel->GetRxPower(14, mobility[i], mobility[j]),
+                                          reference->CalcRxPower(14, mobility[i], mobility[j]),
+                                          1e-4,
+                                          "Link " << i << "-" << j << " differs from the model");
+            }
+        }
+    }
+
+    // Links of PHYs that move are computed again
+    mobility[3]->SetPosition(Vector(20, 0.0, 0.0));
+    NS_TEST_EXPECT_MSG_EQ(channel->GetRxPower(14, mobility[0], mobility[3]),
+                          reference->CalcRxPower(14, mobility[0], mobility[3]),
+                          "Link of a moved PHY was taken from the table");
+
+    // Tables are rejected if positions, roles or models changed
+    channel = CreateChannel({0, 10, 500, 6000}, 3.76, 0, mobility);
+    NS_TEST_EXPECT_MSG_EQ(channel->LoadLinkTable(filename), false, "Table with moved PHYs loaded");
+    channel = CreateChannel(positions, 3.76, 1, mobility);
+    NS_TEST_EXPECT_MSG_EQ(channel->LoadLinkTable(filename), false, "Table of other gateway loaded");
+    channel = CreateChannel(positions, 3.5, 0, mobility);
+    NS_TEST_EXPECT_MSG_EQ(channel->LoadLinkTable(filename), false, "Table of other model loaded");
+    channel = CreateChannel({0, 10, 500}, 3.76, 0, mobility);
+    NS_TEST_EXPECT_MSG_EQ(channel->LoadLinkTable(filename), false, "Table of other PHYs loaded");
+
+    // Received powers of a FixedRssLossModel can't be stored as gains
+    Ptr<FixedRssLossModel> fixedRss = CreateObject<FixedRssLossModel>();
+    fixedRss->SetRss(-80);
+    channel =
+        CreateObject<LoraChannel>(fixedRss, CreateObject<ConstantSpeedPropagationDelayModel>());
+    NS_TEST_EXPECT_MSG_EQ(channel->SaveLinkTable(CreateTempDirFilename("fixed-rss-table.bin")),
+                          false,
+                          "Table of a fixed RSS model written");
+    NS_TEST_EXPECT_MSG_EQ(channel->LoadLinkTable(filename),
+                          false,
+                          "Table loaded for a fixed RSS model");
+
+    Simulator::Destroy();
+}
+
+/**
+ * \ingroup lorawan
+ *
+ * It tests that batch received power computations match the loss model
+ */
+class BatchPathLossTest : public TestCase
+{
+  public:
+    BatchPathLossTest();           //!< Default constructor
+    ~BatchPathLossTest() override; //!< Destructor
+
+  private:
+    void DoRun() override;
+
+    /**
+     * Check the batch computations of a channel against its loss model.
+     *
+     * \param loss The loss model chain.
+     * \param batchComputable Whether the chain is expected to be supported by
+     * the batch kernel.
+     */
+    void CheckChannel(Ptr<PropagationLossModel> loss, bool batchComputable);
+};
+
+// Add some help text to this case to describe what it is intended to test
+BatchPathLossTest::BatchPathLossTest()
+    : TestCase("Verify that batch received power computations match the loss model")
+{
+}
+
+// Reminder that the test case should clean up after itself
+BatchPathLossTest::~BatchPathLossTest()
+{
+}
+
+void
+BatchPathLossTest::CheckChannel(Ptr<PropagationLossModel> loss, bool batchComputable)
+{
+    Ptr<LoraChannel> channel =
+        CreateObject<LoraChannel>(loss, CreateObject<ConstantSpeedPropagationDelayModel>());
+    NS_TEST_EXPECT_MSG_EQ(channel->IsBatchComputable(),
+                          batchComputable,
+                          "Unexpected support of the loss chain by the batch kernel");
+
+    // Receivers include one closer than the reference distance
+    Ptr<ConstantPositionMobilityModel> sender = CreateObject<ConstantPositionMobilityModel>();
+    sender->SetPosition(Vector(100.0, 50.0, 15.0));
+    std::vector<Ptr<MobilityModel>> receivers;
+    LoraPositionBatch positions;
+    for (const auto& position : {Vector(100.5, 50.0, 15.0),
+                                 Vector(300.0, 0.0, 1.2),
+                                 Vector(2000.0, -500.0, 1.2),
+                                 Vector(7000.0, 0.0, 1.2),
+                                 Vector(15000.0, 200.0, 1.2)})
+    {
+        Ptr<ConstantPositionMobilityModel> receiver =
+            CreateObject<ConstantPositionMobilityModel>();
+        receiver->SetPosition(position);
+        receivers.push_back(receiver);
+        positions.Add(receiver->GetPosition());
+    }
+
+    std::vector<double> fromMobility;
+    std::vector<double> fromPositions;
+    channel->GetRxPowers(14, sender, receivers, fromMobility);
+    channel->GetRxPowers(14, sender->GetPosition(), positions, fromPositions);
+    for (std::size_t k = 0; k < receivers.size(); k++)
+    {
+        double expected = loss->CalcRxPower(14, sender, receivers[k]);
+        NS_TEST_EXPECT_MSG_EQ_TOL(fromMobility[k], expected, 1e-9, "Receiver " << k);
+        NS_TEST_EXPECT_MSG_EQ_TOL(fromPositions[k], expected, 1e-9, "Position " << k);
+    }
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+BatchPathLossTest::DoRun()
+{
+    NS_LOG_DEBUG("BatchPathLossTest");
+
+    Ptr<LogDistancePropagationLossModel> logDistance =
+        CreateObject<LogDistancePropagationLossModel>();
+    logDistance->SetPathLossExponent(3.76);
+    logDistance->SetReference(1, 7.7);
+    CheckChannel(logDistance, true);
+
+    // Chained models are applied in order
+    Ptr<RangePropagationLossModel> range = CreateObject<RangePropagationLossModel>();
+    range->SetAttribute("MaxRange", DoubleValue(10000));
+    logDistance->SetNext(range);
+    CheckChannel(logDistance, true);
+
+    // Other models are computed pair by pair
+    CheckChannel(CreateObject<ThreeLogDistancePropagationLossModel>(), false);
+
+    Simulator::Destroy();
+}
+
+/**
+ * \ingroup lorawan
+ *
+ * It tests that registering the receive windows of unconfirmed uplinks lazily
+ * gives the same radio energy consumption as opening and closing them with events
+ */
+class LazyReceiveWindowsTest : public TestCase
+{
+  public:
+    LazyReceiveWindowsTest();           //!< Default constructor
+    ~LazyReceiveWindowsTest() override; //!< Destructor
 
-    // Sleeping PHYs do not receive the packet
+  private:
+    void DoRun() override;
 
-    edPhy2->SwitchToSleep();
+    /**
+     * Send some unconfirmed uplinks from an end device, without a network
+     * server to reply to them.
+     *
+     * \param lazy Whether the end device registers its receive windows lazily.
+     * \param remainingEnergy Set to the remaining energy of the source of the
+     * end device [J].
+     * \return The total energy consumption of the radio of the end device [J].
+     */
+    double GetEnergyConsumption(bool lazy, double& remainingEnergy);
 
-    Simulator::Schedule(Seconds(2),
-                        &SimpleEndDeviceLoraPhy::Send,
-                        edPhy1,
-                        packet,
-                        txParams,
-                        868.1,
-                        14);
+    /**
+     * Callback for tracing RequiredTransmissions.
+     *
+     * \param reqTx The number of transmissions.
+     * \param success Whether the packet was delivered.
+     * \param firstAttempt The time of the first transmission.
+     * \param packet The packet.
+     */
+    void RequiredTransmissions(uint8_t reqTx, bool success, Time firstAttempt, Ptr<Packet> packet);
 
-    Simulator::Stop(Hours(2));
-    Simulator::Run();
-    Simulator::Destroy();
+    std::vector<Time> m_requiredTransmissionsTimes; //!< Times of the RequiredTransmissions calls
+};
 
-    NS_TEST_EXPECT_MSG_EQ(
-        m_receivedPacketCalls,
-        1,
-        "Packet was received by a PHY in SLEEP mode"); // All PHYs in Standby except the sender
+// Add some help text to this case to describe what it is intended to test
+LazyReceiveWindowsTest::LazyReceiveWindowsTest()
+    : TestCase("Verify that lazy receive windows consume as much energy as eager ones")
+{
+}
 
-    Reset();
+// Reminder that the test case should clean up after itself
+LazyReceiveWindowsTest::~LazyReceiveWindowsTest()
+{
+}
 
-    // Packet that arrives under sensitivity is received correctly if the spreading factor increases
+void
+LazyReceiveWindowsTest::RequiredTransmissions(uint8_t reqTx,
+                                              bool success,
+                                              Time firstAttempt,
+                                              Ptr<Packet> packet)
+{
+    NS_LOG_FUNCTION(unsigned(reqTx) << success << firstAttempt << packet);
 
-    txParams.sf = 7;
-    edPhy2->SetSpreadingFactor(7);
-    DynamicCast<ConstantPositionMobilityModel>(edPhy2->GetMobility())
-        ->SetPosition(Vector(2990, 0, 0));
+    m_requiredTransmissionsTimes.push_back(Simulator::Now());
+}
 
-    Simulator::Schedule(Seconds(2),
-                        &SimpleEndDeviceLoraPhy::Send,
-                        edPhy1,
-                        packet,
-                        txParams,
-                        868.1,
-                        14);
+double
+LazyReceiveWindowsTest::GetEnergyConsumption(bool lazy, double& remainingEnergy)
+{
+    Ptr<LoraChannel> channel = CreateChannel();
+
+    MobilityHelper mobility;
+    Ptr<ListPositionAllocator> allocator = CreateObject<ListPositionAllocator>();
+    allocator->Add(Vector(100, 0, 0));
+    allocator->Add(Vector(0, 0, 0));
+    mobility.SetPositionAllocator(allocator);
+    mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+
+    NodeContainer endDevices = CreateEndDevices(1, mobility, channel);
+    NodeContainer gateways = CreateGateways(1, mobility, channel);
+
+    LorawanMacHelper::SetSpreadingFactorsUp(endDevices, gateways, channel);
+
+    Ptr<EndDeviceLorawanMac> mac = GetMacLayerFromNode<EndDeviceLorawanMac>(endDevices.Get(0));
+    mac->SetMType(LorawanMacHeader::UNCONFIRMED_DATA_UP);
+    mac->SetAttribute("LazyReceiveWindows", BooleanValue(lazy));
+    mac->TraceConnectWithoutContext(
+        "RequiredTransmissions",
+        MakeCallback(&LazyReceiveWindowsTest::RequiredTransmissions, this));
+
+    BasicEnergySourceHelper basicSourceHelper;
+    basicSourceHelper.Set("BasicEnergySupplyVoltageV", DoubleValue(3.3));
+    LoraRadioEnergyModelHelper radioEnergyHelper;
+    EnergySourceContainer sources = basicSourceHelper.Install(endDevices);
+    DeviceEnergyModelContainer deviceModels =
+        radioEnergyHelper.Install(NetDeviceContainer(endDevices.Get(0)->GetDevice(0)), sources);
+
+    // Send uplinks, the last of which has its windows still open at the end
+    for (auto seconds : {10.0, 20.0, 30.0, 39.0})
+    {
+        Simulator::Schedule(Seconds(seconds),
+                            &EndDeviceLorawanMac::Send,
+                            mac,
+                            Create<Packet>(10));
+    }
 
-    Simulator::Stop(Hours(2));
+    Simulator::Stop(Seconds(40.5));
     Simulator::Run();
+    double energy =
+        DynamicCast<LoraRadioEnergyModel>(deviceModels.Get(0))->GetTotalEnergyConsumption();
+    remainingEnergy = sources.Get(0)->GetRemainingEnergy();
     Simulator::Destroy();
 
-    NS_TEST_EXPECT_MSG_EQ(
-        m_underSensitivityCalls,
-        1,
-        "Packet that should have been lost because of low receive power was received");
+    return energy;
+}
 
-    Reset();
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+LazyReceiveWindowsTest::DoRun()
+{
+    NS_LOG_DEBUG("LazyReceiveWindowsTest");
+
+    double eagerRemainingEnergy;
+    double eagerEnergy = GetEnergyConsumption(false, eagerRemainingEnergy);
+    std::vector<Time> eagerTimes = m_requiredTransmissionsTimes;
+    NS_TEST_EXPECT_MSG_EQ(eagerTimes.size(),
+                          3,
+                          "Uplinks were not reported at the end of their second window");
+
+    m_requiredTransmissionsTimes.clear();
+    double lazyRemainingEnergy;
+    double lazyEnergy = GetEnergyConsumption(true, lazyRemainingEnergy);
+    NS_TEST_ASSERT_MSG_EQ(m_requiredTransmissionsTimes.size(),
+                          eagerTimes.size(),
+                          "Lazy receive windows changed the reported uplinks");
+    for (std::size_t i = 0; i < eagerTimes.size(); i++)
+    {
+        NS_TEST_EXPECT_MSG_EQ(m_requiredTransmissionsTimes[i],
+                              eagerTimes[i],
+                              "Uplink " << i << " was not reported at the end of its windows");
+    }
 
-    // Try again using a packet with higher spreading factor
-    txParams.sf = 8;
-    edPhy2->SetSpreadingFactor(8);
-    DynamicCast<ConstantPositionMobilityModel>(edPhy2->GetMobility())
-        ->SetPosition(Vector(2990, 0, 0));
+    NS_TEST_EXPECT_MSG_GT(eagerEnergy, 0, "No energy was consumed");
+    NS_TEST_EXPECT_MSG_EQ_TOL(lazyEnergy,
+                              eagerEnergy,
+                              eagerEnergy * 1e-9,
+                              "Lazy receive windows changed the energy consumption");
+    NS_TEST_EXPECT_MSG_EQ_TOL(lazyRemainingEnergy,
+                              eagerRemainingEnergy,
+                              eagerEnergy * 1e-9,
+                              "Lazy receive windows changed the energy drawn from the source");
+}
 
-    Simulator::Schedule(Seconds(2),
-                        &SimpleEndDeviceLoraPhy::Send,
-                        edPhy1,
-                        packet,
-                        txParams,
-                        868.1,
-                        14);
+/**
+ * \ingroup lorawan
+ *
+ * It tests that the packets of a LoraEndDevicePopulation are received by
+ * gateways as those of end device nodes, and that devices respect the duty cycle
+ */
+class EndDevicePopulationTest : public TestCase
+{
+  public:
+    EndDevicePopulationTest();           //!< Default constructor
+    ~EndDevicePopulationTest() override; //!< Destructor
 
-    Simulator::Stop(Hours(2));
-    Simulator::Run();
-    Simulator::Destroy();
+  private:
+    void DoRun() override;
 
-    NS_TEST_EXPECT_MSG_EQ(m_underSensitivityCalls,
-                          0,
-                          "Packets that should have arrived above sensitivity were under it");
+    /**
+     * Callback for tracing ReceivedPacket of the gateway.
+     *
+     * \param packet The packet received.
+     * \param node The id of the gateway node.
+     */
+    void ReceivedPacket(Ptr<const Packet> packet, uint32_t node);
 
-    Reset();
+    /**
+     * Callback for tracing StartSending of the population.
+     *
+     * \param packet The packet sent.
+     * \param index The index of the sender in the population.
+     */
+    void StartSending(Ptr<const Packet> packet, uint32_t index);
 
-    // Packets can be destroyed by interference
+    Ptr<LoraEndDevicePopulation> m_population; //!< The population under test
+    std::vector<std::vector<Time>> m_sendTimes; //!< The send times of each device
+    std::vector<uint16_t> m_lastFCnt;           //!< The last frame counter received per device
+};
 
-    txParams.sf = 12;
-    Simulator::Schedule(Seconds(2),
-                        &SimpleEndDeviceLoraPhy::Send,
-                        edPhy1,
-                        packet,
-                        txParams,
-                        868.1,
-                        14);
-    Simulator::Schedule(Seconds(2),
-                        &SimpleEndDeviceLoraPhy::Send,
-                        edPhy3,
-                        packet,
-                        txParams,
-                        868.1,
-                        14);
+// Add some help text to this case to describe what it is intended to test
+EndDevicePopulationTest::EndDevicePopulationTest()
+    : TestCase("Verify that a population of end devices sends well formed packets")
+{
+}
 
-    Simulator::Stop(Hours(2));
-    Simulator::Run();
-    Simulator::Destroy();
+// Reminder that the test case should clean up after itself
+EndDevicePopulationTest::~EndDevicePopulationTest()
+{
+}
 
-    NS_TEST_EXPECT_MSG_EQ(m_interferenceCalls,
-                          1,
-                          "Packets that should be destroyed by interference weren't");
+void
+EndDevicePopulationTest::ReceivedPacket(Ptr<const Packet> packet, uint32_t node)
+{
+    NS_LOG_FUNCTION(packet << node);
 
-    Reset();
+    Ptr<Packet> copy = packet->Copy();
+    LorawanMacHeader macHdr;
+    copy->RemoveHeader(macHdr);
+    NS_TEST_EXPECT_MSG_EQ(unsigned(macHdr.GetMType()),
+                          unsigned(LorawanMacHeader::UNCONFIRMED_DATA_UP),
+                          "Unexpected message type");
+    LoraFrameHeader frameHdr;
+    frameHdr.SetAsUplink();
+    copy->RemoveHeader(frameHdr);
 
-    // Packets can be lost because the PHY is not listening on the right frequency
+    // Find the sender from its address
+    uint32_t i = 0;
+    while (i < m_population->GetN() && m_population->GetAddress(i) != frameHdr.GetAddress())
+    {
+        i++;
+    }
+    NS_TEST_ASSERT_MSG_LT(i, m_population->GetN(), "Unknown sender address");
+    NS_TEST_EXPECT_MSG_EQ(frameHdr.GetFCnt(),
+                          m_lastFCnt[i] + 1,
+                          "Frame counters of device " << i << " are not consecutive");
+    m_lastFCnt[i] = frameHdr.GetFCnt();
+    NS_TEST_EXPECT_MSG_EQ(copy->GetSize(), 10, "Unexpected payload size");
+}
 
-    Simulator::Schedule(Seconds(2),
-                        &SimpleEndDeviceLoraPhy::Send,
-                        edPhy1,
-                        packet,
-                        txParams,
-                        868.3,
-                        14);
+void
+EndDevicePopulationTest::StartSending(Ptr<const Packet> packet, uint32_t index)
+{
+    NS_LOG_FUNCTION(packet << index);
 
-    Simulator::Stop(Hours(2));
-    Simulator::Run();
-    Simulator::Destroy();
+    m_sendTimes[index].push_back(Simulator::Now());
+}
 
-    NS_TEST_EXPECT_MSG_EQ(m_wrongFrequencyCalls,
-                          2,
-                          "Packets were received even though PHY was on a different frequency");
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+EndDevicePopulationTest::DoRun()
+{
+    NS_LOG_DEBUG("EndDevicePopulationTest");
+
+    Ptr<LoraChannel> channel = CreateChannel();
+
+    MobilityHelper mobility;
+    mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+    NodeContainer gateways = CreateGateways(1, mobility, channel);
+    DynamicCast<LoraNetDevice>(gateways.Get(0)->GetDevice(0))
+        ->GetPhy()
+        ->TraceConnectWithoutContext(
+            "ReceivedPacket",
+            MakeCallback(&EndDevicePopulationTest::ReceivedPacket, this));
+
+    // Both devices are close to the gateway, and get DR5
+    m_population = CreateObject<LoraEndDevicePopulation>();
+    m_population->SetChannel(channel);
+    m_population->Add(Vector(100, 0, 0), Seconds(10), Seconds(1));
+    m_population->Add(Vector(0, 100, 0), Seconds(10), Seconds(2));
+    m_population->TraceConnectWithoutContext(
+        "StartSending",
+        MakeCallback(&EndDevicePopulationTest::StartSending, this));
+    m_sendTimes.assign(m_population->GetN(), {});
+    m_lastFCnt.assign(m_population->GetN(), 0);
+
+    std::vector<int> dataRates =
+        LorawanMacHelper::SetSpreadingFactorsUp(m_population, gateways, channel);
+    NS_TEST_EXPECT_MSG_EQ(dataRates[0], 2, "Devices close to the gateway don't use DR5");
+
+    // The second device uses DR0: its duty cycle is longer than its period
+    m_population->SetDataRate(1, 0);
+
+    m_population->Start(Seconds(35));
+    Simulator::Stop(Seconds(300));
+    Simulator::Run();
 
-    Reset();
+    NS_TEST_EXPECT_MSG_EQ(m_sendTimes[0].size(), 4, "Device 0 didn't send one packet per period");
+    NS_TEST_EXPECT_MSG_EQ(m_population->GetFrameCounter(0), 4, "Wrong frame counter");
 
-    // Packets can be lost because the PHY is not listening for the right spreading factor
+    // Packets of the second device wait for the duty cycle, and are superseded
+    // by newer ones in the meantime
+    NS_TEST_ASSERT_MSG_EQ(m_sendTimes[1].size(), 2, "Device 1 didn't respect the duty cycle");
+    LoraTxParameters params;
+    params.sf = 12;
+    params.lowDataRateOptimizationEnabled = true;
+    Ptr<Packet> packet = Create<Packet>(10);
+    LoraFrameHeader frameHdr;
+    frameHdr.SetAsUplink();
+    packet->AddHeader(frameHdr);
+    LorawanMacHeader macHdr;
+    packet->AddHeader(macHdr);
+    double timeOnAir = LoraPhy::GetOnAirTime(packet, params).GetSeconds();
+    NS_TEST_EXPECT_MSG_EQ_TOL((m_sendTimes[1][1] - m_sendTimes[1][0]).GetSeconds(),
+                              timeOnAir / 0.01 - timeOnAir,
+                              1e-6,
+                              "Device 1 didn't send as soon as the duty cycle allowed");
 
-    txParams.sf = 8; // Send with 8, listening for 12
-    Simulator::Schedule(Seconds(2),
-                        &SimpleEndDeviceLoraPhy::Send,
-                        edPhy1,
-                        packet,
-                        txParams,
-                        868.1,
-                        14);
+    NS_TEST_EXPECT_MSG_EQ(m_lastFCnt[0], 4, "Not all packets of device 0 were received");
+    NS_TEST_EXPECT_MSG_EQ(m_lastFCnt[1], 2, "Not all packets of device 1 were received");
 
-    Simulator::Stop(Hours(2));
-    Simulator::Run();
+    m_population = nullptr;
     Simulator::Destroy();
+}
 
-    NS_TEST_EXPECT_MSG_EQ(
-        m_wrongSfCalls,
-        2,
-        "Packets were received even though PHY was listening for a different spreading factor.");
-
-    Reset();
+/**
+ * \ingroup lorawan
+ *
+ * It tests that MAC commands stored by value serialize like MacCommand objects
+ */
+class MacCommandValueTest : public TestCase
+{
+  public:
+    MacCommandValueTest();           //!< Default constructor
+    ~MacCommandValueTest() override; //!< Destructor
 
-    // Sending of packets
-    /////////////////////
+  private:
+    void DoRun() override;
+};
 
-    // The very same packet arrives at the other PHY
-    Simulator::Schedule(Seconds(2),
-                        &SimpleEndDeviceLoraPhy::Send,
-                        edPhy1,
-                        packet,
-                        txParams,
-                        868.1,
-                        14);
+// Add some help text to this case to describe what it is intended to test
+MacCommandValueTest::MacCommandValueTest()
+    : TestCase("Verify that MAC command values match the wire format of MacCommand objects")
+{
+}
 
-    Simulator::Stop(Hours(2));
-    Simulator::Run();
-    Simulator::Destroy();
+// Reminder that the test case should clean up after itself
+MacCommandValueTest::~MacCommandValueTest()
+{
+}
 
-    NS_TEST_EXPECT_MSG_EQ(IsSamePacket(packet, m_latestReceivedPacket),
-                          true,
-                          "Packet changed contents when going through the channel");
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+MacCommandValueTest::DoRun()
+{
+    NS_LOG_DEBUG("MacCommandValueTest");
+
+    ///////////////////////////////////////////////
+    // Values and objects produce the same bytes //
+    ///////////////////////////////////////////////
+
+    NewChannelReqValue newChannelReq;
+    newChannelReq.chIndex = 3;
+    newChannelReq.frequency = 867.1e6;
+    newChannelReq.minDataRate = 0;
+    newChannelReq.maxDataRate = 5;
+
+    Buffer valueBuffer;
+    valueBuffer.AddAtStart(GetMacCommandSize(newChannelReq));
+    Buffer::Iterator valueIt = valueBuffer.Begin();
+    SerializeMacCommand(newChannelReq, valueIt);
+
+    Ptr<MacCommand> object = Create<NewChannelReq>(3, 867.1e6, 0, 5);
+    Buffer objectBuffer;
+    objectBuffer.AddAtStart(object->GetSerializedSize());
+    Buffer::Iterator objectIt = objectBuffer.Begin();
+    object->Serialize(objectIt);
+
+    NS_TEST_EXPECT_MSG_EQ(unsigned(GetMacCommandSize(newChannelReq)),
+                          object->GetSerializedSize(),
+                          "Value and object have different sizes");
+    valueIt = valueBuffer.Begin();
+    objectIt = objectBuffer.Begin();
+    for (uint8_t i = 0; i < object->GetSerializedSize(); i++)
+    {
+        NS_TEST_EXPECT_MSG_EQ(unsigned(valueIt.ReadU8()),
+                              unsigned(objectIt.ReadU8()),
+                              "Value and object serialize to different bytes");
+    }
 
-    Reset();
+    // Conversions in both directions preserve the fields
+    Ptr<NewChannelReq> converted = DynamicCast<NewChannelReq>(ToMacCommand(newChannelReq));
+    NS_TEST_ASSERT_MSG_EQ(bool(converted), true, "Conversion created the wrong subclass");
+    NS_TEST_EXPECT_MSG_EQ(converted->GetFrequency(), 867.1e6, "Frequency changes in conversion");
+    NS_TEST_EXPECT_MSG_EQ(unsigned(converted->GetMaxDataRate()),
+                          5,
+                          "MaxDR changes in conversion");
+
+    Ptr<MacCommand> linkAdrReq = Create<LinkAdrReq>(5, 2, 0b101, 0, 1);
+    LinkAdrReqValue linkAdrReqValue = std::get<LinkAdrReqValue>(ToMacCommandValue(linkAdrReq));
+    NS_TEST_EXPECT_MSG_EQ(unsigned(linkAdrReqValue.dataRate), 5, "DataRate changes in conversion");
+    NS_TEST_EXPECT_MSG_EQ(unsigned(linkAdrReqValue.txPower), 2, "TXPower changes in conversion");
+    NS_TEST_EXPECT_MSG_EQ(linkAdrReqValue.GetEnabledChannelsList().size(),
+                          2,
+                          "ChMask changes in conversion");
+    NS_TEST_EXPECT_MSG_EQ(unsigned(linkAdrReqValue.nbRep), 1, "NbTrans changes in conversion");
 
-    // Correct state transitions
-    ////////////////////////////
+    //////////////////////////////////////////////////
+    // Frame headers with more commands than inline //
+    //////////////////////////////////////////////////
 
-    // PHY switches to STANDBY after TX and RX
+    LoraFrameHeader frameHdr;
+    frameHdr.SetAsUplink();
+    frameHdr.SetFPort(1);
+    for (int i = 0; i < 6; i++)
+    {
+        frameHdr.AddDutyCycleAns();
+    }
+    frameHdr.AddLinkCheckReq();
+    frameHdr.AddCommand(Create<LinkAdrAns>(true, false, true));
 
-    Simulator::Schedule(Seconds(2),
-                        &SimpleEndDeviceLoraPhy::Send,
-                        edPhy1,
-                        packet,
-                        txParams,
-                        868.1,
-                        14);
+    Ptr<Packet> pkt = Create<Packet>(10);
+    pkt->AddHeader(frameHdr);
 
-    Simulator::Stop(Hours(2));
-    Simulator::Run();
-    Simulator::Destroy();
+    LoraFrameHeader frameHdr1;
+    frameHdr1.SetAsUplink();
+    pkt->RemoveHeader(frameHdr1);
 
-    NS_TEST_EXPECT_MSG_EQ(edPhy1->GetState(),
-                          SimpleEndDeviceLoraPhy::STANDBY,
-                          "State didn't switch to STANDBY as expected");
-    NS_TEST_EXPECT_MSG_EQ(edPhy2->GetState(),
-                          SimpleEndDeviceLoraPhy::STANDBY,
-                          "State didn't switch to STANDBY as expected");
+    NS_TEST_EXPECT_MSG_EQ(frameHdr1.GetCommandValues().GetN(), 8, "Wrong number of commands");
+    NS_TEST_EXPECT_MSG_EQ(unsigned(frameHdr1.GetFOptsLen()), 9, "Wrong FOpts length");
+    NS_TEST_EXPECT_MSG_EQ((frameHdr1.FindMacCommand<LinkCheckReqValue>() != nullptr),
+                          true,
+                          "LinkCheckReq beyond the inline commands was lost");
+    const LinkAdrAnsValue* linkAdrAns = frameHdr1.FindMacCommand<LinkAdrAnsValue>();
+    NS_TEST_ASSERT_MSG_EQ((linkAdrAns != nullptr),
+                          true,
+                          "LinkAdrAns beyond the inline commands was lost");
+    NS_TEST_EXPECT_MSG_EQ(linkAdrAns->powerAck, true, "PowerACK changes in deserialization");
+    NS_TEST_EXPECT_MSG_EQ(linkAdrAns->dataRateAck, false, "DataRateACK changes in deserialization");
+    NS_TEST_EXPECT_MSG_EQ(bool(frameHdr1.GetMacCommand<LinkAdrAns>()),
+                          true,
+                          "The Ptr-based API doesn't find the command");
+    NS_TEST_EXPECT_MSG_EQ((frameHdr1.FindMacCommand<LinkCheckAnsValue>() == nullptr),
+                          true,
+                          "Found a command that is not in the header");
+
+    /////////////////////////////////////////////////////
+    // Unknown CIDs are skipped with the rest of FOpts //
+    /////////////////////////////////////////////////////
+
+    Buffer unknownBuffer;
+    unknownBuffer.AddAtStart(frameHdr.GetSerializedSize());
+    frameHdr.Serialize(unknownBuffer.Begin());
+    Buffer::Iterator unknownIt = unknownBuffer.Begin();
+    unknownIt.Next(8); // DevAddr, FCtrl, FCnt and the first DutyCycleAns
+    unknownIt.WriteU8(0x7f);
+
+    LoraFrameHeader frameHdr2;
+    frameHdr2.SetAsUplink();
+    uint32_t size = frameHdr2.Deserialize(unknownBuffer.Begin());
+    NS_TEST_EXPECT_MSG_EQ(size, frameHdr.GetSerializedSize(), "Wrong number of bytes consumed");
+    NS_TEST_EXPECT_MSG_EQ(frameHdr2.GetCommandValues().GetN(),
+                          1,
+                          "Commands after an unknown CID were parsed");
+    NS_TEST_EXPECT_MSG_EQ(unsigned(frameHdr2.GetFPort()), 1, "FPort read from the FOpts field");
 }
 
 /**
@@ -1623,9 +3991,24 @@ LorawanTestSuite::LorawanTestSuite()
     AddTestCase(new AddressTest, Duration::QUICK);
     AddTestCase(new HeaderTest, Duration::QUICK);
     AddTestCase(new ReceivePathTest, Duration::QUICK);
+    AddTestCase(new ReceptionPathPoolTest, Duration::QUICK);
+    AddTestCase(new SicTest, Duration::QUICK);
+    AddTestCase(new PreambleCaptureTest, Duration::QUICK);
     AddTestCase(new LogicalLoraChannelTest, Duration::QUICK);
     AddTestCase(new TimeOnAirTest, Duration::QUICK);
     AddTestCase(new PhyConnectivityTest, Duration::QUICK);
+    AddTestCase(new SpatialIndexTest, Duration::QUICK);
+    AddTestCase(new LinkCacheTest, Duration::QUICK);
+    AddTestCase(new ReceiverSubscriptionsTest, Duration::QUICK);
+    AddTestCase(new SharedAirLogTest, Duration::QUICK);
+    AddTestCase(new BatchedDeliveryTest, Duration::QUICK);
+    AddTestCase(new BatchedDeliveryContextTest, Duration::QUICK);
+    AddTestCase(new ParallelLinkBudgetTest, Duration::QUICK);
+    AddTestCase(new LinkTableTest, Duration::QUICK);
+    AddTestCase(new BatchPathLossTest, Duration::QUICK);
+    AddTestCase(new LazyReceiveWindowsTest, Duration::QUICK);
+    AddTestCase(new EndDevicePopulationTest, Duration::QUICK);
+    AddTestCase(new MacCommandValueTest, Duration::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
@@ -9,6 +9,7 @@
 /*
  * This file includes testing for the following components:
  * - NetworkServer
+ * - UplinkContext
  */
 
 // Include headers of classes to test
@@ -17,6 +18,10 @@
 #include "ns3/callback.h"
 #include "ns3/core-module.h"
 #include "ns3/log.h"
+#include "ns3/lora-frame-header.h"
+#include "ns3/lora-tag.h"
+#include "ns3/mac48-address.h"
+#include "ns3/network-controller-components.h"
 #include "ns3/network-server-helper.h"
 #include "ns3/network-server.h"
 
@@ -327,6 +332,167 @@ LinkCheckTest::DoRun()
     NS_ASSERT(m_receivedPacketAtEd);
 }
 
+/**
+ * \ingroup lorawan
+ *
+ * A NetworkControllerComponent that records the uplink packets it is called for.
+ */
+class CountingComponent : public NetworkControllerComponent
+{
+  public:
+    void OnReceivedPacket(const UplinkContext& context, Ptr<NetworkStatus> networkStatus) override
+    {
+        m_contexts.push_back(context);
+    }
+
+    void BeforeSendingReply(Ptr<EndDeviceStatus> status, Ptr<NetworkStatus> networkStatus) override
+    {
+    }
+
+    void OnFailedReply(Ptr<EndDeviceStatus> status, Ptr<NetworkStatus> networkStatus) override
+    {
+    }
+
+    std::vector<UplinkContext> m_contexts; //!< The contexts of the packets received
+};
+
+/**
+ * \ingroup lorawan
+ *
+ * It verifies that the NetworkServer parses each uplink packet once, and only passes it to the
+ * NetworkController components handling its message type.
+ */
+class UplinkContextTest : public TestCase
+{
+  public:
+    UplinkContextTest();           //!< Default constructor
+    ~UplinkContextTest() override; //!< Destructor
+
+    /**
+     * Build an uplink packet as forwarded by a gateway.
+     *
+     * \param mType The message type of the packet.
+     * \param address The address of the sender.
+     * \param fCnt The frame counter of the packet.
+     * \return The packet, with its headers and LoraTag.
+     */
+    Ptr<Packet> CreateUplink(LorawanMacHeader::MType mType,
+                             LoraDeviceAddress address,
+                             uint16_t fCnt);
+
+  private:
+    void DoRun() override;
+};
+
+// Add some help text to this case to describe what it is intended to test
+UplinkContextTest::UplinkContextTest()
+    : TestCase("Verify that the NetworkServer passes uplink packets to the components handling "
+               "their message type")
+{
+}
+
+// Reminder that the test case should clean up after itself
+UplinkContextTest::~UplinkContextTest()
+{
+}
+
+Ptr<Packet>
+UplinkContextTest::CreateUplink(LorawanMacHeader::MType mType,
+                                LoraDeviceAddress address,
+                                uint16_t fCnt)
+{
+    Ptr<Packet> packet = Create<Packet>(10);
+
+    LoraFrameHeader frameHdr;
+    frameHdr.SetAsUplink();
+    frameHdr.SetAddress(address);
+    frameHdr.SetFCnt(fCnt);
+    packet->AddHeader(frameHdr);
+
+    LorawanMacHeader macHdr;
+    macHdr.SetMType(mType);
+    packet->AddHeader(macHdr);
+
+    LoraTag tag;
+    tag.SetSpreadingFactor(9);
+    tag.SetFrequency(868.3);
+    tag.SetReceivePower(-110);
+    packet->AddPacketTag(tag);
+
+    return packet;
+}
+
+// This method is the pure virtual method from class TestCase that every
+// TestCase must implement
+void
+UplinkContextTest::DoRun()
+{
+    NS_LOG_DEBUG("UplinkContextTest");
+
+    LoraDeviceAddress address(1, 1);
+    Ptr<NetworkServer> server = CreateObject<NetworkServer>();
+    server->GetNetworkStatus()->AddNode(address);
+
+    Ptr<CountingComponent> dataComponent = CreateObject<CountingComponent>();
+    server->AddComponent(dataComponent);
+    Ptr<ConfirmedMessagesComponent> ackComponent = CreateObject<ConfirmedMessagesComponent>();
+    server->AddComponent(ackComponent);
+
+    NS_TEST_EXPECT_MSG_EQ(dataComponent->HandlesMType(LorawanMacHeader::UNCONFIRMED_DATA_UP),
+                          true,
+                          "Components should handle unconfirmed uplinks by default");
+    NS_TEST_EXPECT_MSG_EQ(dataComponent->HandlesMType(LorawanMacHeader::JOIN_REQUEST),
+                          false,
+                          "Components shouldn't handle join requests by default");
+    NS_TEST_EXPECT_MSG_EQ(ackComponent->HandlesMType(LorawanMacHeader::UNCONFIRMED_DATA_UP),
+                          false,
+                          "Unconfirmed uplinks don't need an acknowledgment");
+
+    // An unconfirmed uplink, received by two gateways
+    Address gwAddress = Mac48Address("00:00:00:00:00:01");
+    Ptr<Packet> packet = CreateUplink(LorawanMacHeader::UNCONFIRMED_DATA_UP, address, 5);
+    server->Receive(nullptr, packet, 0, gwAddress);
+    server->Receive(nullptr, packet, 0, Mac48Address("00:00:00:00:00:02"));
+
+    NS_TEST_ASSERT_MSG_EQ(dataComponent->m_contexts.size(), 2, "Component not called");
+    const UplinkContext& context = dataComponent->m_contexts.front();
+    NS_TEST_EXPECT_MSG_EQ(context.address, address, "Wrong address in the context");
+    NS_TEST_EXPECT_MSG_EQ(context.frame.GetFCnt(), 5, "Wrong FCnt in the context");
+    NS_TEST_EXPECT_MSG_EQ(context.gwAddress, gwAddress, "Wrong gateway in the context");
+    NS_TEST_EXPECT_MSG_EQ(unsigned(context.sf), 9, "Wrong SF in the context");
+    NS_TEST_EXPECT_MSG_EQ_TOL(context.frequency, 868.3, 1e-9, "Wrong frequency in the context");
+    NS_TEST_EXPECT_MSG_EQ_TOL(context.rxPower, -110, 1e-9, "Wrong power in the context");
+
+    Ptr<EndDeviceStatus> status = server->GetNetworkStatus()->GetEndDeviceStatus(address);
+    NS_TEST_EXPECT_MSG_EQ((context.status == status), true, "Wrong status in the context");
+    NS_TEST_EXPECT_MSG_EQ(status->GetReceivedPacketList().size(),
+                          1,
+                          "Packet received by two gateways stored twice");
+    NS_TEST_EXPECT_MSG_EQ(status->GetReceivedPacketList().back().second.gwList.size(),
+                          2,
+                          "Second gateway not recorded");
+    NS_TEST_EXPECT_MSG_EQ(status->m_reply.needsReply,
+                          false,
+                          "Unconfirmed uplink passed to the ConfirmedMessagesComponent");
+
+    // A confirmed uplink
+    server->Receive(nullptr,
+                    CreateUplink(LorawanMacHeader::CONFIRMED_DATA_UP, address, 6),
+                    0,
+                    gwAddress);
+    NS_TEST_EXPECT_MSG_EQ(dataComponent->m_contexts.size(), 3, "Component not called");
+    NS_TEST_EXPECT_MSG_EQ(status->m_reply.needsReply, true, "Confirmed uplink not acknowledged");
+
+    // Packets from unknown devices are dropped
+    server->Receive(nullptr,
+                    CreateUplink(LorawanMacHeader::UNCONFIRMED_DATA_UP, LoraDeviceAddress(2, 2), 1),
+                    0,
+                    gwAddress);
+    NS_TEST_EXPECT_MSG_EQ(dataComponent->m_contexts.size(), 3, "Unknown device not dropped");
+
+    Simulator::Destroy();
+}
+
 /**
  * \ingroup lorawan
  *
@@ -363,6 +529,7 @@ NetworkServerTestSuite::NetworkServerTestSuite()
     AddTestCase(new UplinkPacketTest, Duration::QUICK);
     AddTestCase(new DownlinkPacketTest, Duration::QUICK);
     AddTestCase(new LinkCheckTest, Duration::QUICK);
+    AddTestCase(new UplinkContextTest, Duration::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
@@ -8,6 +8,10 @@
 
 #include "utilities.h"
 
+#include "ns3/abort.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/simulator.h"
+
 namespace ns3
 {
 namespace lorawan
@@ -26,6 +30,87 @@ CreateChannel()
     return CreateObject<LoraChannel>(loss, delay);
 }
 
+std::vector<Ptr<SimpleEndDeviceLoraPhy>>
+CreateEndDevicePhys(Ptr<LoraChannel> channel, const std::vector<double>& positions, bool standby)
+{
+    std::vector<Ptr<SimpleEndDeviceLoraPhy>> phys;
+    for (auto x : positions)
+    {
+        Ptr<SimpleEndDeviceLoraPhy> phy = CreateObject<SimpleEndDeviceLoraPhy>();
+        Ptr<ConstantPositionMobilityModel> mobility =
+            CreateObject<ConstantPositionMobilityModel>();
+        mobility->SetPosition(Vector(x, 0.0, 0.0));
+        phy->SetMobility(mobility);
+        phy->SetFrequency(868.1);
+        phy->SetSpreadingFactor(12);
+        if (standby)
+        {
+            phy->SwitchToStandby();
+        }
+        phy->SetChannel(channel);
+        channel->Add(phy);
+        phys.push_back(phy);
+    }
+
+    return phys;
+}
+
+void
+ScheduleSend(Time delay, Ptr<SimpleEndDeviceLoraPhy> phy)
+{
+    LoraTxParameters txParams;
+    txParams.sf = 12;
+
+    Simulator::Schedule(delay,
+                        &SimpleEndDeviceLoraPhy::Send,
+                        phy,
+                        Create<Packet>(10),
+                        txParams,
+                        868.1,
+                        14);
+}
+
+/**
+ * Increment a counter, as a callback of a PHY trace source.
+ *
+ * \param counter The counter.
+ * \param packet The packet of the trace source.
+ * \param node The node id of the trace source.
+ */
+static void
+IncrementPhyCounter(int* counter, Ptr<const Packet> packet, uint32_t node)
+{
+    (*counter)++;
+}
+
+/**
+ * Increment a counter, as a callback of the PacketSent trace source of a channel.
+ *
+ * \param counter The counter.
+ * \param packet The packet being sent.
+ */
+static void
+IncrementChannelCounter(int* counter, Ptr<const Packet> packet)
+{
+    (*counter)++;
+}
+
+void
+CountPhyTrace(Ptr<LoraPhy> phy, std::string traceSource, int* counter)
+{
+    bool connected =
+        phy->TraceConnectWithoutContext(traceSource,
+                                        MakeBoundCallback(&IncrementPhyCounter, counter));
+    NS_ABORT_MSG_UNLESS(connected, "Unknown trace source " << traceSource);
+}
+
+void
+CountPacketsSent(Ptr<LoraChannel> channel, int* counter)
+{
+    channel->TraceConnectWithoutContext("PacketSent",
+                                        MakeBoundCallback(&IncrementChannelCounter, counter));
+}
+
 NodeContainer
 CreateEndDevices(int nDevices, MobilityHelper mobility, Ptr<LoraChannel> channel)
 {
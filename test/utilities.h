@@ -14,6 +14,10 @@
 #include "ns3/mobility-helper.h"
 #include "ns3/network-server-helper.h"
 #include "ns3/position-allocator.h"
+#include "ns3/simple-end-device-lora-phy.h"
+
+#include <string>
+#include <vector>
 
 namespace ns3
 {
@@ -35,6 +39,47 @@ struct NetworkComponents
 
 Ptr<LoraChannel> CreateChannel();
 
+/**
+ * Create end device PHYs along the x axis, connected to a channel and set to
+ * listen to SF12 on 868.1 MHz.
+ *
+ * \param channel The channel to connect the PHYs to.
+ * \param positions The x coordinate [m] of each PHY.
+ * \param standby Whether to switch the PHYs to STANDBY, rather than leaving
+ * them in SLEEP.
+ * \return The PHYs, in the order of their positions.
+ */
+std::vector<Ptr<SimpleEndDeviceLoraPhy>> CreateEndDevicePhys(Ptr<LoraChannel> channel,
+                                                           const std::vector<double>& positions,
+                                                           bool standby);
+
+/**
+ * Schedule the transmission of a 10 byte packet at SF12 on 868.1 MHz, at 14 dBm.
+ *
+ * \param delay The delay after which the packet is sent.
+ * \param phy The sending PHY.
+ */
+void ScheduleSend(Time delay, Ptr<SimpleEndDeviceLoraPhy> phy);
+
+/**
+ * Count the calls of a PHY trace source with a (packet, node id) signature,
+ * such as ReceivedPacket or LostPacketBecauseInterference.
+ *
+ * \param phy The PHY.
+ * \param traceSource The name of the trace source.
+ * \param counter The counter to increment at each call.
+ */
+void CountPhyTrace(Ptr<LoraPhy> phy, std::string traceSource, int* counter);
+
+/**
+ * Count the deliveries of packets to PHYs through the PacketSent trace source
+ * of a channel.
+ *
+ * \param channel The channel.
+ * \param counter The counter to increment at each delivery.
+ */
+void CountPacketsSent(Ptr<LoraChannel> channel, int* counter);
+
 NodeContainer CreateEndDevices(int nDevices, MobilityHelper mobility, Ptr<LoraChannel> channel);
 
 NodeContainer CreateGateways(int nGateways, MobilityHelper mobility, Ptr<LoraChannel> channel);